@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+constexpr std::size_t kCacheLineSize = 64;
+
+// Single-allocation bump arena for the per-config runtime tables. Callers sum
+// bytes_for<T>() over everything they need, reserve() once, then carve arrays
+// with allocate<T>(). Every array starts on its own cache line. Only trivially
+// destructible types are accepted, because the arena frees memory without
+// running destructors.
+class Arena {
+public:
+    Arena() = default;
+    ~Arena() { release(); }
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    Arena(Arena &&other) noexcept { take(other); }
+    Arena &operator=(Arena &&other) noexcept {
+        if (this != &other) {
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    template <typename T>
+    static constexpr std::size_t bytes_for(std::size_t count) {
+        return round_up(count * sizeof(T));
+    }
+
+    bool reserve(std::size_t bytes) {
+        release();
+        if (bytes == 0) {
+            return true;
+        }
+        base_ = static_cast<std::uint8_t *>(std::aligned_alloc(kCacheLineSize, round_up(bytes)));
+        if (base_ == nullptr) {
+            return false;
+        }
+        capacity_ = round_up(bytes);
+        used_ = 0;
+        return true;
+    }
+
+    template <typename T>
+    T *allocate(std::size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena storage is released without destructors");
+        static_assert(alignof(T) <= kCacheLineSize, "arena only guarantees cache-line alignment");
+        const std::size_t bytes = bytes_for<T>(count);
+        if (count == 0 || base_ == nullptr || used_ + bytes > capacity_) {
+            return nullptr;
+        }
+        T *items = reinterpret_cast<T *>(base_ + used_);
+        used_ += bytes;
+        for (std::size_t i = 0; i < count; ++i) {
+            new (&items[i]) T();
+        }
+        return items;
+    }
+
+    std::size_t capacity() const { return capacity_; }
+
+    void release() {
+        std::free(base_);
+        base_ = nullptr;
+        capacity_ = 0;
+        used_ = 0;
+    }
+
+private:
+    static constexpr std::size_t round_up(std::size_t bytes) {
+        return (bytes + kCacheLineSize - 1) & ~(kCacheLineSize - 1);
+    }
+
+    void take(Arena &other) {
+        base_ = other.base_;
+        capacity_ = other.capacity_;
+        used_ = other.used_;
+        other.base_ = nullptr;
+        other.capacity_ = 0;
+        other.used_ = 0;
+    }
+
+    std::uint8_t *base_{nullptr};
+    std::size_t capacity_{0};
+    std::size_t used_{0};
+};
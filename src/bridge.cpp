@@ -1,35 +1,26 @@
 #include "bridge.hpp"
+#include "clock.hpp"
+#include "udp_filter.hpp"
 
 #include <algorithm>
 #include <array>
 #include <arpa/inet.h>
 #include <cerrno>
+#include <csignal>
 #include <cstdio>
 #include <cstring>
-#include <fcntl.h>
 #include <linux/can.h>
-#include <linux/can/raw.h>
-#include <net/if.h>
 #include <string>
+#include <tuple>
 #include <sys/epoll.h>
-#include <sys/ioctl.h>
-#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
 #include <syslog.h>
 #include <unistd.h>
 
 namespace {
 
-bool set_non_blocking(int fd) {
-    const int flags = fcntl(fd, F_GETFL, 0);
-    if (flags < 0) {
-        return false;
-    }
-    if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
-        return false;
-    }
-    return true;
-}
-
 void close_fd(int &fd) {
     if (fd >= 0) {
         close(fd);
@@ -41,15 +32,156 @@ void log_errno(const char *message) {
     syslog(LOG_ERR, "%s: %s", message, std::strerror(errno));
 }
 
-bool interface_exists(const std::string &name) {
-    return if_nametoindex(name.c_str()) != 0U;
+bool same_rate_limits(const std::vector<RateLimitRule> &lhs, const std::vector<RateLimitRule> &rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+        const RateLimitRule &a = lhs[i];
+        const RateLimitRule &b = rhs[i];
+        if (a.id_range.min != b.id_range.min || a.id_range.max != b.id_range.max || a.max_rate_hz != b.max_rate_hz ||
+            a.burst != b.burst || a.decimate != b.decimate || a.direction != b.direction) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool same_change_filter(const ChangeFilterConfig &a, const ChangeFilterConfig &b) {
+    return a.enabled == b.enabled && a.refresh_interval_ms == b.refresh_interval_ms && a.eff_capacity == b.eff_capacity;
+}
+
+bool same_tx_queue(const TxQueueConfig &a, const TxQueueConfig &b) {
+    return a.enabled == b.enabled && a.priority == b.priority && a.depth == b.depth;
+}
+
+bool same_tx_pacing(const TxPacingConfig &a, const TxPacingConfig &b) {
+    return a.enabled == b.enabled && a.bus_load_percent == b.bus_load_percent && a.burst_frames == b.burst_frames;
+}
+
+bool same_socket_buffers(const SocketBufferConfig &a, const SocketBufferConfig &b) {
+    return a.rcvbuf == b.rcvbuf && a.sndbuf == b.sndbuf && a.force == b.force && a.adaptive == b.adaptive &&
+           a.max_rcvbuf == b.max_rcvbuf;
+}
+
+// Arms a one-shot CLOCK_MONOTONIC timerfd for an absolute deadline. An
+// all-zero it_value would disarm it, so the deadline is at least 1 ns; one in
+// the past fires immediately.
+bool set_timer_deadline(int fd, std::uint64_t deadline_ns) {
+    constexpr std::uint64_t kNanosPerSecond = 1000000000ULL;
+    deadline_ns = std::max<std::uint64_t>(deadline_ns, 1);
+    itimerspec spec{};
+    spec.it_value.tv_sec = static_cast<time_t>(deadline_ns / kNanosPerSecond);
+    spec.it_value.tv_nsec = static_cast<long>(deadline_ns % kNanosPerSecond);
+    return timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, nullptr) == 0;
+}
+
+// A CAN_BCM message head for one ID; period_us becomes ival2, the TX
+// period or the RX throttle.
+bcm_msg_head bcm_head(std::uint32_t opcode, canid_t can_id, std::uint32_t period_us) {
+    constexpr std::uint32_t kMicrosPerSecond = 1000000;
+    bcm_msg_head head{};
+    head.opcode = opcode;
+    head.can_id = can_id;
+    head.ival2.tv_sec = static_cast<long>(period_us / kMicrosPerSecond);
+    head.ival2.tv_usec = static_cast<long>(period_us % kMicrosPerSecond);
+    return head;
+}
+
+bool same_isotp(const IsoTpConfig &a, const IsoTpConfig &b) {
+    return a.vcan_name == b.vcan_name && a.tx_id == b.tx_id && a.rx_id == b.rx_id && a.block_size == b.block_size &&
+           a.st_min_us == b.st_min_us && a.padding == b.padding;
+}
+
+// The socket setup of a link; st_min_us was validated to map onto the flow
+// control byte exactly.
+IsoTpLinkSpec isotp_spec(const IsoTpConfig &config) {
+    const auto can_id = [](std::uint32_t id) { return id > CAN_SFF_MASK ? (id | CAN_EFF_FLAG) : id; };
+    const std::uint32_t st_min_us = config.st_min_us;
+    const std::uint32_t st_min = st_min_us != 0 && st_min_us < 1000 ? 0xF0U + st_min_us / 100U : st_min_us / 1000U;
+    return IsoTpLinkSpec{can_id(config.tx_id),
+                         can_id(config.rx_id),
+                         static_cast<std::uint8_t>(config.block_size),
+                         static_cast<std::uint8_t>(st_min),
+                         config.padding};
+}
+
+bool same_xdp_ports(const std::vector<XdpPort> &a, const std::vector<XdpPort> &b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const XdpPort &lhs, const XdpPort &rhs) {
+        return lhs.port == rhs.port && lhs.filtered == rhs.filtered &&
+               lhs.filter.source.s_addr == rhs.filter.source.s_addr && lhs.filter.frame_size == rhs.filter.frame_size &&
+               lhs.filter.header_size == rhs.filter.header_size && lhs.filter.check_info == rhs.filter.check_info;
+    });
+}
+
+bool same_replay(const ReplayConfig &a, const ReplayConfig &b) {
+    return a.enabled == b.enabled && a.path == b.path && a.speed == b.speed && a.inject == b.inject &&
+           a.loop == b.loop && a.filter_direction == b.filter_direction && a.direction == b.direction;
+}
+
+bool same_capture(const CaptureConfig &a, const CaptureConfig &b) {
+    return a.enabled == b.enabled && a.path == b.path && a.file_size_mb == b.file_size_mb && a.files == b.files;
+}
+
+std::vector<std::string> capture_channel_names(const BridgeConfig &config) {
+    std::vector<std::string> names;
+    for (const auto &port_cfg : config.ports) {
+        for (const auto &channel_cfg : port_cfg.channels) {
+            names.push_back(channel_cfg.vcan_name);
+        }
+    }
+    return names;
 }
 
 } // namespace
 
 BridgeApp::BridgeApp(const BridgeConfig &config)
+    : BridgeApp(config, socket_io_) {}
+
+BridgeApp::BridgeApp(const BridgeConfig &config, IoBackend &io)
     : config_(config),
+      io_(io),
       epoll_fd_(-1),
+      signal_fd_(-1),
+      control_fd_(-1),
+      handle_stop_signals_(false),
+      reload_pending_(false),
+      stop_requested_(false),
+      reload_requested_(false),
+      udp_fds_(nullptr),
+      remote_addrs_(nullptr),
+      port_wire_(nullptr),
+      port_stats_(nullptr),
+      rx_sequences_(nullptr),
+      tx_sequences_(nullptr),
+      can_fds_(nullptr),
+      tx_timer_fds_(nullptr),
+      channel_ports_(nullptr),
+      channel_stats_(nullptr),
+      id_lookup_(nullptr),
+      events_(nullptr),
+      rx_buffer_(nullptr),
+      pacing_active_(false),
+      replay_next_{},
+      replay_pending_(false),
+      replay_timer_fd_(-1),
+      xdp_retry_timer_fd_(-1),
+      xdp_retries_(0),
+      shared_can_fd_(-1),
+      shared_can_blocked_(0),
+      can_rx_batch_{},
+      bcm_fd_(-1),
+      bcm_rx_fd_(-1),
+      bcm_rx_drops_{},
+      bcm_rx_socket_drops_(0),
+      can_ring_frames_{},
+      shared_can_drops_{},
+      shared_can_socket_drops_(0),
+      tx_staged_count_(0),
+      tx_staged_port_(0),
+      port_configs_(nullptr),
+      channel_configs_(nullptr),
+      event_capacity_(0),
       udp_port_count_(0),
       channel_count_(0),
       id_lookup_count_(0) {
@@ -60,350 +192,2025 @@ BridgeApp::~BridgeApp() {
     shutdown();
 }
 
+void BridgeApp::enable_reload(const std::string &config_path) {
+    config_path_ = config_path;
+}
+
+void BridgeApp::enable_signals() {
+    handle_stop_signals_ = true;
+}
+
 bool BridgeApp::initialize() {
     shutdown();
 
-    if (config_.ports.empty()) {
-        std::fprintf(stderr, "configuration must contain at least one UDP port\n");
+    epoll_fd_ = epoll_create1(0);
+    if (epoll_fd_ < 0) {
+        log_errno("failed to create epoll instance");
+        return false;
+    }
+
+    if (!apply_config(config_)) {
+        shutdown();
         return false;
     }
 
-    in_addr server_addr{};
-    if (inet_pton(AF_INET, config_.server.ip.c_str(), &server_addr) != 1) {
-        std::fprintf(stderr, "invalid server ip address: %s\n", config_.server.ip.c_str());
+    if (!open_control_fd()) {
+        shutdown();
         return false;
     }
+    if ((!config_path_.empty() || handle_stop_signals_) && !open_signal_fd()) {
+        shutdown();
+        return false;
+    }
+    stop_requested_.store(false);
+    return true;
+}
 
-    epoll_fd_ = epoll_create1(0);
+bool BridgeApp::reload(const BridgeConfig &next) {
     if (epoll_fd_ < 0) {
-        log_errno("failed to create epoll instance");
         return false;
     }
+    return apply_config(next);
+}
 
-    udp_port_count_ = 0;
-    channel_count_ = 0;
-    id_lookup_count_ = 0;
+// Two phases: everything that can fail for reasons outside the process
+// (bad address, missing interface, port in use) happens before the running
+// tables are touched, so a rejected config leaves the bridge as it was.
+// The one exception is auto_setup_interfaces, whose link changes cannot be
+// undone: it runs last in the first phase, after the server address,
+// capture, replay and UDP ports are secured, so only a failure of the setup
+// itself or of opening a CAN socket leaves links changed under the old
+// config.
+bool BridgeApp::apply_config(BridgeConfig next) {
+    if (next.ports.empty()) {
+        syslog(LOG_ERR, "configuration must contain at least one UDP port");
+        return false;
+    }
 
-    for (const auto &port_cfg : config_.ports) {
-        if (udp_port_count_ >= kMaxUdpPorts) {
-            syslog(LOG_ERR, "configured UDP ports exceed supported maximum (%zu)", kMaxUdpPorts);
-            shutdown();
-            return false;
-        }
+    in_addr server_addr{};
+    if (inet_pton(AF_INET, next.server.ip.c_str(), &server_addr) != 1) {
+        syslog(LOG_ERR, "invalid server ip address: %s", next.server.ip.c_str());
+        return false;
+    }
 
-        UdpPortContext &port_ctx = udp_ports_[udp_port_count_];
-        port_ctx = {};
-        port_ctx.config = port_cfg;
-        port_ctx.remote_addr.sin_family = AF_INET;
-        port_ctx.remote_addr.sin_addr = server_addr;
-        port_ctx.remote_addr.sin_port = htons(port_cfg.send_port);
-        port_ctx.rx_buffer.fill(0);
+    CaptureWriter capture;
+    if (!prepare_capture(next, capture)) {
+        return false;
+    }
+    ReplaySource replay;
+    if (!prepare_replay(next, replay)) {
+        return false;
+    }
 
-        if (!configure_udp_socket(port_ctx)) {
-            shutdown();
-            return false;
-        }
+    std::vector<int> udp_fds;
+    std::vector<int> can_fds;
+    if (!open_endpoints(next, udp_fds, can_fds)) {
+        return false;
+    }
 
-        const std::size_t port_index = udp_port_count_;
-        ++udp_port_count_;
+    RetiredTables retired;
+    retire_tables(retired);
+    config_ = std::move(next);
+    const bool built = build_tables(retired, udp_fds, can_fds);
+    close_retired(retired);
+    if (!built) {
+        // Half-built tables cannot serve traffic; stop the loop instead.
+        syslog(LOG_ERR, "failed to build runtime tables, stopping");
+        shutdown();
+        return false;
+    }
+    if (!config_.shared_can_socket && shared_can_fd_ >= 0) {
+        io_.close_endpoint(shared_can_fd_);
+        shared_can_fd_ = -1;
+    }
 
-        if (!register_event(EventType::Udp, static_cast<std::uint32_t>(port_index), port_ctx.udp_fd)) {
-            shutdown();
-            return false;
+    if (capture.enabled() || !config_.capture.enabled) {
+        capture_ = std::move(capture);
+    } else {
+        std::string error;
+        if (!capture_.set_channels(capture_channel_names(config_), error)) {
+            syslog(LOG_ERR, "capture stopped: %s", error.c_str());
         }
+    }
 
-        syslog(LOG_INFO,
-               "[UDP:%zu] listen 0.0.0.0:%u -> %s:%u",
-               port_index,
-               port_ctx.config.listen_port,
-               config_.server.ip.c_str(),
-               port_ctx.config.send_port);
-
-        for (const auto &channel_cfg : port_cfg.channels) {
-            if (channel_count_ >= kMaxChannels) {
-                syslog(LOG_ERR, "configured channels exceed supported maximum (%zu)", kMaxChannels);
-                shutdown();
-                return false;
-            }
-
-            ChannelContext &channel_ctx = channels_[channel_count_];
-            channel_ctx = {};
-            channel_ctx.config = channel_cfg;
-            channel_ctx.port_index = port_index;
-
-            if (!prepare_can_interface(channel_ctx.config)) {
-                shutdown();
-                return false;
-            }
+    index_replay_channels();
+    if (replay.is_open()) {
+        replay_ = std::move(replay);
+        start_replay();
+    } else if (!config_.replay.enabled) {
+        stop_replay();
+    }
+    configure_xdp();
+    configure_bcm_rx();
+    configure_can_ring();
+    configure_cyclic_tx();
+    configure_isotp();
+    return true;
+}
 
-            if (!configure_can_socket(channel_ctx)) {
-                shutdown();
-                return false;
-            }
+// What udp_filter accepts on the port, for its socket filter and the XDP
+// program.
+UdpFilterSpec BridgeApp::udp_filter_spec(std::size_t port_index) const {
+    const PortWire wire = port_wire_[port_index];
+    return UdpFilterSpec{remote_addrs_[port_index].sin_addr,
+                         wire.frame_size,
+                         wire.sequenced ? static_cast<std::uint32_t>(kSequenceHeaderSize) : 0U,
+                         config_.udp_filter.info_bytes};
+}
 
-            const std::size_t channel_index = channel_count_;
-            ++channel_count_;
+// AF_XDP ingress only accelerates ports that keep their UDP socket, so a
+// setup failure is logged and the sockets carry the traffic alone.
+void BridgeApp::configure_xdp() {
+    xdp_ports_.clear();
+    for (std::size_t i = 0; i < udp_port_count_; ++i) {
+        if (port_configs_[i]->xdp_ingress) {
+            xdp_ports_.emplace_back(port_configs_[i]->listen_port, static_cast<std::uint32_t>(i));
+        }
+    }
+    std::sort(xdp_ports_.begin(), xdp_ports_.end());
+    if (!config_.xdp.enabled) {
+        xdp_.close();
+        return;
+    }
 
-            if (!register_event(EventType::Can, static_cast<std::uint32_t>(channel_index), channels_[channel_index].can_fd)) {
-                shutdown();
-                return false;
-            }
+    // udp_filter's checks run in the XDP program too; redirected datagrams
+    // never reach the socket filter.
+    std::vector<XdpPort> ports;
+    for (const auto &entry : xdp_ports_) {
+        ports.push_back(XdpPort{entry.first, config_.udp_filter.enabled, udp_filter_spec(entry.second)});
+    }
+    std::string error;
+    if (xdp_.same_setup(config_.xdp)) {
+        if (!same_xdp_ports(ports, xdp_.ports()) && !xdp_.set_ports(ports, error)) {
+            syslog(LOG_WARNING, "AF_XDP ingress stopped, UDP sockets serve all ports: %s", error.c_str());
+            xdp_.close();
+        }
+        return;
+    }
+    if (!xdp_.open(config_.xdp, ports, error)) {
+        // Queues a reload just released stay busy for a moment. Sleeping here
+        // would stall the loop, so the sockets carry the ports meanwhile and
+        // a timer tries again.
+        if (errno == EBUSY && xdp_retries_ < kXdpRetries && schedule_xdp_retry()) {
+            ++xdp_retries_;
+            return;
+        }
+        xdp_retries_ = 0;
+        syslog(LOG_WARNING,
+               "AF_XDP ingress on %s unavailable, UDP sockets serve all ports: %s",
+               config_.xdp.interface.c_str(),
+               error.c_str());
+        return;
+    }
+    xdp_retries_ = 0;
+    for (std::size_t queue = 0; queue < xdp_.queue_count(); ++queue) {
+        if (!register_event(EventType::Xdp, static_cast<std::uint32_t>(queue), xdp_.queue_fd(queue))) {
+            xdp_.close();
+            return;
+        }
+    }
+    syslog(LOG_INFO,
+           "AF_XDP ingress on %s: %zu ports, %zu queues",
+           config_.xdp.interface.c_str(),
+           ports.size(),
+           xdp_.queue_count());
+}
 
-            if (id_lookup_count_ >= kMaxChannels) {
-                syslog(LOG_ERR, "identifier lookup table overflow");
-                shutdown();
-                return false;
-            }
+bool BridgeApp::schedule_xdp_retry() {
+    if (xdp_retry_timer_fd_ < 0) {
+        xdp_retry_timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (xdp_retry_timer_fd_ < 0) {
+            log_errno("failed to create AF_XDP retry timer");
+            return false;
+        }
+        if (!register_event(EventType::XdpRetry, 0, xdp_retry_timer_fd_)) {
+            close_fd(xdp_retry_timer_fd_);
+            return false;
+        }
+    }
+    if (!set_timer_deadline(xdp_retry_timer_fd_, monotonic_ns() + kXdpRetryDelayNs)) {
+        log_errno("failed to arm AF_XDP retry timer");
+        return false;
+    }
+    return true;
+}
 
-            RangeLookup &lookup = id_lookup_[id_lookup_count_];
-            lookup.range = channel_cfg.id_range;
-            lookup.channel_index = channel_index;
-            ++id_lookup_count_;
+// Picks up whatever the running config asks for by then; a reload in between
+// may have changed or disabled AF_XDP ingress.
+void BridgeApp::handle_xdp_retry_timer() {
+    std::uint64_t expirations = 0;
+    if (read(xdp_retry_timer_fd_, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN) {
+        log_errno("read from AF_XDP retry timer failed");
+    }
+    if (!xdp_.active()) {
+        configure_xdp();
+    }
+}
 
+// Like AF_XDP, the ring only takes over reception: the CAN sockets stay open
+// for writing and receive again whenever the ring is off or fails to open.
+void BridgeApp::configure_can_ring() {
+    if (!config_.can_rx_ring.enabled) {
+        can_ring_.close();
+    } else if (!can_ring_.same_setup(config_.can_rx_ring)) {
+        std::string error;
+        if (!can_ring_.open(config_.can_rx_ring, error)) {
+            syslog(LOG_WARNING, "CAN RX ring unavailable, CAN sockets keep receiving: %s", error.c_str());
+        } else if (!register_event(EventType::CanRing, 0, can_ring_.fd())) {
+            can_ring_.close();
+        } else {
             syslog(LOG_INFO,
-                   "[CAN:%zu] %s range[0x%08X,0x%08X] -> UDP port %zu",
-                   channel_index,
-                   channel_ctx.config.vcan_name.c_str(),
-                   channel_ctx.config.id_range.min,
-                   channel_ctx.config.id_range.max,
-                   channel_ctx.port_index);
+                   "CAN RX ring: %u blocks of %u bytes, %u ms timeout",
+                   config_.can_rx_ring.block_count,
+                   config_.can_rx_ring.block_size,
+                   config_.can_rx_ring.block_timeout_ms);
         }
     }
 
-    if (id_lookup_count_ > 1) {
-        std::sort(id_lookup_.begin(),
-                  id_lookup_.begin() + static_cast<std::ptrdiff_t>(id_lookup_count_),
-                  [](const RangeLookup &lhs, const RangeLookup &rhs) { return lhs.range.min < rhs.range.min; });
+    const bool receive = !can_ring_.active();
+    if (config_.shared_can_socket) {
+        io_.set_can_receive(shared_can_fd_, receive);
+        return;
+    }
+    for (std::size_t i = 0; i < channel_count_; ++i) {
+        io_.set_can_receive(can_fds_[i], receive && bcm_rx_channels_[i] == 0U);
     }
-
-    return true;
 }
 
-void BridgeApp::run(std::atomic<bool> &keep_running) {
-    if (epoll_fd_ < 0) {
-        return;
+// Subscriptions are diffed against the running ones so that a reload keeps
+// the kernel's last-frame state of unchanged IDs (a fresh RX_SETUP reports
+// the next frame as changed). A channel whose subscriptions cannot all be
+// set up drops them and keeps receiving on its CAN_RAW socket.
+void BridgeApp::configure_bcm_rx() {
+    std::vector<BcmRxOp> previous;
+    previous.swap(bcm_rx_ops_);
+    bcm_rx_channels_.assign(channel_count_, 0);
+    const bool wanted = std::any_of(channel_configs_, channel_configs_ + channel_count_, [](const ChannelConfig *cfg) {
+        return cfg->bcm_rx.enabled;
+    });
+    if (wanted && bcm_rx_fd_ < 0) {
+        bcm_rx_fd_ = io_.open_can_bcm();
+        if (bcm_rx_fd_ < 0) {
+            syslog(LOG_WARNING, "CAN_BCM unavailable, bcm_rx channels keep receiving on CAN_RAW");
+        } else if (!register_event(EventType::CanBcm, 0, bcm_rx_fd_)) {
+            io_.close_endpoint(bcm_rx_fd_);
+            bcm_rx_fd_ = -1;
+        } else {
+            bcm_rx_drops_ = SocketDrops{};
+            apply_socket_buffers(bcm_rx_fd_, config_.socket_buffers, bcm_rx_drops_, "[BCM]");
+        }
+        previous.clear();
     }
-
-    const std::size_t max_events = udp_port_count_ + channel_count_;
-    if (max_events == 0) {
+    if (!wanted || bcm_rx_fd_ < 0) {
+        // Closing the socket ends every subscription.
+        if (bcm_rx_fd_ >= 0) {
+            io_.close_endpoint(bcm_rx_fd_);
+            bcm_rx_fd_ = -1;
+        }
         return;
     }
 
-    std::array<epoll_event, kMaxEvents> events{};
-    while (keep_running.load()) {
-        const int ready = epoll_wait(epoll_fd_, events.data(), static_cast<int>(max_events), 1000);
-        if (ready < 0) {
-            if (errno == EINTR) {
-                continue;
+    const auto by_key = [](const BcmRxOp &a, const BcmRxOp &b) {
+        return std::tie(a.ifindex, a.can_id) < std::tie(b.ifindex, b.can_id);
+    };
+    const auto same_op = [](const BcmRxOp &a, const BcmRxOp &b) {
+        return a.ifindex == b.ifindex && a.can_id == b.can_id && a.throttle_ms == b.throttle_ms &&
+               a.changes_only == b.changes_only;
+    };
+    bool timestamps = false;
+    for (std::size_t channel_index = 0; channel_index < channel_count_; ++channel_index) {
+        const BcmRxConfig &bcm_cfg = channel_configs_[channel_index]->bcm_rx;
+        const int ifindex = can_ifindexes_[channel_index];
+        if (!bcm_cfg.enabled || ifindex == 0) {
+            continue;
+        }
+        std::vector<std::uint32_t> ids = bcm_cfg.ids;
+        if (ids.empty()) {
+            const IdRange &range = channel_configs_[channel_index]->id_range;
+            for (std::uint32_t id = range.min; id <= range.max; ++id) {
+                ids.push_back(id);
             }
-            log_errno("epoll_wait failed");
-            break;
         }
-        if (ready == 0) {
+        const std::size_t first = bcm_rx_ops_.size();
+        bool subscribed = true;
+        for (const std::uint32_t id : ids) {
+            const canid_t can_id = id > CAN_SFF_MASK ? (id | CAN_EFF_FLAG) : id;
+            BcmRxOp op{ifindex, can_id, bcm_cfg.throttle_ms, bcm_cfg.changes_only};
+            const auto running = std::lower_bound(previous.begin(), previous.end(), op, by_key);
+            if (running != previous.end() && same_op(*running, op)) {
+                op.last = running->last;
+                op.seen = running->seen;
+            } else if (!subscribe_bcm_rx(op)) {
+                subscribed = false;
+                break;
+            }
+            bcm_rx_ops_.push_back(op);
+        }
+        if (!subscribed) {
+            log_errno("CAN_BCM RX_SETUP failed");
+            syslog(LOG_WARNING, "[CAN:%zu] bcm_rx unavailable, receiving on CAN_RAW", channel_index);
+            for (std::size_t i = first; i < bcm_rx_ops_.size(); ++i) {
+                io_.can_bcm_send(bcm_rx_fd_, ifindex, bcm_head(RX_DELETE, bcm_rx_ops_[i].can_id, 0), nullptr);
+            }
+            bcm_rx_ops_.resize(first);
             continue;
         }
+        bcm_rx_channels_[channel_index] = 1;
+        timestamps = timestamps || port_wire_[channel_ports_[channel_index]].format == FrameFormat::Timestamped;
+    }
+    std::sort(bcm_rx_ops_.begin(), bcm_rx_ops_.end(), by_key);
 
-        for (int i = 0; i < ready; ++i) {
-            const EventType type = decode_event_type(events[i].data.u64);
-            const std::uint32_t index = decode_event_index(events[i].data.u64);
-            switch (type) {
-            case EventType::Udp:
-                if (index < udp_port_count_) {
-                    handle_udp_events(index);
-                }
-                break;
-            case EventType::Can:
-                if (index < channel_count_) {
-                    handle_can_events(index);
-                }
-                break;
-            default:
-                break;
-            }
+    for (const BcmRxOp &op : previous) {
+        if (!std::binary_search(bcm_rx_ops_.begin(), bcm_rx_ops_.end(), op, by_key)) {
+            io_.can_bcm_send(bcm_rx_fd_, op.ifindex, bcm_head(RX_DELETE, op.can_id, 0), nullptr);
         }
     }
+    if (timestamps && !io_.enable_can_timestamps(bcm_rx_fd_)) {
+        syslog(LOG_WARNING, "[BCM] RX timestamps unavailable, sending 0");
+    }
 }
 
-bool BridgeApp::configure_udp_socket(UdpPortContext &context) {
-    context.udp_fd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (context.udp_fd < 0) {
-        log_errno("failed to create UDP socket");
-        return false;
+// RX_CHECK_DLC plus an all-ones mask report any change of DLC or payload;
+// RX_FILTER_ID reports every frame. Either way SETTIMER with ival2 throttles
+// the updates of the ID.
+bool BridgeApp::subscribe_bcm_rx(const BcmRxOp &op) {
+    bcm_msg_head head = bcm_head(RX_SETUP, op.can_id, op.throttle_ms * 1000U);
+    struct can_frame mask{};
+    if (op.changes_only) {
+        head.flags = RX_CHECK_DLC;
+        head.nframes = 1;
+        mask.can_id = op.can_id;
+        mask.can_dlc = CAN_MAX_DLEN;
+        std::memset(mask.data, 0xFF, sizeof(mask.data));
+    } else {
+        head.flags = RX_FILTER_ID;
     }
-    if (!set_non_blocking(context.udp_fd)) {
-        log_errno("failed to set UDP non-blocking");
-        close_fd(context.udp_fd);
-        return false;
+    if (op.throttle_ms != 0) {
+        head.flags |= SETTIMER;
     }
+    return io_.can_bcm_send(bcm_rx_fd_, op.ifindex, head, &mask);
+}
 
-    int opt = 1;
-    if (setsockopt(context.udp_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-        log_errno("setsockopt SO_REUSEADDR failed");
-    }
+BridgeApp::BcmRxOp *BridgeApp::find_bcm_rx_op(int ifindex, canid_t can_id) {
+    const auto op = std::lower_bound(
+        bcm_rx_ops_.begin(), bcm_rx_ops_.end(), std::make_pair(ifindex, can_id), [](const BcmRxOp &entry, const auto &key) {
+            return std::tie(entry.ifindex, entry.can_id) < std::tie(key.first, key.second);
+        });
+    return op != bcm_rx_ops_.end() && op->ifindex == ifindex && op->can_id == can_id ? &*op : nullptr;
+}
 
-    sockaddr_in local{};
-    local.sin_family = AF_INET;
-    local.sin_addr.s_addr = INADDR_ANY;
-    local.sin_port = htons(context.config.listen_port);
-    if (bind(context.udp_fd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) < 0) {
-        log_errno("failed to bind UDP socket");
-        close_fd(context.udp_fd);
+// Whether the subscription will report our write of `frame` back, so that
+// the copy can be told from bus traffic. Unsubscribed IDs and unchanged
+// content produce no copy, and a throttled subscription may merge it into a
+// later update; those writes are not expected (a throttled one then reaches
+// the server). Either way the write becomes the content the kernel compares
+// the next frame against.
+bool BridgeApp::expect_bcm_echo(std::size_t channel_index, const struct can_frame &frame) {
+    BcmRxOp *op = find_bcm_rx_op(can_ifindexes_[channel_index], frame.can_id);
+    if (op == nullptr) {
         return false;
     }
+    const bool changed = !op->changes_only || !op->seen || op->last.can_dlc != frame.can_dlc ||
+                         std::memcmp(op->last.data, frame.data, sizeof(frame.data)) != 0;
+    op->last = frame;
+    op->seen = true;
+    return changed && op->throttle_ms == 0;
+}
 
-    return true;
+// Jobs outlive a reload while their interface still carries the channel
+// their ID routes to; the rest are deleted. Turning cyclic_tx off closes the
+// socket, which ends every job in the kernel. Without CAN_BCM the bridge
+// runs on and refuses the control records.
+void BridgeApp::configure_cyclic_tx() {
+    if (!config_.cyclic_tx.enabled) {
+        if (bcm_fd_ >= 0) {
+            io_.close_endpoint(bcm_fd_);
+            bcm_fd_ = -1;
+        }
+        cyclic_jobs_.clear();
+        return;
+    }
+    if (bcm_fd_ < 0) {
+        bcm_fd_ = io_.open_can_bcm();
+        if (bcm_fd_ < 0) {
+            syslog(LOG_WARNING, "CAN_BCM unavailable, cyclic control records are refused");
+            return;
+        }
+    }
+
+    const auto stale = [this](const std::pair<int, canid_t> &job) {
+        struct can_frame frame{};
+        frame.can_id = job.second;
+        const std::size_t channel_index =
+            find_channel_for_can_id(id_lookup_, id_lookup_count_, extract_identifier(frame));
+        if (channel_index != kInvalidChannelIndex && can_ifindexes_[channel_index] == job.first) {
+            return false;
+        }
+        const bcm_msg_head head = bcm_head(TX_DELETE, job.second, 0);
+        io_.can_bcm_send(bcm_fd_, job.first, head, nullptr);
+        return true;
+    };
+    cyclic_jobs_.erase(std::remove_if(cyclic_jobs_.begin(), cyclic_jobs_.end(), stale), cyclic_jobs_.end());
 }
 
-bool BridgeApp::configure_can_socket(ChannelContext &context) {
-    context.can_fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
-    if (context.can_fd < 0) {
-        log_errno("failed to create CAN socket");
-        return false;
+// An unchanged link keeps its socket, and with it a transfer in progress;
+// the rest are closed before new ones bind. A link whose socket cannot be
+// opened stays listed, drops its PDUs and leaves the bridge running.
+void BridgeApp::configure_isotp() {
+    std::vector<IsoTpLink> previous;
+    previous.swap(isotp_links_);
+    for (std::size_t port_index = 0; port_index < udp_port_count_; ++port_index) {
+        for (const IsoTpConfig &link_cfg : port_configs_[port_index]->isotp) {
+            IsoTpLink link{link_cfg, static_cast<std::uint32_t>(port_index), -1, IsoTpStats{}};
+            const auto running = std::find_if(previous.begin(), previous.end(), [&link_cfg](const IsoTpLink &old) {
+                return old.fd >= 0 && same_isotp(old.config, link_cfg);
+            });
+            if (running != previous.end()) {
+                link.fd = running->fd;
+                link.stats = running->stats;
+                running->fd = -1;
+            }
+            isotp_links_.push_back(link);
+        }
     }
-    if (!set_non_blocking(context.can_fd)) {
-        log_errno("failed to set CAN non-blocking");
-        close_fd(context.can_fd);
-        return false;
+    for (const IsoTpLink &old : previous) {
+        if (old.fd >= 0) {
+            io_.close_endpoint(old.fd);
+        }
     }
 
-    ifreq ifr{};
-    std::strncpy(ifr.ifr_name, context.config.vcan_name.c_str(), sizeof(ifr.ifr_name));
-    ifr.ifr_name[sizeof(ifr.ifr_name) - 1] = '\0';
-    if (ioctl(context.can_fd, SIOCGIFINDEX, &ifr) < 0) {
-        log_errno("failed to lookup CAN interface");
-        close_fd(context.can_fd);
-        return false;
+    for (std::size_t i = 0; i < isotp_links_.size(); ++i) {
+        IsoTpLink &link = isotp_links_[i];
+        const auto index = static_cast<std::uint32_t>(i);
+        if (link.fd >= 0) {
+            update_event(EventType::IsoTp, index, link.fd, EPOLLIN);
+            continue;
+        }
+        link.fd = io_.open_isotp(link.config.vcan_name, isotp_spec(link.config));
+        if (link.fd < 0) {
+            log_errno("CAN_ISOTP socket failed");
+            syslog(LOG_WARNING,
+                   "[ISOTP:%s 0x%X] link unavailable, its PDUs are dropped",
+                   link.config.vcan_name.c_str(),
+                   link.config.tx_id);
+        } else if (!register_event(EventType::IsoTp, index, link.fd)) {
+            io_.close_endpoint(link.fd);
+            link.fd = -1;
+        }
     }
+}
 
-    sockaddr_can addr{};
-    addr.can_family = AF_CAN;
-    addr.can_ifindex = ifr.ifr_ifindex;
-    if (bind(context.can_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
-        log_errno("failed to bind CAN socket");
-        close_fd(context.can_fd);
+// Opens the capture of `next` into `opened` when it differs from the running
+// one, so that a bad path fails the reload before anything is torn down. An
+// unchanged capture keeps its file and `opened` stays closed.
+bool BridgeApp::prepare_capture(const BridgeConfig &next, CaptureWriter &opened) {
+    const CaptureConfig &capture_cfg = next.capture;
+    if (!capture_cfg.enabled || (capture_.enabled() && same_capture(config_.capture, capture_cfg))) {
+        return true;
+    }
+    constexpr std::uint64_t kBytesPerMegabyte = 1024ULL * 1024ULL;
+    std::string error;
+    if (!opened.open(capture_cfg.path,
+                     capture_cfg.file_size_mb * kBytesPerMegabyte,
+                     capture_cfg.files,
+                     capture_channel_names(next),
+                     error)) {
+        syslog(LOG_ERR, "failed to open capture: %s", error.c_str());
         return false;
     }
-
+    syslog(LOG_INFO,
+           "capturing to %s (%u x %u MB)",
+           capture_cfg.path.c_str(),
+           capture_cfg.files,
+           capture_cfg.file_size_mb);
     return true;
 }
 
-bool BridgeApp::prepare_can_interface(const ChannelConfig &config) const {
-    if (!interface_exists(config.vcan_name)) {
-        syslog(LOG_ERR, "required CAN interface %s not found", config.vcan_name.c_str());
+// Like prepare_capture: a changed or newly enabled replay is opened before the
+// switch, an unchanged one keeps its position.
+bool BridgeApp::prepare_replay(const BridgeConfig &next, ReplaySource &opened) {
+    const ReplayConfig &replay_cfg = next.replay;
+    if (!replay_cfg.enabled || (replay_.is_open() && same_replay(config_.replay, replay_cfg))) {
+        return true;
+    }
+    std::string error;
+    if (!opened.open(replay_cfg.path, error)) {
+        syslog(LOG_ERR, "failed to open replay: %s", error.c_str());
         return false;
     }
+    opened.set_direction_filter(replay_cfg.filter_direction, replay_cfg.direction);
     return true;
 }
 
-bool BridgeApp::register_event(EventType type, std::uint32_t index, int fd) {
-    if (epoll_fd_ < 0 || fd < 0) {
-        return false;
+void BridgeApp::start_replay() {
+    replay_pending_ = false;
+    if (replay_timer_fd_ < 0) {
+        replay_timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (replay_timer_fd_ < 0) {
+            log_errno("failed to create replay timer");
+            return;
+        }
+        if (!register_event(EventType::Replay, 0, replay_timer_fd_)) {
+            close_fd(replay_timer_fd_);
+            return;
+        }
     }
-    epoll_event event{};
-    event.events = EPOLLIN;
-    event.data.u64 = make_event_tag(type, index);
-    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
-        log_errno("failed to register fd with epoll");
-        return false;
+    if (!replay_.next(replay_next_)) {
+        syslog(LOG_WARNING, "replay %s holds no usable frames", config_.replay.path.c_str());
+        return;
+    }
+    replay_timing_ = ReplayTiming(config_.replay.speed);
+    replay_timing_.start(replay_next_.timestamp_ns, monotonic_ns());
+    replay_pending_ = true;
+    syslog(LOG_INFO,
+           "replaying %s into the %s side at %s",
+           config_.replay.path.c_str(),
+           config_.replay.inject == ReplayInject::Udp ? "UDP" : "CAN",
+           replay_timing_.max_speed() ? "maximum speed" : "recorded timing");
+    if (!set_timer_deadline(replay_timer_fd_, replay_timing_.due_ns(replay_next_.timestamp_ns))) {
+        log_errno("failed to arm replay timer");
     }
-    return true;
 }
 
-void BridgeApp::shutdown() {
-    for (std::size_t i = 0; i < channel_count_; ++i) {
-        close_fd(channels_[i].can_fd);
+void BridgeApp::stop_replay() {
+    replay_pending_ = false;
+    replay_.close();
+    if (replay_timer_fd_ >= 0) {
+        const itimerspec disarm{};
+        timerfd_settime(replay_timer_fd_, 0, &disarm, nullptr);
     }
-    for (std::size_t i = 0; i < udp_port_count_; ++i) {
-        close_fd(udp_ports_[i].udp_fd);
+}
+
+void BridgeApp::index_replay_channels() {
+    replay_channels_.clear();
+    for (std::size_t i = 0; i < channel_count_; ++i) {
+        replay_channels_.emplace_back(channel_configs_[i]->vcan_name, static_cast<std::uint32_t>(i));
     }
-    close_fd(epoll_fd_);
-    udp_port_count_ = 0;
-    channel_count_ = 0;
-    id_lookup_count_ = 0;
+    std::sort(replay_channels_.begin(), replay_channels_.end());
 }
 
-void BridgeApp::handle_udp_events(std::size_t port_index) {
-    if (port_index >= udp_port_count_) {
+void BridgeApp::handle_replay_timer() {
+    std::uint64_t expirations = 0;
+    if (read(replay_timer_fd_, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN) {
+        log_errno("read from replay timer failed");
+    }
+    if (!replay_pending_) {
         return;
     }
 
-    UdpPortContext &port = udp_ports_[port_index];
-    while (true) {
-        const ssize_t received = recv(port.udp_fd, port.rx_buffer.data(), port.rx_buffer.size(), 0);
-        if (received < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                break;
-            }
-            log_errno("recv from UDP failed");
+    const std::uint64_t now_ns = monotonic_ns();
+    std::size_t replayed = 0;
+    while (replay_timing_.due_ns(replay_next_.timestamp_ns) <= now_ns && replayed < kReplayBatch) {
+        replay_frame(replay_next_, now_ns);
+        ++replayed;
+        if (replay_.next(replay_next_)) {
+            continue;
+        }
+        if (!config_.replay.loop) {
+            syslog(LOG_INFO, "replay finished after %llu frames", static_cast<unsigned long long>(replay_stats_.frames));
+            replay_pending_ = false;
             break;
         }
-        if (received == 0) {
+        replay_.rewind();
+        if (!replay_.next(replay_next_)) {
+            replay_pending_ = false;
             break;
         }
+        ++replay_stats_.loops;
+        replay_timing_.start(replay_next_.timestamp_ns, now_ns);
+    }
+    flush_udp_tx();
+    if (!replay_pending_) {
+        return;
+    }
+    // After a full batch the next frame is already due and the timer fires
+    // again right away, behind whatever events queued up meanwhile.
+    if (!set_timer_deadline(replay_timer_fd_, replay_timing_.due_ns(replay_next_.timestamp_ns))) {
+        log_errno("failed to arm replay timer");
+    }
+}
 
-        if (received % static_cast<ssize_t>(kUdpFrameSize) != 0) {
-            syslog(LOG_WARNING,
-                   "[UDP:%zu] payload length %zd not multiple of %zu",
-                   port_index,
-                   received,
-                   kUdpFrameSize);
+// Replayed frames enter where live traffic would: UDP-side frames are rate
+// limited and routed by CAN ID, CAN-side frames go through the channel's
+// filters to its UDP port with the recorded timestamp.
+void BridgeApp::replay_frame(const ReplayFrame &replayed, std::uint64_t now_ns) {
+    ++replay_stats_.frames;
+    const struct can_frame &frame = replayed.frame;
+    if (config_.replay.inject == ReplayInject::Udp) {
+        const std::uint32_t can_id = extract_identifier(frame);
+        if (rate_limiter_.active(FlowDirection::UdpToCan) && !rate_limiter_.allow(FlowDirection::UdpToCan, can_id, now_ns)) {
+            return;
         }
+        const std::size_t channel_index = find_channel_for_can_id(id_lookup_, id_lookup_count_, can_id);
+        if (channel_index == kInvalidChannelIndex) {
+            ++replay_stats_.unroutable;
+            return;
+        }
+        write_can_frame(channel_index, frame, now_ns);
+        return;
+    }
 
-        std::size_t offset = 0;
-        while (offset + kUdpFrameSize <= static_cast<std::size_t>(received)) {
-            struct can_frame frame{};
-            if (!decode_udp_frame(port.rx_buffer.data() + offset, frame)) {
-                syslog(LOG_WARNING, "[UDP:%zu] failed to decode frame at offset %zu", port_index, offset);
-                offset += kUdpFrameSize;
-                continue;
-            }
+    const auto it = std::lower_bound(replay_channels_.begin(),
+                                     replay_channels_.end(),
+                                     replayed.interface_name,
+                                     [](const std::pair<std::string, std::uint32_t> &entry, std::string_view name) {
+                                         return std::string_view(entry.first) < name;
+                                     });
+    if (it == replay_channels_.end() || it->first != replayed.interface_name) {
+        ++replay_stats_.unroutable;
+        return;
+    }
+    ++channel_stats_[it->second].can_rx_frames;
+    forward_can_frame(it->second, frame, replayed.timestamp_ns, now_ns);
+}
 
-            const std::uint32_t can_id = extract_identifier(frame);
-            const std::size_t channel_index = find_channel_for_can_id(can_id);
-            if (channel_index == kInvalidChannelIndex) {
-                syslog(LOG_WARNING,
-                       "[UDP:%zu] no channel mapping for CAN id 0x%08X",
-                       port_index,
-                       static_cast<unsigned int>(can_id));
-                offset += kUdpFrameSize;
-                continue;
-            }
+void BridgeApp::capture_frame(CaptureDirection direction, std::size_t channel_index, const struct can_frame &frame) {
+    CaptureRecord record{};
+    record.timestamp_ns = realtime_ns();
+    record.can_id = frame.can_id;
+    record.dlc = frame.can_dlc;
+    record.direction = static_cast<std::uint8_t>(direction);
+    record.channel = static_cast<std::uint16_t>(channel_index);
+    record.udp_port = port_configs_[channel_ports_[channel_index]]->listen_port;
+    std::memcpy(record.data, frame.data, sizeof(record.data));
+    std::string error;
+    if (!capture_.append(record, error)) {
+        syslog(LOG_ERR, "capture stopped: %s", error.c_str());
+    }
+}
 
-            ChannelContext &channel = channels_[channel_index];
-            if (channel.port_index != port_index) {
-                syslog(LOG_WARNING,
-                       "[UDP:%zu] channel %zu belongs to port %zu for CAN id 0x%08X",
-                       port_index,
-                       channel_index,
-                       channel.port_index,
-                       static_cast<unsigned int>(can_id));
-                offset += kUdpFrameSize;
-                continue;
+// Opens the sockets `next` needs that the running tables do not already
+// have. Slots that will be adopted from the running tables stay -1, and so do
+// all CAN slots in shared_can_socket mode, whose one socket is opened and
+// registered here the first time.
+bool BridgeApp::open_endpoints(const BridgeConfig &next, std::vector<int> &udp_fds, std::vector<int> &can_fds) {
+    const auto close_opened = [&]() {
+        for (int &fd : udp_fds) {
+            if (fd >= 0) {
+                io_.close_endpoint(fd);
             }
-
-            const ssize_t written = write(channel.can_fd, &frame, sizeof(frame));
-            if (written < 0) {
-                if (errno != EAGAIN && errno != EWOULDBLOCK) {
-                    log_errno("write to CAN failed");
-                }
-                break;
+        }
+        for (int &fd : can_fds) {
+            if (fd >= 0) {
+                io_.close_endpoint(fd);
             }
-            offset += kUdpFrameSize;
         }
-    }
-}
+    };
+
+    for (const auto &port_cfg : next.ports) {
+        bool running = false;
+        for (std::size_t i = 0; i < udp_port_count_; ++i) {
+            running = running || port_configs_[i]->listen_port == port_cfg.listen_port;
+        }
+        udp_fds.push_back(running ? -1 : io_.open_udp(port_cfg.listen_port));
+        if (!running && udp_fds.back() < 0) {
+            syslog(LOG_ERR, "failed to open UDP port %u", port_cfg.listen_port);
+            close_opened();
+            return false;
+        }
+    }
+
+    // Interfaces are created or reconfigured only once every UDP port is
+    // secured; a busy port must not take a live CAN link down first.
+    if (next.auto_setup_interfaces && !setup_can_interfaces(next)) {
+        close_opened();
+        return false;
+    }
+
+    for (const auto &port_cfg : next.ports) {
+        for (const auto &channel_cfg : port_cfg.channels) {
+            bool running = false;
+            for (std::size_t i = 0; i < channel_count_; ++i) {
+                running = running || (channel_configs_[i]->vcan_name == channel_cfg.vcan_name && can_fds_[i] >= 0);
+            }
+            if (running && !next.shared_can_socket) {
+                can_fds.push_back(-1);
+                continue;
+            }
+            if (!prepare_can_interface(channel_cfg)) {
+                close_opened();
+                return false;
+            }
+            if (next.shared_can_socket) {
+                can_fds.push_back(-1);
+                continue;
+            }
+            can_fds.push_back(io_.open_can(channel_cfg.vcan_name));
+            if (can_fds.back() < 0) {
+                syslog(LOG_ERR, "failed to open CAN interface %s", channel_cfg.vcan_name.c_str());
+                close_opened();
+                return false;
+            }
+        }
+    }
+
+    if (next.shared_can_socket && shared_can_fd_ < 0) {
+        const int fd = io_.open_can_any();
+        if (fd < 0 || !register_event(EventType::CanShared, 0, fd)) {
+            syslog(LOG_ERR, "failed to open the shared CAN socket");
+            if (fd >= 0) {
+                io_.close_endpoint(fd);
+            }
+            close_opened();
+            return false;
+        }
+        shared_can_fd_ = fd;
+    }
+    return true;
+}
+
+void BridgeApp::retire_tables(RetiredTables &retired) {
+    retired.config = std::move(config_);
+    retired.arena = std::move(arena_);
+    retired.udp_fds = udp_fds_;
+    retired.port_stats = port_stats_;
+    retired.rx_sequences = rx_sequences_;
+    retired.tx_sequences = tx_sequences_;
+    retired.can_fds = can_fds_;
+    retired.tx_timer_fds = tx_timer_fds_;
+    retired.channel_stats = channel_stats_;
+    retired.port_count = udp_port_count_;
+    retired.channel_count = channel_count_;
+    retired.value_caches = std::move(value_caches_);
+    retired.rate_limiter = std::move(rate_limiter_);
+    retired.egress_queues = std::move(egress_queues_);
+    retired.tx_pacers = std::move(tx_pacers_);
+    retired.tx_schedules = std::move(tx_schedules_);
+    retired.udp_drops = std::move(udp_drops_);
+    retired.can_drops = std::move(can_drops_);
+
+    // port_configs_/channel_configs_ point into retired.config, whose
+    // vectors kept their storage through the move.
+    udp_fds_ = nullptr;
+    remote_addrs_ = nullptr;
+    port_wire_ = nullptr;
+    port_stats_ = nullptr;
+    rx_sequences_ = nullptr;
+    tx_sequences_ = nullptr;
+    can_fds_ = nullptr;
+    tx_timer_fds_ = nullptr;
+    channel_ports_ = nullptr;
+    channel_stats_ = nullptr;
+    id_lookup_ = nullptr;
+    events_ = nullptr;
+    rx_buffer_ = nullptr;
+    port_configs_ = nullptr;
+    channel_configs_ = nullptr;
+    value_caches_.clear();
+    rate_limiter_ = RateLimiter{};
+    egress_queues_.clear();
+    tx_pacers_.clear();
+    tx_schedules_.clear();
+    can_tx_blocked_.clear();
+    tx_timer_deadlines_.clear();
+    can_ifindexes_.clear();
+    ifindex_channels_.clear();
+    tx_echoes_.clear();
+    udp_drops_.clear();
+    can_drops_.clear();
+    shared_can_blocked_ = 0;
+    pacing_active_ = false;
+    event_capacity_ = 0;
+    udp_port_count_ = 0;
+    channel_count_ = 0;
+    id_lookup_count_ = 0;
+}
+
+bool BridgeApp::build_tables(RetiredTables &retired, const std::vector<int> &udp_fds, const std::vector<int> &can_fds) {
+    in_addr server_addr{};
+    inet_pton(AF_INET, config_.server.ip.c_str(), &server_addr);
+
+    std::size_t total_channels = 0;
+    for (const auto &port_cfg : config_.ports) {
+        total_channels += port_cfg.channels.size();
+    }
+    if (!allocate_tables(config_.ports.size(), total_channels)) {
+        syslog(LOG_ERR, "failed to allocate runtime tables for %zu ports / %zu channels", config_.ports.size(), total_channels);
+        // Adopted sockets are still owned by `retired`; close the fresh ones.
+        for (int fd : udp_fds) {
+            if (fd >= 0) {
+                io_.close_endpoint(fd);
+            }
+        }
+        for (int fd : can_fds) {
+            if (fd >= 0) {
+                io_.close_endpoint(fd);
+            }
+        }
+        return false;
+    }
+    value_caches_.assign(total_channels, LastValueCache{});
+    egress_queues_.assign(total_channels, EgressQueue{});
+    tx_pacers_.assign(total_channels, TxPacer{});
+    tx_schedules_.assign(total_channels, TxSchedule{});
+    can_tx_blocked_.assign(total_channels, 0);
+    tx_timer_deadlines_.assign(total_channels, 0);
+    can_ifindexes_.assign(total_channels, 0);
+    tx_echoes_.assign(total_channels, TxEchoFilter{});
+    udp_drops_.assign(config_.ports.size(), SocketDrops{});
+    can_drops_.assign(total_channels, SocketDrops{});
+
+    // Fill every fd slot first so that an early failure still closes them.
+    {
+        std::size_t channel_index = 0;
+        for (std::size_t port_index = 0; port_index < config_.ports.size(); ++port_index) {
+            const PortConfig &port_cfg = config_.ports[port_index];
+            const std::size_t old_port = retired.find_port(port_cfg.listen_port);
+            if (old_port != kInvalidChannelIndex) {
+                udp_fds_[port_index] = retired.udp_fds[old_port];
+                retired.udp_fds[old_port] = -1;
+                port_stats_[port_index] = retired.port_stats[old_port];
+                udp_drops_[port_index] = retired.udp_drops[old_port];
+                if (retired.config.ports[old_port].sequence_header == port_cfg.sequence_header) {
+                    rx_sequences_[port_index] = retired.rx_sequences[old_port];
+                    tx_sequences_[port_index] = retired.tx_sequences[old_port];
+                }
+            } else {
+                udp_fds_[port_index] = udp_fds[port_index];
+            }
+            port_configs_[port_index] = &port_cfg;
+            ++udp_port_count_;
+
+            for (const auto &channel_cfg : port_cfg.channels) {
+                const std::size_t old_channel = retired.find_channel(channel_cfg.vcan_name);
+                if (old_channel != kInvalidChannelIndex) {
+                    channel_stats_[channel_index] = retired.channel_stats[old_channel];
+                }
+                // A socket switching in or out of the shared one is replaced;
+                // the retired socket is closed with the old tables.
+                if (old_channel != kInvalidChannelIndex && can_fds[channel_index] < 0 && !config_.shared_can_socket) {
+                    can_fds_[channel_index] = retired.can_fds[old_channel];
+                    retired.can_fds[old_channel] = -1;
+                    can_drops_[channel_index] = retired.can_drops[old_channel];
+                } else {
+                    can_fds_[channel_index] = can_fds[channel_index];
+                }
+                channel_configs_[channel_index] = &channel_cfg;
+                channel_ports_[channel_index] = static_cast<std::uint32_t>(port_index);
+                ++channel_count_;
+                ++channel_index;
+            }
+        }
+    }
+
+    if (retired.port_count != 0 && same_rate_limits(retired.config.rate_limits, config_.rate_limits)) {
+        // Unchanged rules keep their buckets and counters.
+        rate_limiter_ = std::move(retired.rate_limiter);
+    } else {
+        if (!rate_limiter_.initialize(config_.rate_limits)) {
+            syslog(LOG_ERR, "failed to compile %zu rate limit rules", config_.rate_limits.size());
+            return false;
+        }
+        for (std::size_t i = 0; i < config_.rate_limits.size(); ++i) {
+            const RateLimitRule &rule = config_.rate_limits[i];
+            syslog(LOG_INFO,
+                   "[RATE:%zu] ids[0x%08X,0x%08X] max %u Hz burst %u decimate 1/%u",
+                   i,
+                   rule.id_range.min,
+                   rule.id_range.max,
+                   rule.max_rate_hz,
+                   rule.burst,
+                   rule.decimate);
+        }
+    }
+
+    for (std::size_t port_index = 0; port_index < udp_port_count_; ++port_index) {
+        const PortConfig &port_cfg = *port_configs_[port_index];
+        remote_addrs_[port_index].sin_family = AF_INET;
+        remote_addrs_[port_index].sin_addr = server_addr;
+        remote_addrs_[port_index].sin_port = htons(port_cfg.send_port);
+        port_wire_[port_index].frame_size = static_cast<std::uint32_t>(frame_size(port_cfg.frame_format));
+        port_wire_[port_index].format = port_cfg.frame_format;
+        port_wire_[port_index].scheduled_tx = port_cfg.scheduled_tx;
+        port_wire_[port_index].sequenced = port_cfg.sequence_header;
+
+        const bool adopted = udp_fds[port_index] < 0;
+        const bool registered = adopted
+                                    ? update_event(EventType::Udp, static_cast<std::uint32_t>(port_index), udp_fds_[port_index], EPOLLIN)
+                                    : register_event(EventType::Udp, static_cast<std::uint32_t>(port_index), udp_fds_[port_index]);
+        if (!registered) {
+            return false;
+        }
+
+        // Without the filter the bridge still checks every datagram itself.
+        std::vector<sock_filter> filter;
+        if (config_.udp_filter.enabled) {
+            filter = build_udp_filter(udp_filter_spec(port_index));
+        }
+        if (!io_.set_udp_filter(udp_fds_[port_index], filter)) {
+            syslog(LOG_WARNING,
+                   "[UDP:%zu] cannot %s socket filter: %s",
+                   port_index,
+                   filter.empty() ? "remove" : "attach",
+                   std::strerror(errno));
+        }
+
+        const std::size_t old_port = retired.find_port(port_cfg.listen_port);
+        if (!adopted || !same_socket_buffers(retired.config.ports[old_port].socket_buffers, port_cfg.socket_buffers)) {
+            apply_socket_buffers(udp_fds_[port_index],
+                                 port_cfg.socket_buffers,
+                                 udp_drops_[port_index],
+                                 "[UDP:" + std::to_string(port_index) + "]");
+        }
+
+        syslog(LOG_INFO,
+               "[UDP:%zu] listen 0.0.0.0:%u -> %s:%u%s",
+               port_index,
+               port_cfg.listen_port,
+               config_.server.ip.c_str(),
+               port_cfg.send_port,
+               adopted ? " (kept)" : "");
+    }
+
+    // Queued frames are re-armed below; start the shared socket unblocked.
+    if (config_.shared_can_socket) {
+        if (!update_event(EventType::CanShared, 0, shared_can_fd_, EPOLLIN)) {
+            return false;
+        }
+        if (!retired.config.shared_can_socket) {
+            shared_can_drops_ = SocketDrops{};
+        }
+        if (!retired.config.shared_can_socket ||
+            !same_socket_buffers(retired.config.socket_buffers, config_.socket_buffers)) {
+            apply_socket_buffers(shared_can_fd_, config_.socket_buffers, shared_can_drops_, "[CAN]");
+        }
+    }
+
+    for (std::size_t channel_index = 0; channel_index < channel_count_; ++channel_index) {
+        const ChannelConfig &channel_cfg = *channel_configs_[channel_index];
+        const std::size_t old_channel = retired.find_channel(channel_cfg.vcan_name);
+        const ChannelConfig *old_cfg = nullptr;
+        if (old_channel != kInvalidChannelIndex) {
+            for (const auto &port_cfg : retired.config.ports) {
+                for (const auto &candidate : port_cfg.channels) {
+                    if (candidate.vcan_name == channel_cfg.vcan_name) {
+                        old_cfg = &candidate;
+                    }
+                }
+            }
+        }
+
+        if (old_cfg != nullptr && same_change_filter(old_cfg->change_filter, channel_cfg.change_filter)) {
+            value_caches_[channel_index] = std::move(retired.value_caches[old_channel]);
+        } else if (!value_caches_[channel_index].initialize(channel_cfg.change_filter)) {
+            syslog(LOG_ERR, "[CAN:%zu] failed to set up change filter", channel_index);
+            return false;
+        }
+
+        const TxQueueConfig &queue_cfg = channel_cfg.tx_queue;
+        if (old_cfg != nullptr && same_tx_queue(old_cfg->tx_queue, queue_cfg)) {
+            egress_queues_[channel_index] = std::move(retired.egress_queues[old_channel]);
+        } else {
+            if (old_cfg != nullptr) {
+                // A resized or re-ordered queue starts empty.
+                channel_stats_[channel_index].can_tx_dropped += retired.egress_queues[old_channel].size();
+            }
+            if (queue_cfg.enabled && !egress_queues_[channel_index].initialize(queue_cfg.depth, queue_cfg.priority)) {
+                syslog(LOG_ERR, "[CAN:%zu] failed to set up egress queue", channel_index);
+                return false;
+            }
+        }
+
+        const bool adopted = old_channel != kInvalidChannelIndex;
+        const int ifindex = static_cast<int>(io_.interface_index(channel_cfg.vcan_name));
+        if (ifindex == 0) {
+            // Gone since open_endpoints(); the shared socket and the ring
+            // drop its frames.
+            syslog(LOG_WARNING, "[CAN:%zu] %s has no ifindex", channel_index, channel_cfg.vcan_name.c_str());
+        } else {
+            ifindex_channels_.emplace_back(ifindex, static_cast<std::uint32_t>(channel_index));
+        }
+        can_ifindexes_[channel_index] = ifindex;
+        if (!config_.shared_can_socket) {
+            const bool registered = can_fds[channel_index] < 0
+                                        ? update_event(EventType::Can, static_cast<std::uint32_t>(channel_index), can_fds_[channel_index], EPOLLIN)
+                                        : register_event(EventType::Can, static_cast<std::uint32_t>(channel_index), can_fds_[channel_index]);
+            if (!registered) {
+                return false;
+            }
+            if (can_fds[channel_index] >= 0 ||
+                (old_cfg != nullptr && !same_socket_buffers(old_cfg->socket_buffers, channel_cfg.socket_buffers))) {
+                apply_socket_buffers(can_fds_[channel_index],
+                                     channel_cfg.socket_buffers,
+                                     can_drops_[channel_index],
+                                     "[CAN:" + std::to_string(channel_index) + "]");
+            }
+        }
+
+        const PortWire &wire = port_wire_[channel_ports_[channel_index]];
+        const int rx_fd = config_.shared_can_socket ? shared_can_fd_ : can_fds_[channel_index];
+        if (wire.format == FrameFormat::Timestamped && !io_.enable_can_timestamps(rx_fd)) {
+            syslog(LOG_WARNING, "[CAN:%zu] RX timestamps unavailable, sending 0", channel_index);
+        }
+
+        if (wire.scheduled_tx) {
+            if (old_cfg != nullptr && retired.tx_schedules[old_channel].enabled()) {
+                tx_schedules_[channel_index] = std::move(retired.tx_schedules[old_channel]);
+            } else if (!tx_schedules_[channel_index].initialize(kTxScheduleDepth)) {
+                syslog(LOG_ERR, "[CAN:%zu] failed to set up TX schedule", channel_index);
+                return false;
+            }
+        } else if (old_cfg != nullptr) {
+            channel_stats_[channel_index].can_tx_dropped += retired.tx_schedules[old_channel].size();
+        }
+
+        if (channel_cfg.tx_pacing.enabled || wire.scheduled_tx || queue_cfg.enabled) {
+            if (old_cfg != nullptr && retired.tx_timer_fds[old_channel] >= 0) {
+                tx_timer_fds_[channel_index] = retired.tx_timer_fds[old_channel];
+                retired.tx_timer_fds[old_channel] = -1;
+                if (old_cfg->bitrate == channel_cfg.bitrate && same_tx_pacing(old_cfg->tx_pacing, channel_cfg.tx_pacing)) {
+                    tx_pacers_[channel_index] = retired.tx_pacers[old_channel];
+                }
+            }
+            if (!configure_tx_timer(channel_index)) {
+                return false;
+            }
+        }
+
+        if (!egress_queues_[channel_index].empty()) {
+            wait_for_can_egress(channel_index, false);
+        }
+        if (!tx_schedules_[channel_index].empty()) {
+            arm_tx_timer(channel_index, tx_schedules_[channel_index].next_due_ns());
+        }
+
+        RangeLookup &lookup = id_lookup_[id_lookup_count_];
+        lookup.range = channel_cfg.id_range;
+        lookup.channel_index = static_cast<std::uint32_t>(channel_index);
+        ++id_lookup_count_;
+
+        syslog(LOG_INFO,
+               "[CAN:%zu] %s range[0x%08X,0x%08X] -> UDP port %u%s",
+               channel_index,
+               channel_cfg.vcan_name.c_str(),
+               channel_cfg.id_range.min,
+               channel_cfg.id_range.max,
+               channel_ports_[channel_index],
+               adopted ? " (kept)" : "");
+        if (queue_cfg.enabled) {
+            syslog(LOG_INFO,
+                   "[CAN:%zu] %s egress queue, depth %u",
+                   channel_index,
+                   queue_cfg.priority ? "priority" : "FIFO",
+                   queue_cfg.depth);
+        }
+        if (channel_cfg.tx_pacing.enabled) {
+            syslog(LOG_INFO,
+                   "[CAN:%zu] TX paced at %u bit/s, %u%% bus load, burst %u",
+                   channel_index,
+                   channel_cfg.bitrate,
+                   channel_cfg.tx_pacing.bus_load_percent,
+                   channel_cfg.tx_pacing.burst_frames);
+        }
+        if (channel_cfg.change_filter.enabled) {
+            syslog(LOG_INFO,
+                   "[CAN:%zu] change-only forwarding, refresh %u ms",
+                   channel_index,
+                   channel_cfg.change_filter.refresh_interval_ms);
+        }
+    }
+
+    sort_range_lookup(id_lookup_, id_lookup_count_);
+    std::sort(ifindex_channels_.begin(), ifindex_channels_.end());
+    return true;
+}
+
+void BridgeApp::close_retired(RetiredTables &retired) {
+    std::size_t channel_index = 0;
+    for (std::size_t port_index = 0; port_index < retired.port_count; ++port_index) {
+        const PortConfig &port_cfg = retired.config.ports[port_index];
+        for (const auto &channel_cfg : port_cfg.channels) {
+            if (channel_index >= retired.channel_count) {
+                break;
+            }
+            if (retired.can_fds[channel_index] >= 0) {
+                syslog(LOG_INFO, "[CAN] closing %s", channel_cfg.vcan_name.c_str());
+                io_.close_endpoint(retired.can_fds[channel_index]);
+                retired.can_fds[channel_index] = -1;
+            }
+            close_fd(retired.tx_timer_fds[channel_index]);
+            ++channel_index;
+        }
+        if (retired.udp_fds[port_index] >= 0) {
+            syslog(LOG_INFO, "[UDP] closing listen port %u", port_cfg.listen_port);
+            io_.close_endpoint(retired.udp_fds[port_index]);
+            retired.udp_fds[port_index] = -1;
+        }
+    }
+}
+
+std::size_t BridgeApp::RetiredTables::find_port(std::uint16_t listen_port) const {
+    for (std::size_t i = 0; i < port_count; ++i) {
+        if (config.ports[i].listen_port == listen_port) {
+            return i;
+        }
+    }
+    return kInvalidChannelIndex;
+}
+
+std::size_t BridgeApp::RetiredTables::find_channel(const std::string &vcan_name) const {
+    std::size_t index = 0;
+    for (const auto &port_cfg : config.ports) {
+        for (const auto &channel_cfg : port_cfg.channels) {
+            if (index < channel_count && channel_cfg.vcan_name == vcan_name) {
+                return index;
+            }
+            ++index;
+        }
+    }
+    return kInvalidChannelIndex;
+}
+
+bool BridgeApp::allocate_tables(std::size_t port_count, std::size_t channel_count) {
+    // One slot per UDP socket, CAN socket and (potential) TX timer, plus the
+    // signalfd, the control eventfd, the replay timer, the AF_XDP sockets, the
+    // shared CAN socket, the CAN ring, the CAN_BCM RX socket and the ISO-TP
+    // links.
+    std::size_t isotp_count = 0;
+    for (const auto &port_cfg : config_.ports) {
+        isotp_count += port_cfg.isotp.size();
+    }
+    event_capacity_ =
+        port_count + channel_count * 2 + 6 + (config_.xdp.enabled ? config_.xdp.queues : 0) + isotp_count;
+    const std::size_t bytes = Arena::bytes_for<int>(port_count) +
+                              Arena::bytes_for<sockaddr_in>(port_count) +
+                              Arena::bytes_for<PortWire>(port_count) +
+                              Arena::bytes_for<PortStats>(port_count) +
+                              Arena::bytes_for<SequenceTracker>(port_count) +
+                              Arena::bytes_for<std::uint32_t>(port_count) +
+                              Arena::bytes_for<int>(channel_count) +
+                              Arena::bytes_for<int>(channel_count) +
+                              Arena::bytes_for<std::uint32_t>(channel_count) +
+                              Arena::bytes_for<ChannelStats>(channel_count) +
+                              Arena::bytes_for<RangeLookup>(channel_count) +
+                              Arena::bytes_for<epoll_event>(event_capacity_) +
+                              Arena::bytes_for<std::uint8_t>(kUdpRxBufferSize) +
+                              Arena::bytes_for<const PortConfig *>(port_count) +
+                              Arena::bytes_for<const ChannelConfig *>(channel_count);
+    if (!arena_.reserve(bytes)) {
+        return false;
+    }
+
+    // Allocation order is layout order: the lookup path (ranges, channel
+    // ports, fds) sits together at the front, cold pointers at the back.
+    id_lookup_ = arena_.allocate<RangeLookup>(channel_count);
+    channel_ports_ = arena_.allocate<std::uint32_t>(channel_count);
+    can_fds_ = arena_.allocate<int>(channel_count);
+    tx_timer_fds_ = arena_.allocate<int>(channel_count);
+    udp_fds_ = arena_.allocate<int>(port_count);
+    remote_addrs_ = arena_.allocate<sockaddr_in>(port_count);
+    port_wire_ = arena_.allocate<PortWire>(port_count);
+    channel_stats_ = arena_.allocate<ChannelStats>(channel_count);
+    port_stats_ = arena_.allocate<PortStats>(port_count);
+    rx_sequences_ = arena_.allocate<SequenceTracker>(port_count);
+    tx_sequences_ = arena_.allocate<std::uint32_t>(port_count);
+    events_ = arena_.allocate<epoll_event>(event_capacity_);
+    rx_buffer_ = arena_.allocate<std::uint8_t>(kUdpRxBufferSize);
+    port_configs_ = arena_.allocate<const PortConfig *>(port_count);
+    channel_configs_ = arena_.allocate<const ChannelConfig *>(channel_count);
+    if (id_lookup_ == nullptr || channel_ports_ == nullptr || can_fds_ == nullptr || tx_timer_fds_ == nullptr ||
+        udp_fds_ == nullptr || port_wire_ == nullptr ||
+        remote_addrs_ == nullptr || channel_stats_ == nullptr || port_stats_ == nullptr || events_ == nullptr ||
+        rx_sequences_ == nullptr || tx_sequences_ == nullptr ||
+        rx_buffer_ == nullptr || port_configs_ == nullptr || channel_configs_ == nullptr) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < port_count; ++i) {
+        udp_fds_[i] = -1;
+    }
+    for (std::size_t i = 0; i < channel_count; ++i) {
+        can_fds_[i] = -1;
+        tx_timer_fds_[i] = -1;
+    }
+    return true;
+}
+
+void BridgeApp::run() {
+    if (epoll_fd_ < 0) {
+        return;
+    }
+
+    while (!stop_requested_.load()) {
+        if (!poll_once(-1)) {
+            break;
+        }
+    }
+}
+
+bool BridgeApp::poll_once(int timeout_ms) {
+    if (epoll_fd_ < 0) {
+        return false;
+    }
+
+    if (event_capacity_ == 0) {
+        return false;
+    }
+
+    const int ready = epoll_wait(epoll_fd_, events_, static_cast<int>(event_capacity_), timeout_ms);
+    if (ready < 0) {
+        if (errno == EINTR) {
+            return true;
+        }
+        log_errno("epoll_wait failed");
+        return false;
+    }
+
+    for (int i = 0; i < ready; ++i) {
+        const EventType type = decode_event_type(events_[i].data.u64);
+        const std::uint32_t index = decode_event_index(events_[i].data.u64);
+        switch (type) {
+        case EventType::Udp:
+            if (index < udp_port_count_) {
+                handle_udp_events(index);
+            }
+            break;
+        case EventType::Can:
+            if (index < channel_count_) {
+                if ((events_[i].events & EPOLLOUT) != 0U) {
+                    drain_can_egress(index);
+                }
+                if ((events_[i].events & EPOLLIN) != 0U) {
+                    handle_can_events(index);
+                }
+            }
+            break;
+        case EventType::Signal:
+            handle_signal_events();
+            break;
+        case EventType::Control:
+            handle_control_events();
+            break;
+        case EventType::CanTxTimer:
+            if (index < channel_count_) {
+                handle_tx_timer(index);
+            }
+            break;
+        case EventType::Replay:
+            handle_replay_timer();
+            break;
+        case EventType::Xdp:
+            if (index < xdp_.queue_count()) {
+                handle_xdp_events(index);
+            }
+            break;
+        case EventType::XdpRetry:
+            handle_xdp_retry_timer();
+            break;
+        case EventType::CanShared:
+            if ((events_[i].events & EPOLLOUT) != 0U) {
+                drain_shared_can_egress();
+            }
+            if ((events_[i].events & EPOLLIN) != 0U) {
+                handle_shared_can_events();
+            }
+            break;
+        case EventType::CanRing:
+            handle_can_ring_events();
+            break;
+        case EventType::CanBcm:
+            handle_bcm_rx_events();
+            break;
+        case EventType::IsoTp:
+            if (index < isotp_links_.size()) {
+                handle_isotp_events(index);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Tables are only swapped here, after the batch: events_ and every index
+    // handed out above belong to the running tables.
+    if (reload_pending_) {
+        reload_pending_ = false;
+        reload_from_file();
+        return epoll_fd_ >= 0;
+    }
+    return true;
+}
+
+// One timer per channel serves the pacer, the TX schedule and the ENOBUFS
+// back-off of the egress queue; each arms it for its own next deadline and
+// the earlier one wins.
+bool BridgeApp::configure_tx_timer(std::size_t channel_index) {
+    const ChannelConfig &channel_cfg = *channel_configs_[channel_index];
+    const TxPacingConfig &pacing = channel_cfg.tx_pacing;
+    TxPacer &pacer = tx_pacers_[channel_index];
+    if (pacing.enabled && !pacer.enabled() &&
+        !pacer.initialize(channel_cfg.bitrate, pacing.bus_load_percent, pacing.burst_frames)) {
+        syslog(LOG_ERR, "[CAN:%zu] invalid TX pacing parameters", channel_index);
+        return false;
+    }
+
+    const std::uint32_t index = static_cast<std::uint32_t>(channel_index);
+    if (tx_timer_fds_[channel_index] >= 0) {
+        // Timer kept across a reload; only its event tag changes.
+        if (!update_event(EventType::CanTxTimer, index, tx_timer_fds_[channel_index], EPOLLIN)) {
+            return false;
+        }
+    } else {
+        tx_timer_fds_[channel_index] = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (tx_timer_fds_[channel_index] < 0) {
+            log_errno("failed to create TX timer");
+            return false;
+        }
+        if (!register_event(EventType::CanTxTimer, index, tx_timer_fds_[channel_index])) {
+            return false;
+        }
+    }
+    if (pacing.enabled) {
+        pacing_active_ = true;
+    }
+    return true;
+}
+
+void BridgeApp::apply_socket_buffers(int fd,
+                                     const SocketBufferConfig &config,
+                                     SocketDrops &state,
+                                     const std::string &label) {
+    state.at_limit = false;
+    if ((config.rcvbuf != 0 || config.sndbuf != 0) &&
+        !io_.set_socket_buffers(fd, config.rcvbuf, config.sndbuf, config.force)) {
+        syslog(LOG_WARNING, "%s cannot size socket buffers: %s", label.c_str(), std::strerror(errno));
+    }
+}
+
+// Takes the drops a read reported since the socket's previous one and, with
+// adaptive sizing, doubles the receive buffer. Called only when the counter
+// moved, so the receive loops pay one comparison per read.
+std::uint32_t BridgeApp::account_socket_drops(int fd,
+                                              std::uint32_t counter,
+                                              SocketDrops &state,
+                                              const SocketBufferConfig &config,
+                                              bool filtered,
+                                              const std::string &label) {
+    const std::uint32_t dropped = counter - state.seen;
+    state.seen = counter;
+    SocketMemory memory{};
+    if (!config.adaptive || state.at_limit || !io_.socket_memory(fd, memory)) {
+        return dropped;
+    }
+    // Datagrams udp_filter rejects are counted as drops as well; there only a
+    // queue that is still half full shows that the buffer was too small.
+    if (filtered && std::uint64_t{memory.receive_queued} * 2 < memory.receive_buffer) {
+        return dropped;
+    }
+    // The kernel doubles the size it is given, so asking for the current
+    // size doubles the buffer.
+    const std::uint32_t request = std::min(memory.receive_buffer, config.max_rcvbuf);
+    SocketMemory grown{};
+    if (request > memory.receive_buffer / 2 && io_.set_socket_buffers(fd, request, 0, config.force) &&
+        io_.socket_memory(fd, grown) && grown.receive_buffer > memory.receive_buffer) {
+        syslog(LOG_INFO,
+               "%s %u dropped, receive buffer grown to %u bytes",
+               label.c_str(),
+               dropped,
+               grown.receive_buffer);
+    } else {
+        state.at_limit = true;
+        syslog(LOG_WARNING,
+               "%s %u dropped, receive buffer stays at %u bytes (max_rcvbuf, or rmem_max without force)",
+               label.c_str(),
+               dropped,
+               memory.receive_buffer);
+    }
+    return dropped;
+}
+
+bool BridgeApp::setup_can_interfaces(const BridgeConfig &config) {
+    std::vector<CanLinkSpec> specs;
+    for (const auto &port_cfg : config.ports) {
+        for (const auto &channel_cfg : port_cfg.channels) {
+            CanLinkSpec spec;
+            spec.name = channel_cfg.vcan_name;
+            spec.bitrate = channel_cfg.bitrate;
+            spec.txqueuelen = channel_cfg.txqueuelen;
+            specs.push_back(std::move(spec));
+        }
+    }
+    std::string error_message;
+    if (!io_.setup_can_interfaces(specs, error_message)) {
+        syslog(LOG_ERR, "CAN interface setup failed: %s", error_message.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool BridgeApp::prepare_can_interface(const ChannelConfig &config) const {
+    if (!io_.interface_exists(config.vcan_name)) {
+        syslog(LOG_ERR, "required CAN interface %s not found", config.vcan_name.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool BridgeApp::open_signal_fd() {
+    sigset_t mask;
+    sigemptyset(&mask);
+    if (!config_path_.empty()) {
+        sigaddset(&mask, SIGHUP);
+    }
+    if (handle_stop_signals_) {
+        sigaddset(&mask, SIGINT);
+        sigaddset(&mask, SIGTERM);
+    }
+    // signalfd only sees signals that are blocked from normal delivery.
+    if (sigprocmask(SIG_BLOCK, &mask, nullptr) < 0) {
+        log_errno("failed to block signals");
+        return false;
+    }
+    signal_fd_ = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd_ < 0) {
+        log_errno("failed to create signalfd");
+        return false;
+    }
+    return register_event(EventType::Signal, 0, signal_fd_);
+}
+
+void BridgeApp::handle_signal_events() {
+    signalfd_siginfo info{};
+    while (read(signal_fd_, &info, sizeof(info)) == static_cast<ssize_t>(sizeof(info))) {
+        if (info.ssi_signo == SIGHUP) {
+            reload_pending_ = true;
+        } else if (info.ssi_signo == SIGINT || info.ssi_signo == SIGTERM) {
+            syslog(LOG_INFO, "received signal %u, stopping", info.ssi_signo);
+            stop_requested_.store(true);
+        }
+    }
+}
+
+bool BridgeApp::open_control_fd() {
+    control_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (control_fd_ < 0) {
+        log_errno("failed to create control eventfd");
+        return false;
+    }
+    return register_event(EventType::Control, 0, control_fd_);
+}
+
+void BridgeApp::handle_control_events() {
+    std::uint64_t count = 0;
+    if (read(control_fd_, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        log_errno("read from control eventfd failed");
+    }
+    if (reload_requested_.exchange(false)) {
+        if (config_path_.empty()) {
+            syslog(LOG_WARNING, "reload requested but no config path is set");
+        } else {
+            reload_pending_ = true;
+        }
+    }
+}
+
+void BridgeApp::request_stop() {
+    stop_requested_.store(true);
+    const std::uint64_t one = 1;
+    if (control_fd_ >= 0) {
+        // write(2) is async-signal-safe; a full counter still leaves the fd readable.
+        (void)write(control_fd_, &one, sizeof(one));
+    }
+}
+
+void BridgeApp::request_reload() {
+    reload_requested_.store(true);
+    const std::uint64_t one = 1;
+    if (control_fd_ >= 0) {
+        (void)write(control_fd_, &one, sizeof(one));
+    }
+}
+
+void BridgeApp::reload_from_file() {
+    BridgeConfig next{};
+    std::string error_message;
+    if (!load_bridge_config(config_path_, next, error_message)) {
+        syslog(LOG_ERR, "reload of %s rejected: %s", config_path_.c_str(), error_message.c_str());
+        return;
+    }
+    if (!apply_config(std::move(next))) {
+        syslog(LOG_ERR, "reload of %s failed, keeping previous configuration", config_path_.c_str());
+        return;
+    }
+    syslog(LOG_INFO, "reloaded %s: %zu ports, %zu channels", config_path_.c_str(), udp_port_count_, channel_count_);
+}
+
+bool BridgeApp::register_event(EventType type, std::uint32_t index, int fd) {
+    if (epoll_fd_ < 0 || fd < 0) {
+        return false;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = make_event_tag(type, index);
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+        log_errno("failed to register fd with epoll");
+        return false;
+    }
+    return true;
+}
+
+bool BridgeApp::update_event(EventType type, std::uint32_t index, int fd, std::uint32_t events) {
+    if (epoll_fd_ < 0 || fd < 0) {
+        return false;
+    }
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = make_event_tag(type, index);
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) < 0) {
+        log_errno("failed to update epoll registration");
+        return false;
+    }
+    return true;
+}
+
+void BridgeApp::shutdown() {
+    for (std::size_t i = 0; i < channel_count_; ++i) {
+        if (can_fds_[i] >= 0) {
+            io_.close_endpoint(can_fds_[i]);
+            can_fds_[i] = -1;
+        }
+        close_fd(tx_timer_fds_[i]);
+    }
+    for (std::size_t i = 0; i < udp_port_count_; ++i) {
+        if (udp_fds_[i] >= 0) {
+            io_.close_endpoint(udp_fds_[i]);
+            udp_fds_[i] = -1;
+        }
+    }
+    if (shared_can_fd_ >= 0) {
+        io_.close_endpoint(shared_can_fd_);
+        shared_can_fd_ = -1;
+    }
+    if (bcm_fd_ >= 0) {
+        io_.close_endpoint(bcm_fd_);
+        bcm_fd_ = -1;
+    }
+    cyclic_jobs_.clear();
+    if (bcm_rx_fd_ >= 0) {
+        io_.close_endpoint(bcm_rx_fd_);
+        bcm_rx_fd_ = -1;
+    }
+    bcm_rx_ops_.clear();
+    bcm_rx_channels_.clear();
+    for (const IsoTpLink &link : isotp_links_) {
+        if (link.fd >= 0) {
+            io_.close_endpoint(link.fd);
+        }
+    }
+    isotp_links_.clear();
+    close_fd(signal_fd_);
+    close_fd(control_fd_);
+    close_fd(epoll_fd_);
+    reload_pending_ = false;
+    udp_port_count_ = 0;
+    channel_count_ = 0;
+    id_lookup_count_ = 0;
+    event_capacity_ = 0;
+    pacing_active_ = false;
+    capture_.close();
+    stop_replay();
+    close_fd(replay_timer_fd_);
+    close_fd(xdp_retry_timer_fd_);
+    xdp_retries_ = 0;
+    xdp_.close();
+    can_ring_.close();
+}
+
+void BridgeApp::handle_udp_events(std::size_t port_index) {
+    if (port_index >= udp_port_count_) {
+        return;
+    }
+
+    const int udp_fd = udp_fds_[port_index];
+    PortStats &port_stats = port_stats_[port_index];
+    const PortWire wire = port_wire_[port_index];
+    const bool rate_limited = rate_limiter_.active(FlowDirection::UdpToCan);
+    const std::uint64_t now_ns = (rate_limited || pacing_active_ || wire.scheduled_tx) ? monotonic_ns() : 0;
+    // Requested TX times are wall clock; convert to the monotonic timer base
+    // with one offset per drain.
+    const std::uint64_t wall_now_ns = wire.scheduled_tx ? realtime_ns() : 0;
+    SocketDrops &drops = udp_drops_[port_index];
+    while (true) {
+        std::size_t segment_size = 0;
+        std::uint32_t drop_counter = 0;
+        const ssize_t received = io_.udp_recv(udp_fd, rx_buffer_, kUdpRxBufferSize, segment_size, drop_counter);
+        if (received < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            log_errno("recv from UDP failed");
+            break;
+        }
+        if (drop_counter != drops.seen) {
+            port_stats.udp_rx_socket_drops += account_socket_drops(udp_fd,
+                                                                   drop_counter,
+                                                                   drops,
+                                                                   port_configs_[port_index]->socket_buffers,
+                                                                   config_.udp_filter.enabled,
+                                                                   "[UDP:" + std::to_string(port_index) + "]");
+        }
+        if (received == 0) {
+            break;
+        }
+
+        // A GRO read carries several datagrams back to back; each keeps its
+        // own boundary for the header and length checks.
+        const std::size_t length = static_cast<std::size_t>(received);
+        if (segment_size == 0) {
+            handle_udp_datagram(port_index, rx_buffer_, length, now_ns, wall_now_ns);
+            continue;
+        }
+        ++port_stats.udp_rx_coalesced;
+        for (std::size_t offset = 0; offset < length; offset += segment_size) {
+            handle_udp_datagram(
+                port_index, rx_buffer_ + offset, std::min(segment_size, length - offset), now_ns, wall_now_ns);
+        }
+    }
+}
+
+void BridgeApp::handle_udp_datagram(std::size_t port_index,
+                                    const std::uint8_t *datagram,
+                                    std::size_t length,
+                                    std::uint64_t now_ns,
+                                    std::uint64_t wall_now_ns) {
+    PortStats &port_stats = port_stats_[port_index];
+    const PortWire wire = port_wire_[port_index];
+    const std::size_t step = wire.frame_size;
+    const bool timestamped = wire.format == FrameFormat::Timestamped;
+    const bool rate_limited = rate_limiter_.active(FlowDirection::UdpToCan);
+    ++port_stats.udp_rx_datagrams;
+
+    std::size_t offset = 0;
+    if (wire.sequenced) {
+        if (!accept_datagram_header(port_index, datagram, length)) {
+            return;
+        }
+        offset = kSequenceHeaderSize;
+    }
+
+    if ((length - offset) % step != 0) {
+        ++port_stats.udp_rx_malformed;
+        syslog(LOG_WARNING, "[UDP:%zu] payload length %zu not multiple of %zu", port_index, length - offset, step);
+    }
+
+    while (offset + step <= length) {
+        struct can_frame frame{};
+        std::uint64_t tx_time_ns = 0;
+        const bool decoded = timestamped ? decode_timestamped_frame(datagram + offset, frame, tx_time_ns)
+                                         : decode_udp_frame(datagram + offset, frame);
+        if (!decoded) {
+            if (datagram[offset] == kControlInfo &&
+                datagram[offset + 1] == static_cast<std::uint8_t>(ControlOpcode::IsoTpPdu)) {
+                // The payload runs to the end of the datagram.
+                handle_isotp_pdu(port_index, datagram + offset, length - offset);
+                return;
+            }
+            if (datagram[offset] == kControlInfo && offset + kControlSlots * step <= length) {
+                handle_control_record(port_index, datagram + offset);
+                offset += kControlSlots * step;
+                continue;
+            }
+            ++port_stats.udp_rx_malformed;
+            syslog(LOG_WARNING, "[UDP:%zu] failed to decode frame at offset %zu", port_index, offset);
+            offset += step;
+            continue;
+        }
+        ++port_stats.udp_rx_frames;
+
+        const std::uint32_t can_id = extract_identifier(frame);
+        if (rate_limited && !rate_limiter_.allow(FlowDirection::UdpToCan, can_id, now_ns)) {
+            ++port_stats.udp_rx_rate_limited;
+            offset += step;
+            continue;
+        }
+
+        const std::size_t channel_index = route_udp_frame(port_index, can_id);
+        if (channel_index == kInvalidChannelIndex) {
+            offset += step;
+            continue;
+        }
+
+        ChannelStats &channel_stats = channel_stats_[channel_index];
+        if (wire.scheduled_tx && tx_time_ns > wall_now_ns) {
+            schedule_can_frame(channel_index, frame, now_ns + (tx_time_ns - wall_now_ns), now_ns);
+            offset += step;
+            continue;
+        }
+
+        if (egress_queues_[channel_index].enabled()) {
+            enqueue_can_frame(channel_index, frame, now_ns);
+            offset += step;
+            continue;
+        }
+
+        const ssize_t written = can_write(channel_index, frame);
+        if (written < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                log_errno("write to CAN failed");
+            }
+            // The rest of this datagram is dropped; count it against the channel.
+            channel_stats.can_tx_dropped += (length - offset) / step;
+            return;
+        }
+        ++channel_stats.can_tx_frames;
+        if (capture_.enabled()) {
+            capture_frame(CaptureDirection::UdpToCan, channel_index, frame);
+        }
+        offset += step;
+    }
+}
+
+// The channel this port's frames with `can_id` go to. kInvalidChannelIndex,
+// counted as unroutable, when no channel covers the ID or it belongs to
+// another port.
+std::size_t BridgeApp::route_udp_frame(std::size_t port_index, std::uint32_t can_id) {
+    const std::size_t channel_index = find_channel_for_can_id(id_lookup_, id_lookup_count_, can_id);
+    if (channel_index == kInvalidChannelIndex) {
+        ++port_stats_[port_index].udp_rx_unroutable;
+        syslog(LOG_WARNING,
+               "[UDP:%zu] no channel mapping for CAN id 0x%08X",
+               port_index,
+               static_cast<unsigned int>(can_id));
+        return kInvalidChannelIndex;
+    }
+    if (channel_ports_[channel_index] != port_index) {
+        ++port_stats_[port_index].udp_rx_unroutable;
+        syslog(LOG_WARNING,
+               "[UDP:%zu] channel %zu belongs to port %u for CAN id 0x%08X",
+               port_index,
+               channel_index,
+               channel_ports_[channel_index],
+               static_cast<unsigned int>(can_id));
+        return kInvalidChannelIndex;
+    }
+    return channel_index;
+}
+
+// A control record and the frame it applies to, the kControlSlots slots at
+// `slots`. Cyclic frames are sent by the kernel: they bypass rate limits,
+// pacing, the egress queue and capture.
+void BridgeApp::handle_control_record(std::size_t port_index, const std::uint8_t *slots) {
+    PortStats &port_stats = port_stats_[port_index];
+    const PortWire wire = port_wire_[port_index];
+    const std::uint8_t *frame_slot = slots + wire.frame_size;
+    ControlRecord record{};
+    struct can_frame frame{};
+    std::uint64_t ignored_ns = 0;
+    const bool decoded = decode_control_record(slots, record) &&
+                         (wire.format == FrameFormat::Timestamped ? decode_timestamped_frame(frame_slot, frame, ignored_ns)
+                                                                  : decode_udp_frame(frame_slot, frame));
+    if (!decoded) {
+        ++port_stats.udp_rx_malformed;
+        syslog(LOG_WARNING, "[UDP:%zu] failed to decode control record (opcode %u)", port_index, slots[1]);
+        return;
+    }
+    if (bcm_fd_ < 0) {
+        ++port_stats.udp_rx_control_rejected;
+        syslog(LOG_WARNING, "[UDP:%zu] control record refused: cyclic_tx is not active", port_index);
+        return;
+    }
+    const std::size_t channel_index = route_udp_frame(port_index, extract_identifier(frame));
+    if (channel_index == kInvalidChannelIndex) {
+        return;
+    }
+    const int ifindex = can_ifindexes_[channel_index];
+    const std::pair<int, canid_t> key{ifindex, frame.can_id};
+    const auto job = std::find(cyclic_jobs_.begin(), cyclic_jobs_.end(), key);
+
+    if (record.opcode == ControlOpcode::CyclicStop) {
+        if (job == cyclic_jobs_.end()) {
+            ++port_stats.udp_rx_control_rejected;
+            syslog(LOG_WARNING,
+                   "[UDP:%zu] no cyclic frame 0x%08X to stop",
+                   port_index,
+                   static_cast<unsigned int>(frame.can_id));
+            return;
+        }
+        if (!io_.can_bcm_send(bcm_fd_, ifindex, bcm_head(TX_DELETE, frame.can_id, 0), nullptr)) {
+            log_errno("CAN_BCM TX_DELETE failed");
+        }
+        cyclic_jobs_.erase(job);
+        ++port_stats.udp_rx_control;
+        return;
+    }
+
+    if (record.period_us < config_.cyclic_tx.min_period_us) {
+        ++port_stats.udp_rx_control_rejected;
+        syslog(LOG_WARNING,
+               "[UDP:%zu] cyclic frame 0x%08X period %u us below min_period_us %u",
+               port_index,
+               static_cast<unsigned int>(frame.can_id),
+               record.period_us,
+               config_.cyclic_tx.min_period_us);
+        return;
+    }
+    if (job == cyclic_jobs_.end() && cyclic_jobs_.size() >= config_.cyclic_tx.max_jobs) {
+        ++port_stats.udp_rx_control_rejected;
+        syslog(LOG_WARNING,
+               "[UDP:%zu] cyclic frame 0x%08X refused: %u jobs running",
+               port_index,
+               static_cast<unsigned int>(frame.can_id),
+               config_.cyclic_tx.max_jobs);
+        return;
+    }
+    // Replaces the frame and period of a running job; TX_ANNOUNCE sends the
+    // first copy right away.
+    bcm_msg_head head = bcm_head(TX_SETUP, frame.can_id, record.period_us);
+    head.flags = SETTIMER | STARTTIMER | TX_ANNOUNCE;
+    head.nframes = 1;
+    if (!io_.can_bcm_send(bcm_fd_, ifindex, head, &frame)) {
+        ++port_stats.udp_rx_control_rejected;
+        log_errno("CAN_BCM TX_SETUP failed");
+        return;
+    }
+    if (job == cyclic_jobs_.end()) {
+        cyclic_jobs_.push_back(key);
+    }
+    ++port_stats.udp_rx_control;
+}
+
+// A PDU record and the payload behind it, `available` bytes from
+// `record_slot` to the end of the datagram. Like cyclic frames, PDUs are
+// segmented by the kernel and bypass rate limits, pacing and capture.
+void BridgeApp::handle_isotp_pdu(std::size_t port_index, const std::uint8_t *record_slot, std::size_t available) {
+    PortStats &port_stats = port_stats_[port_index];
+    const std::size_t step = port_wire_[port_index].frame_size;
+    ControlRecord record{};
+    if (!decode_control_record(record_slot, record) || record.length == 0 || record.length > kMaxIsoTpPdu ||
+        record.length > available - step) {
+        ++port_stats.udp_rx_malformed;
+        syslog(LOG_WARNING,
+               "[UDP:%zu] ISO-TP PDU of %u bytes does not fit %zu",
+               port_index,
+               static_cast<unsigned int>(record.length),
+               available - step);
+        return;
+    }
+    const auto link = std::find_if(isotp_links_.begin(), isotp_links_.end(), [&](const IsoTpLink &candidate) {
+        return candidate.port_index == port_index && candidate.config.tx_id == record.can_id;
+    });
+    if (link == isotp_links_.end()) {
+        ++port_stats.udp_rx_unroutable;
+        syslog(LOG_WARNING,
+               "[UDP:%zu] no ISO-TP link for CAN id 0x%08X",
+               port_index,
+               static_cast<unsigned int>(record.can_id));
+        return;
+    }
+    if (link->fd < 0 || io_.isotp_send(link->fd, record_slot + step, record.length) < 0) {
+        if (link->fd >= 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            log_errno("write to CAN_ISOTP failed");
+        }
+        ++link->stats.can_tx_dropped;
+        return;
+    }
+    ++link->stats.can_tx_pdus;
+    link->stats.can_tx_bytes += record.length;
+}
+
+// Each received PDU leaves in one datagram of its own, built in rx_buffer_
+// around the payload the socket wrote there.
+void BridgeApp::handle_isotp_events(std::size_t link_index) {
+    IsoTpLink &link = isotp_links_[link_index];
+    const std::size_t port_index = link.port_index;
+    const PortWire wire = port_wire_[port_index];
+    const std::size_t step = wire.frame_size;
+    const std::size_t header_size = wire.sequenced ? kSequenceHeaderSize : 0;
+    std::uint8_t *const record_slot = rx_buffer_ + header_size;
+    std::uint8_t *const payload = record_slot + step;
+    while (true) {
+        const ssize_t received = io_.isotp_recv(link.fd, payload, kMaxIsoTpPdu);
+        if (received < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ++link.stats.can_rx_errors;
+                log_errno("ISO-TP reception failed");
+            }
+            break;
+        }
+        if (received == 0) {
+            // No PDU to carry; the record would be malformed at the far end.
+            continue;
+        }
+        const std::size_t length = static_cast<std::size_t>(received);
+        const std::size_t slots = 1 + (length + step - 1) / step;
+        std::memset(payload + length, 0, (slots - 1) * step - length);
+        std::memset(record_slot, 0, step);
+        ControlRecord record{ControlOpcode::IsoTpPdu};
+        record.can_id = link.config.rx_id;
+        record.length = static_cast<std::uint16_t>(length);
+        encode_control_record(record, record_slot);
+        if (wire.sequenced) {
+            encode_datagram_header(
+                DatagramHeader{tx_sequences_[port_index]++, static_cast<std::uint16_t>(slots)}, rx_buffer_);
+        }
+        const std::size_t datagram_size = header_size + slots * step;
+        if (io_.udp_send(udp_fds_[port_index], rx_buffer_, datagram_size, remote_addrs_[port_index]) < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                log_errno("send UDP failed");
+            }
+            ++port_stats_[port_index].udp_tx_dropped;
+            continue;
+        }
+        ++link.stats.can_rx_pdus;
+        link.stats.can_rx_bytes += length;
+    }
+}
+
+// Datagrams the XDP program redirected, straight out of the UMEM. The
+// program only matches configured ports, so a miss here is a frame too short
+// for what its headers claim.
+void BridgeApp::handle_xdp_events(std::size_t queue) {
+    const std::uint64_t now_ns = monotonic_ns();
+    const std::uint64_t wall_now_ns = realtime_ns();
+    while (true) {
+        const std::size_t count = xdp_.receive(queue, xdp_packets_.data(), xdp_packets_.size());
+        if (count == 0) {
+            break;
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            const XdpPacket &packet = xdp_packets_[i];
+            const auto it = std::lower_bound(xdp_ports_.begin(),
+                                             xdp_ports_.end(),
+                                             packet.dst_port,
+                                             [](const std::pair<std::uint16_t, std::uint32_t> &entry,
+                                                std::uint16_t port) { return entry.first < port; });
+            if (packet.payload == nullptr || it == xdp_ports_.end() || it->first != packet.dst_port) {
+                continue;
+            }
+            ++port_stats_[it->second].udp_rx_xdp;
+            handle_udp_datagram(it->second, packet.payload, packet.length, now_ns, wall_now_ns);
+        }
+        xdp_.release(queue);
+    }
+}
+
+// Sequence accounting for one datagram. Returns false when the datagram must
+// not be forwarded: too short for a header, or a duplicate. A frame count that
+// disagrees with the length is reported but the whole frames present are
+// still forwarded, as for any other malformed payload.
+bool BridgeApp::accept_datagram_header(std::size_t port_index, const std::uint8_t *datagram, std::size_t length) {
+    PortStats &port_stats = port_stats_[port_index];
+    DatagramHeader header{};
+    if (length < kSequenceHeaderSize || !decode_datagram_header(datagram, header)) {
+        ++port_stats.udp_rx_malformed;
+        syslog(LOG_WARNING, "[UDP:%zu] datagram of %zu bytes has no sequence header", port_index, length);
+        return false;
+    }
+
+    const std::size_t frames = (length - kSequenceHeaderSize) / port_wire_[port_index].frame_size;
+    if (frames != header.frame_count) {
+        ++port_stats.udp_rx_malformed;
+        syslog(LOG_WARNING,
+               "[UDP:%zu] sequence %u announces %u frames, carries %zu",
+               port_index,
+               header.sequence,
+               static_cast<unsigned int>(header.frame_count),
+               frames);
+    }
+
+    std::uint32_t gap = 0;
+    switch (rx_sequences_[port_index].observe(header.sequence, gap)) {
+    case SequenceTracker::Verdict::Gap:
+        port_stats.udp_rx_seq_lost += gap;
+        break;
+    case SequenceTracker::Verdict::Late:
+        ++port_stats.udp_rx_seq_reordered;
+        if (port_stats.udp_rx_seq_lost != 0) {
+            --port_stats.udp_rx_seq_lost;
+        }
+        break;
+    case SequenceTracker::Verdict::Duplicate:
+        ++port_stats.udp_rx_seq_duplicates;
+        return false;
+    case SequenceTracker::Verdict::Restart:
+        syslog(LOG_INFO, "[UDP:%zu] peer restarted its sequence at %u", port_index, header.sequence);
+        break;
+    case SequenceTracker::Verdict::First:
+    case SequenceTracker::Verdict::InOrder:
+        break;
+    }
+    return true;
+}
 
 void BridgeApp::handle_can_events(std::size_t channel_index) {
     if (channel_index >= channel_count_) {
         return;
     }
 
-    ChannelContext &channel = channels_[channel_index];
-    UdpPortContext &port = udp_ports_[channel.port_index];
+    const int can_fd = can_fds_[channel_index];
+    ChannelStats &channel_stats = channel_stats_[channel_index];
+    const bool rate_limited = rate_limiter_.active(FlowDirection::CanToUdp);
+    // One clock read per drain is plenty for millisecond intervals.
+    const std::uint64_t now_ns = (value_caches_[channel_index].enabled() || rate_limited) ? monotonic_ns() : 0;
+    const bool timestamped = port_wire_[channel_ports_[channel_index]].format == FrameFormat::Timestamped;
+    SocketDrops &drops = can_drops_[channel_index];
 
     while (true) {
         struct can_frame frame{};
-        const ssize_t bytes = read(channel.can_fd, &frame, sizeof(frame));
+        std::uint64_t rx_time_ns = 0;
+        std::uint32_t drop_counter = 0;
+        const ssize_t bytes = timestamped ? io_.can_read_timestamped(can_fd, frame, rx_time_ns, drop_counter)
+                                          : io_.can_read(can_fd, frame, drop_counter);
         if (bytes < 0) {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 break;
@@ -411,6 +2218,14 @@ void BridgeApp::handle_can_events(std::size_t channel_index) {
             log_errno("read from CAN failed");
             break;
         }
+        if (drop_counter != drops.seen) {
+            channel_stats.can_rx_socket_drops += account_socket_drops(can_fd,
+                                                                      drop_counter,
+                                                                      drops,
+                                                                      channel_configs_[channel_index]->socket_buffers,
+                                                                      false,
+                                                                      "[CAN:" + std::to_string(channel_index) + "]");
+        }
         if (bytes == 0) {
             break;
         }
@@ -418,59 +2233,440 @@ void BridgeApp::handle_can_events(std::size_t channel_index) {
             syslog(LOG_WARNING, "[CAN:%zu] unexpected frame length %zd", channel_index, bytes);
             continue;
         }
+        ++channel_stats.can_rx_frames;
+        if (!forward_can_frame(channel_index, frame, rx_time_ns, now_ns)) {
+            break;
+        }
+    }
+    flush_udp_tx();
+}
 
-        if (!encode_udp_frame(frame, tx_buffer_.data())) {
-            syslog(LOG_WARNING, "[CAN:%zu] failed to encode CAN frame", channel_index);
-            continue;
+// All channels behind the shared socket, demultiplexed by the interface each
+// frame arrived on. Frames from interfaces without a channel are dropped.
+void BridgeApp::handle_shared_can_events() {
+    const std::uint64_t now_ns = monotonic_ns();
+    while (true) {
+        const ssize_t count = io_.can_read_batch(shared_can_fd_, can_rx_batch_.data(), can_rx_batch_.size());
+        if (count < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                log_errno("read from shared CAN socket failed");
+            }
+            break;
+        }
+        for (ssize_t i = 0; i < count; ++i) {
+            const CanRxFrame &received = can_rx_batch_[static_cast<std::size_t>(i)];
+            if (received.drops != shared_can_drops_.seen) {
+                shared_can_socket_drops_ += account_socket_drops(
+                    shared_can_fd_, received.drops, shared_can_drops_, config_.socket_buffers, false, "[CAN]");
+            }
+            const std::size_t channel_index = channel_for_ifindex(received.ifindex);
+            if (channel_index == kInvalidChannelIndex) {
+                continue;
+            }
+            ++channel_stats_[channel_index].can_rx_frames;
+            // A refused UDP batch only concerns its own port; keep going.
+            forward_can_frame(channel_index, received.frame, received.timestamp_ns, now_ns);
+        }
+        if (static_cast<std::size_t>(count) < can_rx_batch_.size()) {
+            break;
+        }
+    }
+    flush_udp_tx();
+}
+
+// Frames of all channels straight out of the ring blocks. Loopback copies of
+// our own writes are recognised and dropped, as a CAN_RAW socket would.
+void BridgeApp::handle_can_ring_events() {
+    const std::uint64_t now_ns = monotonic_ns();
+    while (true) {
+        const std::size_t count = can_ring_.receive(can_ring_frames_.data(), can_ring_frames_.size());
+        if (count == 0) {
+            break;
         }
+        for (std::size_t i = 0; i < count; ++i) {
+            const CanRingFrame &received = can_ring_frames_[i];
+            const std::size_t channel_index = channel_for_ifindex(received.ifindex);
+            if (channel_index == kInvalidChannelIndex ||
+                tx_echoes_[channel_index].consume(*received.frame, now_ns)) {
+                continue;
+            }
+            ++channel_stats_[channel_index].can_rx_frames;
+            forward_can_frame(channel_index, *received.frame, received.timestamp_ns, now_ns);
+        }
+        can_ring_.release();
+    }
+    flush_udp_tx();
+}
 
-        const ssize_t sent = sendto(port.udp_fd,
-                                    tx_buffer_.data(),
-                                    kUdpFrameSize,
-                                    0,
-                                    reinterpret_cast<const sockaddr *>(&port.remote_addr),
-                                    sizeof(port.remote_addr));
-        if (sent < 0) {
+// Changed (or throttled) frames of the bcm_rx channels. The subscriptions
+// also see the loopback copies of our own writes; those expect_bcm_echo()
+// recorded are dropped like on the CAN ring.
+void BridgeApp::handle_bcm_rx_events() {
+    const std::uint64_t now_ns = monotonic_ns();
+    while (true) {
+        const ssize_t count = io_.can_bcm_read_batch(bcm_rx_fd_, can_rx_batch_.data(), can_rx_batch_.size());
+        if (count < 0) {
             if (errno != EAGAIN && errno != EWOULDBLOCK) {
-                log_errno("send UDP failed");
+                log_errno("read from CAN_BCM socket failed");
+            }
+            break;
+        }
+        for (ssize_t i = 0; i < count; ++i) {
+            const CanRxFrame &received = can_rx_batch_[static_cast<std::size_t>(i)];
+            if (received.drops != bcm_rx_drops_.seen) {
+                bcm_rx_socket_drops_ += account_socket_drops(
+                    bcm_rx_fd_, received.drops, bcm_rx_drops_, config_.socket_buffers, false, "[BCM]");
+            }
+            const std::size_t channel_index = channel_for_ifindex(received.ifindex);
+            if (channel_index == kInvalidChannelIndex || bcm_rx_channels_[channel_index] == 0U) {
+                continue;
             }
+            if (BcmRxOp *op = find_bcm_rx_op(received.ifindex, received.frame.can_id)) {
+                op->last = received.frame;
+                op->seen = true;
+            }
+            if (tx_echoes_[channel_index].consume(received.frame, now_ns)) {
+                continue;
+            }
+            ++channel_stats_[channel_index].can_rx_frames;
+            forward_can_frame(channel_index, received.frame, received.timestamp_ns, now_ns);
+        }
+        if (static_cast<std::size_t>(count) < can_rx_batch_.size()) {
             break;
         }
     }
+    flush_udp_tx();
 }
 
-std::size_t BridgeApp::find_channel_for_can_id(std::uint32_t can_id) const {
-    if (id_lookup_count_ == 0) {
-        return kInvalidChannelIndex;
+std::size_t BridgeApp::channel_for_ifindex(int ifindex) const {
+    const auto match = std::lower_bound(
+        ifindex_channels_.begin(), ifindex_channels_.end(), std::make_pair(ifindex, std::uint32_t{0}));
+    return match != ifindex_channels_.end() && match->first == ifindex ? match->second : kInvalidChannelIndex;
+}
+
+void BridgeApp::drain_shared_can_egress() {
+    for (std::size_t channel_index = 0; channel_index < channel_count_; ++channel_index) {
+        if (can_tx_blocked_[channel_index] != 0U) {
+            drain_can_egress(channel_index);
+        }
+    }
+}
+
+// Filters one received CAN frame and stages its datagram for flush_udp_tx().
+// Returns false when the frame's own UDP socket refused the full batch ahead
+// of it, which ends the drain; the frame is then dropped with it. A refused
+// batch of another port is counted there and staging goes on.
+bool BridgeApp::forward_can_frame(std::size_t channel_index,
+                                  const struct can_frame &frame,
+                                  std::uint64_t rx_time_ns,
+                                  std::uint64_t now_ns) {
+    const std::uint32_t port_index = channel_ports_[channel_index];
+    ChannelStats &channel_stats = channel_stats_[channel_index];
+    PortStats &port_stats = port_stats_[port_index];
+    LastValueCache &value_cache = value_caches_[channel_index];
+    const PortWire wire = port_wire_[port_index];
+    const std::size_t header_size = wire.sequenced ? kSequenceHeaderSize : 0;
+
+    if (value_cache.enabled() && !value_cache.should_forward(frame, now_ns)) {
+        ++channel_stats.can_rx_suppressed;
+        return true;
+    }
+
+    if (rate_limiter_.active(FlowDirection::CanToUdp) &&
+        !rate_limiter_.allow(FlowDirection::CanToUdp, extract_identifier(frame), now_ns)) {
+        ++channel_stats.can_rx_rate_limited;
+        return true;
+    }
+
+    // A batch holds datagrams for one port only, all of the same size.
+    if (tx_staged_count_ != 0 && (tx_staged_port_ != port_index || tx_staged_count_ == kMaxTxSegments)) {
+        const bool same_port = tx_staged_port_ == port_index;
+        if (!flush_udp_tx() && same_port) {
+            ++port_stats.udp_tx_dropped;
+            return false;
+        }
+    }
+
+    const std::size_t datagram_size = header_size + wire.frame_size;
+    std::uint8_t *const datagram = tx_buffer_.data() + tx_staged_count_ * datagram_size;
+    std::uint8_t *const payload = datagram + header_size;
+    const bool encoded = wire.format == FrameFormat::Timestamped ? encode_timestamped_frame(frame, rx_time_ns, payload)
+                                                                 : encode_udp_frame(frame, payload);
+    if (!encoded) {
+        syslog(LOG_WARNING, "[CAN:%zu] failed to encode CAN frame", channel_index);
+        return true;
+    }
+    if (wire.sequenced) {
+        // The sequence advances even when the send fails, so the peer sees
+        // the local drop as a gap.
+        encode_datagram_header(DatagramHeader{tx_sequences_[port_index]++, 1}, datagram);
+    }
+    tx_staged_[tx_staged_count_++] = StagedFrame{static_cast<std::uint32_t>(channel_index), frame};
+    tx_staged_port_ = port_index;
+    return true;
+}
+
+// Sends the staged datagrams with one call; the kernel splits the buffer back
+// into one datagram per frame (UDP GSO), so the wire format is unchanged.
+// Returns false when the socket refused the batch; the refused frames are
+// counted against the batch's port and the staging area is empty either way.
+bool BridgeApp::flush_udp_tx() {
+    const std::size_t count = tx_staged_count_;
+    if (count == 0) {
+        return true;
+    }
+    tx_staged_count_ = 0;
+    const std::uint32_t port_index = tx_staged_port_;
+    const PortWire wire = port_wire_[port_index];
+    PortStats &port_stats = port_stats_[port_index];
+    const std::size_t datagram_size = (wire.sequenced ? kSequenceHeaderSize : 0) + wire.frame_size;
+
+    const ssize_t sent = io_.udp_send_segments(
+        udp_fds_[port_index], tx_buffer_.data(), count * datagram_size, datagram_size, remote_addrs_[port_index]);
+    std::size_t delivered = 0;
+    if (sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            log_errno("send UDP failed");
+        }
+    } else {
+        delivered = std::min(count, static_cast<std::size_t>(sent) / datagram_size);
+    }
+    if (count > 1 && delivered != 0) {
+        ++port_stats.udp_tx_segmented;
+    }
+    port_stats.udp_tx_frames += delivered;
+    port_stats.udp_tx_dropped += count - delivered;
+    if (capture_.enabled()) {
+        for (std::size_t i = 0; i < delivered; ++i) {
+            capture_frame(CaptureDirection::CanToUdp, tx_staged_[i].channel_index, tx_staged_[i].frame);
+        }
+    }
+    return delivered == count;
+}
+
+ssize_t BridgeApp::can_write(std::size_t channel_index, const struct can_frame &frame) {
+    const ssize_t written = config_.shared_can_socket
+                                ? io_.can_write_to(shared_can_fd_, frame, can_ifindexes_[channel_index])
+                                : io_.can_write(can_fds_[channel_index], frame);
+    if (written < 0) {
+        return written;
     }
+    if (bcm_rx_channels_[channel_index] != 0U ? expect_bcm_echo(channel_index, frame) : can_ring_.active()) {
+        tx_echoes_[channel_index].record(frame, monotonic_ns());
+    }
+    return written;
+}
+
+// Queued channels write straight through while the socket accepts frames
+// (and, when paced, while the bus model has room) and only start queueing once
+// either pushes back. From then on every new frame joins the queue so that the
+// drain can reorder by priority.
+bool BridgeApp::enqueue_can_frame(std::size_t channel_index, const struct can_frame &frame, std::uint64_t now_ns) {
+    EgressQueue &queue = egress_queues_[channel_index];
+    TxPacer &pacer = tx_pacers_[channel_index];
+    ChannelStats &stats = channel_stats_[channel_index];
+
+    // A non-empty queue already waits for EPOLLOUT or the TX timer.
+    const bool attempted = queue.empty() && (!pacer.enabled() || pacer.ready(now_ns));
+    bool device_full = false;
+    if (attempted) {
+        const ssize_t written = can_write(channel_index, frame);
+        if (written >= 0) {
+            ++stats.can_tx_frames;
+            if (capture_.enabled()) {
+                capture_frame(CaptureDirection::UdpToCan, channel_index, frame);
+            }
+            if (pacer.enabled()) {
+                pacer.commit(frame, now_ns);
+            }
+            return true;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+            log_errno("write to CAN failed");
+            ++stats.can_tx_dropped;
+            return false;
+        }
+        device_full = errno == ENOBUFS;
+        if (pacer.enabled()) {
+            pacer.back_off(frame, now_ns);
+        }
+    }
+
+    if (!queue.push(frame)) {
+        ++stats.can_tx_dropped;
+        return false;
+    }
+    ++stats.can_tx_queued;
+    if (queue.size() > stats.can_tx_queue_peak) {
+        stats.can_tx_queue_peak = queue.size();
+    }
+    if (attempted || pacer.enabled()) {
+        wait_for_can_egress(channel_index, device_full);
+    }
+    return true;
+}
+
+void BridgeApp::drain_can_egress(std::size_t channel_index) {
+    EgressQueue &queue = egress_queues_[channel_index];
+    TxPacer &pacer = tx_pacers_[channel_index];
+    ChannelStats &stats = channel_stats_[channel_index];
+    const bool paced = pacer.enabled();
+    const std::uint64_t now_ns = paced ? monotonic_ns() : 0;
+    bool device_full = false;
 
-    std::size_t low = 0;
-    std::size_t high = id_lookup_count_;
-    while (low < high) {
-        const std::size_t mid = (low + high) / 2;
-        if (id_lookup_[mid].range.min <= can_id) {
-            low = mid + 1;
+    while (!queue.empty()) {
+        if (paced && !pacer.ready(now_ns)) {
+            break;
+        }
+        const ssize_t written = can_write(channel_index, queue.front());
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+                device_full = errno == ENOBUFS;
+                if (paced) {
+                    pacer.back_off(queue.front(), now_ns);
+                }
+                break;
+            }
+            log_errno("write to CAN failed");
+            ++stats.can_tx_dropped;
         } else {
-            high = mid;
+            ++stats.can_tx_frames;
+            if (capture_.enabled()) {
+                capture_frame(CaptureDirection::UdpToCan, channel_index, queue.front());
+            }
+            if (paced) {
+                pacer.commit(queue.front(), now_ns);
+            }
         }
+        queue.pop();
     }
 
-    if (low == 0) {
-        return kInvalidChannelIndex;
+    if (queue.empty()) {
+        set_can_tx_blocked(channel_index, false);
+    } else {
+        wait_for_can_egress(channel_index, device_full);
     }
+}
 
-    const RangeLookup &candidate = id_lookup_[low - 1];
-    if (candidate.range.min <= can_id && can_id <= candidate.range.max) {
-        return candidate.channel_index;
+// Frames held for a requested TX time. They skip the queue until due and then
+// go out exactly like a frame that just arrived, pacing included.
+bool BridgeApp::schedule_can_frame(std::size_t channel_index,
+                                   const struct can_frame &frame,
+                                   std::uint64_t due_ns,
+                                   std::uint64_t now_ns) {
+    TxSchedule &schedule = tx_schedules_[channel_index];
+    ChannelStats &stats = channel_stats_[channel_index];
+    if (due_ns - now_ns > kMaxScheduleAheadNs || !schedule.push(due_ns, frame)) {
+        ++stats.can_tx_dropped;
+        return false;
+    }
+    ++stats.can_tx_scheduled;
+    arm_tx_timer(channel_index, schedule.next_due_ns());
+    return true;
+}
+
+void BridgeApp::release_scheduled(std::size_t channel_index, std::uint64_t now_ns) {
+    TxSchedule &schedule = tx_schedules_[channel_index];
+    while (!schedule.empty() && schedule.next_due_ns() <= now_ns) {
+        const struct can_frame frame = schedule.front();
+        schedule.pop();
+        write_can_frame(channel_index, frame, now_ns);
+    }
+}
+
+// One frame outside a datagram (released from the schedule, replayed): through
+// the queue when the channel has one, otherwise written or dropped. A full
+// socket or device queue is back-pressure, counted but not logged.
+void BridgeApp::write_can_frame(std::size_t channel_index, const struct can_frame &frame, std::uint64_t now_ns) {
+    if (egress_queues_[channel_index].enabled()) {
+        enqueue_can_frame(channel_index, frame, now_ns);
+        return;
+    }
+    ChannelStats &stats = channel_stats_[channel_index];
+    if (can_write(channel_index, frame) < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+            log_errno("write to CAN failed");
+        }
+        ++stats.can_tx_dropped;
+        return;
+    }
+    ++stats.can_tx_frames;
+    if (capture_.enabled()) {
+        capture_frame(CaptureDirection::UdpToCan, channel_index, frame);
+    }
+}
+
+void BridgeApp::handle_tx_timer(std::size_t channel_index) {
+    std::uint64_t expirations = 0;
+    if (read(tx_timer_fds_[channel_index], &expirations, sizeof(expirations)) < 0 && errno != EAGAIN) {
+        log_errno("read from TX timer failed");
+    }
+    tx_timer_deadlines_[channel_index] = 0;
+
+    TxSchedule &schedule = tx_schedules_[channel_index];
+    if (!schedule.empty()) {
+        release_scheduled(channel_index, monotonic_ns());
+    }
+    if (!egress_queues_[channel_index].empty()) {
+        drain_can_egress(channel_index);
+    }
+    if (!schedule.empty()) {
+        arm_tx_timer(channel_index, schedule.next_due_ns());
     }
-    return kInvalidChannelIndex;
 }
 
-std::uint32_t BridgeApp::extract_identifier(const struct can_frame &frame) {
-    if ((frame.can_id & CAN_EFF_FLAG) != 0U) {
-        return frame.can_id & CAN_EFF_MASK;
+// Paced channels arm their one-shot timer for the moment the bus model frees
+// up. Unpaced ones wait for EPOLLOUT while the socket send buffer is full;
+// ENOBUFS means the qdisc or driver queue is full instead, with the socket
+// still writable, so level-triggered EPOLLOUT would fire straight away and
+// the loop would spin on it. Those retry from the timer after a back-off.
+void BridgeApp::wait_for_can_egress(std::size_t channel_index, bool device_full) {
+    if (tx_pacers_[channel_index].enabled()) {
+        arm_tx_timer(channel_index, tx_pacers_[channel_index].next_release_ns());
+        return;
+    }
+    set_can_tx_blocked(channel_index, !device_full);
+    if (device_full) {
+        arm_tx_timer(channel_index, monotonic_ns() + kCanTxBackoffNs);
+    }
+}
+
+// Keeps the earliest pending deadline: a later request while the timer is
+// armed sooner is picked up when it fires and re-arms.
+void BridgeApp::arm_tx_timer(std::size_t channel_index, std::uint64_t deadline_ns) {
+    deadline_ns = std::max<std::uint64_t>(deadline_ns, 1);
+    std::uint64_t &armed_ns = tx_timer_deadlines_[channel_index];
+    if (armed_ns != 0 && armed_ns <= deadline_ns) {
+        return;
+    }
+    if (!set_timer_deadline(tx_timer_fds_[channel_index], deadline_ns)) {
+        log_errno("failed to arm TX timer");
+        return;
+    }
+    armed_ns = deadline_ns;
+}
+
+// On the shared socket EPOLLOUT is wanted while any channel is blocked, and
+// every blocked channel is drained when it fires.
+void BridgeApp::set_can_tx_blocked(std::size_t channel_index, bool blocked) {
+    if ((can_tx_blocked_[channel_index] != 0U) == blocked) {
+        return;
+    }
+    if (config_.shared_can_socket) {
+        const std::size_t waiting = blocked ? shared_can_blocked_ + 1 : shared_can_blocked_ - 1;
+        // Only the first channel to block and the last to unblock change it.
+        const bool changes = blocked ? waiting == 1 : waiting == 0;
+        if (changes && !update_event(EventType::CanShared, 0, shared_can_fd_, blocked ? (EPOLLIN | EPOLLOUT) : EPOLLIN)) {
+            return;
+        }
+        shared_can_blocked_ = waiting;
+        can_tx_blocked_[channel_index] = blocked ? 1U : 0U;
+        return;
+    }
+    const std::uint32_t events = blocked ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    if (update_event(EventType::Can, static_cast<std::uint32_t>(channel_index), can_fds_[channel_index], events)) {
+        can_tx_blocked_[channel_index] = blocked ? 1U : 0U;
     }
-    return frame.can_id & CAN_SFF_MASK;
 }
 
 std::uint64_t BridgeApp::make_event_tag(EventType type, std::uint32_t index) {
@@ -1,74 +1,444 @@
 #pragma once
 
+#include "arena.hpp"
+#include "can_packet_ring.hpp"
+#include "capture.hpp"
+#include "change_filter.hpp"
 #include "config.hpp"
+#include "egress_queue.hpp"
+#include "io_backend.hpp"
 #include "protocol.hpp"
+#include "rate_limiter.hpp"
+#include "replay.hpp"
+#include "routing.hpp"
+#include "sequence_tracker.hpp"
+#include "tx_echo_filter.hpp"
+#include "tx_pacer.hpp"
+#include "tx_schedule.hpp"
+#include "udp_filter.hpp"
+#include "xdp_ingress.hpp"
 
 #include <array>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <netinet/in.h>
+#include <sys/epoll.h>
 
 class BridgeApp {
 public:
+    struct PortStats {
+        std::uint64_t udp_rx_datagrams{0};
+        std::uint64_t udp_rx_coalesced{0}; // reads that carried several datagrams (GRO)
+        std::uint64_t udp_rx_xdp{0};       // datagrams that arrived through AF_XDP
+        // Dropped by the kernel before reaching the socket's queue: a full
+        // receive buffer, or a datagram udp_filter rejected.
+        std::uint64_t udp_rx_socket_drops{0};
+        std::uint64_t udp_rx_frames{0};
+        std::uint64_t udp_rx_malformed{0};
+        std::uint64_t udp_rx_unroutable{0};
+        std::uint64_t udp_rx_rate_limited{0};
+        // Control records acted on, and those refused (cyclic_tx off, job
+        // limit, period too short, no such job).
+        std::uint64_t udp_rx_control{0};
+        std::uint64_t udp_rx_control_rejected{0};
+        // Sequence-header ports only. Lost is net of datagrams that later
+        // arrived out of order; duplicates are dropped.
+        std::uint64_t udp_rx_seq_lost{0};
+        std::uint64_t udp_rx_seq_reordered{0};
+        std::uint64_t udp_rx_seq_duplicates{0};
+        std::uint64_t udp_tx_frames{0};
+        std::uint64_t udp_tx_segmented{0}; // sends that carried several datagrams (GSO)
+        std::uint64_t udp_tx_dropped{0};
+    };
+
+    struct ChannelStats {
+        std::uint64_t can_rx_frames{0};
+        std::uint64_t can_rx_suppressed{0};
+        std::uint64_t can_rx_rate_limited{0};
+        // Frames the channel's own CAN socket lost to a full receive buffer.
+        std::uint64_t can_rx_socket_drops{0};
+        std::uint64_t can_tx_frames{0};
+        std::uint64_t can_tx_dropped{0};
+        std::uint64_t can_tx_queued{0};
+        std::uint64_t can_tx_queue_peak{0};
+        std::uint64_t can_tx_scheduled{0};
+    };
+
+    // Per ISO-TP link: whole payloads and their bytes in each direction.
+    // TX drops are PDUs refused while the previous one was still being
+    // segmented, or sent to a link whose socket did not open; RX errors are
+    // transfers the socket aborted (timeouts, sequence errors).
+    struct IsoTpStats {
+        std::uint64_t can_tx_pdus{0};
+        std::uint64_t can_tx_bytes{0};
+        std::uint64_t can_tx_dropped{0};
+        std::uint64_t can_rx_pdus{0};
+        std::uint64_t can_rx_bytes{0};
+        std::uint64_t can_rx_errors{0};
+    };
+
+    struct ReplayStats {
+        std::uint64_t frames{0};
+        std::uint64_t unroutable{0}; // no channel for the ID or interface
+        std::uint64_t loops{0};
+    };
+
     explicit BridgeApp(const BridgeConfig &config);
+    BridgeApp(const BridgeConfig &config, IoBackend &io);
     ~BridgeApp();
 
+    // Reload `config_path` on SIGHUP, read through a signalfd in the epoll
+    // set. Call before initialize(); SIGHUP is blocked for the process.
+    void enable_reload(const std::string &config_path);
+    // Stop run() on SIGINT/SIGTERM through the same signalfd. Call before
+    // initialize(); both signals are blocked for the process.
+    void enable_signals();
+
     bool initialize();
-    void run(std::atomic<bool> &keep_running);
+    // Switches the running bridge to `next` between event batches. Sockets of
+    // ports (by listen_port) and channels (by vcan_name) present in both
+    // configs stay open together with their stats and queued frames; only
+    // the difference is opened or closed. Returns false, with the old config
+    // still active, when `next` cannot be applied; with auto_setup_interfaces
+    // its CAN links may already have been reconfigured if the failure came
+    // from the interface setup or a CAN socket.
+    bool reload(const BridgeConfig &next);
+    // Blocks in epoll until a stop is requested; there is no periodic wakeup.
+    void run();
+    // Safe from other threads and signal handlers: flag the request and wake
+    // the loop through the control eventfd.
+    void request_stop();
+    void request_reload();
+    // Waits up to timeout_ms for one batch of events and handles it. Returns
+    // false when the event loop hit an unrecoverable error.
+    bool poll_once(int timeout_ms);
+
+    std::size_t port_count() const { return udp_port_count_; }
+    std::size_t channel_count() const { return channel_count_; }
+    const PortStats &port_stats(std::size_t port_index) const { return port_stats_[port_index]; }
+    const ChannelStats &channel_stats(std::size_t channel_index) const { return channel_stats_[channel_index]; }
+    const RateLimiter &rate_limiter() const { return rate_limiter_; }
+    const ReplayStats &replay_stats() const { return replay_stats_; }
+    // Frames the shared CAN socket lost to a full receive buffer; they
+    // cannot be told apart by channel.
+    std::uint64_t shared_can_socket_drops() const { return shared_can_socket_drops_; }
+    // Likewise for the CAN_BCM socket of the bcm_rx channels.
+    std::uint64_t bcm_rx_socket_drops() const { return bcm_rx_socket_drops_; }
+    bool replay_active() const { return replay_pending_; }
+    // False when no xdp section is configured or its setup failed.
+    bool xdp_active() const { return xdp_.active(); }
+    // Likewise for can_rx_ring.
+    bool can_ring_active() const { return can_ring_.active(); }
+    // CAN_BCM jobs running for cyclic_tx.
+    std::size_t cyclic_job_count() const { return cyclic_jobs_.size(); }
+    // ISO-TP links in config order, port by port.
+    std::size_t isotp_link_count() const { return isotp_links_.size(); }
+    const IsoTpStats &isotp_stats(std::size_t link_index) const { return isotp_links_[link_index].stats; }
+    const BridgeConfig &config() const { return config_; }
 
 private:
     enum class EventType : std::uint16_t {
         Udp = 1,
         Can = 2,
+        CanTxTimer = 3,
+        Signal = 4,
+        Control = 5,
+        Replay = 6,
+        Xdp = 7,
+        CanShared = 8,
+        CanRing = 9,
+        CanBcm = 10,
+        IsoTp = 11,
+        XdpRetry = 12,
+    };
+
+    // A configured ISO-TP link and the port its PDUs cross; fd is -1 while
+    // its socket is not open.
+    struct IsoTpLink {
+        IsoTpConfig config;
+        std::uint32_t port_index;
+        int fd;
+        IsoTpStats stats;
     };
 
-    static constexpr std::size_t kMaxUdpPorts = 8;
-    static constexpr std::size_t kMaxChannels = 32;
-    static constexpr std::size_t kMaxEvents = kMaxUdpPorts + kMaxChannels;
-    static constexpr std::size_t kInvalidChannelIndex = static_cast<std::size_t>(-1);
+    // One CAN_BCM RX_SETUP subscription of a bcm_rx channel, and the last
+    // frame of its ID the kernel compares against (seen: there is one).
+    struct BcmRxOp {
+        int ifindex;
+        canid_t can_id;
+        std::uint32_t throttle_ms;
+        bool changes_only;
+        struct can_frame last{};
+        bool seen{false};
+    };
 
-    struct UdpPortContext {
-        PortConfig config;
-        int udp_fd{-1};
-        sockaddr_in remote_addr{};
-        std::array<std::uint8_t, 4096> rx_buffer{};
+    // A receive socket's kernel drop counter as of its last read, and whether
+    // adaptive sizing cannot grow its buffer any further.
+    struct SocketDrops {
+        std::uint32_t seen{0};
+        bool at_limit{false};
     };
 
-    struct ChannelContext {
-        ChannelConfig config;
-        int can_fd{-1};
-        std::size_t port_index{0};
+    // Everything sized from one config. On reload the running tables are
+    // moved here, the new ones adopt whatever they can, and the rest is
+    // closed with it.
+    struct RetiredTables {
+        BridgeConfig config;
+        Arena arena;
+        int *udp_fds{nullptr};
+        PortStats *port_stats{nullptr};
+        SequenceTracker *rx_sequences{nullptr};
+        std::uint32_t *tx_sequences{nullptr};
+        int *can_fds{nullptr};
+        int *tx_timer_fds{nullptr};
+        ChannelStats *channel_stats{nullptr};
+        std::size_t port_count{0};
+        std::size_t channel_count{0};
+        std::vector<LastValueCache> value_caches;
+        RateLimiter rate_limiter;
+        std::vector<EgressQueue> egress_queues;
+        std::vector<TxPacer> tx_pacers;
+        std::vector<TxSchedule> tx_schedules;
+        std::vector<SocketDrops> udp_drops;
+        std::vector<SocketDrops> can_drops;
+
+        std::size_t find_port(std::uint16_t listen_port) const;
+        std::size_t find_channel(const std::string &vcan_name) const;
     };
 
-    struct RangeLookup {
-        IdRange range{};
-        std::size_t channel_index{0};
+    // Large enough for a full UDP GRO read (up to 64 KiB of datagrams).
+    static constexpr std::size_t kUdpRxBufferSize = 65536;
+    // Frames replayed per timer wakeup at most, so that a max-speed replay
+    // still lets the loop serve live traffic in between.
+    static constexpr std::size_t kReplayBatch = 256;
+    // Frames a scheduled-TX channel may hold, and how far ahead they may be.
+    static constexpr std::size_t kTxScheduleDepth = 256;
+    static constexpr std::uint64_t kMaxScheduleAheadNs = 10ULL * 1000000000ULL;
+    // How long an unpaced queued channel waits after ENOBUFS before it
+    // retries the device queue.
+    static constexpr std::uint64_t kCanTxBackoffNs = 1000000ULL;
+    // How often and how long AF_XDP ingress retries queues a reload left
+    // busy, about half a second in all.
+    static constexpr std::uint64_t kXdpRetryDelayNs = 5000000ULL;
+    static constexpr std::uint32_t kXdpRetries = 100;
+    // CAN -> UDP datagrams batched into one send at most (the kernel's GSO
+    // segment limit).
+    static constexpr std::size_t kMaxTxSegments = 64;
+    // AF_XDP descriptors taken off an RX ring per batch.
+    static constexpr std::size_t kXdpBatch = 64;
+    // Frames read from the shared CAN socket or the CAN ring per call.
+    static constexpr std::size_t kCanRxBatch = 64;
+
+    // Per-port wire format, copied out of PortConfig so the datagram loop
+    // does not chase config pointers.
+    struct PortWire {
+        std::uint32_t frame_size;
+        FrameFormat format;
+        bool scheduled_tx;
+        bool sequenced;
     };
 
-    bool configure_udp_socket(UdpPortContext &context);
-    bool configure_can_socket(ChannelContext &context);
+    bool allocate_tables(std::size_t port_count, std::size_t channel_count);
+    bool apply_config(BridgeConfig next);
+    bool open_endpoints(const BridgeConfig &next, std::vector<int> &udp_fds, std::vector<int> &can_fds);
+    void retire_tables(RetiredTables &retired);
+    bool build_tables(RetiredTables &retired, const std::vector<int> &udp_fds, const std::vector<int> &can_fds);
+    void close_retired(RetiredTables &retired);
+    bool configure_tx_timer(std::size_t channel_index);
+    void apply_socket_buffers(int fd, const SocketBufferConfig &config, SocketDrops &state, const std::string &label);
+    std::uint32_t account_socket_drops(int fd,
+                                       std::uint32_t counter,
+                                       SocketDrops &state,
+                                       const SocketBufferConfig &config,
+                                       bool filtered,
+                                       const std::string &label);
+    bool prepare_capture(const BridgeConfig &next, CaptureWriter &opened);
+    void capture_frame(CaptureDirection direction, std::size_t channel_index, const struct can_frame &frame);
+    bool prepare_replay(const BridgeConfig &next, ReplaySource &opened);
+    void start_replay();
+    void stop_replay();
+    void index_replay_channels();
+    UdpFilterSpec udp_filter_spec(std::size_t port_index) const;
+    void configure_xdp();
+    bool schedule_xdp_retry();
+    void handle_xdp_events(std::size_t queue);
+    void handle_xdp_retry_timer();
+    void handle_replay_timer();
+    void replay_frame(const ReplayFrame &replayed, std::uint64_t now_ns);
+    bool setup_can_interfaces(const BridgeConfig &config);
     bool prepare_can_interface(const ChannelConfig &config) const;
+    bool open_signal_fd();
+    bool open_control_fd();
+    void handle_signal_events();
+    void handle_control_events();
+    void reload_from_file();
     bool register_event(EventType type, std::uint32_t index, int fd);
+    bool update_event(EventType type, std::uint32_t index, int fd, std::uint32_t events);
     void shutdown();
 
     void handle_udp_events(std::size_t port_index);
+    void handle_udp_datagram(std::size_t port_index,
+                             const std::uint8_t *datagram,
+                             std::size_t length,
+                             std::uint64_t now_ns,
+                             std::uint64_t wall_now_ns);
+    bool accept_datagram_header(std::size_t port_index, const std::uint8_t *datagram, std::size_t length);
+    std::size_t route_udp_frame(std::size_t port_index, std::uint32_t can_id);
+    void handle_control_record(std::size_t port_index, const std::uint8_t *slots);
+    void configure_cyclic_tx();
+    void handle_isotp_pdu(std::size_t port_index, const std::uint8_t *record_slot, std::size_t available);
+    void configure_isotp();
+    void handle_isotp_events(std::size_t link_index);
     void handle_can_events(std::size_t channel_index);
+    void handle_shared_can_events();
+    void configure_can_ring();
+    void handle_can_ring_events();
+    void configure_bcm_rx();
+    bool subscribe_bcm_rx(const BcmRxOp &op);
+    BcmRxOp *find_bcm_rx_op(int ifindex, canid_t can_id);
+    bool expect_bcm_echo(std::size_t channel_index, const struct can_frame &frame);
+    void handle_bcm_rx_events();
+    std::size_t channel_for_ifindex(int ifindex) const;
+    void drain_shared_can_egress();
+    bool forward_can_frame(std::size_t channel_index,
+                           const struct can_frame &frame,
+                           std::uint64_t rx_time_ns,
+                           std::uint64_t now_ns);
+    bool flush_udp_tx();
+    ssize_t can_write(std::size_t channel_index, const struct can_frame &frame);
+    void write_can_frame(std::size_t channel_index, const struct can_frame &frame, std::uint64_t now_ns);
+    bool enqueue_can_frame(std::size_t channel_index, const struct can_frame &frame, std::uint64_t now_ns);
+    void drain_can_egress(std::size_t channel_index);
+    bool schedule_can_frame(std::size_t channel_index, const struct can_frame &frame, std::uint64_t due_ns, std::uint64_t now_ns);
+    void release_scheduled(std::size_t channel_index, std::uint64_t now_ns);
+    void handle_tx_timer(std::size_t channel_index);
+    void wait_for_can_egress(std::size_t channel_index, bool device_full);
+    void arm_tx_timer(std::size_t channel_index, std::uint64_t deadline_ns);
+    void set_can_tx_blocked(std::size_t channel_index, bool blocked);
 
-    std::size_t find_channel_for_can_id(std::uint32_t can_id) const;
-    static std::uint32_t extract_identifier(const struct can_frame &frame);
     static std::uint64_t make_event_tag(EventType type, std::uint32_t index);
     static EventType decode_event_type(std::uint64_t tag);
     static std::uint32_t decode_event_index(std::uint64_t tag);
 
     BridgeConfig config_;
+    SocketIoBackend socket_io_;
+    IoBackend &io_;
     int epoll_fd_;
-    std::array<UdpPortContext, kMaxUdpPorts> udp_ports_;
-    std::array<ChannelContext, kMaxChannels> channels_;
-    std::array<RangeLookup, kMaxChannels> id_lookup_;
+    int signal_fd_;
+    int control_fd_;
+    std::string config_path_;
+    bool handle_stop_signals_;
+    bool reload_pending_;
+    std::atomic<bool> stop_requested_;
+    std::atomic<bool> reload_requested_;
+    // All tables below are carved from arena_ in one allocation sized from
+    // config_ at initialize(). Each array starts on its own cache line.
+    //
+    // Hot, touched per frame: one dense array per field so that a batch only
+    // pulls in the lines it needs (32 channels of fds or port indices are two
+    // lines each).
+    Arena arena_;
+    int *udp_fds_;
+    sockaddr_in *remote_addrs_;
+    PortWire *port_wire_;
+    PortStats *port_stats_;
+    SequenceTracker *rx_sequences_;
+    std::uint32_t *tx_sequences_;
+    int *can_fds_;
+    int *tx_timer_fds_;
+    std::uint32_t *channel_ports_;
+    ChannelStats *channel_stats_;
+    RangeLookup *id_lookup_;
+    epoll_event *events_;
+    std::uint8_t *rx_buffer_;
+    // Indexed by channel; disabled caches own no storage.
+    std::vector<LastValueCache> value_caches_;
+    RateLimiter rate_limiter_;
+    // Per channel. A blocked (unpaced) channel has queued frames and waits
+    // for EPOLLOUT; paced and scheduled channels wait on their TX timer, armed
+    // for tx_timer_deadlines_ (0 = not armed).
+    std::vector<EgressQueue> egress_queues_;
+    std::vector<TxPacer> tx_pacers_;
+    std::vector<TxSchedule> tx_schedules_;
+    std::vector<std::uint8_t> can_tx_blocked_;
+    std::vector<std::uint64_t> tx_timer_deadlines_;
+    bool pacing_active_;
+    // Every frame written to CAN or UDP is recorded here when enabled.
+    CaptureWriter capture_;
+    // Replay source and the next frame it yields (replay_pending_); the
+    // frame's interface name points into replay_.
+    ReplaySource replay_;
+    ReplayTiming replay_timing_;
+    ReplayFrame replay_next_;
+    bool replay_pending_;
+    int replay_timer_fd_;
+    ReplayStats replay_stats_;
+    // Sorted vcan_name -> channel index, for replays injected on the CAN side.
+    std::vector<std::pair<std::string, std::uint32_t>> replay_channels_;
+    // AF_XDP ingress and the sorted listen port -> port index table for the
+    // ports it serves.
+    XdpIngress xdp_;
+    std::vector<std::pair<std::uint16_t, std::uint32_t>> xdp_ports_;
+    std::array<XdpPacket, kXdpBatch> xdp_packets_;
+    // Timer for reopening AF_XDP ingress while its queues are still busy,
+    // and the attempts made so far.
+    int xdp_retry_timer_fd_;
+    std::uint32_t xdp_retries_;
+    // Each channel's ifindex and the sorted ifindex -> channel table, for
+    // the receive paths that serve all interfaces at once.
+    std::vector<int> can_ifindexes_;
+    std::vector<std::pair<int, std::uint32_t>> ifindex_channels_;
+    // shared_can_socket mode: the one CAN socket of all channels (their
+    // can_fds_ stay -1) and how many channels wait for EPOLLOUT on it.
+    int shared_can_fd_;
+    std::size_t shared_can_blocked_;
+    std::array<CanRxFrame, kCanRxBatch> can_rx_batch_;
+    // cyclic_tx: the CAN_BCM socket owning the jobs, and each job's
+    // (ifindex, can_id) as the kernel keys it.
+    int bcm_fd_;
+    std::vector<std::pair<int, canid_t>> cyclic_jobs_;
+    // bcm_rx: the CAN_BCM socket of all subscriptions, sorted by (ifindex,
+    // can_id), and per channel whether they replace its CAN_RAW receive.
+    int bcm_rx_fd_;
+    std::vector<BcmRxOp> bcm_rx_ops_;
+    std::vector<std::uint8_t> bcm_rx_channels_;
+    SocketDrops bcm_rx_drops_;
+    std::uint64_t bcm_rx_socket_drops_;
+    // isotp: one CAN_ISOTP socket per link; received PDUs are assembled in
+    // rx_buffer_.
+    std::vector<IsoTpLink> isotp_links_;
+    // can_rx_ring: while active the CAN sockets only write, and each channel
+    // remembers its recent writes so that their loopback copies in the ring
+    // are not sent back to the server.
+    CanPacketRing can_ring_;
+    std::array<CanRingFrame, kCanRxBatch> can_ring_frames_;
+    std::vector<TxEchoFilter> tx_echoes_;
+    // SO_RXQ_OVFL state of each port's and channel's socket and of the
+    // shared CAN socket.
+    std::vector<SocketDrops> udp_drops_;
+    std::vector<SocketDrops> can_drops_;
+    SocketDrops shared_can_drops_;
+    std::uint64_t shared_can_socket_drops_;
+    // CAN -> UDP datagrams encoded into tx_buffer_ but not sent yet, all for
+    // tx_staged_port_; flushed at the end of every drain.
+    struct StagedFrame {
+        std::uint32_t channel_index;
+        struct can_frame frame;
+    };
+    std::array<StagedFrame, kMaxTxSegments> tx_staged_;
+    std::size_t tx_staged_count_;
+    std::uint32_t tx_staged_port_;
+    // Cold, setup and logging only: the parsed configs with their heap strings.
+    const PortConfig **port_configs_;
+    const ChannelConfig **channel_configs_;
+    std::size_t event_capacity_;
     std::size_t udp_port_count_;
     std::size_t channel_count_;
     std::size_t id_lookup_count_;
-    std::array<std::uint8_t, kUdpFrameSize> tx_buffer_;
+    std::array<std::uint8_t, kMaxTxSegments * (kSequenceHeaderSize + kMaxUdpFrameSize)> tx_buffer_;
 };
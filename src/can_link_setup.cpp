@@ -0,0 +1,382 @@
+#include "can_link_setup.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <linux/can/netlink.h>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <syslog.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::size_t kRecvBufferSize = 32768;
+
+// Appends netlink messages with their rtattrs to one contiguous buffer.
+// Offsets instead of pointers because the buffer grows while being built.
+class NetlinkBatch {
+public:
+    std::size_t begin_message(std::uint16_t type, std::uint16_t flags, std::uint32_t seq) {
+        const std::size_t offset = buffer_.size();
+        nlmsghdr header{};
+        header.nlmsg_type = type;
+        header.nlmsg_flags = static_cast<std::uint16_t>(NLM_F_REQUEST | flags);
+        header.nlmsg_seq = seq;
+        append(&header, sizeof(header));
+        return offset;
+    }
+
+    void end_message(std::size_t offset) {
+        header_at(offset)->nlmsg_len = static_cast<std::uint32_t>(buffer_.size() - offset);
+    }
+
+    void put_ifinfo(const ifinfomsg &info) { append(&info, sizeof(info)); }
+
+    void put_attr(std::uint16_t type, const void *data, std::size_t length) {
+        rtattr attr{};
+        attr.rta_type = type;
+        attr.rta_len = static_cast<unsigned short>(RTA_LENGTH(length));
+        append(&attr, sizeof(attr));
+        append(data, length);
+    }
+
+    void put_string(std::uint16_t type, const std::string &value) { put_attr(type, value.c_str(), value.size() + 1); }
+
+    void put_u32(std::uint16_t type, std::uint32_t value) { put_attr(type, &value, sizeof(value)); }
+
+    std::size_t begin_nest(std::uint16_t type) {
+        const std::size_t offset = buffer_.size();
+        rtattr attr{};
+        attr.rta_type = type;
+        append(&attr, sizeof(attr));
+        return offset;
+    }
+
+    void end_nest(std::size_t offset) {
+        auto *attr = reinterpret_cast<rtattr *>(buffer_.data() + offset);
+        attr->rta_len = static_cast<unsigned short>(buffer_.size() - offset);
+    }
+
+    const std::uint8_t *data() const { return buffer_.data(); }
+    std::size_t size() const { return buffer_.size(); }
+
+private:
+    nlmsghdr *header_at(std::size_t offset) { return reinterpret_cast<nlmsghdr *>(buffer_.data() + offset); }
+
+    void append(const void *data, std::size_t length) {
+        const auto *bytes = static_cast<const std::uint8_t *>(data);
+        buffer_.insert(buffer_.end(), bytes, bytes + length);
+        buffer_.resize(NLMSG_ALIGN(buffer_.size()), 0);
+    }
+
+    std::vector<std::uint8_t> buffer_;
+};
+
+class NetlinkSocket {
+public:
+    NetlinkSocket() : fd_(socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE)) {}
+    ~NetlinkSocket() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+    NetlinkSocket(const NetlinkSocket &) = delete;
+    NetlinkSocket &operator=(const NetlinkSocket &) = delete;
+
+    bool valid() const { return fd_ >= 0; }
+
+    bool send(const NetlinkBatch &batch) {
+        sockaddr_nl kernel{};
+        kernel.nl_family = AF_NETLINK;
+        const ssize_t sent = sendto(fd_,
+                                    batch.data(),
+                                    batch.size(),
+                                    0,
+                                    reinterpret_cast<const sockaddr *>(&kernel),
+                                    sizeof(kernel));
+        return sent == static_cast<ssize_t>(batch.size());
+    }
+
+    ssize_t receive(std::uint8_t *buffer, std::size_t capacity) {
+        while (true) {
+            const ssize_t received = recv(fd_, buffer, capacity, 0);
+            if (received >= 0 || errno != EINTR) {
+                return received;
+            }
+        }
+    }
+
+private:
+    int fd_;
+};
+
+void parse_link_info(const rtattr *info, CanLinkState &state) {
+    int remaining = static_cast<int>(RTA_PAYLOAD(info));
+    for (const rtattr *attr = static_cast<const rtattr *>(RTA_DATA(info)); RTA_OK(attr, remaining);
+         attr = RTA_NEXT(attr, remaining)) {
+        if (attr->rta_type == IFLA_INFO_KIND) {
+            const auto *kind = static_cast<const char *>(RTA_DATA(attr));
+            state.kind.assign(kind, strnlen(kind, RTA_PAYLOAD(attr)));
+        } else if (attr->rta_type == IFLA_INFO_DATA) {
+            int data_remaining = static_cast<int>(RTA_PAYLOAD(attr));
+            for (const rtattr *data = static_cast<const rtattr *>(RTA_DATA(attr)); RTA_OK(data, data_remaining);
+                 data = RTA_NEXT(data, data_remaining)) {
+                if (data->rta_type == IFLA_CAN_BITTIMING && RTA_PAYLOAD(data) >= sizeof(can_bittiming)) {
+                    can_bittiming timing{};
+                    std::memcpy(&timing, RTA_DATA(data), sizeof(timing));
+                    state.bitrate = timing.bitrate;
+                }
+            }
+        }
+    }
+}
+
+bool parse_link(const nlmsghdr *header, CanLinkState &state) {
+    if (header->nlmsg_len < NLMSG_LENGTH(sizeof(ifinfomsg))) {
+        return false;
+    }
+    const auto *info = static_cast<const ifinfomsg *>(NLMSG_DATA(header));
+    state.ifindex = info->ifi_index;
+    state.up = (info->ifi_flags & IFF_UP) != 0U;
+
+    int remaining = static_cast<int>(IFLA_PAYLOAD(header));
+    for (const rtattr *attr = IFLA_RTA(info); RTA_OK(attr, remaining); attr = RTA_NEXT(attr, remaining)) {
+        switch (attr->rta_type) {
+        case IFLA_IFNAME: {
+            const auto *name = static_cast<const char *>(RTA_DATA(attr));
+            state.name.assign(name, strnlen(name, RTA_PAYLOAD(attr)));
+            break;
+        }
+        case IFLA_TXQLEN:
+            if (RTA_PAYLOAD(attr) >= sizeof(std::uint32_t)) {
+                std::memcpy(&state.txqueuelen, RTA_DATA(attr), sizeof(std::uint32_t));
+            }
+            break;
+        case IFLA_LINKINFO:
+            parse_link_info(attr, state);
+            break;
+        default:
+            break;
+        }
+    }
+    return !state.name.empty();
+}
+
+bool dump_links(NetlinkSocket &socket, std::vector<CanLinkState> &links, std::string &error_message) {
+    constexpr std::uint32_t kDumpSeq = 1;
+    NetlinkBatch request;
+    const std::size_t offset = request.begin_message(RTM_GETLINK, NLM_F_DUMP, kDumpSeq);
+    ifinfomsg info{};
+    info.ifi_family = AF_UNSPEC;
+    request.put_ifinfo(info);
+    request.end_message(offset);
+    if (!socket.send(request)) {
+        error_message = std::string("RTM_GETLINK dump failed: ") + std::strerror(errno);
+        return false;
+    }
+
+    std::vector<std::uint8_t> buffer(kRecvBufferSize);
+    while (true) {
+        const ssize_t received = socket.receive(buffer.data(), buffer.size());
+        if (received < 0) {
+            error_message = std::string("reading link dump failed: ") + std::strerror(errno);
+            return false;
+        }
+        int remaining = static_cast<int>(received);
+        for (const auto *header = reinterpret_cast<const nlmsghdr *>(buffer.data()); NLMSG_OK(header, remaining);
+             header = NLMSG_NEXT(header, remaining)) {
+            if (header->nlmsg_seq != kDumpSeq) {
+                continue;
+            }
+            if (header->nlmsg_type == NLMSG_DONE) {
+                return true;
+            }
+            if (header->nlmsg_type == NLMSG_ERROR) {
+                const auto *err = static_cast<const nlmsgerr *>(NLMSG_DATA(header));
+                error_message = std::string("link dump rejected: ") + std::strerror(-err->error);
+                return false;
+            }
+            if (header->nlmsg_type == RTM_NEWLINK) {
+                CanLinkState state;
+                if (parse_link(header, state)) {
+                    links.push_back(std::move(state));
+                }
+            }
+        }
+    }
+}
+
+const char *describe(CanLinkOp::Type type) {
+    switch (type) {
+    case CanLinkOp::Type::CreateVcan:
+        return "create vcan";
+    case CanLinkOp::Type::SetDown:
+        return "set down";
+    case CanLinkOp::Type::Configure:
+        return "configure";
+    }
+    return "?";
+}
+
+void append_op(NetlinkBatch &batch, const CanLinkOp &op, const CanLinkSpec &spec, std::uint32_t seq) {
+    const bool create = op.type == CanLinkOp::Type::CreateVcan;
+    const std::uint16_t flags = NLM_F_ACK | (create ? (NLM_F_CREATE | NLM_F_EXCL) : 0);
+    const std::size_t offset = batch.begin_message(RTM_NEWLINK, static_cast<std::uint16_t>(flags), seq);
+
+    ifinfomsg info{};
+    info.ifi_family = AF_UNSPEC;
+    info.ifi_index = create ? 0 : op.ifindex;
+    info.ifi_change = IFF_UP;
+    info.ifi_flags = op.type == CanLinkOp::Type::SetDown ? 0U : static_cast<unsigned int>(IFF_UP);
+    batch.put_ifinfo(info);
+
+    if (create) {
+        batch.put_string(IFLA_IFNAME, spec.name);
+    }
+    if (op.txqueuelen != 0) {
+        batch.put_u32(IFLA_TXQLEN, op.txqueuelen);
+    }
+    if (create || op.bitrate != 0) {
+        const std::size_t linkinfo = batch.begin_nest(IFLA_LINKINFO);
+        batch.put_string(IFLA_INFO_KIND, create ? "vcan" : "can");
+        if (op.bitrate != 0) {
+            const std::size_t data = batch.begin_nest(IFLA_INFO_DATA);
+            can_bittiming timing{};
+            timing.bitrate = op.bitrate;
+            batch.put_attr(IFLA_CAN_BITTIMING, &timing, sizeof(timing));
+            batch.end_nest(data);
+        }
+        batch.end_nest(linkinfo);
+    }
+    batch.end_message(offset);
+}
+
+} // namespace
+
+void plan_can_link_setup(const std::vector<CanLinkSpec> &specs,
+                         const std::vector<CanLinkState> &links,
+                         std::vector<CanLinkOp> &ops) {
+    ops.clear();
+    for (std::size_t i = 0; i < specs.size(); ++i) {
+        const CanLinkSpec &spec = specs[i];
+        const CanLinkState *link = nullptr;
+        for (const CanLinkState &candidate : links) {
+            if (candidate.name == spec.name) {
+                link = &candidate;
+                break;
+            }
+        }
+
+        CanLinkOp op;
+        op.spec_index = i;
+        if (link == nullptr) {
+            op.type = CanLinkOp::Type::CreateVcan;
+            op.txqueuelen = spec.txqueuelen;
+            ops.push_back(op);
+            continue;
+        }
+
+        op.ifindex = link->ifindex;
+        if (link->kind == "can" && link->bitrate != spec.bitrate) {
+            op.bitrate = spec.bitrate;
+        }
+        if (spec.txqueuelen != 0 && spec.txqueuelen != link->txqueuelen) {
+            op.txqueuelen = spec.txqueuelen;
+        }
+        if (op.bitrate == 0 && op.txqueuelen == 0 && link->up) {
+            continue;
+        }
+        if (op.bitrate != 0 && link->up) {
+            CanLinkOp down = op;
+            down.type = CanLinkOp::Type::SetDown;
+            down.bitrate = 0;
+            down.txqueuelen = 0;
+            ops.push_back(down);
+        }
+        op.type = CanLinkOp::Type::Configure;
+        ops.push_back(op);
+    }
+}
+
+bool apply_can_link_setup(const std::vector<CanLinkSpec> &specs, std::string &error_message) {
+    NetlinkSocket socket;
+    if (!socket.valid()) {
+        error_message = std::string("failed to open rtnetlink socket: ") + std::strerror(errno);
+        return false;
+    }
+
+    std::vector<CanLinkState> links;
+    if (!dump_links(socket, links, error_message)) {
+        return false;
+    }
+    for (const CanLinkSpec &spec : specs) {
+        for (const CanLinkState &link : links) {
+            if (link.name == spec.name && link.kind != "can" && link.kind != "vcan" && link.kind != "vxcan") {
+                syslog(LOG_WARNING,
+                       "%s has link kind '%s'; bitrate %u cannot be verified",
+                       spec.name.c_str(),
+                       link.kind.c_str(),
+                       spec.bitrate);
+            }
+        }
+    }
+
+    std::vector<CanLinkOp> ops;
+    plan_can_link_setup(specs, links, ops);
+    if (ops.empty()) {
+        return true;
+    }
+
+    // Sequence numbers 2.. map back to ops[seq - 2]; the kernel processes the
+    // whole buffer in order and acks each message individually.
+    constexpr std::uint32_t kFirstSeq = 2;
+    NetlinkBatch batch;
+    for (std::size_t i = 0; i < ops.size(); ++i) {
+        append_op(batch, ops[i], specs[ops[i].spec_index], kFirstSeq + static_cast<std::uint32_t>(i));
+    }
+    if (!socket.send(batch)) {
+        error_message = std::string("sending link setup batch failed: ") + std::strerror(errno);
+        return false;
+    }
+
+    std::size_t pending = ops.size();
+    bool ok = true;
+    std::vector<std::uint8_t> buffer(kRecvBufferSize);
+    while (pending > 0) {
+        const ssize_t received = socket.receive(buffer.data(), buffer.size());
+        if (received < 0) {
+            error_message = std::string("reading link setup acks failed: ") + std::strerror(errno);
+            return false;
+        }
+        int remaining = static_cast<int>(received);
+        for (const auto *header = reinterpret_cast<const nlmsghdr *>(buffer.data()); NLMSG_OK(header, remaining);
+             header = NLMSG_NEXT(header, remaining)) {
+            if (header->nlmsg_type != NLMSG_ERROR || header->nlmsg_seq < kFirstSeq ||
+                header->nlmsg_seq - kFirstSeq >= ops.size()) {
+                continue;
+            }
+            --pending;
+            const auto *err = static_cast<const nlmsgerr *>(NLMSG_DATA(header));
+            const CanLinkOp &op = ops[header->nlmsg_seq - kFirstSeq];
+            const CanLinkSpec &spec = specs[op.spec_index];
+            if (err->error != 0) {
+                if (!error_message.empty()) {
+                    error_message += "; ";
+                }
+                error_message += spec.name + ": " + describe(op.type) + " failed: " + std::strerror(-err->error);
+                ok = false;
+                continue;
+            }
+            syslog(LOG_INFO,
+                   "[LINK] %s: %s (bitrate %u, txqueuelen %u, 0 = unchanged)",
+                   spec.name.c_str(),
+                   describe(op.type),
+                   op.bitrate,
+                   op.txqueuelen);
+        }
+    }
+    return ok;
+}
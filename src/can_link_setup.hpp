@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// What a channel wants from its CAN interface.
+struct CanLinkSpec {
+    std::string name;
+    std::uint32_t bitrate{0};
+    std::uint32_t txqueuelen{0}; // 0 = leave unchanged
+};
+
+// What the kernel reported for an existing link (RTM_GETLINK dump).
+struct CanLinkState {
+    std::string name;
+    int ifindex{0};
+    std::string kind; // IFLA_INFO_KIND: "can", "vcan", "vxcan", or empty
+    bool up{false};
+    std::uint32_t txqueuelen{0};
+    std::uint32_t bitrate{0}; // only reported for kind "can" once configured
+};
+
+// One RTM_NEWLINK message of the setup batch.
+struct CanLinkOp {
+    enum class Type : std::uint8_t {
+        CreateVcan, // new vcan named after the spec, created up
+        SetDown,    // bit timing can only change while the link is down
+        Configure,  // bitrate/txqueuelen (0 = untouched), then up
+    };
+
+    Type type{Type::Configure};
+    std::size_t spec_index{0};
+    int ifindex{0};
+    std::uint32_t bitrate{0};
+    std::uint32_t txqueuelen{0};
+};
+
+// Works out the minimal batch that brings `links` in line with `specs`. Links
+// that already match produce no messages. Bitrates are applied to kind "can"
+// only; virtual interfaces have no bit timing.
+void plan_can_link_setup(const std::vector<CanLinkSpec> &specs,
+                         const std::vector<CanLinkState> &links,
+                         std::vector<CanLinkOp> &ops);
+
+// Dumps the current links, plans the changes and sends them to the kernel as
+// one rtnetlink batch, then collects one ack per message. Every rejected
+// message is reported in error_message. Requires CAP_NET_ADMIN.
+bool apply_can_link_setup(const std::vector<CanLinkSpec> &specs, std::string &error_message);
@@ -0,0 +1,153 @@
+#include "can_packet_ring.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <linux/net_tstamp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+std::string errno_text(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+// TPACKET_V3 packs packets back to back and ignores the frame size, but
+// the ring request must still describe a consistent frame layout.
+constexpr std::uint32_t kFrameSize = TPACKET_ALIGN(TPACKET3_HDRLEN + sizeof(struct can_frame));
+
+} // namespace
+
+bool CanPacketRing::open(const CanRingConfig &config, std::string &error_message) {
+    close();
+    // Protocol 0 receives nothing until bind(), which follows the ring setup.
+    fd_ = socket(AF_PACKET, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        error_message = errno_text("cannot create AF_PACKET socket");
+        return false;
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(fd_, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        error_message = errno_text("TPACKET_V3 not supported");
+        close();
+        return false;
+    }
+    // Both best effort: without PACKET_IGNORE_OUTGOING (Linux 4.20) receive()
+    // skips outgoing copies itself, and without hardware stamps the kernel's
+    // software stamp is used.
+    int one = 1;
+    setsockopt(fd_, SOL_PACKET, PACKET_IGNORE_OUTGOING, &one, sizeof(one));
+    int timestamping = SOF_TIMESTAMPING_RAW_HARDWARE;
+    setsockopt(fd_, SOL_PACKET, PACKET_TIMESTAMP, &timestamping, sizeof(timestamping));
+
+    tpacket_req3 request{};
+    request.tp_block_size = config.block_size;
+    request.tp_block_nr = config.block_count;
+    request.tp_frame_size = kFrameSize;
+    request.tp_frame_nr = (config.block_size / kFrameSize) * config.block_count;
+    request.tp_retire_blk_tov = config.block_timeout_ms;
+    if (setsockopt(fd_, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)) < 0) {
+        error_message = errno_text("cannot set up PACKET_RX_RING");
+        close();
+        return false;
+    }
+    ring_length_ = static_cast<std::size_t>(config.block_size) * config.block_count;
+    void *ring = mmap(nullptr, ring_length_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, 0);
+    if (ring == MAP_FAILED) {
+        error_message = errno_text("cannot map PACKET_RX_RING");
+        ring_length_ = 0;
+        close();
+        return false;
+    }
+    ring_ = static_cast<std::uint8_t *>(ring);
+
+    sockaddr_ll address{};
+    address.sll_family = AF_PACKET;
+    address.sll_protocol = htons(ETH_P_CAN);
+    address.sll_ifindex = 0;
+    if (bind(fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        error_message = errno_text("cannot bind AF_PACKET socket to ETH_P_CAN");
+        close();
+        return false;
+    }
+
+    config_ = config;
+    return true;
+}
+
+void CanPacketRing::close() {
+    if (ring_ != nullptr) {
+        munmap(ring_, ring_length_);
+        ring_ = nullptr;
+        ring_length_ = 0;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    block_ = 0;
+    packet_ = nullptr;
+    remaining_ = 0;
+    block_open_ = false;
+}
+
+bool CanPacketRing::same_setup(const CanRingConfig &config) const {
+    return active() && config.block_size == config_.block_size && config.block_count == config_.block_count &&
+           config.block_timeout_ms == config_.block_timeout_ms;
+}
+
+std::size_t CanPacketRing::receive(CanRingFrame *frames, std::size_t capacity) {
+    std::size_t count = 0;
+    while (count == 0 && capacity != 0) {
+        if (!block_open_) {
+            auto *block = reinterpret_cast<tpacket_block_desc *>(ring_ + static_cast<std::size_t>(block_) * config_.block_size);
+            if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0U) {
+                return 0;
+            }
+            block_open_ = true;
+            packet_ = reinterpret_cast<const std::uint8_t *>(block) + block->hdr.bh1.offset_to_first_pkt;
+            remaining_ = block->hdr.bh1.num_pkts;
+        }
+
+        while (count < capacity && remaining_ != 0) {
+            const auto *header = reinterpret_cast<const tpacket3_hdr *>(packet_);
+            const auto *link = reinterpret_cast<const sockaddr_ll *>(packet_ + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+            const std::uint8_t *data = packet_ + header->tp_mac;
+            --remaining_;
+            packet_ += header->tp_next_offset;
+            // CAN FD frames travel as ETH_P_CANFD and never match the binding.
+            if (link->sll_pkttype == PACKET_OUTGOING || header->tp_snaplen != sizeof(struct can_frame)) {
+                continue;
+            }
+            frames[count].frame = reinterpret_cast<const struct can_frame *>(data);
+            frames[count].ifindex = link->sll_ifindex;
+            frames[count].timestamp_ns =
+                static_cast<std::uint64_t>(header->tp_sec) * 1000000000ULL + static_cast<std::uint64_t>(header->tp_nsec);
+            ++count;
+        }
+        // A block of nothing but skipped packets goes straight back.
+        if (count == 0) {
+            release();
+        }
+    }
+    return count;
+}
+
+// Hands the block back once all of its packets were taken; a partly read
+// block stays ours for the next receive().
+void CanPacketRing::release() {
+    if (!block_open_ || remaining_ != 0) {
+        return;
+    }
+    auto *block = reinterpret_cast<tpacket_block_desc *>(ring_ + static_cast<std::size_t>(block_) * config_.block_size);
+    __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    block_open_ = false;
+    packet_ = nullptr;
+    block_ = (block_ + 1) % config_.block_count;
+}
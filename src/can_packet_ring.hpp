@@ -0,0 +1,58 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <linux/can.h>
+
+// One CAN frame in a ring block. frame points into the ring and stays valid
+// until the batch is released.
+struct CanRingFrame {
+    const struct can_frame *frame;
+    int ifindex;
+    // CLOCK_REALTIME RX time: the hardware stamp when the driver has one.
+    std::uint64_t timestamp_ns;
+};
+
+// Receive-only PACKET_MMAP ring (TPACKET_V3) on an AF_PACKET socket bound to
+// ETH_P_CAN on every interface. The kernel packs the frames of all CAN
+// interfaces into blocks shared with the process and hands a block over when
+// it is full or block_timeout_ms after its first frame, so frames are read in
+// place without a syscall per frame or per block. Frames sent from this host
+// are seen once, as the loopback copy any CAN_RAW socket would receive.
+class CanPacketRing {
+public:
+    CanPacketRing() = default;
+    ~CanPacketRing() { close(); }
+
+    CanPacketRing(const CanPacketRing &) = delete;
+    CanPacketRing &operator=(const CanPacketRing &) = delete;
+
+    bool open(const CanRingConfig &config, std::string &error_message);
+    void close();
+    bool active() const { return fd_ >= 0; }
+    bool same_setup(const CanRingConfig &config) const;
+    // Readable while the kernel has handed over a block.
+    int fd() const { return fd_; }
+
+    // Takes up to `capacity` frames of the current block without copying
+    // them. Returns the number taken, 0 when no block is ready; the batch
+    // must be handed back with release() before the next receive().
+    std::size_t receive(CanRingFrame *frames, std::size_t capacity);
+    void release();
+
+private:
+    CanRingConfig config_{};
+    int fd_{-1};
+    std::uint8_t *ring_{nullptr};
+    std::size_t ring_length_{0};
+    std::uint32_t block_{0};
+    // Position inside the block being read: its next packet header and the
+    // packets left after it; block_open_ while the block is ours.
+    const std::uint8_t *packet_{nullptr};
+    std::uint32_t remaining_{0};
+    bool block_open_{false};
+};
@@ -0,0 +1,152 @@
+#include "candump_log.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+std::string format_candump_line(std::uint64_t timestamp_ns, const std::string &interface_name, const struct can_frame &frame) {
+    constexpr std::uint64_t kNanosPerSecond = 1000000000ULL;
+    char buffer[64];
+    int length = std::snprintf(buffer,
+                               sizeof(buffer),
+                               "(%llu.%06llu) ",
+                               static_cast<unsigned long long>(timestamp_ns / kNanosPerSecond),
+                               static_cast<unsigned long long>((timestamp_ns % kNanosPerSecond) / 1000ULL));
+    std::string line(buffer, static_cast<std::size_t>(length));
+    line += interface_name;
+
+    if ((frame.can_id & CAN_EFF_FLAG) != 0U) {
+        length = std::snprintf(buffer, sizeof(buffer), " %08X#", static_cast<unsigned int>(frame.can_id & CAN_EFF_MASK));
+    } else {
+        length = std::snprintf(buffer, sizeof(buffer), " %03X#", static_cast<unsigned int>(frame.can_id & CAN_SFF_MASK));
+    }
+    line.append(buffer, static_cast<std::size_t>(length));
+
+    const unsigned int dlc = std::min<unsigned int>(frame.can_dlc, 8U);
+    if ((frame.can_id & CAN_RTR_FLAG) != 0U) {
+        line += 'R';
+        line += static_cast<char>('0' + dlc);
+        return line;
+    }
+    static constexpr char kHex[] = "0123456789ABCDEF";
+    for (unsigned int i = 0; i < dlc; ++i) {
+        line += kHex[frame.data[i] >> 4U];
+        line += kHex[frame.data[i] & 0x0FU];
+    }
+    return line;
+}
+
+namespace {
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+bool parse_decimal(std::string_view text, std::uint64_t &value) {
+    if (text.empty()) {
+        return false;
+    }
+    value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10U + static_cast<std::uint64_t>(c - '0');
+    }
+    return true;
+}
+
+} // namespace
+
+bool parse_candump_line(std::string_view line, CandumpEntry &entry) {
+    constexpr std::uint64_t kNanosPerSecond = 1000000000ULL;
+    // "(" seconds "." fraction ")"
+    if (line.size() < 4 || line[0] != '(') {
+        return false;
+    }
+    const std::size_t close = line.find(')');
+    const std::size_t dot = line.find('.');
+    if (close == std::string_view::npos || dot == std::string_view::npos || dot > close) {
+        return false;
+    }
+    std::uint64_t seconds = 0;
+    std::uint64_t fraction = 0;
+    const std::string_view fraction_text = line.substr(dot + 1, close - dot - 1);
+    if (!parse_decimal(line.substr(1, dot - 1), seconds) || fraction_text.size() > 9 ||
+        !parse_decimal(fraction_text, fraction)) {
+        return false;
+    }
+    for (std::size_t digits = fraction_text.size(); digits < 9; ++digits) {
+        fraction *= 10U;
+    }
+    entry.timestamp_ns = seconds * kNanosPerSecond + fraction;
+
+    std::size_t pos = line.find_first_not_of(' ', close + 1);
+    const std::size_t name_end = line.find(' ', pos);
+    if (pos == std::string_view::npos || name_end == std::string_view::npos) {
+        return false;
+    }
+    entry.interface_name = line.substr(pos, name_end - pos);
+
+    pos = line.find_first_not_of(' ', name_end);
+    const std::size_t hash = line.find('#', pos);
+    if (pos == std::string_view::npos || hash == std::string_view::npos || hash == pos || hash - pos > 8) {
+        return false;
+    }
+    std::uint32_t can_id = 0;
+    for (std::size_t i = pos; i < hash; ++i) {
+        const int digit = hex_value(line[i]);
+        if (digit < 0) {
+            return false;
+        }
+        can_id = (can_id << 4U) | static_cast<std::uint32_t>(digit);
+    }
+    std::memset(&entry.frame, 0, sizeof(entry.frame));
+    // candump writes three digits for SFF and eight for EFF identifiers.
+    if (hash - pos == 8) {
+        entry.frame.can_id = (can_id & CAN_EFF_MASK) | CAN_EFF_FLAG;
+    } else if (can_id <= CAN_SFF_MASK) {
+        entry.frame.can_id = can_id;
+    } else {
+        return false;
+    }
+
+    pos = hash + 1;
+    if (pos < line.size() && line[pos] == '#') {
+        return false; // CAN FD
+    }
+    if (pos < line.size() && (line[pos] == 'R' || line[pos] == 'r')) {
+        entry.frame.can_id |= CAN_RTR_FLAG;
+        ++pos;
+        if (pos < line.size() && line[pos] >= '0' && line[pos] <= '8') {
+            entry.frame.can_dlc = static_cast<std::uint8_t>(line[pos] - '0');
+        }
+        return true;
+    }
+
+    std::uint8_t dlc = 0;
+    while (pos < line.size() && line[pos] != ' ') {
+        if (line[pos] == '.') {
+            ++pos;
+            continue;
+        }
+        const int high = hex_value(line[pos]);
+        const int low = pos + 1 < line.size() ? hex_value(line[pos + 1]) : -1;
+        if (high < 0 || low < 0 || dlc == 8U) {
+            return false;
+        }
+        entry.frame.data[dlc++] = static_cast<std::uint8_t>((high << 4) | low);
+        pos += 2;
+    }
+    entry.frame.can_dlc = dlc;
+    return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <linux/can.h>
+
+// candump -L log lines: "(1436509052.249713) vcan0 123#DEADBEEF". EFF IDs
+// use eight hex digits, remote frames "#R" followed by the DLC.
+std::string format_candump_line(std::uint64_t timestamp_ns, const std::string &interface_name, const struct can_frame &frame);
+
+struct CandumpEntry {
+    std::uint64_t timestamp_ns;
+    std::string_view interface_name; // points into the parsed line
+    struct can_frame frame;
+};
+
+// Parses one log line without the trailing newline. Returns false for lines
+// that do not hold a classic CAN frame (blank, comments, CAN FD "##").
+bool parse_candump_line(std::string_view line, CandumpEntry &entry);
@@ -0,0 +1,244 @@
+#include "capture.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::string errno_text(const char *what, const std::string &path) {
+    return std::string(what) + " " + path + ": " + std::strerror(errno);
+}
+
+std::string rotated_name(const std::string &path, std::uint32_t generation) {
+    return generation == 0 ? path : path + "." + std::to_string(generation);
+}
+
+// path.(files-2) -> path.(files-1), ..., path -> path.1. The oldest file is
+// replaced by the rename; with a single file the current one is simply
+// recreated.
+void shift_files(const std::string &path, std::uint32_t files) {
+    for (std::uint32_t generation = files - 1; generation > 0; --generation) {
+        rename(rotated_name(path, generation - 1).c_str(), rotated_name(path, generation).c_str());
+    }
+}
+
+} // namespace
+
+CaptureWriter::CaptureWriter(CaptureWriter &&other) noexcept {
+    *this = std::move(other);
+}
+
+CaptureWriter &CaptureWriter::operator=(CaptureWriter &&other) noexcept {
+    if (this != &other) {
+        close();
+        path_ = std::move(other.path_);
+        file_bytes_ = other.file_bytes_;
+        files_ = other.files_;
+        channel_names_ = std::move(other.channel_names_);
+        fd_ = std::exchange(other.fd_, -1);
+        header_ = std::exchange(other.header_, nullptr);
+        records_ = std::exchange(other.records_, nullptr);
+        capacity_ = std::exchange(other.capacity_, 0);
+        count_ = std::exchange(other.count_, 0);
+    }
+    return *this;
+}
+
+bool CaptureWriter::open(const std::string &path,
+                         std::uint64_t file_bytes,
+                         std::uint32_t files,
+                         const std::vector<std::string> &channel_names,
+                         std::string &error_message) {
+    close();
+    if (file_bytes < kCaptureDataOffset + sizeof(CaptureRecord) || files == 0) {
+        error_message = "capture file too small";
+        return false;
+    }
+    path_ = path;
+    file_bytes_ = file_bytes;
+    files_ = files;
+    channel_names_ = channel_names;
+
+    // Keep what a previous run captured.
+    struct stat existing{};
+    if (stat(path_.c_str(), &existing) == 0) {
+        shift_files(path_, files_);
+    }
+    return open_file(error_message);
+}
+
+bool CaptureWriter::set_channels(const std::vector<std::string> &channel_names, std::string &error_message) {
+    if (!enabled() || channel_names == channel_names_) {
+        return true;
+    }
+    channel_names_ = channel_names;
+    if (count_ == 0) {
+        // Nothing refers to the old table yet; rewrite it in place.
+        finish_file();
+        return open_file(error_message);
+    }
+    return rotate(error_message);
+}
+
+void CaptureWriter::close() {
+    finish_file();
+    channel_names_.clear();
+}
+
+bool CaptureWriter::open_file(std::string &error_message) {
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        error_message = errno_text("cannot create", path_);
+        return false;
+    }
+    // Allocate every block up front so that appends never hit the
+    // filesystem allocator; fall back to a sparse file where unsupported.
+    const int allocated = posix_fallocate(fd_, 0, static_cast<off_t>(file_bytes_));
+    const bool unsupported = allocated == EOPNOTSUPP || allocated == EINVAL;
+    if (allocated != 0 && (!unsupported || ftruncate(fd_, static_cast<off_t>(file_bytes_)) < 0)) {
+        errno = allocated;
+        error_message = errno_text("cannot preallocate", path_);
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    void *mapping = mmap(nullptr, file_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapping == MAP_FAILED) {
+        error_message = errno_text("cannot map", path_);
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    header_ = static_cast<CaptureFileHeader *>(mapping);
+    std::memset(header_, 0, sizeof(*header_));
+    std::memcpy(header_->magic, kCaptureMagic, sizeof(kCaptureMagic));
+    header_->version = kCaptureVersion;
+    header_->record_size = sizeof(CaptureRecord);
+    header_->data_offset = kCaptureDataOffset;
+    capacity_ = (file_bytes_ - kCaptureDataOffset) / sizeof(CaptureRecord);
+    header_->capacity = capacity_;
+    const std::size_t named = std::min(channel_names_.size(), kCaptureMaxChannels);
+    header_->channel_count = static_cast<std::uint32_t>(named);
+    for (std::size_t i = 0; i < named; ++i) {
+        std::strncpy(header_->channel_names[i], channel_names_[i].c_str(), kCaptureNameSize - 1);
+    }
+    records_ = reinterpret_cast<CaptureRecord *>(static_cast<std::uint8_t *>(mapping) + kCaptureDataOffset);
+    count_ = 0;
+    return true;
+}
+
+void CaptureWriter::finish_file() {
+    if (header_ == nullptr) {
+        return;
+    }
+    munmap(header_, file_bytes_);
+    // Give back the preallocated tail the file never used. If this fails the
+    // file keeps its full size and record_count still bounds the data.
+    const int truncated = ftruncate(fd_, static_cast<off_t>(kCaptureDataOffset + count_ * sizeof(CaptureRecord)));
+    (void)truncated;
+    ::close(fd_);
+    fd_ = -1;
+    header_ = nullptr;
+    records_ = nullptr;
+    capacity_ = 0;
+    count_ = 0;
+}
+
+bool CaptureWriter::rotate(std::string &error_message) {
+    finish_file();
+    shift_files(path_, files_);
+    if (!open_file(error_message)) {
+        channel_names_.clear();
+        return false;
+    }
+    return true;
+}
+
+CaptureReader::CaptureReader(CaptureReader &&other) noexcept {
+    *this = std::move(other);
+}
+
+CaptureReader &CaptureReader::operator=(CaptureReader &&other) noexcept {
+    if (this != &other) {
+        close();
+        base_ = std::exchange(other.base_, nullptr);
+        length_ = std::exchange(other.length_, 0);
+        header_ = std::exchange(other.header_, nullptr);
+        records_ = std::exchange(other.records_, nullptr);
+        count_ = std::exchange(other.count_, 0);
+    }
+    return *this;
+}
+
+bool CaptureReader::open(const std::string &path, std::string &error_message) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error_message = errno_text("cannot open", path);
+        return false;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) < 0) {
+        error_message = errno_text("cannot stat", path);
+        ::close(fd);
+        return false;
+    }
+    const std::size_t length = static_cast<std::size_t>(info.st_size);
+    if (length < kCaptureDataOffset) {
+        error_message = path + ": not a capture file";
+        ::close(fd);
+        return false;
+    }
+    void *mapping = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        error_message = errno_text("cannot map", path);
+        return false;
+    }
+
+    const auto *header = static_cast<const CaptureFileHeader *>(mapping);
+    if (std::memcmp(header->magic, kCaptureMagic, sizeof(kCaptureMagic)) != 0 || header->version != kCaptureVersion ||
+        header->record_size != sizeof(CaptureRecord) || header->data_offset != kCaptureDataOffset) {
+        error_message = path + ": not a capture file or unsupported version";
+        munmap(mapping, length);
+        return false;
+    }
+
+    base_ = static_cast<const std::uint8_t *>(mapping);
+    length_ = length;
+    header_ = header;
+    records_ = reinterpret_cast<const CaptureRecord *>(base_ + kCaptureDataOffset);
+    // A file still being written may be longer than its records, and one cut
+    // short by a crash shorter than record_count claims.
+    const std::uint64_t published = __atomic_load_n(&header->record_count, __ATOMIC_ACQUIRE);
+    count_ = static_cast<std::size_t>(
+        std::min<std::uint64_t>(published, (length - kCaptureDataOffset) / sizeof(CaptureRecord)));
+    return true;
+}
+
+void CaptureReader::close() {
+    if (base_ != nullptr) {
+        munmap(const_cast<std::uint8_t *>(base_), length_);
+    }
+    base_ = nullptr;
+    length_ = 0;
+    header_ = nullptr;
+    records_ = nullptr;
+    count_ = 0;
+}
+
+std::string CaptureReader::channel_name(std::uint16_t channel) const {
+    if (header_ != nullptr && channel < header_->channel_count && header_->channel_names[channel][0] != '\0') {
+        return std::string(header_->channel_names[channel], strnlen(header_->channel_names[channel], kCaptureNameSize));
+    }
+    return "can" + std::to_string(channel);
+}
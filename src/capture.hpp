@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <linux/can.h>
+
+// Capture file layout: one page of CaptureFileHeader, then fixed-size
+// CaptureRecords up to the preallocated capacity. Fields are in host byte
+// order; readers reject files whose version does not match. record_count is
+// published after each record, so a file can be read while it is written.
+constexpr char kCaptureMagic[8] = {'C', 'A', 'N', 'B', 'C', 'A', 'P', '\0'};
+constexpr std::uint32_t kCaptureVersion = 1;
+constexpr std::size_t kCaptureDataOffset = 4096;
+constexpr std::size_t kCaptureMaxChannels = 240;
+constexpr std::size_t kCaptureNameSize = 16;
+
+enum class CaptureDirection : std::uint8_t {
+    UdpToCan = 0,
+    CanToUdp = 1,
+};
+
+struct CaptureFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t record_size;
+    std::uint64_t data_offset;
+    std::uint64_t capacity;
+    std::uint64_t record_count;
+    std::uint32_t channel_count;
+    std::uint32_t reserved;
+    // Interface name per channel index, NUL-padded.
+    char channel_names[kCaptureMaxChannels][kCaptureNameSize];
+};
+static_assert(sizeof(CaptureFileHeader) <= kCaptureDataOffset, "capture header must fit its page");
+
+struct CaptureRecord {
+    std::uint64_t timestamp_ns; // CLOCK_REALTIME when the frame was forwarded
+    std::uint32_t can_id;       // SocketCAN can_id, flags included
+    std::uint8_t dlc;
+    std::uint8_t direction;     // CaptureDirection
+    std::uint16_t channel;      // index into channel_names
+    std::uint16_t udp_port;     // listen port of the channel's UDP port
+    std::uint16_t reserved;
+    std::uint8_t data[8];
+    std::uint32_t reserved2;
+};
+static_assert(sizeof(CaptureRecord) == 32, "capture records are 32 bytes");
+
+// Appends records to the current capture file through a shared mapping and
+// rotates to a fresh preallocated file when it is full. append() does no
+// system call except on rotation.
+class CaptureWriter {
+public:
+    CaptureWriter() = default;
+    ~CaptureWriter() { close(); }
+
+    CaptureWriter(const CaptureWriter &) = delete;
+    CaptureWriter &operator=(const CaptureWriter &) = delete;
+    CaptureWriter(CaptureWriter &&other) noexcept;
+    CaptureWriter &operator=(CaptureWriter &&other) noexcept;
+
+    bool open(const std::string &path,
+              std::uint64_t file_bytes,
+              std::uint32_t files,
+              const std::vector<std::string> &channel_names,
+              std::string &error_message);
+    bool enabled() const { return header_ != nullptr; }
+    // Channel indices in the current file refer to this table, so a change
+    // starts a new file.
+    bool set_channels(const std::vector<std::string> &channel_names, std::string &error_message);
+    // Returns false when rotation failed; the writer is closed by then.
+    bool append(const CaptureRecord &record, std::string &error_message) {
+        if (count_ == capacity_ && !rotate(error_message)) {
+            return false;
+        }
+        records_[count_++] = record;
+        __atomic_store_n(&header_->record_count, count_, __ATOMIC_RELEASE);
+        return true;
+    }
+    // Truncates the current file to its records and unmaps it.
+    void close();
+
+    std::uint64_t file_records() const { return count_; }
+
+private:
+    bool open_file(std::string &error_message);
+    void finish_file();
+    bool rotate(std::string &error_message);
+
+    std::string path_;
+    std::uint64_t file_bytes_{0};
+    std::uint32_t files_{0};
+    std::vector<std::string> channel_names_;
+    int fd_{-1};
+    CaptureFileHeader *header_{nullptr};
+    CaptureRecord *records_{nullptr};
+    std::uint64_t capacity_{0};
+    std::uint64_t count_{0};
+};
+
+// Read-only mapping of one capture file.
+class CaptureReader {
+public:
+    CaptureReader() = default;
+    ~CaptureReader() { close(); }
+
+    CaptureReader(const CaptureReader &) = delete;
+    CaptureReader &operator=(const CaptureReader &) = delete;
+    CaptureReader(CaptureReader &&other) noexcept;
+    CaptureReader &operator=(CaptureReader &&other) noexcept;
+
+    bool open(const std::string &path, std::string &error_message);
+    void close();
+
+    std::size_t size() const { return count_; }
+    std::size_t channel_count() const { return header_ == nullptr ? 0 : header_->channel_count; }
+    const CaptureRecord &record(std::size_t index) const { return records_[index]; }
+    // Interface name of a record's channel; "can<N>" when the header has none.
+    std::string channel_name(std::uint16_t channel) const;
+
+private:
+    const std::uint8_t *base_{nullptr};
+    std::size_t length_{0};
+    const CaptureFileHeader *header_{nullptr};
+    const CaptureRecord *records_{nullptr};
+    std::size_t count_{0};
+};
@@ -0,0 +1,165 @@
+#include "candump_log.hpp"
+#include "capture.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <linux/can.h>
+
+namespace {
+
+// LINKTYPE_CAN_SOCKETCAN with nanosecond timestamps.
+constexpr std::uint32_t kPcapNanosecondMagic = 0xA1B23C4DU;
+constexpr std::uint32_t kLinktypeCanSocketcan = 227;
+constexpr std::size_t kPcapCanFrameSize = 16;
+
+enum class Format {
+    Candump,
+    Pcap,
+};
+
+struct Options {
+    Format format{Format::Candump};
+    bool filter_direction{false};
+    CaptureDirection direction{CaptureDirection::UdpToCan};
+    const char *output{nullptr};
+    std::vector<const char *> inputs;
+};
+
+void usage(const char *argv0) {
+    std::fprintf(stderr,
+                 "Usage: %s [--format candump|pcap] [--direction udp-to-can|can-to-udp] [-o output] <capture>...\n"
+                 "Captures are exported in the order given (oldest first, e.g. cap.2 cap.1 cap).\n",
+                 argv0);
+}
+
+bool parse_options(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(arg, "--format") == 0 && has_value) {
+            const char *value = argv[++i];
+            if (std::strcmp(value, "candump") == 0) {
+                options.format = Format::Candump;
+            } else if (std::strcmp(value, "pcap") == 0) {
+                options.format = Format::Pcap;
+            } else {
+                return false;
+            }
+        } else if (std::strcmp(arg, "--direction") == 0 && has_value) {
+            const char *value = argv[++i];
+            options.filter_direction = true;
+            if (std::strcmp(value, "udp-to-can") == 0) {
+                options.direction = CaptureDirection::UdpToCan;
+            } else if (std::strcmp(value, "can-to-udp") == 0) {
+                options.direction = CaptureDirection::CanToUdp;
+            } else {
+                return false;
+            }
+        } else if (std::strcmp(arg, "-o") == 0 && has_value) {
+            options.output = argv[++i];
+        } else if (arg[0] == '-') {
+            return false;
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+    return !options.inputs.empty();
+}
+
+struct can_frame record_frame(const CaptureRecord &record) {
+    struct can_frame frame{};
+    frame.can_id = record.can_id;
+    frame.can_dlc = record.dlc;
+    std::memcpy(frame.data, record.data, sizeof(frame.data));
+    return frame;
+}
+
+void write_u32(std::FILE *out, std::uint32_t value) {
+    std::fwrite(&value, sizeof(value), 1, out);
+}
+
+void write_pcap_header(std::FILE *out) {
+    write_u32(out, kPcapNanosecondMagic);
+    const std::uint16_t version[2] = {2, 4};
+    std::fwrite(version, sizeof(version), 1, out);
+    write_u32(out, 0); // thiszone
+    write_u32(out, 0); // sigfigs
+    write_u32(out, 65535);
+    write_u32(out, kLinktypeCanSocketcan);
+}
+
+// The SocketCAN pseudo-header carries the CAN ID in network byte order.
+void write_pcap_record(std::FILE *out, const CaptureRecord &record) {
+    constexpr std::uint64_t kNanosPerSecond = 1000000000ULL;
+    std::uint8_t packet[kPcapCanFrameSize] = {};
+    packet[0] = static_cast<std::uint8_t>(record.can_id >> 24U);
+    packet[1] = static_cast<std::uint8_t>(record.can_id >> 16U);
+    packet[2] = static_cast<std::uint8_t>(record.can_id >> 8U);
+    packet[3] = static_cast<std::uint8_t>(record.can_id);
+    packet[4] = record.dlc;
+    std::memcpy(&packet[8], record.data, sizeof(record.data));
+
+    write_u32(out, static_cast<std::uint32_t>(record.timestamp_ns / kNanosPerSecond));
+    write_u32(out, static_cast<std::uint32_t>(record.timestamp_ns % kNanosPerSecond));
+    write_u32(out, sizeof(packet));
+    write_u32(out, sizeof(packet));
+    std::fwrite(packet, sizeof(packet), 1, out);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::FILE *out = stdout;
+    if (options.output != nullptr) {
+        out = std::fopen(options.output, "wb");
+        if (out == nullptr) {
+            std::fprintf(stderr, "cannot open %s: %s\n", options.output, std::strerror(errno));
+            return 1;
+        }
+    }
+    if (options.format == Format::Pcap) {
+        write_pcap_header(out);
+    }
+
+    std::size_t exported = 0;
+    int status = 0;
+    for (const char *input : options.inputs) {
+        CaptureReader reader;
+        std::string error;
+        if (!reader.open(input, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            status = 1;
+            continue;
+        }
+        for (std::size_t i = 0; i < reader.size(); ++i) {
+            const CaptureRecord &record = reader.record(i);
+            if (options.filter_direction && record.direction != static_cast<std::uint8_t>(options.direction)) {
+                continue;
+            }
+            if (options.format == Format::Pcap) {
+                write_pcap_record(out, record);
+            } else {
+                const std::string line =
+                    format_candump_line(record.timestamp_ns, reader.channel_name(record.channel), record_frame(record));
+                std::fprintf(out, "%s\n", line.c_str());
+            }
+            ++exported;
+        }
+    }
+
+    if (out != stdout) {
+        std::fclose(out);
+    }
+    std::fprintf(stderr, "exported %zu frames\n", exported);
+    return status;
+}
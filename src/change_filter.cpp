@@ -0,0 +1,76 @@
+#include "change_filter.hpp"
+
+#include <cstring>
+
+bool LastValueCache::initialize(const ChangeFilterConfig &config) {
+    enabled_ = config.enabled;
+    sff_entries_.clear();
+    eff_entries_.clear();
+    eff_mask_ = 0;
+    eff_overflows_ = 0;
+    if (!enabled_) {
+        return true;
+    }
+
+    refresh_interval_ns_ = static_cast<std::uint64_t>(config.refresh_interval_ms) * 1000000ULL;
+
+    std::size_t capacity = 1;
+    while (capacity < config.eff_capacity) {
+        capacity <<= 1U;
+    }
+    sff_entries_.assign(kSffEntries, Entry{});
+    eff_entries_.assign(capacity, Entry{});
+    eff_mask_ = capacity - 1;
+    return true;
+}
+
+bool LastValueCache::should_forward(const struct can_frame &frame, std::uint64_t now_ns) {
+    if (!enabled_ || (frame.can_id & (CAN_RTR_FLAG | CAN_ERR_FLAG)) != 0U) {
+        return true;
+    }
+
+    if ((frame.can_id & CAN_EFF_FLAG) == 0U) {
+        return check_and_update(sff_entries_[frame.can_id & CAN_SFF_MASK], frame, now_ns);
+    }
+
+    Entry *entry = find_eff_slot(frame.can_id & CAN_EFF_MASK);
+    if (entry == nullptr) {
+        ++eff_overflows_;
+        return true;
+    }
+    return check_and_update(*entry, frame, now_ns);
+}
+
+bool LastValueCache::check_and_update(Entry &entry, const struct can_frame &frame, std::uint64_t now_ns) {
+    const std::uint8_t dlc = frame.can_dlc > CAN_MAX_DLEN ? CAN_MAX_DLEN : frame.can_dlc;
+    if (entry.valid != 0U && entry.dlc == dlc && std::memcmp(entry.data, frame.data, dlc) == 0) {
+        const bool refresh_due = refresh_interval_ns_ != 0U && now_ns - entry.forwarded_ns >= refresh_interval_ns_;
+        if (!refresh_due) {
+            return false;
+        }
+    }
+
+    entry.valid = 1;
+    entry.can_id = frame.can_id;
+    entry.dlc = dlc;
+    std::memcpy(entry.data, frame.data, dlc);
+    entry.forwarded_ns = now_ns;
+    return true;
+}
+
+LastValueCache::Entry *LastValueCache::find_eff_slot(std::uint32_t can_id) {
+    // Fibonacci hashing spreads the dense low bits of J1939-style IDs.
+    std::size_t slot = static_cast<std::size_t>((can_id * 0x9E3779B1U) >> 7U) & eff_mask_;
+    for (std::size_t probe = 0; probe < kMaxProbes && probe <= eff_mask_; ++probe) {
+        Entry &entry = eff_entries_[slot];
+        if (entry.valid == 0U) {
+            entry.can_id = can_id | CAN_EFF_FLAG;
+            return &entry;
+        }
+        if ((entry.can_id & CAN_EFF_MASK) == can_id) {
+            return &entry;
+        }
+        slot = (slot + 1) & eff_mask_;
+    }
+    return nullptr;
+}
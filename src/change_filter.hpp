@@ -0,0 +1,49 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <linux/can.h>
+
+// Per-channel last-value cache used for change-only forwarding. Standard
+// (11-bit) data frames index a direct 2048-entry table; extended frames go to
+// a fixed-capacity open-addressing hash. All storage is allocated by
+// initialize(), so should_forward() never touches the heap. When the EFF hash
+// has no free slot within its probe window the frame is simply forwarded.
+class LastValueCache {
+public:
+    bool initialize(const ChangeFilterConfig &config);
+    bool enabled() const { return enabled_; }
+
+    // Returns true when the frame must be forwarded: first sighting of its ID,
+    // changed DLC or payload, forced refresh due, or a frame type the cache
+    // does not track (RTR, error frames). Records the frame when forwarded.
+    bool should_forward(const struct can_frame &frame, std::uint64_t now_ns);
+
+    std::uint64_t eff_overflows() const { return eff_overflows_; }
+
+private:
+    static constexpr std::size_t kSffEntries = CAN_SFF_MASK + 1U;
+    static constexpr std::size_t kMaxProbes = 8;
+
+    struct Entry {
+        std::uint64_t forwarded_ns{0};
+        std::uint32_t can_id{0};
+        std::uint8_t valid{0};
+        std::uint8_t dlc{0};
+        std::uint8_t data[CAN_MAX_DLEN]{};
+    };
+
+    bool check_and_update(Entry &entry, const struct can_frame &frame, std::uint64_t now_ns);
+    Entry *find_eff_slot(std::uint32_t can_id);
+
+    bool enabled_{false};
+    std::uint64_t refresh_interval_ns_{0};
+    std::vector<Entry> sff_entries_;
+    std::vector<Entry> eff_entries_;
+    std::size_t eff_mask_{0};
+    std::uint64_t eff_overflows_{0};
+};
@@ -1,5 +1,6 @@
 #include "config.hpp"
 
+#include <algorithm>
 #include <cerrno>
 #include <cctype>
 #include <cstdint>
@@ -57,8 +58,509 @@ bool parse_server(const Json::Value &node, ServerConfig &server, std::string &er
     return true;
 }
 
+bool parse_change_filter(const Json::Value &node,
+                         ChangeFilterConfig &filter,
+                         const std::string &context,
+                         std::string &error_message) {
+    if (node.isNull()) {
+        return true;
+    }
+    if (!node.isObject()) {
+        error_message = context + " must be an object";
+        return false;
+    }
+
+    filter.enabled = true;
+    const auto &enabled = node["enabled"];
+    if (!enabled.isNull()) {
+        if (!enabled.isBool()) {
+            error_message = context + ".enabled must be a boolean";
+            return false;
+        }
+        filter.enabled = enabled.asBool();
+    }
+
+    const auto &refresh = node["refresh_interval_ms"];
+    if (!refresh.isNull()) {
+        if (!refresh.isUInt()) {
+            error_message = context + ".refresh_interval_ms must be an unsigned integer";
+            return false;
+        }
+        filter.refresh_interval_ms = refresh.asUInt();
+    }
+
+    const auto &capacity = node["eff_capacity"];
+    if (!capacity.isNull()) {
+        if (!capacity.isUInt()) {
+            error_message = context + ".eff_capacity must be an unsigned integer";
+            return false;
+        }
+        filter.eff_capacity = capacity.asUInt();
+        if (filter.eff_capacity == 0 || filter.eff_capacity > (1U << 20U)) {
+            error_message = context + ".eff_capacity must be within [1,1048576]";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parse_tx_queue(const Json::Value &node, TxQueueConfig &queue, const std::string &context, std::string &error_message) {
+    if (node.isNull()) {
+        return true;
+    }
+    if (!node.isObject()) {
+        error_message = context + " must be an object";
+        return false;
+    }
+
+    queue.enabled = true;
+    const auto parse_bool = [&](const char *key, bool &dest) -> bool {
+        const auto &value = node[key];
+        if (value.isNull()) {
+            return true;
+        }
+        if (!value.isBool()) {
+            error_message = context + "." + key + " must be a boolean";
+            return false;
+        }
+        dest = value.asBool();
+        return true;
+    };
+    if (!parse_bool("enabled", queue.enabled) || !parse_bool("priority", queue.priority)) {
+        return false;
+    }
+
+    const auto &depth = node["depth"];
+    if (!depth.isNull()) {
+        if (!depth.isUInt() || depth.asUInt() == 0 || depth.asUInt() > 65534U) {
+            error_message = context + ".depth must be within [1,65534]";
+            return false;
+        }
+        queue.depth = depth.asUInt();
+    }
+    return true;
+}
+
+// Fields present in `node` override those already in `buffers`, which hold
+// the inherited defaults.
+bool parse_socket_buffers(const Json::Value &node,
+                          SocketBufferConfig &buffers,
+                          const std::string &context,
+                          std::string &error_message) {
+    if (node.isNull()) {
+        return true;
+    }
+    if (!node.isObject()) {
+        error_message = context + " must be an object";
+        return false;
+    }
+
+    for (const auto &entry : {std::make_pair("rcvbuf", &buffers.rcvbuf),
+                              std::make_pair("sndbuf", &buffers.sndbuf),
+                              std::make_pair("max_rcvbuf", &buffers.max_rcvbuf)}) {
+        const auto &field = node[entry.first];
+        if (field.isNull()) {
+            continue;
+        }
+        if (!field.isUInt() || field.asUInt() < 4096U || field.asUInt() > (1U << 30)) {
+            error_message = context + "." + entry.first + " must be within [4096,1073741824]";
+            return false;
+        }
+        *entry.second = field.asUInt();
+    }
+    for (const auto &entry : {std::make_pair("force", &buffers.force), std::make_pair("adaptive", &buffers.adaptive)}) {
+        const auto &field = node[entry.first];
+        if (field.isNull()) {
+            continue;
+        }
+        if (!field.isBool()) {
+            error_message = context + "." + entry.first + " must be a boolean";
+            return false;
+        }
+        *entry.second = field.asBool();
+    }
+    if (buffers.adaptive && buffers.rcvbuf > buffers.max_rcvbuf) {
+        error_message = context + ".max_rcvbuf must not be below rcvbuf";
+        return false;
+    }
+    return true;
+}
+
+bool parse_capture(const Json::Value &node, CaptureConfig &capture, std::string &error_message) {
+    if (node.isNull()) {
+        return true;
+    }
+    if (!node.isObject()) {
+        error_message = "capture must be an object";
+        return false;
+    }
+
+    capture.enabled = true;
+    const auto &enabled = node["enabled"];
+    if (!enabled.isNull()) {
+        if (!enabled.isBool()) {
+            error_message = "capture.enabled must be a boolean";
+            return false;
+        }
+        capture.enabled = enabled.asBool();
+    }
+
+    const auto &path = node["path"];
+    if (!path.isString() || path.asString().empty()) {
+        error_message = "capture.path must be a non-empty string";
+        return false;
+    }
+    capture.path = path.asString();
+
+    const auto &size = node["file_size_mb"];
+    if (!size.isNull()) {
+        if (!size.isUInt() || size.asUInt() == 0 || size.asUInt() > 4096U) {
+            error_message = "capture.file_size_mb must be within [1,4096]";
+            return false;
+        }
+        capture.file_size_mb = size.asUInt();
+    }
+
+    const auto &files = node["files"];
+    if (!files.isNull()) {
+        if (!files.isUInt() || files.asUInt() == 0 || files.asUInt() > 100U) {
+            error_message = "capture.files must be within [1,100]";
+            return false;
+        }
+        capture.files = files.asUInt();
+    }
+    return true;
+}
+
+bool parse_xdp(const Json::Value &node, XdpConfig &xdp, std::string &error_message) {
+    if (node.isNull()) {
+        return true;
+    }
+    if (!node.isObject()) {
+        error_message = "xdp must be an object";
+        return false;
+    }
+
+    xdp.enabled = true;
+    const auto parse_bool = [&node, &error_message](const char *key, bool &value) {
+        const auto &field = node[key];
+        if (field.isNull()) {
+            return true;
+        }
+        if (!field.isBool()) {
+            error_message = std::string("xdp.") + key + " must be a boolean";
+            return false;
+        }
+        value = field.asBool();
+        return true;
+    };
+    if (!parse_bool("enabled", xdp.enabled) || !parse_bool("zero_copy", xdp.zero_copy) ||
+        !parse_bool("skb_mode", xdp.skb_mode)) {
+        return false;
+    }
+    if (xdp.zero_copy && xdp.skb_mode) {
+        error_message = "xdp.zero_copy cannot be combined with xdp.skb_mode";
+        return false;
+    }
+
+    const auto &interface = node["interface"];
+    if (!interface.isString() || interface.asString().empty()) {
+        error_message = "xdp.interface must be a non-empty string";
+        return false;
+    }
+    xdp.interface = interface.asString();
+
+    const auto &queues = node["queues"];
+    if (!queues.isNull()) {
+        if (!queues.isUInt() || queues.asUInt() == 0 || queues.asUInt() > 64U) {
+            error_message = "xdp.queues must be within [1,64]";
+            return false;
+        }
+        xdp.queues = queues.asUInt();
+    }
+    return true;
+}
+
+bool parse_can_rx_ring(const Json::Value &node, CanRingConfig &ring, std::string &error_message) {
+    if (node.isNull()) {
+        return true;
+    }
+    if (!node.isObject()) {
+        error_message = "can_rx_ring must be an object";
+        return false;
+    }
+
+    ring.enabled = true;
+    const auto &enabled = node["enabled"];
+    if (!enabled.isNull()) {
+        if (!enabled.isBool()) {
+            error_message = "can_rx_ring.enabled must be a boolean";
+            return false;
+        }
+        ring.enabled = enabled.asBool();
+    }
+    const auto parse_uint = [&node, &error_message](const char *key, std::uint32_t min, std::uint32_t max, std::uint32_t &value) {
+        const auto &field = node[key];
+        if (field.isNull()) {
+            return true;
+        }
+        if (!field.isUInt() || field.asUInt() < min || field.asUInt() > max) {
+            error_message = std::string("can_rx_ring.") + key + " must be within [" + std::to_string(min) + "," +
+                            std::to_string(max) + "]";
+            return false;
+        }
+        value = field.asUInt();
+        return true;
+    };
+    constexpr std::uint32_t kPageSize = 4096;
+    if (!parse_uint("block_size", kPageSize, 4U * 1024U * 1024U, ring.block_size) ||
+        !parse_uint("block_count", 2, 1024, ring.block_count) ||
+        !parse_uint("block_timeout_ms", 1, 1000, ring.block_timeout_ms)) {
+        return false;
+    }
+    if (ring.block_size % kPageSize != 0) {
+        error_message = "can_rx_ring.block_size must be a multiple of 4096";
+        return false;
+    }
+    return true;
+}
+
+bool parse_udp_filter(const Json::Value &node, UdpFilterConfig &filter, std::string &error_message) {
+    if (node.isNull()) {
+        return true;
+    }
+    if (!node.isObject()) {
+        error_message = "udp_filter must be an object";
+        return false;
+    }
+
+    filter.enabled = true;
+    for (const auto &entry : {std::make_pair("enabled", &filter.enabled), std::make_pair("info_bytes", &filter.info_bytes)}) {
+        const auto &field = node[entry.first];
+        if (field.isNull()) {
+            continue;
+        }
+        if (!field.isBool()) {
+            error_message = std::string("udp_filter.") + entry.first + " must be a boolean";
+            return false;
+        }
+        *entry.second = field.asBool();
+    }
+    return true;
+}
+
+bool parse_cyclic_tx(const Json::Value &node, CyclicTxConfig &cyclic, std::string &error_message) {
+    if (node.isNull()) {
+        return true;
+    }
+    if (!node.isObject()) {
+        error_message = "cyclic_tx must be an object";
+        return false;
+    }
+
+    cyclic.enabled = true;
+    const auto &enabled = node["enabled"];
+    if (!enabled.isNull()) {
+        if (!enabled.isBool()) {
+            error_message = "cyclic_tx.enabled must be a boolean";
+            return false;
+        }
+        cyclic.enabled = enabled.asBool();
+    }
+    const auto parse_uint = [&node, &error_message](const char *key, std::uint32_t min, std::uint32_t max, std::uint32_t &value) {
+        const auto &field = node[key];
+        if (field.isNull()) {
+            return true;
+        }
+        if (!field.isUInt() || field.asUInt() < min || field.asUInt() > max) {
+            error_message = std::string("cyclic_tx.") + key + " must be within [" + std::to_string(min) + "," +
+                            std::to_string(max) + "]";
+            return false;
+        }
+        value = field.asUInt();
+        return true;
+    };
+    return parse_uint("max_jobs", 1, 65536, cyclic.max_jobs) &&
+           parse_uint("min_period_us", 100, 3600U * 1000000U, cyclic.min_period_us);
+}
+
+bool parse_replay(const Json::Value &node, ReplayConfig &replay, std::string &error_message) {
+    if (node.isNull()) {
+        return true;
+    }
+    if (!node.isObject()) {
+        error_message = "replay must be an object";
+        return false;
+    }
+
+    replay.enabled = true;
+    const auto parse_bool = [&](const char *key, bool &dest) -> bool {
+        const auto &value = node[key];
+        if (value.isNull()) {
+            return true;
+        }
+        if (!value.isBool()) {
+            error_message = std::string("replay.") + key + " must be a boolean";
+            return false;
+        }
+        dest = value.asBool();
+        return true;
+    };
+    if (!parse_bool("enabled", replay.enabled) || !parse_bool("loop", replay.loop)) {
+        return false;
+    }
+
+    const auto &path = node["path"];
+    if (!path.isString() || path.asString().empty()) {
+        error_message = "replay.path must be a non-empty string";
+        return false;
+    }
+    replay.path = path.asString();
+
+    const auto &speed = node["speed"];
+    if (!speed.isNull()) {
+        if (!speed.isNumeric() || speed.asDouble() < 0.0 || speed.asDouble() > 1000.0) {
+            error_message = "replay.speed must be within [0,1000]";
+            return false;
+        }
+        replay.speed = speed.asDouble();
+    }
+
+    const auto &inject = node["inject"];
+    if (!inject.isNull()) {
+        if (inject.isString() && inject.asString() == "udp") {
+            replay.inject = ReplayInject::Udp;
+        } else if (inject.isString() && inject.asString() == "can") {
+            replay.inject = ReplayInject::Can;
+        } else {
+            error_message = "replay.inject must be \"udp\" or \"can\"";
+            return false;
+        }
+    }
+
+    const auto &direction = node["direction"];
+    if (!direction.isNull()) {
+        replay.filter_direction = true;
+        if (direction.isString() && direction.asString() == "udp_to_can") {
+            replay.direction = CaptureDirection::UdpToCan;
+        } else if (direction.isString() && direction.asString() == "can_to_udp") {
+            replay.direction = CaptureDirection::CanToUdp;
+        } else {
+            error_message = "replay.direction must be \"udp_to_can\" or \"can_to_udp\"";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Subscriptions per channel at most; a wider id_range must list its IDs.
+constexpr std::uint32_t kMaxBcmRxIds = 2048;
+
+bool parse_bcm_rx(const Json::Value &node,
+                  const IdRange &id_range,
+                  BcmRxConfig &bcm_rx,
+                  const std::string &context,
+                  std::string &error_message) {
+    if (node.isNull()) {
+        return true;
+    }
+    if (!node.isObject()) {
+        error_message = context + " must be an object";
+        return false;
+    }
+
+    bcm_rx.enabled = true;
+    for (const auto &entry : {std::make_pair("enabled", &bcm_rx.enabled),
+                              std::make_pair("changes_only", &bcm_rx.changes_only)}) {
+        const auto &field = node[entry.first];
+        if (field.isNull()) {
+            continue;
+        }
+        if (!field.isBool()) {
+            error_message = context + "." + entry.first + " must be a boolean";
+            return false;
+        }
+        *entry.second = field.asBool();
+    }
+
+    const auto &throttle = node["throttle_ms"];
+    if (!throttle.isNull()) {
+        if (!throttle.isUInt() || throttle.asUInt() > 60000) {
+            error_message = context + ".throttle_ms must be within [0,60000]";
+            return false;
+        }
+        bcm_rx.throttle_ms = throttle.asUInt();
+    }
+    if (!bcm_rx.changes_only && bcm_rx.throttle_ms == 0) {
+        error_message = context + " without changes_only needs a throttle_ms";
+        return false;
+    }
+
+    const auto &ids = node["ids"];
+    if (!ids.isNull()) {
+        if (!ids.isArray() || ids.empty() || ids.size() > kMaxBcmRxIds) {
+            error_message = context + ".ids must be an array of 1 to " + std::to_string(kMaxBcmRxIds) + " IDs";
+            return false;
+        }
+        for (const auto &id : ids) {
+            std::uint32_t parsed = 0;
+            if (!id.isString() || !parse_hex_uint32(id.asString(), parsed) || parsed > 0x1FFFFFFFu) {
+                error_message = context + ".ids entries must be hex/decimal strings within the 29-bit CAN limit";
+                return false;
+            }
+            bcm_rx.ids.push_back(parsed);
+        }
+        std::sort(bcm_rx.ids.begin(), bcm_rx.ids.end());
+        bcm_rx.ids.erase(std::unique(bcm_rx.ids.begin(), bcm_rx.ids.end()), bcm_rx.ids.end());
+    } else if (id_range.max - id_range.min >= kMaxBcmRxIds) {
+        error_message = context + ": id_range spans more than " + std::to_string(kMaxBcmRxIds) + " IDs, list them in ids";
+        return false;
+    }
+    return true;
+}
+
+bool parse_tx_pacing(const Json::Value &node, TxPacingConfig &pacing, const std::string &context, std::string &error_message) {
+    if (node.isNull()) {
+        return true;
+    }
+    if (!node.isObject()) {
+        error_message = context + " must be an object";
+        return false;
+    }
+
+    pacing.enabled = true;
+    const auto &enabled = node["enabled"];
+    if (!enabled.isNull()) {
+        if (!enabled.isBool()) {
+            error_message = context + ".enabled must be a boolean";
+            return false;
+        }
+        pacing.enabled = enabled.asBool();
+    }
+
+    const auto &load = node["bus_load_percent"];
+    if (!load.isNull()) {
+        if (!load.isUInt() || load.asUInt() == 0 || load.asUInt() > 100U) {
+            error_message = context + ".bus_load_percent must be within [1,100]";
+            return false;
+        }
+        pacing.bus_load_percent = load.asUInt();
+    }
+
+    const auto &burst = node["burst_frames"];
+    if (!burst.isNull()) {
+        if (!burst.isUInt() || burst.asUInt() == 0 || burst.asUInt() > 1024U) {
+            error_message = context + ".burst_frames must be within [1,1024]";
+            return false;
+        }
+        pacing.burst_frames = burst.asUInt();
+    }
+    return true;
+}
+
 bool parse_channel(const Json::Value &node,
                    ChannelConfig &channel,
+                   const SocketBufferConfig &default_buffers,
                    std::set<std::string> &global_vcan_names,
                    std::set<std::uint32_t> &channel_ids,
                    std::vector<IdRange> &ranges,
@@ -102,6 +604,15 @@ bool parse_channel(const Json::Value &node,
         return false;
     }
 
+    const auto &txqueuelen_val = node["txqueuelen"];
+    if (!txqueuelen_val.isNull()) {
+        if (!txqueuelen_val.isUInt() || txqueuelen_val.asUInt() == 0) {
+            error_message = context + ".txqueuelen must be a positive integer";
+            return false;
+        }
+        channel.txqueuelen = txqueuelen_val.asUInt();
+    }
+
     const auto &range_node = node["id_range"];
     if (!range_node.isObject()) {
         error_message = context + ".id_range must be an object";
@@ -145,13 +656,104 @@ bool parse_channel(const Json::Value &node,
         }
     }
     ranges.push_back(channel.id_range);
+
+    if (!parse_change_filter(node["change_filter"], channel.change_filter, context + ".change_filter", error_message)) {
+        return false;
+    }
+    if (!parse_bcm_rx(node["bcm_rx"], channel.id_range, channel.bcm_rx, context + ".bcm_rx", error_message)) {
+        return false;
+    }
+    if (!parse_tx_pacing(node["tx_pacing"], channel.tx_pacing, context + ".tx_pacing", error_message)) {
+        return false;
+    }
+    if (!parse_tx_queue(node["tx_queue"], channel.tx_queue, context + ".tx_queue", error_message)) {
+        return false;
+    }
+    channel.socket_buffers = default_buffers;
+    if (!parse_socket_buffers(node["socket_buffers"], channel.socket_buffers, context + ".socket_buffers", error_message)) {
+        return false;
+    }
+    if (channel.tx_pacing.enabled && !channel.tx_queue.enabled) {
+        if (!node["tx_queue"].isNull()) {
+            error_message = context + ".tx_pacing requires tx_queue";
+            return false;
+        }
+        // Paced frames have to wait somewhere; default to arrival order.
+        channel.tx_queue.enabled = true;
+        channel.tx_queue.priority = false;
+    }
+    return true;
+}
+
+bool parse_isotp(const Json::Value &node,
+                 IsoTpConfig &link,
+                 std::set<std::pair<std::string, std::uint32_t>> &receivers,
+                 const std::string &context,
+                 std::string &error_message) {
+    if (!node.isObject()) {
+        error_message = context + " must be an object";
+        return false;
+    }
+    const auto &vcan = node["vcan_name"];
+    if (!vcan.isString() || vcan.asString().empty()) {
+        error_message = context + ".vcan_name must be a non-empty string";
+        return false;
+    }
+    link.vcan_name = vcan.asString();
+
+    for (const auto &entry : {std::make_pair("tx_id", &link.tx_id), std::make_pair("rx_id", &link.rx_id)}) {
+        const auto &field = node[entry.first];
+        if (!field.isString() || !parse_hex_uint32(field.asString(), *entry.second) || *entry.second > 0x1FFFFFFFu) {
+            error_message = context + "." + entry.first + " must be a hex/decimal string within the 29-bit CAN limit";
+            return false;
+        }
+    }
+    if (link.tx_id == link.rx_id) {
+        error_message = context + ": tx_id and rx_id must differ";
+        return false;
+    }
+    // Two sockets on one rx_id would both reassemble, and both send flow control.
+    if (!receivers.emplace(link.vcan_name, link.rx_id).second) {
+        error_message = context + ": rx_id is already used on " + link.vcan_name;
+        return false;
+    }
+
+    const auto &block_size = node["block_size"];
+    if (!block_size.isNull()) {
+        if (!block_size.isUInt() || block_size.asUInt() > 255) {
+            error_message = context + ".block_size must be within [0,255]";
+            return false;
+        }
+        link.block_size = block_size.asUInt();
+    }
+    const auto &st_min = node["st_min_us"];
+    if (!st_min.isNull()) {
+        // The flow control byte holds 100-900 us or whole milliseconds up to 127.
+        if (!st_min.isUInt() || st_min.asUInt() > 127000 ||
+            (st_min.asUInt() < 1000 ? st_min.asUInt() % 100 : st_min.asUInt() % 1000) != 0) {
+            error_message = context + ".st_min_us must be 0, 100-900 in steps of 100, or whole ms up to 127000";
+            return false;
+        }
+        link.st_min_us = st_min.asUInt();
+    }
+    const auto &padding = node["padding"];
+    if (!padding.isNull()) {
+        std::uint32_t value = 0;
+        if (!padding.isString() || !parse_hex_uint32(padding.asString(), value) || value > 0xFF) {
+            error_message = context + ".padding must be a hex/decimal byte string";
+            return false;
+        }
+        link.padding = static_cast<int>(value);
+    }
     return true;
 }
 
 bool parse_port(const Json::Value &node,
                 PortConfig &port,
+                const SocketBufferConfig &default_buffers,
                 std::set<std::uint16_t> &listen_ports,
                 std::set<std::string> &global_vcan_names,
+                std::set<std::pair<std::string, std::uint32_t>> &isotp_receivers,
                 const std::string &context,
                 std::string &error_message) {
     if (!node.isObject()) {
@@ -215,6 +817,54 @@ bool parse_port(const Json::Value &node,
         return false;
     }
 
+    const auto &format = node["frame_format"];
+    if (!format.isNull()) {
+        if (format.isString() && format.asString() == "standard") {
+            port.frame_format = FrameFormat::Standard;
+        } else if (format.isString() && format.asString() == "timestamped") {
+            port.frame_format = FrameFormat::Timestamped;
+        } else {
+            error_message = context + ".frame_format must be \"standard\" or \"timestamped\"";
+            return false;
+        }
+    }
+
+    const auto &scheduled = node["scheduled_tx"];
+    if (!scheduled.isNull()) {
+        if (!scheduled.isBool()) {
+            error_message = context + ".scheduled_tx must be a boolean";
+            return false;
+        }
+        port.scheduled_tx = scheduled.asBool();
+        if (port.scheduled_tx && port.frame_format != FrameFormat::Timestamped) {
+            error_message = context + ".scheduled_tx requires frame_format \"timestamped\"";
+            return false;
+        }
+    }
+
+    const auto &sequence_header = node["sequence_header"];
+    if (!sequence_header.isNull()) {
+        if (!sequence_header.isBool()) {
+            error_message = context + ".sequence_header must be a boolean";
+            return false;
+        }
+        port.sequence_header = sequence_header.asBool();
+    }
+
+    const auto &xdp_ingress = node["xdp_ingress"];
+    if (!xdp_ingress.isNull()) {
+        if (!xdp_ingress.isBool()) {
+            error_message = context + ".xdp_ingress must be a boolean";
+            return false;
+        }
+        port.xdp_ingress = xdp_ingress.asBool();
+    }
+
+    port.socket_buffers = default_buffers;
+    if (!parse_socket_buffers(node["socket_buffers"], port.socket_buffers, context + ".socket_buffers", error_message)) {
+        return false;
+    }
+
     const auto &channels = node["channels"];
     if (!channels.isArray() || channels.empty()) {
         error_message = context + ".channels must be a non-empty array";
@@ -227,16 +877,65 @@ bool parse_port(const Json::Value &node,
     for (Json::ArrayIndex i = 0; i < channels.size(); ++i) {
         ChannelConfig channel{};
         const std::string chan_ctx = context + ".channels[" + std::to_string(i) + "]";
-        if (!parse_channel(channels[i], channel, global_vcan_names, channel_ids, ranges, chan_ctx, error_message)) {
+        if (!parse_channel(
+                channels[i], channel, default_buffers, global_vcan_names, channel_ids, ranges, chan_ctx, error_message)) {
             return false;
         }
         port.channels.push_back(std::move(channel));
     }
 
+    const auto &isotp = node["isotp"];
+    if (!isotp.isNull() && !isotp.isArray()) {
+        error_message = context + ".isotp must be an array";
+        return false;
+    }
+    std::set<std::uint32_t> isotp_tx_ids;
+    for (Json::ArrayIndex i = 0; i < isotp.size(); ++i) {
+        IsoTpConfig link{};
+        const std::string link_ctx = context + ".isotp[" + std::to_string(i) + "]";
+        if (!parse_isotp(isotp[i], link, isotp_receivers, link_ctx, error_message)) {
+            return false;
+        }
+        // The server addresses a link by tx_id.
+        if (!isotp_tx_ids.insert(link.tx_id).second) {
+            error_message = link_ctx + ": tx_id is already used on this port";
+            return false;
+        }
+        port.isotp.push_back(std::move(link));
+    }
+
+    return true;
+}
+
+// The channel bridging the link's interface would forward every segment of
+// the link frame by frame next to the reassembled PDUs.
+bool check_isotp_ranges(const std::vector<PortConfig> &ports, std::string &error_message) {
+    for (std::size_t p = 0; p < ports.size(); ++p) {
+        for (std::size_t l = 0; l < ports[p].isotp.size(); ++l) {
+            const IsoTpConfig &link = ports[p].isotp[l];
+            for (const PortConfig &port : ports) {
+                for (const ChannelConfig &channel : port.channels) {
+                    if (channel.vcan_name != link.vcan_name) {
+                        continue;
+                    }
+                    for (const auto &entry : {std::make_pair("tx_id", link.tx_id), std::make_pair("rx_id", link.rx_id)}) {
+                        if (entry.second >= channel.id_range.min && entry.second <= channel.id_range.max) {
+                            error_message = "ports[" + std::to_string(p) + "].isotp[" + std::to_string(l) + "]." +
+                                            entry.first + " lies within the id_range of " + channel.vcan_name;
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+    }
     return true;
 }
 
-bool parse_ports(const Json::Value &node, std::vector<PortConfig> &ports, std::string &error_message) {
+bool parse_ports(const Json::Value &node,
+                 std::vector<PortConfig> &ports,
+                 const SocketBufferConfig &default_buffers,
+                 std::string &error_message) {
     if (!node.isArray() || node.empty()) {
         error_message = "ports must be a non-empty array";
         return false;
@@ -244,16 +943,140 @@ bool parse_ports(const Json::Value &node, std::vector<PortConfig> &ports, std::s
 
     std::set<std::uint16_t> listen_ports;
     std::set<std::string> global_vcan_names;
+    std::set<std::pair<std::string, std::uint32_t>> isotp_receivers;
 
     ports.reserve(node.size());
     for (Json::ArrayIndex i = 0; i < node.size(); ++i) {
         PortConfig port{};
         const std::string context = "ports[" + std::to_string(i) + "]";
-        if (!parse_port(node[i], port, listen_ports, global_vcan_names, context, error_message)) {
+        if (!parse_port(node[i],
+                        port,
+                        default_buffers,
+                        listen_ports,
+                        global_vcan_names,
+                        isotp_receivers,
+                        context,
+                        error_message)) {
             return false;
         }
         ports.push_back(std::move(port));
     }
+    return check_isotp_ranges(ports, error_message);
+}
+
+bool directions_overlap(RateLimitDirection lhs, RateLimitDirection rhs) {
+    return lhs == RateLimitDirection::Both || rhs == RateLimitDirection::Both || lhs == rhs;
+}
+
+bool parse_rate_limit(const Json::Value &node,
+                      RateLimitRule &rule,
+                      const std::string &context,
+                      std::string &error_message) {
+    if (!node.isObject()) {
+        error_message = context + " must be an object";
+        return false;
+    }
+
+    const auto &id = node["id"];
+    const auto &range = node["id_range"];
+    if (id.isNull() == range.isNull()) {
+        error_message = context + " must have exactly one of id or id_range";
+        return false;
+    }
+    if (!id.isNull()) {
+        if (!id.isString() || !parse_hex_uint32(id.asString(), rule.id_range.min)) {
+            error_message = context + ".id must be a valid hex/decimal string";
+            return false;
+        }
+        rule.id_range.max = rule.id_range.min;
+    } else {
+        if (!range.isObject() || !range["min"].isString() || !range["max"].isString() ||
+            !parse_hex_uint32(range["min"].asString(), rule.id_range.min) ||
+            !parse_hex_uint32(range["max"].asString(), rule.id_range.max)) {
+            error_message = context + ".id_range must hold hex/decimal strings min and max";
+            return false;
+        }
+        if (rule.id_range.min > rule.id_range.max) {
+            error_message = context + ": id_range.min must be <= id_range.max";
+            return false;
+        }
+    }
+    if (rule.id_range.max > 0x1FFFFFFFu) {
+        error_message = context + ": identifier exceeds 29-bit CAN limit";
+        return false;
+    }
+
+    const auto parse_uint = [&](const char *key, std::uint32_t &dest) -> bool {
+        const auto &value = node[key];
+        if (value.isNull()) {
+            return true;
+        }
+        if (!value.isUInt()) {
+            error_message = context + "." + key + " must be an unsigned integer";
+            return false;
+        }
+        dest = value.asUInt();
+        return true;
+    };
+    if (!parse_uint("max_rate_hz", rule.max_rate_hz) || !parse_uint("burst", rule.burst) ||
+        !parse_uint("decimate", rule.decimate)) {
+        return false;
+    }
+    if (rule.burst == 0) {
+        error_message = context + ".burst must be > 0";
+        return false;
+    }
+    if (rule.decimate == 0) {
+        error_message = context + ".decimate must be > 0";
+        return false;
+    }
+    if (rule.max_rate_hz == 0 && rule.decimate == 1) {
+        error_message = context + " must set max_rate_hz or decimate > 1";
+        return false;
+    }
+
+    const auto &direction = node["direction"];
+    if (!direction.isNull()) {
+        const std::string value = direction.isString() ? direction.asString() : std::string();
+        if (value == "both") {
+            rule.direction = RateLimitDirection::Both;
+        } else if (value == "can_to_udp") {
+            rule.direction = RateLimitDirection::CanToUdp;
+        } else if (value == "udp_to_can") {
+            rule.direction = RateLimitDirection::UdpToCan;
+        } else {
+            error_message = context + ".direction must be one of both, can_to_udp, udp_to_can";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parse_rate_limits(const Json::Value &node, std::vector<RateLimitRule> &rules, std::string &error_message) {
+    if (node.isNull()) {
+        return true;
+    }
+    if (!node.isArray()) {
+        error_message = "rate_limits must be an array";
+        return false;
+    }
+
+    rules.reserve(node.size());
+    for (Json::ArrayIndex i = 0; i < node.size(); ++i) {
+        RateLimitRule rule{};
+        const std::string context = "rate_limits[" + std::to_string(i) + "]";
+        if (!parse_rate_limit(node[i], rule, context, error_message)) {
+            return false;
+        }
+        for (const auto &existing : rules) {
+            const bool ids_overlap = !(rule.id_range.max < existing.id_range.min || rule.id_range.min > existing.id_range.max);
+            if (ids_overlap && directions_overlap(rule.direction, existing.direction)) {
+                error_message = context + ": overlaps with another rule in the same direction";
+                return false;
+            }
+        }
+        rules.push_back(rule);
+    }
     return true;
 }
 
@@ -284,7 +1107,66 @@ bool load_bridge_config(const std::string &path, BridgeConfig &config, std::stri
     if (!parse_server(root["server"], parsed.server, error_message)) {
         return false;
     }
-    if (!parse_ports(root["ports"], parsed.ports, error_message)) {
+    if (!parse_socket_buffers(root["socket_buffers"], parsed.socket_buffers, "socket_buffers", error_message)) {
+        return false;
+    }
+    if (!parse_ports(root["ports"], parsed.ports, parsed.socket_buffers, error_message)) {
+        return false;
+    }
+    if (!parse_rate_limits(root["rate_limits"], parsed.rate_limits, error_message)) {
+        return false;
+    }
+    const auto &auto_setup = root["auto_setup_interfaces"];
+    if (!auto_setup.isNull()) {
+        if (!auto_setup.isBool()) {
+            error_message = "auto_setup_interfaces must be a boolean";
+            return false;
+        }
+        parsed.auto_setup_interfaces = auto_setup.asBool();
+    }
+    const auto &shared_can = root["shared_can_socket"];
+    if (!shared_can.isNull()) {
+        if (!shared_can.isBool()) {
+            error_message = "shared_can_socket must be a boolean";
+            return false;
+        }
+        parsed.shared_can_socket = shared_can.asBool();
+    }
+    if (!parse_capture(root["capture"], parsed.capture, error_message)) {
+        return false;
+    }
+    if (!parse_replay(root["replay"], parsed.replay, error_message)) {
+        return false;
+    }
+    if (!parse_xdp(root["xdp"], parsed.xdp, error_message)) {
+        return false;
+    }
+    if (!parse_can_rx_ring(root["can_rx_ring"], parsed.can_rx_ring, error_message)) {
+        return false;
+    }
+    if (!parse_udp_filter(root["udp_filter"], parsed.udp_filter, error_message)) {
+        return false;
+    }
+    if (!parse_cyclic_tx(root["cyclic_tx"], parsed.cyclic_tx, error_message)) {
+        return false;
+    }
+    const bool bcm_rx = std::any_of(parsed.ports.begin(), parsed.ports.end(), [](const PortConfig &port) {
+        return std::any_of(port.channels.begin(), port.channels.end(), [](const ChannelConfig &channel) {
+            return channel.bcm_rx.enabled;
+        });
+    });
+    if (bcm_rx && (parsed.shared_can_socket || parsed.can_rx_ring.enabled)) {
+        error_message = "channels[].bcm_rx cannot be combined with shared_can_socket or can_rx_ring";
+        return false;
+    }
+    const bool xdp_ports = std::any_of(
+        parsed.ports.begin(), parsed.ports.end(), [](const PortConfig &port) { return port.xdp_ingress; });
+    if (parsed.xdp.enabled && !xdp_ports) {
+        error_message = "xdp requires at least one port with xdp_ingress";
+        return false;
+    }
+    if (xdp_ports && !parsed.xdp.enabled) {
+        error_message = "ports[].xdp_ingress requires the top-level xdp section";
         return false;
     }
 
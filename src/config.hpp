@@ -1,5 +1,8 @@
 #pragma once
 
+#include "capture.hpp"
+#include "protocol.hpp"
+
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -9,26 +12,218 @@ struct IdRange {
     std::uint32_t max{0};
 };
 
+// Change-only forwarding for the CAN -> UDP direction: a frame whose DLC and
+// payload match the last one forwarded for its CAN ID is suppressed, except
+// that an unchanged frame is still forwarded once refresh_interval_ms has
+// passed (0 disables the forced refresh).
+struct ChangeFilterConfig {
+    bool enabled{false};
+    std::uint32_t refresh_interval_ms{1000};
+    std::uint32_t eff_capacity{1024};
+};
+
+// Kernel-side filtering for the CAN -> UDP direction: the channel receives
+// through CAN_BCM RX_SETUP subscriptions, one per CAN ID, instead of its
+// CAN_RAW socket. With `changes_only` the kernel passes on a frame only when
+// its DLC or payload differs from the last one of its ID, otherwise every
+// frame; throttle_ms > 0 holds back further updates of an ID for that long
+// and then passes on the latest. `ids` lists the subscribed IDs; when empty,
+// every ID of id_range is subscribed. IDs above 0x7FF are extended frames.
+struct BcmRxConfig {
+    bool enabled{false};
+    bool changes_only{true};
+    std::uint32_t throttle_ms{0};
+    std::vector<std::uint32_t> ids;
+};
+
+// Per-channel UDP -> CAN egress queue. Frames the CAN socket cannot take
+// right now (EAGAIN/ENOBUFS) are held here instead of being dropped and are
+// drained lowest arbitration ID first when `priority` is set, FIFO otherwise.
+struct TxQueueConfig {
+    bool enabled{false};
+    bool priority{true};
+    std::uint32_t depth{256};
+};
+
+// UDP -> CAN pacing at bus speed. Each written frame reserves its worst-case
+// on-wire time (bit stuffing included) at `bitrate`, scaled by
+// 100 / bus_load_percent; frames beyond `burst_frames` in flight wait in the
+// channel's egress queue (implicitly FIFO/256 unless tx_queue says otherwise).
+struct TxPacingConfig {
+    bool enabled{false};
+    std::uint32_t bus_load_percent{100};
+    std::uint32_t burst_frames{1};
+};
+
+// Kernel buffer sizes of one socket, in bytes as passed to setsockopt (the
+// kernel doubles them for its bookkeeping); 0 leaves the current size.
+// `force` goes past net.core.rmem_max/wmem_max with SO_RCVBUFFORCE/
+// SO_SNDBUFFORCE (CAP_NET_ADMIN). With `adaptive` the receive buffer doubles,
+// up to max_rcvbuf, each time the kernel reports drops on the socket.
+struct SocketBufferConfig {
+    std::uint32_t rcvbuf{0};
+    std::uint32_t sndbuf{0};
+    bool force{false};
+    bool adaptive{false};
+    std::uint32_t max_rcvbuf{4U << 20};
+};
+
 struct ChannelConfig {
     std::string vcan_name;
     std::uint32_t tx_channel_id{0};
     IdRange id_range{};
     std::uint32_t bitrate{0};
+    std::uint32_t txqueuelen{0}; // 0 = leave the interface setting alone
+    ChangeFilterConfig change_filter{};
+    BcmRxConfig bcm_rx{};
+    TxQueueConfig tx_queue{};
+    TxPacingConfig tx_pacing{};
+    SocketBufferConfig socket_buffers{};
+};
+
+// An ISO-TP (ISO 15765-2) link on `vcan_name` whose payloads cross UDP as
+// whole PDUs: a CAN_ISOTP socket segments what the server sends for tx_id
+// and reassembles what arrives on rx_id, flow control included. block_size
+// and st_min_us go into the flow control frames the bridge sends; padding
+// >= 0 pads transmitted frames to 8 bytes with that value. IDs above 0x7FF
+// are extended frames.
+struct IsoTpConfig {
+    std::string vcan_name;
+    std::uint32_t tx_id{0};
+    std::uint32_t rx_id{0};
+    std::uint32_t block_size{0};
+    std::uint32_t st_min_us{0};
+    int padding{-1};
 };
 
 struct PortConfig {
     std::uint16_t listen_port{0};
     std::uint16_t send_port{0};
+    FrameFormat frame_format{FrameFormat::Standard};
+    // Timestamped ports only: hold UDP -> CAN frames until their transmit
+    // timestamp instead of sending them on arrival.
+    bool scheduled_tx{false};
+    // Prefix every datagram, both directions, with a DatagramHeader.
+    bool sequence_header{false};
+    // Also receive this port's datagrams through the AF_XDP path (XdpConfig).
+    bool xdp_ingress{false};
+    SocketBufferConfig socket_buffers{};
     std::vector<ChannelConfig> channels;
+    std::vector<IsoTpConfig> isotp;
 };
 
 struct ServerConfig {
     std::string ip;
 };
 
+enum class RateLimitDirection : std::uint8_t {
+    Both,
+    CanToUdp,
+    UdpToCan,
+};
+
+// One rate_limits[] entry. A single ID is stored as a range with min == max;
+// a range rule shares one bucket and one decimation counter across the range.
+struct RateLimitRule {
+    IdRange id_range{};
+    std::uint32_t max_rate_hz{0}; // 0 = no token bucket
+    std::uint32_t burst{1};
+    std::uint32_t decimate{1}; // forward every Nth frame, 1 = all
+    RateLimitDirection direction{RateLimitDirection::Both};
+};
+
+// In-process capture of every forwarded frame into preallocated, mmap'd
+// files of `file_size_mb` each. When the current file `path` fills up it is
+// renamed to path.1 (path.1 to path.2, ...), keeping `files` in total.
+struct CaptureConfig {
+    bool enabled{false};
+    std::string path;
+    std::uint32_t file_size_mb{64};
+    std::uint32_t files{4};
+};
+
+enum class ReplayInject : std::uint8_t {
+    Udp, // as if received from the server: routed by CAN ID and written to CAN
+    Can, // as if received on the frame's interface: forwarded to UDP
+};
+
+// In-bridge replay of a candump -L log or a capture file. `speed` scales the
+// recorded timing (1 = original, 2 = twice as fast, 0 = as fast as possible).
+// For capture files `direction` limits replay to records of one direction.
+struct ReplayConfig {
+    bool enabled{false};
+    std::string path;
+    double speed{1.0};
+    ReplayInject inject{ReplayInject::Udp};
+    bool loop{false};
+    bool filter_direction{false};
+    CaptureDirection direction{CaptureDirection::UdpToCan};
+};
+
+// AF_XDP ingress for the ports marked xdp_ingress: an XDP program on
+// `interface` steers their UDP packets on RX queues [0, queues) to AF_XDP
+// sockets. `skb_mode` forces generic XDP for drivers without native support;
+// `zero_copy` requires driver support instead of letting the kernel choose.
+// If any of it cannot be set up the regular UDP sockets serve all traffic.
+struct XdpConfig {
+    bool enabled{false};
+    std::string interface;
+    std::uint32_t queues{1};
+    bool zero_copy{false};
+    bool skb_mode{false};
+};
+
+// PACKET_MMAP (TPACKET_V3) reception for all CAN channels: `block_count`
+// blocks of `block_size` bytes shared with the kernel, each handed over when
+// full or `block_timeout_ms` after its first frame. If the ring cannot be set
+// up the CAN sockets keep receiving.
+struct CanRingConfig {
+    bool enabled{false};
+    std::uint32_t block_size{65536};
+    std::uint32_t block_count{8};
+    std::uint32_t block_timeout_ms{1};
+};
+
+// Classic BPF filter on every listen port: datagrams not sent from
+// server.ip or not made of whole frames are dropped in the kernel, and with
+// `info_bytes` so are those whose leading frames carry a DLC above 8. The
+// bridge never wakes up for them; they only show up in the port's socket
+// drop count.
+struct UdpFilterConfig {
+    bool enabled{false};
+    bool info_bytes{false};
+};
+
+// Kernel-generated cyclic frames: the server's CyclicStart control records
+// become CAN_BCM TX_SETUP jobs on the frame's channel. At most `max_jobs` run
+// at once, none faster than `min_period_us`.
+struct CyclicTxConfig {
+    bool enabled{false};
+    std::uint32_t max_jobs{256};
+    std::uint32_t min_period_us{1000};
+};
+
 struct BridgeConfig {
     ServerConfig server{};
     std::vector<PortConfig> ports;
+    std::vector<RateLimitRule> rate_limits;
+    CaptureConfig capture{};
+    ReplayConfig replay{};
+    XdpConfig xdp{};
+    CanRingConfig can_rx_ring{};
+    UdpFilterConfig udp_filter{};
+    CyclicTxConfig cyclic_tx{};
+    // Defaults for every port's and channel's socket_buffers, and the
+    // settings of the shared CAN socket.
+    SocketBufferConfig socket_buffers{};
+    // Create missing vcan interfaces and apply bitrate/txqueuelen to existing
+    // CAN interfaces over rtnetlink. Runs once capture/replay are prepared and
+    // every UDP port is bound, right before the CAN sockets are opened; if the
+    // setup itself or a CAN socket then fails, the links stay reconfigured.
+    bool auto_setup_interfaces{false};
+    // Serve every channel from one CAN_RAW socket bound to all interfaces,
+    // demultiplexed by ifindex, instead of one socket per channel.
+    bool shared_can_socket{false};
 };
 
 bool load_bridge_config(const std::string &path, BridgeConfig &config, std::string &error_message);
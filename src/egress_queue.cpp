@@ -0,0 +1,107 @@
+#include "egress_queue.hpp"
+
+bool EgressQueue::initialize(std::size_t depth, bool priority) {
+    nodes_.clear();
+    heads_.clear();
+    tails_.clear();
+    size_ = 0;
+    free_head_ = kNil;
+    bucket_bits_.fill(0);
+    word_bits_ = 0;
+    if (depth == 0) {
+        return true;
+    }
+    if (depth >= kNil) {
+        return false;
+    }
+
+    priority_ = priority;
+    nodes_.resize(depth);
+    const std::size_t buckets = priority_ ? kBucketCount : 1;
+    heads_.assign(buckets, kNil);
+    tails_.assign(buckets, kNil);
+    clear();
+    return true;
+}
+
+bool EgressQueue::push(const struct can_frame &frame) {
+    if (free_head_ == kNil) {
+        return false;
+    }
+    const std::uint16_t node_index = free_head_;
+    Node &node = nodes_[node_index];
+    free_head_ = node.next;
+    node.frame = frame;
+    node.next = kNil;
+
+    const std::size_t bucket = bucket_for(frame);
+    if (heads_[bucket] == kNil) {
+        heads_[bucket] = node_index;
+        const std::size_t word = bucket / kWordBits;
+        bucket_bits_[word] |= std::uint64_t{1} << (bucket % kWordBits);
+        word_bits_ |= std::uint64_t{1} << word;
+    } else {
+        nodes_[tails_[bucket]].next = node_index;
+    }
+    tails_[bucket] = node_index;
+    ++size_;
+    return true;
+}
+
+const struct can_frame &EgressQueue::front() const {
+    return nodes_[heads_[lowest_bucket()]].frame;
+}
+
+void EgressQueue::pop() {
+    if (size_ == 0) {
+        return;
+    }
+    const std::size_t bucket = lowest_bucket();
+    const std::uint16_t node_index = heads_[bucket];
+    Node &node = nodes_[node_index];
+    heads_[bucket] = node.next;
+    if (heads_[bucket] == kNil) {
+        tails_[bucket] = kNil;
+        const std::size_t word = bucket / kWordBits;
+        bucket_bits_[word] &= ~(std::uint64_t{1} << (bucket % kWordBits));
+        if (bucket_bits_[word] == 0) {
+            word_bits_ &= ~(std::uint64_t{1} << word);
+        }
+    }
+    node.next = free_head_;
+    free_head_ = node_index;
+    --size_;
+}
+
+void EgressQueue::clear() {
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+        nodes_[i].next = i + 1 < nodes_.size() ? static_cast<std::uint16_t>(i + 1) : kNil;
+    }
+    free_head_ = nodes_.empty() ? kNil : 0;
+    for (auto &head : heads_) {
+        head = kNil;
+    }
+    for (auto &tail : tails_) {
+        tail = kNil;
+    }
+    bucket_bits_.fill(0);
+    word_bits_ = 0;
+    size_ = 0;
+}
+
+std::size_t EgressQueue::bucket_for(const struct can_frame &frame) const {
+    if (!priority_) {
+        return 0;
+    }
+    if ((frame.can_id & CAN_EFF_FLAG) != 0U) {
+        // The first 11 bits on the wire are the top of the 29-bit identifier.
+        const std::uint32_t base = (frame.can_id & CAN_EFF_MASK) >> 18U;
+        return (static_cast<std::size_t>(base) << 1U) | 1U;
+    }
+    return static_cast<std::size_t>(frame.can_id & CAN_SFF_MASK) << 1U;
+}
+
+std::size_t EgressQueue::lowest_bucket() const {
+    const std::size_t word = static_cast<std::size_t>(__builtin_ctzll(word_bits_));
+    return word * kWordBits + static_cast<std::size_t>(__builtin_ctzll(bucket_bits_[word]));
+}
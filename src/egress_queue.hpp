@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <linux/can.h>
+
+// Fixed-capacity CAN egress queue. In priority mode frames are bucketed by
+// their position in CAN arbitration: the 11-bit base identifier followed by
+// the IDE bit, so a standard frame beats an extended frame that shares its
+// base ID, just as on the wire. A two-level bitmap finds the lowest
+// non-empty bucket with two ctz operations. Frames within a bucket (extended
+// frames sharing a base ID, repeats of one ID) keep arrival order. FIFO mode
+// uses a single bucket.
+//
+// Nodes come from a pool sized by initialize(); push/pop never allocate.
+class EgressQueue {
+public:
+    bool initialize(std::size_t depth, bool priority);
+    bool enabled() const { return !nodes_.empty(); }
+
+    bool empty() const { return size_ == 0; }
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return nodes_.size(); }
+
+    // Returns false (and leaves the queue untouched) when the pool is exhausted.
+    bool push(const struct can_frame &frame);
+    // Lowest-priority-value (= highest CAN priority) frame; queue must be non-empty.
+    const struct can_frame &front() const;
+    void pop();
+    void clear();
+
+private:
+    static constexpr std::size_t kBucketCount = 4096; // 11-bit base ID x IDE
+    static constexpr std::size_t kWordBits = 64;
+    static constexpr std::size_t kWordCount = kBucketCount / kWordBits;
+    static constexpr std::uint16_t kNil = 0xFFFFU;
+
+    struct Node {
+        struct can_frame frame;
+        std::uint16_t next;
+    };
+
+    std::size_t bucket_for(const struct can_frame &frame) const;
+    std::size_t lowest_bucket() const;
+
+    bool priority_{true};
+    std::size_t size_{0};
+    std::uint16_t free_head_{kNil};
+    std::vector<Node> nodes_;
+    std::vector<std::uint16_t> heads_;
+    std::vector<std::uint16_t> tails_;
+    std::array<std::uint64_t, kWordCount> bucket_bits_{};
+    std::uint64_t word_bits_{0};
+};
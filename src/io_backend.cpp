@@ -0,0 +1,556 @@
+#include "io_backend.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <linux/can/isotp.h>
+#include <linux/can/raw.h>
+#include <linux/sock_diag.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/uio.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <syslog.h>
+#include <unistd.h>
+
+namespace {
+
+bool set_non_blocking(int fd) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) {
+        return false;
+    }
+    if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        return false;
+    }
+    return true;
+}
+
+void close_fd(int &fd) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+void log_errno(const char *message) {
+    syslog(LOG_ERR, "%s: %s", message, std::strerror(errno));
+}
+
+// The RX time from an SCM_TIMESTAMPING message, 0 when none is attached.
+std::uint64_t rx_timestamp_ns(msghdr &msg) {
+    std::uint64_t timestamp_ns = 0;
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_TIMESTAMPING) {
+            continue;
+        }
+        scm_timestamping stamps{};
+        std::memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+        // ts[2] is the raw hardware stamp, ts[0] the software one.
+        const timespec &chosen = (stamps.ts[2].tv_sec != 0 || stamps.ts[2].tv_nsec != 0) ? stamps.ts[2] : stamps.ts[0];
+        timestamp_ns = static_cast<std::uint64_t>(chosen.tv_sec) * 1000000000ULL + static_cast<std::uint64_t>(chosen.tv_nsec);
+    }
+    return timestamp_ns;
+}
+
+// Has the kernel attach the socket's drop counter to every message queued
+// after the first drop. Without it the counter just reads 0.
+void enable_drop_counter(int fd) {
+    const int on = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on)) < 0) {
+        syslog(LOG_DEBUG, "setsockopt SO_RXQ_OVFL failed: %s", std::strerror(errno));
+    }
+}
+
+// The SO_RXQ_OVFL counter of a received message; the kernel leaves it out
+// while it is 0.
+std::uint32_t drop_count(msghdr &msg) {
+    std::uint32_t drops = 0;
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+            std::memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+        }
+    }
+    return drops;
+}
+
+// Applies one buffer size, with the FORCE variant first when asked to.
+bool set_buffer_size(int fd, int option, int force_option, std::uint32_t size, bool force) {
+    const int value = static_cast<int>(size);
+    if (force && setsockopt(fd, SOL_SOCKET, force_option, &value, sizeof(value)) == 0) {
+        return true;
+    }
+    if (force) {
+        syslog(LOG_WARNING,
+               "cannot force socket buffer size %u (%s), staying within the sysctl limit",
+               size,
+               std::strerror(errno));
+    }
+    return setsockopt(fd, SOL_SOCKET, option, &value, sizeof(value)) == 0;
+}
+
+} // namespace
+
+bool SocketIoBackend::interface_exists(const std::string &name) {
+    return if_nametoindex(name.c_str()) != 0U;
+}
+
+unsigned int SocketIoBackend::interface_index(const std::string &name) {
+    return if_nametoindex(name.c_str());
+}
+
+bool SocketIoBackend::setup_can_interfaces(const std::vector<CanLinkSpec> &specs, std::string &error_message) {
+    return apply_can_link_setup(specs, error_message);
+}
+
+int SocketIoBackend::open_udp(std::uint16_t listen_port) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        log_errno("failed to create UDP socket");
+        return -1;
+    }
+    if (!set_non_blocking(fd)) {
+        log_errno("failed to set UDP non-blocking");
+        close_fd(fd);
+        return -1;
+    }
+
+    int opt = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        log_errno("setsockopt SO_REUSEADDR failed");
+    }
+
+    // Let the kernel hand over bursts of datagrams from one flow in a single
+    // read. Older kernels lack UDP_GRO; reads then simply carry one datagram.
+    if (setsockopt(fd, IPPROTO_UDP, UDP_GRO, &opt, sizeof(opt)) < 0) {
+        syslog(LOG_DEBUG, "setsockopt UDP_GRO failed: %s", std::strerror(errno));
+    }
+    enable_drop_counter(fd);
+
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = INADDR_ANY;
+    local.sin_port = htons(listen_port);
+    if (bind(fd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) < 0) {
+        log_errno("failed to bind UDP socket");
+        close_fd(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+bool SocketIoBackend::set_udp_filter(int fd, const std::vector<sock_filter> &program) {
+    if (program.empty()) {
+        // Detaching when nothing is attached is not an error here.
+        const int unused = 0;
+        return setsockopt(fd, SOL_SOCKET, SO_DETACH_FILTER, &unused, sizeof(unused)) == 0 || errno == ENOENT;
+    }
+    sock_fprog fprog{};
+    fprog.len = static_cast<unsigned short>(program.size());
+    fprog.filter = const_cast<sock_filter *>(program.data());
+    return setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) == 0;
+}
+
+int SocketIoBackend::open_can(const std::string &interface_name) {
+    int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd < 0) {
+        log_errno("failed to create CAN socket");
+        return -1;
+    }
+    if (!set_non_blocking(fd)) {
+        log_errno("failed to set CAN non-blocking");
+        close_fd(fd);
+        return -1;
+    }
+
+    ifreq ifr{};
+    std::strncpy(ifr.ifr_name, interface_name.c_str(), sizeof(ifr.ifr_name));
+    ifr.ifr_name[sizeof(ifr.ifr_name) - 1] = '\0';
+    if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0) {
+        log_errno("failed to lookup CAN interface");
+        close_fd(fd);
+        return -1;
+    }
+
+    sockaddr_can addr{};
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        log_errno("failed to bind CAN socket");
+        close_fd(fd);
+        return -1;
+    }
+    enable_drop_counter(fd);
+
+    return fd;
+}
+
+int SocketIoBackend::open_can_any() {
+    int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd < 0) {
+        log_errno("failed to create CAN socket");
+        return -1;
+    }
+    if (!set_non_blocking(fd)) {
+        log_errno("failed to set CAN non-blocking");
+        close_fd(fd);
+        return -1;
+    }
+    // CAN_RAW_RECV_OWN_MSGS stays off (the default): what this socket writes
+    // to one bus must not come back as traffic from that bus.
+    sockaddr_can addr{};
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = 0;
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        log_errno("failed to bind CAN socket to all interfaces");
+        close_fd(fd);
+        return -1;
+    }
+    enable_drop_counter(fd);
+    return fd;
+}
+
+int SocketIoBackend::open_can_bcm() {
+    int fd = socket(PF_CAN, SOCK_DGRAM, CAN_BCM);
+    if (fd < 0) {
+        log_errno("failed to create CAN_BCM socket");
+        return -1;
+    }
+    if (!set_non_blocking(fd)) {
+        log_errno("failed to set CAN_BCM non-blocking");
+        close_fd(fd);
+        return -1;
+    }
+    // Connected to ifindex 0, every message names its own interface.
+    sockaddr_can addr{};
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = 0;
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        log_errno("failed to connect CAN_BCM socket");
+        close_fd(fd);
+        return -1;
+    }
+    enable_drop_counter(fd);
+    return fd;
+}
+
+int SocketIoBackend::open_isotp(const std::string &interface_name, const IsoTpLinkSpec &spec) {
+    int fd = socket(PF_CAN, SOCK_DGRAM, CAN_ISOTP);
+    if (fd < 0) {
+        log_errno("failed to create CAN_ISOTP socket");
+        return -1;
+    }
+    if (!set_non_blocking(fd)) {
+        log_errno("failed to set CAN_ISOTP non-blocking");
+        close_fd(fd);
+        return -1;
+    }
+
+    // Options must be set before bind().
+    can_isotp_options options{};
+    options.frame_txtime = CAN_ISOTP_DEFAULT_FRAME_TXTIME;
+    options.txpad_content = CAN_ISOTP_DEFAULT_PAD_CONTENT;
+    options.rxpad_content = CAN_ISOTP_DEFAULT_PAD_CONTENT;
+    if (spec.padding >= 0) {
+        options.flags = CAN_ISOTP_TX_PADDING;
+        options.txpad_content = static_cast<std::uint8_t>(spec.padding);
+    }
+    const can_isotp_fc_options flow_control{spec.block_size, spec.st_min, CAN_ISOTP_DEFAULT_RECV_WFTMAX};
+    if (setsockopt(fd, SOL_CAN_ISOTP, CAN_ISOTP_OPTS, &options, sizeof(options)) < 0 ||
+        setsockopt(fd, SOL_CAN_ISOTP, CAN_ISOTP_RECV_FC, &flow_control, sizeof(flow_control)) < 0) {
+        log_errno("failed to configure CAN_ISOTP socket");
+        close_fd(fd);
+        return -1;
+    }
+
+    sockaddr_can addr{};
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = static_cast<int>(if_nametoindex(interface_name.c_str()));
+    addr.can_addr.tp.tx_id = spec.tx_id;
+    addr.can_addr.tp.rx_id = spec.rx_id;
+    if (addr.can_ifindex == 0 || bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        log_errno("failed to bind CAN_ISOTP socket");
+        close_fd(fd);
+        return -1;
+    }
+    enable_drop_counter(fd);
+    return fd;
+}
+
+void SocketIoBackend::close_endpoint(int fd) {
+    close_fd(fd);
+}
+
+bool SocketIoBackend::set_socket_buffers(int fd, std::uint32_t rcvbuf, std::uint32_t sndbuf, bool force) {
+    const bool rcvbuf_set = rcvbuf == 0 || set_buffer_size(fd, SO_RCVBUF, SO_RCVBUFFORCE, rcvbuf, force);
+    const bool sndbuf_set = sndbuf == 0 || set_buffer_size(fd, SO_SNDBUF, SO_SNDBUFFORCE, sndbuf, force);
+    return rcvbuf_set && sndbuf_set;
+}
+
+bool SocketIoBackend::socket_memory(int fd, SocketMemory &memory) {
+    std::uint32_t values[SK_MEMINFO_VARS] = {};
+    socklen_t length = sizeof(values);
+    if (getsockopt(fd, SOL_SOCKET, SO_MEMINFO, values, &length) < 0) {
+        return false;
+    }
+    memory.receive_queued = values[SK_MEMINFO_RMEM_ALLOC];
+    memory.receive_buffer = values[SK_MEMINFO_RCVBUF];
+    memory.send_buffer = values[SK_MEMINFO_SNDBUF];
+    memory.drops = values[SK_MEMINFO_DROPS];
+    return true;
+}
+
+ssize_t SocketIoBackend::udp_recv(int fd,
+                                  std::uint8_t *buffer,
+                                  std::size_t capacity,
+                                  std::size_t &segment_size,
+                                  std::uint32_t &drops) {
+    iovec iov{buffer, capacity};
+    alignas(cmsghdr) std::uint8_t control[CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(std::uint32_t))];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    const ssize_t received = recvmsg(fd, &msg, 0);
+    segment_size = 0;
+    // A zero-length datagram carries the drop counter like any other.
+    if (received < 0) {
+        return received;
+    }
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO) {
+            int gso_size = 0;
+            std::memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+            // A single datagram may still come with the cmsg.
+            if (gso_size > 0 && static_cast<std::size_t>(gso_size) < static_cast<std::size_t>(received)) {
+                segment_size = static_cast<std::size_t>(gso_size);
+            }
+        }
+    }
+    drops = drop_count(msg);
+    return received;
+}
+
+ssize_t SocketIoBackend::udp_send(int fd,
+                                  const std::uint8_t *data,
+                                  std::size_t length,
+                                  const sockaddr_in &destination) {
+    return sendto(fd,
+                  data,
+                  length,
+                  0,
+                  reinterpret_cast<const sockaddr *>(&destination),
+                  sizeof(destination));
+}
+
+ssize_t SocketIoBackend::udp_send_segments(int fd,
+                                           const std::uint8_t *data,
+                                           std::size_t length,
+                                           std::size_t segment_size,
+                                           const sockaddr_in &destination) {
+    if (length > segment_size && gso_supported_) {
+        iovec iov{const_cast<std::uint8_t *>(data), length};
+        alignas(cmsghdr) std::uint8_t control[CMSG_SPACE(sizeof(std::uint16_t))] = {};
+        msghdr msg{};
+        msg.msg_name = const_cast<sockaddr_in *>(&destination);
+        msg.msg_namelen = sizeof(destination);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = IPPROTO_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(std::uint16_t));
+        const auto segment = static_cast<std::uint16_t>(segment_size);
+        std::memcpy(CMSG_DATA(cmsg), &segment, sizeof(segment));
+
+        const ssize_t sent = sendmsg(fd, &msg, 0);
+        // EINVAL/ENOPROTOOPT: kernel without UDP GSO; EIO: no checksum
+        // offload on the egress device.
+        if (sent >= 0 || (errno != EINVAL && errno != ENOPROTOOPT && errno != EIO)) {
+            return sent;
+        }
+        syslog(LOG_INFO, "UDP GSO unavailable (%s), sending datagrams one by one", std::strerror(errno));
+        gso_supported_ = false;
+    }
+
+    std::size_t offset = 0;
+    while (offset < length) {
+        const std::size_t chunk = std::min(segment_size, length - offset);
+        if (udp_send(fd, data + offset, chunk, destination) < 0) {
+            return offset == 0 ? -1 : static_cast<ssize_t>(offset);
+        }
+        offset += chunk;
+    }
+    return static_cast<ssize_t>(length);
+}
+
+ssize_t SocketIoBackend::can_read(int fd, struct can_frame &frame, std::uint32_t &drops) {
+    iovec iov{&frame, sizeof(frame)};
+    alignas(cmsghdr) std::uint8_t control[CMSG_SPACE(sizeof(std::uint32_t))];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    const ssize_t bytes = recvmsg(fd, &msg, 0);
+    if (bytes >= 0) {
+        drops = drop_count(msg);
+    }
+    return bytes;
+}
+
+ssize_t SocketIoBackend::can_write(int fd, const struct can_frame &frame) {
+    return write(fd, &frame, sizeof(frame));
+}
+
+bool SocketIoBackend::set_can_receive(int fd, bool enabled) {
+    // The default filter passes every frame; no filter at all passes none.
+    const can_filter all{0, 0};
+    return setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, enabled ? &all : nullptr, enabled ? sizeof(all) : 0) == 0;
+}
+
+bool SocketIoBackend::enable_can_timestamps(int fd) {
+    const int flags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE | SOF_TIMESTAMPING_RX_SOFTWARE |
+                      SOF_TIMESTAMPING_SOFTWARE;
+    if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) < 0) {
+        log_errno("setsockopt SO_TIMESTAMPING failed");
+        return false;
+    }
+    return true;
+}
+
+ssize_t SocketIoBackend::can_read_timestamped(int fd,
+                                              struct can_frame &frame,
+                                              std::uint64_t &timestamp_ns,
+                                              std::uint32_t &drops) {
+    iovec iov{};
+    iov.iov_base = &frame;
+    iov.iov_len = sizeof(frame);
+    alignas(cmsghdr) std::uint8_t control[CMSG_SPACE(sizeof(scm_timestamping)) + CMSG_SPACE(sizeof(std::uint32_t))];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    timestamp_ns = 0;
+    const ssize_t bytes = recvmsg(fd, &msg, 0);
+    if (bytes < 0) {
+        return bytes;
+    }
+    timestamp_ns = rx_timestamp_ns(msg);
+    drops = drop_count(msg);
+    return bytes;
+}
+
+ssize_t SocketIoBackend::can_read_batch(int fd, CanRxFrame *frames, std::size_t capacity) {
+    constexpr std::size_t kMaxBatch = 64;
+    capacity = std::min(capacity, kMaxBatch);
+    mmsghdr messages[kMaxBatch];
+    iovec iovs[kMaxBatch];
+    sockaddr_can addresses[kMaxBatch];
+    alignas(cmsghdr) std::uint8_t
+        control[kMaxBatch][CMSG_SPACE(sizeof(scm_timestamping)) + CMSG_SPACE(sizeof(std::uint32_t))];
+    for (std::size_t i = 0; i < capacity; ++i) {
+        iovs[i].iov_base = &frames[i].frame;
+        iovs[i].iov_len = sizeof(frames[i].frame);
+        messages[i] = mmsghdr{};
+        messages[i].msg_hdr.msg_name = &addresses[i];
+        messages[i].msg_hdr.msg_namelen = sizeof(addresses[i]);
+        messages[i].msg_hdr.msg_iov = &iovs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_control = control[i];
+        messages[i].msg_hdr.msg_controllen = sizeof(control[i]);
+    }
+
+    const int count = recvmmsg(fd, messages, static_cast<unsigned int>(capacity), MSG_DONTWAIT, nullptr);
+    if (count < 0) {
+        return -1;
+    }
+    // CAN FD frames and short reads cannot occur on a classic CAN_RAW socket;
+    // anything that is not a whole can_frame is reported as ifindex 0.
+    for (int i = 0; i < count; ++i) {
+        const bool whole = messages[i].msg_len == sizeof(struct can_frame);
+        frames[i].ifindex = whole ? addresses[i].can_ifindex : 0;
+        frames[i].timestamp_ns = rx_timestamp_ns(messages[i].msg_hdr);
+        frames[i].drops = drop_count(messages[i].msg_hdr);
+    }
+    return count;
+}
+
+bool SocketIoBackend::can_bcm_send(int fd, int ifindex, const bcm_msg_head &head, const struct can_frame *frames) {
+    sockaddr_can addr{};
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifindex;
+    // The kernel takes the head and its frames as one message.
+    iovec iov[2] = {{const_cast<bcm_msg_head *>(&head), sizeof(head)},
+                    {const_cast<struct can_frame *>(frames), head.nframes * sizeof(struct can_frame)}};
+    msghdr msg{};
+    msg.msg_name = &addr;
+    msg.msg_namelen = sizeof(addr);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = head.nframes != 0 ? 2 : 1;
+    return sendmsg(fd, &msg, 0) >= 0;
+}
+
+ssize_t SocketIoBackend::can_bcm_read_batch(int fd, CanRxFrame *frames, std::size_t capacity) {
+    constexpr std::size_t kMaxBatch = 64;
+    capacity = std::min(capacity, kMaxBatch);
+    mmsghdr messages[kMaxBatch];
+    iovec iovs[kMaxBatch][2];
+    bcm_msg_head heads[kMaxBatch];
+    sockaddr_can addresses[kMaxBatch];
+    alignas(cmsghdr) std::uint8_t
+        control[kMaxBatch][CMSG_SPACE(sizeof(scm_timestamping)) + CMSG_SPACE(sizeof(std::uint32_t))];
+    for (std::size_t i = 0; i < capacity; ++i) {
+        iovs[i][0].iov_base = &heads[i];
+        iovs[i][0].iov_len = sizeof(heads[i]);
+        iovs[i][1].iov_base = &frames[i].frame;
+        iovs[i][1].iov_len = sizeof(frames[i].frame);
+        messages[i] = mmsghdr{};
+        messages[i].msg_hdr.msg_name = &addresses[i];
+        messages[i].msg_hdr.msg_namelen = sizeof(addresses[i]);
+        messages[i].msg_hdr.msg_iov = iovs[i];
+        messages[i].msg_hdr.msg_iovlen = 2;
+        messages[i].msg_hdr.msg_control = control[i];
+        messages[i].msg_hdr.msg_controllen = sizeof(control[i]);
+    }
+
+    const int count = recvmmsg(fd, messages, static_cast<unsigned int>(capacity), MSG_DONTWAIT, nullptr);
+    if (count < 0) {
+        return -1;
+    }
+    // The kernel names the interface the frame arrived on.
+    for (int i = 0; i < count; ++i) {
+        const bool changed = messages[i].msg_len == sizeof(bcm_msg_head) + sizeof(struct can_frame) &&
+                             heads[i].opcode == RX_CHANGED && heads[i].nframes == 1;
+        frames[i].ifindex = changed ? addresses[i].can_ifindex : 0;
+        frames[i].timestamp_ns = rx_timestamp_ns(messages[i].msg_hdr);
+        frames[i].drops = drop_count(messages[i].msg_hdr);
+    }
+    return count;
+}
+
+ssize_t SocketIoBackend::isotp_send(int fd, const std::uint8_t *data, std::size_t length) {
+    return write(fd, data, length);
+}
+
+ssize_t SocketIoBackend::isotp_recv(int fd, std::uint8_t *buffer, std::size_t capacity) {
+    return read(fd, buffer, capacity);
+}
+
+ssize_t SocketIoBackend::can_write_to(int fd, const struct can_frame &frame, int ifindex) {
+    sockaddr_can addr{};
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifindex;
+    return sendto(fd, &frame, sizeof(frame), 0, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr));
+}
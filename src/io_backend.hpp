@@ -0,0 +1,177 @@
+#pragma once
+
+#include "can_link_setup.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <linux/can.h>
+#include <linux/can/bcm.h>
+#include <linux/filter.h>
+#include <netinet/in.h>
+#include <sys/types.h>
+
+// One frame read from a socket opened with open_can_any(), tagged with the
+// interface it arrived on.
+struct CanRxFrame {
+    struct can_frame frame;
+    int ifindex;
+    // CLOCK_REALTIME RX time once enable_can_timestamps() was called, else 0.
+    std::uint64_t timestamp_ns;
+    // The socket's drop counter as of this frame, see IoBackend::udp_recv().
+    std::uint32_t drops;
+};
+
+// A socket's receive queue and buffers as the kernel accounts them
+// (SO_MEMINFO): buffer sizes are the doubled values the kernel works with.
+struct SocketMemory {
+    std::uint32_t receive_queued;
+    std::uint32_t receive_buffer;
+    std::uint32_t send_buffer;
+    std::uint32_t drops;
+};
+
+// How open_isotp() binds and configures a CAN_ISOTP socket. IDs carry
+// CAN_EFF_FLAG for extended frames; st_min is the flow control byte
+// (0x00-0x7F ms, 0xF1-0xF9 100-900 us); padding < 0 sends unpadded frames.
+struct IsoTpLinkSpec {
+    canid_t tx_id;
+    canid_t rx_id;
+    std::uint8_t block_size;
+    std::uint8_t st_min;
+    int padding;
+};
+
+// Everything BridgeApp needs from sockets and network interfaces goes through
+// an IoBackend. Endpoints are plain file descriptors that can be registered
+// with epoll, and every call follows the syscall convention: -1 with errno set
+// on failure, EAGAIN/EWOULDBLOCK when the endpoint is drained or full.
+class IoBackend {
+public:
+    virtual ~IoBackend() = default;
+
+    virtual bool interface_exists(const std::string &name) = 0;
+    // 0 when there is no such interface.
+    virtual unsigned int interface_index(const std::string &name) = 0;
+    // Brings the named CAN interfaces in line with the specs (create missing
+    // vcans, apply bitrate/txqueuelen, set up) in one go.
+    virtual bool setup_can_interfaces(const std::vector<CanLinkSpec> &specs, std::string &error_message) = 0;
+    virtual int open_udp(std::uint16_t listen_port) = 0;
+    // Replaces the socket's classic BPF filter; an empty program removes it.
+    virtual bool set_udp_filter(int fd, const std::vector<sock_filter> &program) = 0;
+    virtual int open_can(const std::string &interface_name) = 0;
+    // A CAN_RAW socket bound to every CAN interface at once (ifindex 0).
+    // Frames it writes with can_write_to() are not received back on it.
+    virtual int open_can_any() = 0;
+    // A CAN_BCM socket for all CAN interfaces. Its jobs live as long as the
+    // socket; closing it stops them all.
+    virtual int open_can_bcm() = 0;
+    virtual int open_isotp(const std::string &interface_name, const IsoTpLinkSpec &spec) = 0;
+    virtual void close_endpoint(int fd) = 0;
+    // Sizes the socket's kernel buffers; 0 leaves one as it is. With `force`
+    // the sizes may exceed net.core.rmem_max/wmem_max where the process is
+    // allowed to.
+    virtual bool set_socket_buffers(int fd, std::uint32_t rcvbuf, std::uint32_t sndbuf, bool force) = 0;
+    virtual bool socket_memory(int fd, SocketMemory &memory) = 0;
+
+    // segment_size is set to the length of each datagram when the kernel
+    // coalesced several of them into this read (UDP GRO); every segment but
+    // the last has exactly that length. 0 means buffer holds one datagram.
+    // drops is set to the socket's wrapping count of messages the kernel
+    // dropped before this one was queued (SO_RXQ_OVFL), 0 until the first
+    // drop. The CAN reads report it the same way.
+    virtual ssize_t udp_recv(int fd,
+                             std::uint8_t *buffer,
+                             std::size_t capacity,
+                             std::size_t &segment_size,
+                             std::uint32_t &drops) = 0;
+    virtual ssize_t udp_send(int fd, const std::uint8_t *data, std::size_t length, const sockaddr_in &destination) = 0;
+    // Sends data as consecutive datagrams of segment_size bytes (the last may
+    // be shorter), in one call where the kernel supports UDP GSO. Returns the
+    // bytes of the datagrams that were sent.
+    virtual ssize_t udp_send_segments(int fd,
+                                      const std::uint8_t *data,
+                                      std::size_t length,
+                                      std::size_t segment_size,
+                                      const sockaddr_in &destination) = 0;
+    virtual ssize_t can_read(int fd, struct can_frame &frame, std::uint32_t &drops) = 0;
+    virtual ssize_t can_write(int fd, const struct can_frame &frame) = 0;
+    // For sockets from open_can_any(): reads up to capacity frames in one
+    // call and returns how many, or writes one frame to the given interface.
+    virtual ssize_t can_read_batch(int fd, CanRxFrame *frames, std::size_t capacity) = 0;
+    virtual ssize_t can_write_to(int fd, const struct can_frame &frame, int ifindex) = 0;
+    // Stops, or resumes, queueing bus traffic on a CAN socket, for sockets
+    // that are only written to while frames are read elsewhere.
+    virtual bool set_can_receive(int fd, bool enabled) = 0;
+    // Sends one CAN_BCM message, `head` followed by head.nframes frames,
+    // for the interface with the given ifindex.
+    virtual bool can_bcm_send(int fd, int ifindex, const bcm_msg_head &head, const struct can_frame *frames) = 0;
+    // Reads up to capacity RX_CHANGED notifications of RX_SETUP
+    // subscriptions, like can_read_batch(). Any other message is reported
+    // with ifindex 0.
+    virtual ssize_t can_bcm_read_batch(int fd, CanRxFrame *frames, std::size_t capacity) = 0;
+    // One whole ISO-TP payload each. A send fails with EAGAIN while the
+    // previous one is still being segmented; a failed transfer is reported
+    // by the next receive (ECOMM, ETIMEDOUT, ...).
+    virtual ssize_t isotp_send(int fd, const std::uint8_t *data, std::size_t length) = 0;
+    virtual ssize_t isotp_recv(int fd, std::uint8_t *buffer, std::size_t capacity) = 0;
+
+    // Turns on RX timestamps for can_read_timestamped().
+    virtual bool enable_can_timestamps(int fd) = 0;
+    // can_read() plus the frame's CLOCK_REALTIME RX time in nanoseconds:
+    // the hardware stamp when the driver provides one, else the kernel's
+    // software stamp, 0 when neither was attached.
+    virtual ssize_t can_read_timestamped(int fd,
+                                         struct can_frame &frame,
+                                         std::uint64_t &timestamp_ns,
+                                         std::uint32_t &drops) = 0;
+};
+
+// Production backend: non-blocking UDP and CAN_RAW sockets.
+class SocketIoBackend final : public IoBackend {
+public:
+    bool interface_exists(const std::string &name) override;
+    unsigned int interface_index(const std::string &name) override;
+    bool setup_can_interfaces(const std::vector<CanLinkSpec> &specs, std::string &error_message) override;
+    int open_udp(std::uint16_t listen_port) override;
+    bool set_udp_filter(int fd, const std::vector<sock_filter> &program) override;
+    int open_can(const std::string &interface_name) override;
+    int open_can_any() override;
+    int open_can_bcm() override;
+    int open_isotp(const std::string &interface_name, const IsoTpLinkSpec &spec) override;
+    void close_endpoint(int fd) override;
+    bool set_socket_buffers(int fd, std::uint32_t rcvbuf, std::uint32_t sndbuf, bool force) override;
+    bool socket_memory(int fd, SocketMemory &memory) override;
+
+    ssize_t udp_recv(int fd,
+                     std::uint8_t *buffer,
+                     std::size_t capacity,
+                     std::size_t &segment_size,
+                     std::uint32_t &drops) override;
+    ssize_t udp_send(int fd, const std::uint8_t *data, std::size_t length, const sockaddr_in &destination) override;
+    ssize_t udp_send_segments(int fd,
+                              const std::uint8_t *data,
+                              std::size_t length,
+                              std::size_t segment_size,
+                              const sockaddr_in &destination) override;
+    ssize_t can_read(int fd, struct can_frame &frame, std::uint32_t &drops) override;
+    ssize_t can_write(int fd, const struct can_frame &frame) override;
+    ssize_t can_read_batch(int fd, CanRxFrame *frames, std::size_t capacity) override;
+    ssize_t can_write_to(int fd, const struct can_frame &frame, int ifindex) override;
+    bool set_can_receive(int fd, bool enabled) override;
+    bool can_bcm_send(int fd, int ifindex, const bcm_msg_head &head, const struct can_frame *frames) override;
+    ssize_t can_bcm_read_batch(int fd, CanRxFrame *frames, std::size_t capacity) override;
+    ssize_t isotp_send(int fd, const std::uint8_t *data, std::size_t length) override;
+    ssize_t isotp_recv(int fd, std::uint8_t *buffer, std::size_t capacity) override;
+    bool enable_can_timestamps(int fd) override;
+    ssize_t can_read_timestamped(int fd,
+                                 struct can_frame &frame,
+                                 std::uint64_t &timestamp_ns,
+                                 std::uint32_t &drops) override;
+
+private:
+    // Cleared after the kernel rejects UDP_SEGMENT; sends go one by one.
+    bool gso_supported_{true};
+};
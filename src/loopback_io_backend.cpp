@@ -0,0 +1,733 @@
+#include "loopback_io_backend.hpp"
+#include "clock.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+LoopbackIoBackend::~LoopbackIoBackend() {
+    for (const auto &entry : udp_endpoints_) {
+        close(entry.first);
+    }
+    for (const auto &entry : can_endpoints_) {
+        close(entry.first);
+    }
+    for (const auto &entry : bcm_endpoints_) {
+        close(entry.first);
+    }
+    for (const auto &entry : isotp_endpoints_) {
+        close(entry.first);
+    }
+}
+
+void LoopbackIoBackend::add_interface(const std::string &name) {
+    interfaces_.emplace(name, static_cast<int>(interfaces_.size()) + 1);
+    can_interfaces_[name];
+}
+
+void LoopbackIoBackend::set_can_tx_capacity(const std::string &interface_name, std::size_t frames) {
+    can_interfaces_[interface_name].tx_capacity = frames;
+}
+
+void LoopbackIoBackend::set_can_tx_error(const std::string &interface_name, int error) {
+    can_interfaces_[interface_name].tx_error = error;
+}
+
+void LoopbackIoBackend::set_udp_tx_capacity(std::uint16_t listen_port, std::size_t datagrams) {
+    if (UdpEndpoint *endpoint = find_udp(listen_port)) {
+        endpoint->tx_capacity = datagrams;
+    }
+}
+
+bool LoopbackIoBackend::inject_udp(std::uint16_t listen_port, const std::uint8_t *data, std::size_t length) {
+    return inject_udp_coalesced(listen_port, data, length, 0);
+}
+
+bool LoopbackIoBackend::inject_udp_coalesced(std::uint16_t listen_port,
+                                             const std::uint8_t *data,
+                                             std::size_t length,
+                                             std::size_t segment_size) {
+    for (auto &entry : udp_endpoints_) {
+        if (entry.second.listen_port != listen_port) {
+            continue;
+        }
+        UdpEndpoint &endpoint = entry.second;
+        if (!endpoint.buffers.admit(endpoint.rx.size())) {
+            return true;
+        }
+        UdpDatagram datagram;
+        datagram.payload.assign(data, data + length);
+        datagram.peer.sin_family = AF_INET;
+        datagram.peer.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        datagram.segment_size = segment_size;
+        datagram.drops = endpoint.buffers.drops;
+        endpoint.rx.push_back(std::move(datagram));
+        mark_readable(entry.first);
+        return true;
+    }
+    return false;
+}
+
+bool LoopbackIoBackend::inject_can(const std::string &interface_name,
+                                   const struct can_frame &frame,
+                                   std::uint64_t timestamp_ns) {
+    const auto iface = interfaces_.find(interface_name);
+    if (iface == interfaces_.end()) {
+        return false;
+    }
+    TimedFrame timed{frame, timestamp_ns != 0 ? timestamp_ns : realtime_ns(), iface->second, 0};
+    // Like a real bus, a frame is seen by every socket bound to the interface
+    // and by every socket bound to all of them.
+    for (auto &entry : can_endpoints_) {
+        CanEndpoint &endpoint = entry.second;
+        if (endpoint.receive && (endpoint.interface_name == interface_name || endpoint.interface_name.empty()) &&
+            endpoint.buffers.admit(endpoint.rx.size())) {
+            timed.drops = endpoint.buffers.drops;
+            endpoint.rx.push_back(timed);
+            mark_readable(entry.first);
+        }
+    }
+    for (auto &entry : bcm_endpoints_) {
+        const auto op = entry.second.rx_ops.find({iface->second, frame.can_id});
+        if (op == entry.second.rx_ops.end() || !op->second.changed(frame)) {
+            continue;
+        }
+        op->second.last = frame;
+        op->second.seen = true;
+        entry.second.rx.push_back(timed);
+        mark_readable(entry.first);
+    }
+    return true;
+}
+
+bool LoopbackIoBackend::pop_udp_tx(std::uint16_t listen_port,
+                                   std::vector<std::uint8_t> &datagram,
+                                   sockaddr_in *destination) {
+    UdpEndpoint *endpoint = find_udp(listen_port);
+    if (endpoint == nullptr || endpoint->tx.empty()) {
+        return false;
+    }
+    datagram = std::move(endpoint->tx.front().payload);
+    if (destination != nullptr) {
+        *destination = endpoint->tx.front().peer;
+    }
+    endpoint->tx.pop_front();
+    return true;
+}
+
+bool LoopbackIoBackend::pop_can_tx(const std::string &interface_name, struct can_frame &frame) {
+    auto it = can_interfaces_.find(interface_name);
+    if (it == can_interfaces_.end() || it->second.tx.empty()) {
+        return false;
+    }
+    frame = it->second.tx.front();
+    it->second.tx.pop_front();
+    return true;
+}
+
+std::size_t LoopbackIoBackend::can_tx_pending(const std::string &interface_name) const {
+    const auto it = can_interfaces_.find(interface_name);
+    return it == can_interfaces_.end() ? 0 : it->second.tx.size();
+}
+
+std::size_t LoopbackIoBackend::udp_tx_pending(std::uint16_t listen_port) const {
+    const UdpEndpoint *endpoint = find_udp(listen_port);
+    return endpoint == nullptr ? 0 : endpoint->tx.size();
+}
+
+std::size_t LoopbackIoBackend::udp_filter_length(std::uint16_t listen_port) const {
+    const UdpEndpoint *endpoint = find_udp(listen_port);
+    return endpoint == nullptr ? 0 : endpoint->filter_length;
+}
+
+std::uint32_t LoopbackIoBackend::udp_receive_buffer(std::uint16_t listen_port) const {
+    const UdpEndpoint *endpoint = find_udp(listen_port);
+    if (endpoint == nullptr) {
+        return 0;
+    }
+    return endpoint->buffers.receive != 0 ? endpoint->buffers.receive : kBufferLimit;
+}
+
+std::uint32_t LoopbackIoBackend::can_receive_buffer(const std::string &interface_name) const {
+    for (const auto &entry : can_endpoints_) {
+        if (entry.second.interface_name == interface_name) {
+            return entry.second.buffers.receive != 0 ? entry.second.buffers.receive : kBufferLimit;
+        }
+    }
+    return 0;
+}
+
+bool LoopbackIoBackend::inject_isotp(const std::string &interface_name,
+                                     canid_t rx_id,
+                                     const std::uint8_t *data,
+                                     std::size_t length) {
+    for (auto &entry : isotp_endpoints_) {
+        IsoTpEndpoint &endpoint = entry.second;
+        if (endpoint.interface_name == interface_name && endpoint.spec.rx_id == rx_id) {
+            endpoint.rx.emplace_back(data, data + length);
+            mark_readable(entry.first);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LoopbackIoBackend::pop_isotp_tx(const std::string &interface_name,
+                                     canid_t tx_id,
+                                     std::vector<std::uint8_t> &pdu) {
+    for (auto &entry : isotp_endpoints_) {
+        IsoTpEndpoint &endpoint = entry.second;
+        if (endpoint.interface_name == interface_name && endpoint.spec.tx_id == tx_id && !endpoint.tx.empty()) {
+            pdu = std::move(endpoint.tx.front());
+            endpoint.tx.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LoopbackIoBackend::bcm_tx_job(const std::string &interface_name,
+                                   canid_t can_id,
+                                   struct can_frame &frame,
+                                   std::uint32_t &period_us) const {
+    const auto iface = interfaces_.find(interface_name);
+    if (iface == interfaces_.end()) {
+        return false;
+    }
+    for (const auto &entry : bcm_endpoints_) {
+        const auto job = entry.second.tx_jobs.find({iface->second, can_id});
+        if (job != entry.second.tx_jobs.end()) {
+            frame = job->second.frame;
+            period_us = job->second.period_us;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t LoopbackIoBackend::bcm_tx_job_count() const {
+    std::size_t count = 0;
+    for (const auto &entry : bcm_endpoints_) {
+        count += entry.second.tx_jobs.size();
+    }
+    return count;
+}
+
+bool LoopbackIoBackend::bcm_rx_subscribed(const std::string &interface_name,
+                                          canid_t can_id,
+                                          std::uint32_t &throttle_ms) const {
+    const auto iface = interfaces_.find(interface_name);
+    if (iface == interfaces_.end()) {
+        return false;
+    }
+    for (const auto &entry : bcm_endpoints_) {
+        const auto op = entry.second.rx_ops.find({iface->second, can_id});
+        if (op != entry.second.rx_ops.end()) {
+            throttle_ms = op->second.throttle_ms;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t LoopbackIoBackend::bcm_rx_op_count() const {
+    std::size_t count = 0;
+    for (const auto &entry : bcm_endpoints_) {
+        count += entry.second.rx_ops.size();
+    }
+    return count;
+}
+
+bool LoopbackIoBackend::interface_exists(const std::string &name) {
+    return interfaces_.count(name) != 0;
+}
+
+unsigned int LoopbackIoBackend::interface_index(const std::string &name) {
+    const auto it = interfaces_.find(name);
+    return it == interfaces_.end() ? 0U : static_cast<unsigned int>(it->second);
+}
+
+bool LoopbackIoBackend::setup_can_interfaces(const std::vector<CanLinkSpec> &specs, std::string &error_message) {
+    (void)error_message;
+    link_setup_ = specs;
+    for (const CanLinkSpec &spec : specs) {
+        add_interface(spec.name);
+    }
+    return true;
+}
+
+int LoopbackIoBackend::open_udp(std::uint16_t listen_port) {
+    if (find_udp(listen_port) != nullptr) {
+        errno = EADDRINUSE;
+        return -1;
+    }
+    const int fd = create_event_fd();
+    if (fd < 0) {
+        return -1;
+    }
+    udp_endpoints_[fd].listen_port = listen_port;
+    return fd;
+}
+
+bool LoopbackIoBackend::set_udp_filter(int fd, const std::vector<sock_filter> &program) {
+    auto it = udp_endpoints_.find(fd);
+    if (it == udp_endpoints_.end()) {
+        errno = EBADF;
+        return false;
+    }
+    it->second.filter_length = program.size();
+    return true;
+}
+
+int LoopbackIoBackend::open_can(const std::string &interface_name) {
+    if (interfaces_.count(interface_name) == 0) {
+        errno = ENODEV;
+        return -1;
+    }
+    const int fd = create_event_fd();
+    if (fd < 0) {
+        return -1;
+    }
+    can_endpoints_[fd].interface_name = interface_name;
+    return fd;
+}
+
+int LoopbackIoBackend::open_can_any() {
+    const int fd = create_event_fd();
+    if (fd < 0) {
+        return -1;
+    }
+    can_endpoints_[fd];
+    return fd;
+}
+
+int LoopbackIoBackend::open_can_bcm() {
+    const int fd = create_event_fd();
+    if (fd < 0) {
+        return -1;
+    }
+    bcm_endpoints_[fd];
+    return fd;
+}
+
+int LoopbackIoBackend::open_isotp(const std::string &interface_name, const IsoTpLinkSpec &spec) {
+    if (interfaces_.count(interface_name) == 0) {
+        errno = ENODEV;
+        return -1;
+    }
+    for (const auto &entry : isotp_endpoints_) {
+        if (entry.second.interface_name == interface_name && entry.second.spec.rx_id == spec.rx_id) {
+            errno = EADDRINUSE;
+            return -1;
+        }
+    }
+    const int fd = create_event_fd();
+    if (fd < 0) {
+        return -1;
+    }
+    IsoTpEndpoint &endpoint = isotp_endpoints_[fd];
+    endpoint.interface_name = interface_name;
+    endpoint.spec = spec;
+    return fd;
+}
+
+void LoopbackIoBackend::close_endpoint(int fd) {
+    if (udp_endpoints_.erase(fd) == 0 && can_endpoints_.erase(fd) == 0 && bcm_endpoints_.erase(fd) == 0 &&
+        isotp_endpoints_.erase(fd) == 0) {
+        return;
+    }
+    close(fd);
+}
+
+bool LoopbackIoBackend::set_socket_buffers(int fd, std::uint32_t rcvbuf, std::uint32_t sndbuf, bool force) {
+    Buffers *buffers = nullptr;
+    if (auto udp = udp_endpoints_.find(fd); udp != udp_endpoints_.end()) {
+        buffers = &udp->second.buffers;
+    } else if (auto can = can_endpoints_.find(fd); can != can_endpoints_.end()) {
+        buffers = &can->second.buffers;
+    } else {
+        errno = EBADF;
+        return false;
+    }
+    // Without force the sysctl limit caps the size silently, as in the kernel.
+    const auto effective = [force](std::uint32_t size) { return (force ? size : std::min(size, kBufferLimit)) * 2; };
+    if (rcvbuf != 0) {
+        buffers->receive = effective(rcvbuf);
+    }
+    if (sndbuf != 0) {
+        buffers->send = effective(sndbuf);
+    }
+    return true;
+}
+
+bool LoopbackIoBackend::socket_memory(int fd, SocketMemory &memory) {
+    const Buffers *buffers = nullptr;
+    std::size_t queued = 0;
+    if (auto udp = udp_endpoints_.find(fd); udp != udp_endpoints_.end()) {
+        buffers = &udp->second.buffers;
+        queued = udp->second.rx.size();
+    } else if (auto can = can_endpoints_.find(fd); can != can_endpoints_.end()) {
+        buffers = &can->second.buffers;
+        queued = can->second.rx.size();
+    } else {
+        errno = EBADF;
+        return false;
+    }
+    memory.receive_queued = static_cast<std::uint32_t>(queued) * kQueuedMessageCost;
+    memory.receive_buffer = buffers->receive != 0 ? buffers->receive : kBufferLimit;
+    memory.send_buffer = buffers->send != 0 ? buffers->send : kBufferLimit;
+    memory.drops = buffers->drops;
+    return true;
+}
+
+ssize_t LoopbackIoBackend::udp_recv(int fd,
+                                    std::uint8_t *buffer,
+                                    std::size_t capacity,
+                                    std::size_t &segment_size,
+                                    std::uint32_t &drops) {
+    auto it = udp_endpoints_.find(fd);
+    if (it == udp_endpoints_.end()) {
+        errno = EBADF;
+        return -1;
+    }
+    auto &rx = it->second.rx;
+    if (rx.empty()) {
+        errno = EAGAIN;
+        return -1;
+    }
+    // Datagram semantics: anything beyond capacity is truncated and lost.
+    const std::size_t length = std::min(capacity, rx.front().payload.size());
+    std::memcpy(buffer, rx.front().payload.data(), length);
+    segment_size = rx.front().segment_size;
+    drops = rx.front().drops;
+    rx.pop_front();
+    if (rx.empty()) {
+        mark_drained(fd);
+    }
+    return static_cast<ssize_t>(length);
+}
+
+ssize_t LoopbackIoBackend::udp_send(int fd,
+                                    const std::uint8_t *data,
+                                    std::size_t length,
+                                    const sockaddr_in &destination) {
+    auto it = udp_endpoints_.find(fd);
+    if (it == udp_endpoints_.end()) {
+        errno = EBADF;
+        return -1;
+    }
+    if (it->second.tx.size() >= it->second.tx_capacity) {
+        errno = EAGAIN;
+        return -1;
+    }
+    UdpDatagram datagram;
+    datagram.payload.assign(data, data + length);
+    datagram.peer = destination;
+    it->second.tx.push_back(std::move(datagram));
+    return static_cast<ssize_t>(length);
+}
+
+// Like the kernel's GSO path: the peer sees one datagram per segment.
+ssize_t LoopbackIoBackend::udp_send_segments(int fd,
+                                             const std::uint8_t *data,
+                                             std::size_t length,
+                                             std::size_t segment_size,
+                                             const sockaddr_in &destination) {
+    for (std::size_t offset = 0; offset < length; offset += segment_size) {
+        if (udp_send(fd, data + offset, std::min(segment_size, length - offset), destination) < 0) {
+            return offset == 0 ? -1 : static_cast<ssize_t>(offset);
+        }
+    }
+    return static_cast<ssize_t>(length);
+}
+
+ssize_t LoopbackIoBackend::can_read(int fd, struct can_frame &frame, std::uint32_t &drops) {
+    std::uint64_t timestamp_ns = 0;
+    return can_read_timestamped(fd, frame, timestamp_ns, drops);
+}
+
+bool LoopbackIoBackend::enable_can_timestamps(int fd) {
+    return can_endpoints_.count(fd) != 0;
+}
+
+ssize_t LoopbackIoBackend::can_read_timestamped(int fd,
+                                                struct can_frame &frame,
+                                                std::uint64_t &timestamp_ns,
+                                                std::uint32_t &drops) {
+    auto it = can_endpoints_.find(fd);
+    if (it == can_endpoints_.end()) {
+        errno = EBADF;
+        return -1;
+    }
+    auto &rx = it->second.rx;
+    if (rx.empty()) {
+        errno = EAGAIN;
+        return -1;
+    }
+    frame = rx.front().frame;
+    timestamp_ns = rx.front().timestamp_ns;
+    drops = rx.front().drops;
+    rx.pop_front();
+    if (rx.empty()) {
+        mark_drained(fd);
+    }
+    return static_cast<ssize_t>(sizeof(frame));
+}
+
+ssize_t LoopbackIoBackend::can_write(int fd, const struct can_frame &frame) {
+    auto it = can_endpoints_.find(fd);
+    if (it == can_endpoints_.end()) {
+        errno = EBADF;
+        return -1;
+    }
+    if (it->second.interface_name.empty()) {
+        // Like an unbound send on a socket bound to all interfaces.
+        errno = EDESTADDRREQ;
+        return -1;
+    }
+    return write_frame(it->second.interface_name, frame);
+}
+
+ssize_t LoopbackIoBackend::can_read_batch(int fd, CanRxFrame *frames, std::size_t capacity) {
+    auto it = can_endpoints_.find(fd);
+    if (it == can_endpoints_.end()) {
+        errno = EBADF;
+        return -1;
+    }
+    auto &rx = it->second.rx;
+    if (rx.empty()) {
+        errno = EAGAIN;
+        return -1;
+    }
+    std::size_t count = 0;
+    while (count < capacity && !rx.empty()) {
+        frames[count].frame = rx.front().frame;
+        frames[count].ifindex = rx.front().ifindex;
+        frames[count].timestamp_ns = rx.front().timestamp_ns;
+        frames[count].drops = rx.front().drops;
+        rx.pop_front();
+        ++count;
+    }
+    if (rx.empty()) {
+        mark_drained(fd);
+    }
+    return static_cast<ssize_t>(count);
+}
+
+ssize_t LoopbackIoBackend::can_write_to(int fd, const struct can_frame &frame, int ifindex) {
+    if (can_endpoints_.count(fd) == 0) {
+        errno = EBADF;
+        return -1;
+    }
+    for (const auto &entry : interfaces_) {
+        if (entry.second == ifindex) {
+            return write_frame(entry.first, frame);
+        }
+    }
+    errno = ENODEV;
+    return -1;
+}
+
+bool LoopbackIoBackend::set_can_receive(int fd, bool enabled) {
+    auto it = can_endpoints_.find(fd);
+    if (it == can_endpoints_.end()) {
+        errno = EBADF;
+        return false;
+    }
+    it->second.receive = enabled;
+    return true;
+}
+
+bool LoopbackIoBackend::can_bcm_send(int fd,
+                                     int ifindex,
+                                     const bcm_msg_head &head,
+                                     const struct can_frame *frames) {
+    auto it = bcm_endpoints_.find(fd);
+    if (it == bcm_endpoints_.end()) {
+        errno = EBADF;
+        return false;
+    }
+    const auto iface = std::find_if(interfaces_.begin(), interfaces_.end(), [ifindex](const auto &entry) {
+        return entry.second == ifindex;
+    });
+    if (iface == interfaces_.end()) {
+        errno = ENODEV;
+        return false;
+    }
+    auto &jobs = it->second.tx_jobs;
+    const std::pair<int, canid_t> key{ifindex, head.can_id};
+    switch (head.opcode) {
+    case TX_SETUP: {
+        if (head.nframes != 1) {
+            errno = EINVAL;
+            return false;
+        }
+        const auto period_us = static_cast<std::uint32_t>(head.ival2.tv_sec * 1000000 + head.ival2.tv_usec);
+        jobs[key] = BcmTxJob{frames[0], period_us};
+        if ((head.flags & TX_ANNOUNCE) != 0U) {
+            write_frame(iface->first, frames[0]);
+        }
+        return true;
+    }
+    case TX_DELETE:
+        if (jobs.erase(key) == 0) {
+            errno = EINVAL;
+            return false;
+        }
+        return true;
+    case RX_SETUP: {
+        if (head.nframes > 1 || (head.nframes == 0 && (head.flags & RX_FILTER_ID) == 0U)) {
+            errno = EINVAL;
+            return false;
+        }
+        // A changed setup starts over, as if nothing had been received.
+        BcmRxOp op{head.flags, {}, {}, false, 0};
+        if (head.nframes == 1) {
+            op.mask = frames[0];
+        }
+        if ((head.flags & SETTIMER) != 0U) {
+            op.throttle_ms = static_cast<std::uint32_t>(head.ival2.tv_sec * 1000 + head.ival2.tv_usec / 1000);
+        }
+        it->second.rx_ops[key] = op;
+        return true;
+    }
+    case RX_DELETE:
+        if (it->second.rx_ops.erase(key) == 0) {
+            errno = EINVAL;
+            return false;
+        }
+        return true;
+    default:
+        errno = EINVAL;
+        return false;
+    }
+}
+
+ssize_t LoopbackIoBackend::can_bcm_read_batch(int fd, CanRxFrame *frames, std::size_t capacity) {
+    auto it = bcm_endpoints_.find(fd);
+    if (it == bcm_endpoints_.end()) {
+        errno = EBADF;
+        return -1;
+    }
+    auto &rx = it->second.rx;
+    if (rx.empty()) {
+        errno = EAGAIN;
+        return -1;
+    }
+    std::size_t count = 0;
+    while (count < capacity && !rx.empty()) {
+        frames[count].frame = rx.front().frame;
+        frames[count].ifindex = rx.front().ifindex;
+        frames[count].timestamp_ns = rx.front().timestamp_ns;
+        frames[count].drops = 0;
+        rx.pop_front();
+        ++count;
+    }
+    if (rx.empty()) {
+        mark_drained(fd);
+    }
+    return static_cast<ssize_t>(count);
+}
+
+ssize_t LoopbackIoBackend::isotp_send(int fd, const std::uint8_t *data, std::size_t length) {
+    auto it = isotp_endpoints_.find(fd);
+    if (it == isotp_endpoints_.end()) {
+        errno = EBADF;
+        return -1;
+    }
+    if (!it->second.tx.empty()) {
+        errno = EAGAIN;
+        return -1;
+    }
+    it->second.tx.emplace_back(data, data + length);
+    return static_cast<ssize_t>(length);
+}
+
+ssize_t LoopbackIoBackend::isotp_recv(int fd, std::uint8_t *buffer, std::size_t capacity) {
+    auto it = isotp_endpoints_.find(fd);
+    if (it == isotp_endpoints_.end()) {
+        errno = EBADF;
+        return -1;
+    }
+    auto &rx = it->second.rx;
+    if (rx.empty()) {
+        errno = EAGAIN;
+        return -1;
+    }
+    // Datagram semantics: what does not fit is cut off.
+    const std::size_t length = std::min(capacity, rx.front().size());
+    std::memcpy(buffer, rx.front().data(), length);
+    rx.pop_front();
+    if (rx.empty()) {
+        mark_drained(fd);
+    }
+    return static_cast<ssize_t>(length);
+}
+
+ssize_t LoopbackIoBackend::write_frame(const std::string &interface_name, const struct can_frame &frame) {
+    CanInterface &iface = can_interfaces_[interface_name];
+    if (iface.tx.size() >= iface.tx_capacity) {
+        errno = iface.tx_error;
+        return -1;
+    }
+    iface.tx.push_back(frame);
+    return static_cast<ssize_t>(sizeof(frame));
+}
+
+bool LoopbackIoBackend::BcmRxOp::changed(const struct can_frame &frame) const {
+    if (!seen || (flags & RX_FILTER_ID) != 0U) {
+        return true;
+    }
+    if ((flags & RX_CHECK_DLC) != 0U && frame.can_dlc != last.can_dlc) {
+        return true;
+    }
+    for (std::size_t i = 0; i < sizeof(frame.data); ++i) {
+        if (((frame.data[i] ^ last.data[i]) & mask.data[i]) != 0U) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LoopbackIoBackend::Buffers::admit(std::size_t queued) {
+    if (receive != 0 && (queued + 1) * kQueuedMessageCost > receive) {
+        ++drops;
+        return false;
+    }
+    return true;
+}
+
+int LoopbackIoBackend::create_event_fd() {
+    return eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+void LoopbackIoBackend::mark_readable(int fd) {
+    const eventfd_t one = 1;
+    // The counter only needs to be non-zero; eventfd_write saturates harmlessly.
+    eventfd_write(fd, one);
+}
+
+void LoopbackIoBackend::mark_drained(int fd) {
+    eventfd_t value = 0;
+    eventfd_read(fd, &value);
+}
+
+LoopbackIoBackend::UdpEndpoint *LoopbackIoBackend::find_udp(std::uint16_t listen_port) {
+    for (auto &entry : udp_endpoints_) {
+        if (entry.second.listen_port == listen_port) {
+            return &entry.second;
+        }
+    }
+    return nullptr;
+}
+
+const LoopbackIoBackend::UdpEndpoint *LoopbackIoBackend::find_udp(std::uint16_t listen_port) const {
+    for (const auto &entry : udp_endpoints_) {
+        if (entry.second.listen_port == listen_port) {
+            return &entry.second;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "io_backend.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// In-memory IoBackend for tests and benchmarks. Each endpoint is backed by a
+// non-blocking eventfd that is readable exactly while its receive queue is
+// non-empty, so BridgeApp's real epoll loop drives it unchanged and no root
+// privileges, vcan module or network stack are required.
+//
+// The "far side" of every endpoint is exposed through inject_* (traffic that
+// arrives at the bridge) and pop_* (traffic the bridge emitted). TX queues
+// have a configurable capacity; writes beyond it fail with EAGAIN so that
+// backpressure handling can be exercised deterministically. Receive queues
+// are unlimited until set_socket_buffers() sizes them; past that size
+// arriving traffic is dropped and counted like the kernel does.
+class LoopbackIoBackend final : public IoBackend {
+public:
+    static constexpr std::size_t kUnlimited = std::numeric_limits<std::size_t>::max();
+    // What one queued datagram or frame charges against a sized receive
+    // buffer, roughly the truesize of a small skb.
+    static constexpr std::uint32_t kQueuedMessageCost = 1024;
+    // The default net.core.rmem_max/wmem_max, and the size reported for
+    // buffers that were never set.
+    static constexpr std::uint32_t kBufferLimit = 212992;
+
+    LoopbackIoBackend() = default;
+    ~LoopbackIoBackend() override;
+
+    LoopbackIoBackend(const LoopbackIoBackend &) = delete;
+    LoopbackIoBackend &operator=(const LoopbackIoBackend &) = delete;
+
+    void add_interface(const std::string &name);
+    void set_can_tx_capacity(const std::string &interface_name, std::size_t frames);
+    // What a write beyond the capacity fails with: EAGAIN (socket send buffer
+    // full) by default, ENOBUFS for a full qdisc or driver queue.
+    void set_can_tx_error(const std::string &interface_name, int error);
+    // Datagrams the port's socket accepts before sends fail with EAGAIN;
+    // popped datagrams free their slot. Applies to the open socket only.
+    void set_udp_tx_capacity(std::uint16_t listen_port, std::size_t datagrams);
+
+    bool inject_udp(std::uint16_t listen_port, const std::uint8_t *data, std::size_t length);
+    // Delivers data as one read carrying several datagrams of segment_size
+    // bytes (the last may be shorter), the way UDP GRO presents them.
+    bool inject_udp_coalesced(std::uint16_t listen_port,
+                              const std::uint8_t *data,
+                              std::size_t length,
+                              std::size_t segment_size);
+    // timestamp_ns is what can_read_timestamped() reports; 0 stamps the frame
+    // with the current CLOCK_REALTIME.
+    bool inject_can(const std::string &interface_name, const struct can_frame &frame, std::uint64_t timestamp_ns = 0);
+    bool pop_udp_tx(std::uint16_t listen_port, std::vector<std::uint8_t> &datagram, sockaddr_in *destination = nullptr);
+    bool pop_can_tx(const std::string &interface_name, struct can_frame &frame);
+    std::size_t can_tx_pending(const std::string &interface_name) const;
+    std::size_t udp_tx_pending(std::uint16_t listen_port) const;
+    // Instructions of the filter set on the port's socket; it is recorded,
+    // not run.
+    std::size_t udp_filter_length(std::uint16_t listen_port) const;
+    // Receive buffer sizes, as the kernel would report them (doubled).
+    std::uint32_t udp_receive_buffer(std::uint16_t listen_port) const;
+    std::uint32_t can_receive_buffer(const std::string &interface_name) const;
+    // The cyclic job a CAN_BCM socket runs for can_id on the interface; jobs
+    // are recorded, not fired.
+    bool bcm_tx_job(const std::string &interface_name,
+                    canid_t can_id,
+                    struct can_frame &frame,
+                    std::uint32_t &period_us) const;
+    std::size_t bcm_tx_job_count() const;
+    // An RX_SETUP subscription for can_id on the interface. The content
+    // filter is applied to injected frames; throttling is recorded only.
+    bool bcm_rx_subscribed(const std::string &interface_name, canid_t can_id, std::uint32_t &throttle_ms) const;
+    std::size_t bcm_rx_op_count() const;
+    // The far side of the ISO-TP socket bound to rx_id / tx_id on the
+    // interface. A sent PDU counts as in flight, and further sends fail with
+    // EAGAIN, until it is popped.
+    bool inject_isotp(const std::string &interface_name, canid_t rx_id, const std::uint8_t *data, std::size_t length);
+    bool pop_isotp_tx(const std::string &interface_name, canid_t tx_id, std::vector<std::uint8_t> &pdu);
+    std::size_t open_endpoint_count() const {
+        return udp_endpoints_.size() + can_endpoints_.size() + bcm_endpoints_.size() + isotp_endpoints_.size();
+    }
+    // Specs passed to the last setup_can_interfaces() call.
+    const std::vector<CanLinkSpec> &link_setup() const { return link_setup_; }
+
+    bool interface_exists(const std::string &name) override;
+    unsigned int interface_index(const std::string &name) override;
+    bool setup_can_interfaces(const std::vector<CanLinkSpec> &specs, std::string &error_message) override;
+    int open_udp(std::uint16_t listen_port) override;
+    bool set_udp_filter(int fd, const std::vector<sock_filter> &program) override;
+    int open_can(const std::string &interface_name) override;
+    int open_can_any() override;
+    int open_can_bcm() override;
+    int open_isotp(const std::string &interface_name, const IsoTpLinkSpec &spec) override;
+    void close_endpoint(int fd) override;
+    bool set_socket_buffers(int fd, std::uint32_t rcvbuf, std::uint32_t sndbuf, bool force) override;
+    bool socket_memory(int fd, SocketMemory &memory) override;
+
+    ssize_t udp_recv(int fd,
+                     std::uint8_t *buffer,
+                     std::size_t capacity,
+                     std::size_t &segment_size,
+                     std::uint32_t &drops) override;
+    ssize_t udp_send(int fd, const std::uint8_t *data, std::size_t length, const sockaddr_in &destination) override;
+    ssize_t udp_send_segments(int fd,
+                              const std::uint8_t *data,
+                              std::size_t length,
+                              std::size_t segment_size,
+                              const sockaddr_in &destination) override;
+    ssize_t can_read(int fd, struct can_frame &frame, std::uint32_t &drops) override;
+    ssize_t can_write(int fd, const struct can_frame &frame) override;
+    ssize_t can_read_batch(int fd, CanRxFrame *frames, std::size_t capacity) override;
+    ssize_t can_write_to(int fd, const struct can_frame &frame, int ifindex) override;
+    bool set_can_receive(int fd, bool enabled) override;
+    bool can_bcm_send(int fd, int ifindex, const bcm_msg_head &head, const struct can_frame *frames) override;
+    ssize_t can_bcm_read_batch(int fd, CanRxFrame *frames, std::size_t capacity) override;
+    ssize_t isotp_send(int fd, const std::uint8_t *data, std::size_t length) override;
+    ssize_t isotp_recv(int fd, std::uint8_t *buffer, std::size_t capacity) override;
+    bool enable_can_timestamps(int fd) override;
+    ssize_t can_read_timestamped(int fd,
+                                 struct can_frame &frame,
+                                 std::uint64_t &timestamp_ns,
+                                 std::uint32_t &drops) override;
+
+private:
+    // Sizes are the doubled values; a receive size of 0 means unlimited.
+    struct Buffers {
+        std::uint32_t receive{0};
+        std::uint32_t send{0};
+        std::uint32_t drops{0};
+
+        // Counts a drop when a message does not fit next to `queued` ones.
+        bool admit(std::size_t queued);
+    };
+
+    struct UdpDatagram {
+        std::vector<std::uint8_t> payload;
+        sockaddr_in peer{};
+        std::size_t segment_size{0};
+        std::uint32_t drops{0}; // the socket's drop count when it was queued
+    };
+
+    struct UdpEndpoint {
+        std::uint16_t listen_port{0};
+        std::size_t filter_length{0};
+        Buffers buffers;
+        std::deque<UdpDatagram> rx;
+        std::deque<UdpDatagram> tx;
+        std::size_t tx_capacity{kUnlimited};
+    };
+
+    struct TimedFrame {
+        struct can_frame frame;
+        std::uint64_t timestamp_ns;
+        int ifindex;
+        std::uint32_t drops;
+    };
+
+    struct CanEndpoint {
+        std::string interface_name; // empty for open_can_any()
+        Buffers buffers;
+        std::deque<TimedFrame> rx;
+        bool receive{true};
+    };
+
+    struct BcmTxJob {
+        struct can_frame frame;
+        std::uint32_t period_us;
+    };
+
+    // The RX_SETUP content filter: `mask` selects the payload bits to
+    // compare with `last`, the previous frame of the ID.
+    struct BcmRxOp {
+        std::uint32_t flags;
+        struct can_frame mask;
+        struct can_frame last;
+        bool seen;
+        std::uint32_t throttle_ms;
+
+        bool changed(const struct can_frame &frame) const;
+    };
+
+    // Jobs and subscriptions keyed by (ifindex, can_id), as the kernel keys
+    // them; rx holds the RX_CHANGED frames not read yet.
+    struct BcmEndpoint {
+        std::map<std::pair<int, canid_t>, BcmTxJob> tx_jobs;
+        std::map<std::pair<int, canid_t>, BcmRxOp> rx_ops;
+        std::deque<TimedFrame> rx;
+    };
+
+    struct IsoTpEndpoint {
+        std::string interface_name;
+        IsoTpLinkSpec spec;
+        std::deque<std::vector<std::uint8_t>> rx;
+        std::deque<std::vector<std::uint8_t>> tx;
+    };
+
+    struct CanInterface {
+        std::deque<struct can_frame> tx;
+        std::size_t tx_capacity{kUnlimited};
+        int tx_error{EAGAIN};
+    };
+
+    ssize_t write_frame(const std::string &interface_name, const struct can_frame &frame);
+    int create_event_fd();
+    void mark_readable(int fd);
+    void mark_drained(int fd);
+    UdpEndpoint *find_udp(std::uint16_t listen_port);
+    const UdpEndpoint *find_udp(std::uint16_t listen_port) const;
+
+    // Interface name -> ifindex, numbered from 1 in order of creation.
+    std::map<std::string, int> interfaces_;
+    std::vector<CanLinkSpec> link_setup_;
+    std::map<std::string, CanInterface> can_interfaces_;
+    std::map<int, UdpEndpoint> udp_endpoints_;
+    std::map<int, CanEndpoint> can_endpoints_;
+    std::map<int, BcmEndpoint> bcm_endpoints_;
+    std::map<int, IsoTpEndpoint> isotp_endpoints_;
+};
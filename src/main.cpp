@@ -1,8 +1,6 @@
 #include "bridge.hpp"
 #include "config.hpp"
 
-#include <atomic>
-#include <csignal>
 #include <cstdio>
 #include <cstring>
 #include <string>
@@ -10,12 +8,6 @@
 
 namespace {
 
-std::atomic<bool> g_keep_running(true);
-
-void signal_handler(int) {
-    g_keep_running.store(false);
-}
-
 void print_usage(const char *prog) {
     std::fprintf(stderr, "Usage: %s --config <path>\n", prog);
 }
@@ -60,17 +52,16 @@ int main(int argc, char **argv) {
     openlog("udp_socketcan_bridge", LOG_PID | LOG_CONS, LOG_DAEMON);
 
     BridgeApp app(config);
+    app.enable_reload(config_path);
+    app.enable_signals();
     if (!app.initialize()) {
         syslog(LOG_ERR, "bridge initialization failed");
         closelog();
         return 1;
     }
 
-    std::signal(SIGINT, signal_handler);
-    std::signal(SIGTERM, signal_handler);
-
     syslog(LOG_INFO, "Bridge is running");
-    app.run(g_keep_running);
+    app.run();
     syslog(LOG_INFO, "Shutting down");
     closelog();
     return 0;
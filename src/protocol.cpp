@@ -73,3 +73,91 @@ bool encode_udp_frame(const struct can_frame &frame, std::uint8_t *buffer) {
     std::memcpy(&buffer[5], frame.data, dlc);
     return true;
 }
+
+bool decode_timestamped_frame(const std::uint8_t *data, struct can_frame &frame, std::uint64_t &timestamp_ns) {
+    if (!decode_udp_frame(data, frame)) {
+        return false;
+    }
+    timestamp_ns = 0;
+    for (std::size_t i = 0; i < 8U; ++i) {
+        timestamp_ns = (timestamp_ns << 8U) | data[kUdpFrameSize + i];
+    }
+    return true;
+}
+
+bool encode_timestamped_frame(const struct can_frame &frame, std::uint64_t timestamp_ns, std::uint8_t *buffer) {
+    if (!encode_udp_frame(frame, buffer)) {
+        return false;
+    }
+    for (std::size_t i = 0; i < 8U; ++i) {
+        buffer[kUdpFrameSize + i] = static_cast<std::uint8_t>((timestamp_ns >> (56U - 8U * i)) & 0xFFU);
+    }
+    return true;
+}
+
+bool decode_datagram_header(const std::uint8_t *data, DatagramHeader &header) {
+    if (data == nullptr) {
+        return false;
+    }
+    header.sequence = (static_cast<std::uint32_t>(data[0]) << 24U) |
+                      (static_cast<std::uint32_t>(data[1]) << 16U) |
+                      (static_cast<std::uint32_t>(data[2]) << 8U) |
+                      static_cast<std::uint32_t>(data[3]);
+    header.frame_count = static_cast<std::uint16_t>((static_cast<std::uint32_t>(data[4]) << 8U) | data[5]);
+    return true;
+}
+
+bool encode_datagram_header(const DatagramHeader &header, std::uint8_t *buffer) {
+    if (buffer == nullptr) {
+        return false;
+    }
+    buffer[0] = static_cast<std::uint8_t>((header.sequence >> 24U) & 0xFFU);
+    buffer[1] = static_cast<std::uint8_t>((header.sequence >> 16U) & 0xFFU);
+    buffer[2] = static_cast<std::uint8_t>((header.sequence >> 8U) & 0xFFU);
+    buffer[3] = static_cast<std::uint8_t>(header.sequence & 0xFFU);
+    buffer[4] = static_cast<std::uint8_t>((header.frame_count >> 8U) & 0xFFU);
+    buffer[5] = static_cast<std::uint8_t>(header.frame_count & 0xFFU);
+    return true;
+}
+
+bool decode_control_record(const std::uint8_t *data, ControlRecord &record) {
+    if (data == nullptr || data[0] != kControlInfo) {
+        return false;
+    }
+    const auto opcode = static_cast<ControlOpcode>(data[1]);
+    if (opcode != ControlOpcode::CyclicStart && opcode != ControlOpcode::CyclicStop &&
+        opcode != ControlOpcode::IsoTpPdu) {
+        return false;
+    }
+    record.opcode = opcode;
+    record.period_us = (static_cast<std::uint32_t>(data[2]) << 24U) |
+                       (static_cast<std::uint32_t>(data[3]) << 16U) |
+                       (static_cast<std::uint32_t>(data[4]) << 8U) |
+                       static_cast<std::uint32_t>(data[5]);
+    record.can_id = (static_cast<std::uint32_t>(data[6]) << 24U) |
+                    (static_cast<std::uint32_t>(data[7]) << 16U) |
+                    (static_cast<std::uint32_t>(data[8]) << 8U) |
+                    static_cast<std::uint32_t>(data[9]);
+    record.length = static_cast<std::uint16_t>((static_cast<std::uint16_t>(data[10]) << 8U) | data[11]);
+    return true;
+}
+
+bool encode_control_record(const ControlRecord &record, std::uint8_t *buffer) {
+    if (buffer == nullptr) {
+        return false;
+    }
+    std::memset(buffer, 0, kUdpFrameSize);
+    buffer[0] = kControlInfo;
+    buffer[1] = static_cast<std::uint8_t>(record.opcode);
+    buffer[2] = static_cast<std::uint8_t>((record.period_us >> 24U) & 0xFFU);
+    buffer[3] = static_cast<std::uint8_t>((record.period_us >> 16U) & 0xFFU);
+    buffer[4] = static_cast<std::uint8_t>((record.period_us >> 8U) & 0xFFU);
+    buffer[5] = static_cast<std::uint8_t>(record.period_us & 0xFFU);
+    buffer[6] = static_cast<std::uint8_t>((record.can_id >> 24U) & 0xFFU);
+    buffer[7] = static_cast<std::uint8_t>((record.can_id >> 16U) & 0xFFU);
+    buffer[8] = static_cast<std::uint8_t>((record.can_id >> 8U) & 0xFFU);
+    buffer[9] = static_cast<std::uint8_t>(record.can_id & 0xFFU);
+    buffer[10] = static_cast<std::uint8_t>((record.length >> 8U) & 0xFFU);
+    buffer[11] = static_cast<std::uint8_t>(record.length & 0xFFU);
+    return true;
+}
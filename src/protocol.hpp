@@ -6,6 +6,68 @@
 #include <linux/can.h>
 
 constexpr std::size_t kUdpFrameSize = 13;
+// Timestamped format: the 13-byte frame followed by a big-endian u64
+// CLOCK_REALTIME timestamp in nanoseconds. CAN -> UDP it is the RX time of
+// the frame; UDP -> CAN it is the requested transmit time (0 = now).
+constexpr std::size_t kTimestampedFrameSize = kUdpFrameSize + 8;
+constexpr std::size_t kMaxUdpFrameSize = kTimestampedFrameSize;
+
+// Optional datagram header ahead of the frames: big-endian u32 sequence
+// number (per port and direction, wrapping) and u16 count of the frames that
+// follow.
+constexpr std::size_t kSequenceHeaderSize = 6;
+
+struct DatagramHeader {
+    std::uint32_t sequence;
+    std::uint16_t frame_count;
+};
+
+// Control records share the frame slots of a UDP datagram. The first slot
+// starts with kControlInfo, an info byte no frame has (DLC 15), then an
+// opcode and big-endian fields: u32 period in microseconds at [2], u32 CAN
+// ID at [6], u16 length at [10]; the rest of the slot is zero.
+//  - CyclicStart/CyclicStop: the frame the record applies to fills the next
+//    slot in the port's frame format (a timestamp there is ignored).
+//  - IsoTpPdu: an ISO-TP payload of `length` bytes for the link whose tx_id
+//    (UDP -> CAN) or rx_id (CAN -> UDP) is `can_id` fills the rest of the
+//    datagram, zero-padded to whole slots. The record is the datagram's
+//    first slot.
+// Bridges that do not know control records count the first slot as
+// malformed.
+constexpr std::uint8_t kControlInfo = 0x3F;
+constexpr std::size_t kControlSlots = 2;
+// ISO-TP's classic CAN limit (12-bit first frame length).
+constexpr std::size_t kMaxIsoTpPdu = 4095;
+
+enum class ControlOpcode : std::uint8_t {
+    CyclicStart = 1, // send the frame now and then every period_us
+    CyclicStop = 2,  // stop the cyclic frame with this frame's CAN ID
+    IsoTpPdu = 3,    // one whole ISO-TP payload
+};
+
+struct ControlRecord {
+    ControlOpcode opcode;
+    std::uint32_t period_us{0};
+    std::uint32_t can_id{0};
+    std::uint16_t length{0};
+};
+
+enum class FrameFormat : std::uint8_t {
+    Standard,
+    Timestamped,
+};
+
+constexpr std::size_t frame_size(FrameFormat format) {
+    return format == FrameFormat::Timestamped ? kTimestampedFrameSize : kUdpFrameSize;
+}
 
 bool decode_udp_frame(const std::uint8_t *data, struct can_frame &frame);
 bool encode_udp_frame(const struct can_frame &frame, std::uint8_t *buffer);
+bool decode_timestamped_frame(const std::uint8_t *data, struct can_frame &frame, std::uint64_t &timestamp_ns);
+bool encode_timestamped_frame(const struct can_frame &frame, std::uint64_t timestamp_ns, std::uint8_t *buffer);
+bool decode_datagram_header(const std::uint8_t *data, DatagramHeader &header);
+bool encode_datagram_header(const DatagramHeader &header, std::uint8_t *buffer);
+// Records are read from and written to the first kUdpFrameSize bytes of a
+// slot; encode zero-fills them.
+bool decode_control_record(const std::uint8_t *data, ControlRecord &record);
+bool encode_control_record(const ControlRecord &record, std::uint8_t *buffer);
@@ -0,0 +1,166 @@
+#include "rate_limiter.hpp"
+
+#include <algorithm>
+
+namespace {
+
+std::size_t hash_identifier(std::uint32_t identifier) {
+    return static_cast<std::size_t>(identifier * 0x9E3779B1U);
+}
+
+} // namespace
+
+bool RateLimiter::initialize(const std::vector<RateLimitRule> &rules) {
+    active_.fill(false);
+    tables_ = {};
+    states_.clear();
+    stats_.clear();
+    if (rules.empty()) {
+        return true;
+    }
+    if (rules.size() >= kNoRule) {
+        return false;
+    }
+
+    states_.assign(rules.size() * kDirections, RuleState{});
+    stats_.assign(rules.size(), RuleStats{});
+
+    for (std::size_t d = 0; d < kDirections; ++d) {
+        const FlowDirection direction = static_cast<FlowDirection>(d);
+        DirectionTables &tables = tables_[d];
+
+        std::size_t exact_count = 0;
+        for (const auto &rule : rules) {
+            if (applies(rule.direction, direction) && rule.id_range.min == rule.id_range.max &&
+                rule.id_range.min >= kDirectEntries) {
+                ++exact_count;
+            }
+        }
+        std::size_t exact_capacity = 1;
+        while (exact_capacity < exact_count * 2) {
+            exact_capacity <<= 1U;
+        }
+        tables.exact.assign(exact_capacity, HashSlot{});
+        tables.exact_mask = exact_capacity - 1;
+        tables.direct.assign(kDirectEntries, kNoRule);
+
+        for (std::size_t r = 0; r < rules.size(); ++r) {
+            const RateLimitRule &rule = rules[r];
+            if (!applies(rule.direction, direction)) {
+                continue;
+            }
+            active_[d] = true;
+            const std::uint16_t rule_index = static_cast<std::uint16_t>(r);
+
+            RuleState &state = states_[r * kDirections + d];
+            state.decimate = rule.decimate;
+            if (rule.max_rate_hz != 0) {
+                state.interval_ns = 1000000000ULL / rule.max_rate_hz;
+                state.tolerance_ns = state.interval_ns * (rule.burst - 1U);
+            }
+
+            const std::uint32_t direct_limit = static_cast<std::uint32_t>(kDirectEntries - 1);
+            if (rule.id_range.min <= direct_limit) {
+                const std::uint32_t last = std::min(rule.id_range.max, direct_limit);
+                for (std::uint32_t id = rule.id_range.min; id <= last; ++id) {
+                    tables.direct[id] = rule_index;
+                }
+            }
+            if (rule.id_range.max < kDirectEntries) {
+                continue;
+            }
+            if (rule.id_range.min == rule.id_range.max) {
+                std::size_t slot = hash_identifier(rule.id_range.min) & tables.exact_mask;
+                while (tables.exact[slot].rule != kNoRule) {
+                    slot = (slot + 1) & tables.exact_mask;
+                }
+                tables.exact[slot].identifier = rule.id_range.min;
+                tables.exact[slot].rule = rule_index;
+            } else {
+                RangeEntry entry{};
+                entry.range.min = std::max<std::uint32_t>(rule.id_range.min, kDirectEntries);
+                entry.range.max = rule.id_range.max;
+                entry.rule = rule_index;
+                tables.ranges.push_back(entry);
+            }
+        }
+
+        std::sort(tables.ranges.begin(), tables.ranges.end(), [](const RangeEntry &lhs, const RangeEntry &rhs) {
+            return lhs.range.min < rhs.range.min;
+        });
+    }
+    return true;
+}
+
+bool RateLimiter::allow(FlowDirection direction, std::uint32_t identifier, std::uint64_t now_ns) {
+    const std::size_t d = index(direction);
+    if (!active_[d]) {
+        return true;
+    }
+    const std::uint16_t rule = find_rule(tables_[d], identifier);
+    if (rule == kNoRule) {
+        return true;
+    }
+
+    RuleState &state = states_[static_cast<std::size_t>(rule) * kDirections + d];
+    RuleStats &stats = stats_[rule];
+
+    if (state.decimate > 1U) {
+        const std::uint32_t position = state.decimate_count;
+        state.decimate_count = position + 1U == state.decimate ? 0U : position + 1U;
+        if (position != 0U) {
+            ++stats.dropped_decimation;
+            return false;
+        }
+    }
+
+    if (state.interval_ns != 0U) {
+        if (now_ns + state.tolerance_ns < state.tat_ns) {
+            ++stats.dropped_rate;
+            return false;
+        }
+        state.tat_ns = std::max(state.tat_ns, now_ns) + state.interval_ns;
+    }
+
+    ++stats.passed;
+    return true;
+}
+
+bool RateLimiter::applies(RateLimitDirection rule, FlowDirection direction) {
+    switch (rule) {
+    case RateLimitDirection::Both:
+        return true;
+    case RateLimitDirection::CanToUdp:
+        return direction == FlowDirection::CanToUdp;
+    case RateLimitDirection::UdpToCan:
+        return direction == FlowDirection::UdpToCan;
+    }
+    return false;
+}
+
+std::uint16_t RateLimiter::find_rule(const DirectionTables &tables, std::uint32_t identifier) const {
+    if (identifier < kDirectEntries) {
+        return tables.direct[identifier];
+    }
+
+    std::size_t slot = hash_identifier(identifier) & tables.exact_mask;
+    while (tables.exact[slot].rule != kNoRule) {
+        if (tables.exact[slot].identifier == identifier) {
+            return tables.exact[slot].rule;
+        }
+        slot = (slot + 1) & tables.exact_mask;
+    }
+
+    if (tables.ranges.empty()) {
+        return kNoRule;
+    }
+    auto it = std::upper_bound(tables.ranges.begin(),
+                               tables.ranges.end(),
+                               identifier,
+                               [](std::uint32_t id, const RangeEntry &entry) { return id < entry.range.min; });
+    if (it == tables.ranges.begin()) {
+        return kNoRule;
+    }
+    --it;
+    return identifier <= it->range.max ? it->rule : kNoRule;
+}
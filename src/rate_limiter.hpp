@@ -0,0 +1,77 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class FlowDirection : std::uint8_t {
+    CanToUdp = 0,
+    UdpToCan = 1,
+};
+
+// rate_limits[] compiled into flat per-direction lookup tables. Identifiers
+// below 2048 (every SFF ID, plus the lowest EFF IDs) map through a direct
+// uint16 table, single extended IDs through an open-addressing hash, and only
+// extended ID ranges fall back to a bisected list. Each rule keeps its own
+// state per direction: a decimation counter followed by a GCRA token bucket
+// (interval = 1/rate, burst tolerance = (burst - 1) * interval), all integer
+// nanoseconds with no allocation after initialize().
+class RateLimiter {
+public:
+    struct RuleStats {
+        std::uint64_t passed{0};
+        std::uint64_t dropped_rate{0};
+        std::uint64_t dropped_decimation{0};
+    };
+
+    bool initialize(const std::vector<RateLimitRule> &rules);
+    bool active(FlowDirection direction) const { return active_[index(direction)]; }
+
+    // `identifier` is the masked CAN ID (see extract_identifier).
+    bool allow(FlowDirection direction, std::uint32_t identifier, std::uint64_t now_ns);
+
+    std::size_t rule_count() const { return stats_.size(); }
+    const RuleStats &rule_stats(std::size_t rule_index) const { return stats_[rule_index]; }
+
+private:
+    static constexpr std::uint16_t kNoRule = 0xFFFFU;
+    static constexpr std::size_t kDirectEntries = 2048;
+    static constexpr std::size_t kDirections = 2;
+
+    struct RuleState {
+        std::uint64_t interval_ns{0};
+        std::uint64_t tolerance_ns{0};
+        std::uint64_t tat_ns{0};
+        std::uint32_t decimate{1};
+        std::uint32_t decimate_count{0};
+    };
+
+    struct HashSlot {
+        std::uint32_t identifier{0};
+        std::uint16_t rule{kNoRule};
+    };
+
+    struct RangeEntry {
+        IdRange range{};
+        std::uint16_t rule{kNoRule};
+    };
+
+    struct DirectionTables {
+        std::vector<std::uint16_t> direct;
+        std::vector<HashSlot> exact;
+        std::size_t exact_mask{0};
+        std::vector<RangeEntry> ranges;
+    };
+
+    static constexpr std::size_t index(FlowDirection direction) { return static_cast<std::size_t>(direction); }
+    static bool applies(RateLimitDirection rule, FlowDirection direction);
+    std::uint16_t find_rule(const DirectionTables &tables, std::uint32_t identifier) const;
+
+    std::array<bool, kDirections> active_{};
+    std::array<DirectionTables, kDirections> tables_{};
+    std::vector<RuleState> states_; // rule_index * kDirections + direction
+    std::vector<RuleStats> stats_;
+};
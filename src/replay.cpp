@@ -0,0 +1,139 @@
+#include "replay.hpp"
+#include "candump_log.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+ReplaySource::ReplaySource(ReplaySource &&other) noexcept {
+    *this = std::move(other);
+}
+
+ReplaySource &ReplaySource::operator=(ReplaySource &&other) noexcept {
+    if (this != &other) {
+        close();
+        capture_ = std::move(other.capture_);
+        capture_names_ = std::move(other.capture_names_);
+        filter_direction_ = other.filter_direction_;
+        direction_ = other.direction_;
+        text_ = std::exchange(other.text_, nullptr);
+        text_length_ = std::exchange(other.text_length_, 0);
+        position_ = std::exchange(other.position_, 0);
+    }
+    return *this;
+}
+
+bool ReplaySource::open(const std::string &path, std::string &error_message) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error_message = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) < 0 || info.st_size == 0) {
+        error_message = path + " is empty or unreadable";
+        ::close(fd);
+        return false;
+    }
+
+    char magic[sizeof(kCaptureMagic)] = {};
+    const bool capture = pread(fd, magic, sizeof(magic), 0) == static_cast<ssize_t>(sizeof(magic)) &&
+                         std::memcmp(magic, kCaptureMagic, sizeof(magic)) == 0;
+    if (capture) {
+        ::close(fd);
+        if (!capture_.open(path, error_message)) {
+            return false;
+        }
+        if (capture_.size() == 0) {
+            error_message = path + " holds no records";
+            capture_.close();
+            return false;
+        }
+        for (std::size_t i = 0; i < capture_.channel_count(); ++i) {
+            capture_names_.push_back(capture_.channel_name(static_cast<std::uint16_t>(i)));
+        }
+        return true;
+    }
+
+    const std::size_t length = static_cast<std::size_t>(info.st_size);
+    void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        error_message = "cannot map " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    madvise(mapping, length, MADV_SEQUENTIAL);
+    text_ = static_cast<const char *>(mapping);
+    text_length_ = length;
+    return true;
+}
+
+void ReplaySource::close() {
+    capture_.close();
+    capture_names_.clear();
+    if (text_ != nullptr) {
+        munmap(const_cast<char *>(text_), text_length_);
+    }
+    text_ = nullptr;
+    text_length_ = 0;
+    position_ = 0;
+}
+
+void ReplaySource::set_direction_filter(bool enabled, CaptureDirection direction) {
+    filter_direction_ = enabled;
+    direction_ = direction;
+}
+
+bool ReplaySource::next(ReplayFrame &frame) {
+    if (text_ == nullptr) {
+        while (position_ < capture_.size()) {
+            const CaptureRecord &record = capture_.record(position_++);
+            if (filter_direction_ && record.direction != static_cast<std::uint8_t>(direction_)) {
+                continue;
+            }
+            frame.timestamp_ns = record.timestamp_ns;
+            frame.interface_name =
+                record.channel < capture_names_.size() ? std::string_view(capture_names_[record.channel]) : std::string_view();
+            std::memset(&frame.frame, 0, sizeof(frame.frame));
+            frame.frame.can_id = record.can_id;
+            frame.frame.can_dlc = record.dlc;
+            std::memcpy(frame.frame.data, record.data, sizeof(record.data));
+            return true;
+        }
+        return false;
+    }
+
+    while (position_ < text_length_) {
+        const char *begin = text_ + position_;
+        const void *newline = std::memchr(begin, '\n', text_length_ - position_);
+        const std::size_t length =
+            newline == nullptr ? text_length_ - position_ : static_cast<std::size_t>(static_cast<const char *>(newline) - begin);
+        position_ += length + 1;
+        CandumpEntry entry{};
+        if (parse_candump_line(std::string_view(begin, length), entry)) {
+            frame.timestamp_ns = entry.timestamp_ns;
+            frame.interface_name = entry.interface_name;
+            frame.frame = entry.frame;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ReplaySource::rewind() {
+    position_ = 0;
+}
+
+std::uint64_t ReplayTiming::due_ns(std::uint64_t timestamp_ns) const {
+    if (max_speed() || timestamp_ns <= first_timestamp_ns_) {
+        return start_ns_;
+    }
+    const double offset = static_cast<double>(timestamp_ns - first_timestamp_ns_) / speed_;
+    return start_ns_ + static_cast<std::uint64_t>(offset);
+}
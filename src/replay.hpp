@@ -0,0 +1,71 @@
+#pragma once
+
+#include "capture.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <linux/can.h>
+
+struct ReplayFrame {
+    std::uint64_t timestamp_ns;
+    std::string_view interface_name; // valid while the source stays open
+    struct can_frame frame;
+};
+
+// Frames from a candump -L log or a bridge capture file, both read through a
+// read-only mapping. The format is detected from the capture magic. Capture
+// records can be limited to one direction; log lines that are not classic
+// CAN frames are skipped.
+class ReplaySource {
+public:
+    ReplaySource() = default;
+    ~ReplaySource() { close(); }
+
+    ReplaySource(const ReplaySource &) = delete;
+    ReplaySource &operator=(const ReplaySource &) = delete;
+    ReplaySource(ReplaySource &&other) noexcept;
+    ReplaySource &operator=(ReplaySource &&other) noexcept;
+
+    bool open(const std::string &path, std::string &error_message);
+    void close();
+    bool is_open() const { return capture_.size() != 0 || text_ != nullptr; }
+    bool is_capture() const { return capture_.size() != 0; }
+
+    void set_direction_filter(bool enabled, CaptureDirection direction);
+    // Returns false at the end of the file.
+    bool next(ReplayFrame &frame);
+    void rewind();
+
+private:
+    CaptureReader capture_;
+    std::vector<std::string> capture_names_;
+    bool filter_direction_{false};
+    CaptureDirection direction_{CaptureDirection::UdpToCan};
+    const char *text_{nullptr};
+    std::size_t text_length_{0};
+    std::size_t position_{0};
+};
+
+// Maps recorded timestamps onto the monotonic clock: the first frame is due
+// at start(), later ones after their recorded offset divided by `speed`.
+// Speed 0 replays as fast as possible (every frame is due immediately).
+class ReplayTiming {
+public:
+    explicit ReplayTiming(double speed = 1.0) : speed_(speed) {}
+
+    void start(std::uint64_t first_timestamp_ns, std::uint64_t now_ns) {
+        first_timestamp_ns_ = first_timestamp_ns;
+        start_ns_ = now_ns;
+    }
+    bool max_speed() const { return speed_ <= 0.0; }
+    std::uint64_t due_ns(std::uint64_t timestamp_ns) const;
+
+private:
+    double speed_;
+    std::uint64_t first_timestamp_ns_{0};
+    std::uint64_t start_ns_{0};
+};
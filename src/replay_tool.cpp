@@ -0,0 +1,251 @@
+#include "clock.hpp"
+#include "protocol.hpp"
+#include "replay.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+struct Options {
+    const char *input{nullptr};
+    double speed{1.0};
+    bool loop{false};
+    bool to_can{false};
+    sockaddr_in udp_target{};
+    bool have_udp_target{false};
+    bool filter_direction{false};
+    CaptureDirection direction{CaptureDirection::UdpToCan};
+    // --map from=to renames log interfaces for --can.
+    std::map<std::string, std::string, std::less<>> interface_map;
+};
+
+void usage(const char *argv0) {
+    std::fprintf(stderr,
+                 "Usage: %s [--speed N | --max-speed] [--loop] [--direction udp-to-can|can-to-udp]\n"
+                 "          (--udp HOST:PORT | --can [--map FROM=TO]...) <candump.log|capture>\n"
+                 "  --udp  send each frame as a 13-byte datagram to the bridge's listen port\n"
+                 "  --can  write each frame to the CAN interface named in the file\n",
+                 argv0);
+}
+
+bool parse_udp_target(const char *text, sockaddr_in &address) {
+    const char *colon = std::strrchr(text, ':');
+    if (colon == nullptr) {
+        return false;
+    }
+    const std::string host(text, static_cast<std::size_t>(colon - text));
+    char *end = nullptr;
+    const unsigned long port = std::strtoul(colon + 1, &end, 10);
+    if (*end != '\0' || port == 0 || port > 65535) {
+        return false;
+    }
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<std::uint16_t>(port));
+    return inet_pton(AF_INET, host.c_str(), &address.sin_addr) == 1;
+}
+
+bool parse_options(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(arg, "--speed") == 0 && has_value) {
+            char *end = nullptr;
+            options.speed = std::strtod(argv[++i], &end);
+            if (*end != '\0' || options.speed <= 0.0) {
+                return false;
+            }
+        } else if (std::strcmp(arg, "--max-speed") == 0) {
+            options.speed = 0.0;
+        } else if (std::strcmp(arg, "--loop") == 0) {
+            options.loop = true;
+        } else if (std::strcmp(arg, "--udp") == 0 && has_value) {
+            if (!parse_udp_target(argv[++i], options.udp_target)) {
+                return false;
+            }
+            options.have_udp_target = true;
+        } else if (std::strcmp(arg, "--can") == 0) {
+            options.to_can = true;
+        } else if (std::strcmp(arg, "--map") == 0 && has_value) {
+            const std::string mapping(argv[++i]);
+            const std::size_t equals = mapping.find('=');
+            if (equals == std::string::npos || equals == 0 || equals + 1 == mapping.size()) {
+                return false;
+            }
+            options.interface_map[mapping.substr(0, equals)] = mapping.substr(equals + 1);
+        } else if (std::strcmp(arg, "--direction") == 0 && has_value) {
+            const char *value = argv[++i];
+            options.filter_direction = true;
+            if (std::strcmp(value, "udp-to-can") == 0) {
+                options.direction = CaptureDirection::UdpToCan;
+            } else if (std::strcmp(value, "can-to-udp") == 0) {
+                options.direction = CaptureDirection::CanToUdp;
+            } else {
+                return false;
+            }
+        } else if (arg[0] == '-' || options.input != nullptr) {
+            return false;
+        } else {
+            options.input = arg;
+        }
+    }
+    return options.input != nullptr && (options.to_can != options.have_udp_target);
+}
+
+// One CAN_RAW socket per interface, opened on first use.
+class CanSockets {
+public:
+    ~CanSockets() {
+        for (const auto &entry : sockets_) {
+            if (entry.second >= 0) {
+                close(entry.second);
+            }
+        }
+    }
+
+    int get(const std::string &name) {
+        const auto it = sockets_.find(name);
+        if (it != sockets_.end()) {
+            return it->second;
+        }
+        const int fd = open_socket(name);
+        if (fd < 0) {
+            std::fprintf(stderr, "cannot open CAN interface %s: %s\n", name.c_str(), std::strerror(errno));
+        }
+        sockets_[name] = fd;
+        return fd;
+    }
+
+private:
+    static int open_socket(const std::string &name) {
+        const unsigned int ifindex = if_nametoindex(name.c_str());
+        if (ifindex == 0) {
+            return -1;
+        }
+        const int fd = socket(PF_CAN, SOCK_RAW | SOCK_CLOEXEC, CAN_RAW);
+        if (fd < 0) {
+            return -1;
+        }
+        // Write-only: do not queue the bus traffic we are not going to read.
+        setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, nullptr, 0);
+        sockaddr_can address{};
+        address.can_family = AF_CAN;
+        address.can_ifindex = static_cast<int>(ifindex);
+        if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    std::map<std::string, int> sockets_;
+};
+
+void sleep_until(std::uint64_t deadline_ns) {
+    constexpr std::uint64_t kNanosPerSecond = 1000000000ULL;
+    timespec deadline{};
+    deadline.tv_sec = static_cast<time_t>(deadline_ns / kNanosPerSecond);
+    deadline.tv_nsec = static_cast<long>(deadline_ns % kNanosPerSecond);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    ReplaySource source;
+    std::string error;
+    if (!source.open(options.input, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    source.set_direction_filter(options.filter_direction, options.direction);
+
+    int udp_fd = -1;
+    if (options.have_udp_target) {
+        udp_fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (udp_fd < 0) {
+            std::perror("socket");
+            return 1;
+        }
+    }
+    CanSockets can_sockets;
+
+    ReplayTiming timing(options.speed);
+    ReplayFrame replayed{};
+    std::uint64_t sent = 0;
+    std::uint64_t failed = 0;
+    const std::uint64_t started_ns = monotonic_ns();
+    bool first = true;
+    while (true) {
+        if (!source.next(replayed)) {
+            if (!options.loop || first) {
+                break;
+            }
+            source.rewind();
+            first = true;
+            continue;
+        }
+        if (first) {
+            timing.start(replayed.timestamp_ns, monotonic_ns());
+            first = false;
+        }
+        if (!timing.max_speed()) {
+            sleep_until(timing.due_ns(replayed.timestamp_ns));
+        }
+
+        bool ok = false;
+        if (udp_fd >= 0) {
+            std::uint8_t datagram[kUdpFrameSize];
+            encode_udp_frame(replayed.frame, datagram);
+            ok = sendto(udp_fd,
+                        datagram,
+                        sizeof(datagram),
+                        0,
+                        reinterpret_cast<const sockaddr *>(&options.udp_target),
+                        sizeof(options.udp_target)) == static_cast<ssize_t>(sizeof(datagram));
+        } else {
+            const auto mapped = options.interface_map.find(replayed.interface_name);
+            const int fd = can_sockets.get(mapped != options.interface_map.end() ? mapped->second
+                                                                                 : std::string(replayed.interface_name));
+            ok = fd >= 0 && write(fd, &replayed.frame, sizeof(replayed.frame)) == static_cast<ssize_t>(sizeof(replayed.frame));
+        }
+        if (ok) {
+            ++sent;
+        } else {
+            ++failed;
+        }
+    }
+
+    const double elapsed_s = static_cast<double>(monotonic_ns() - started_ns) / 1e9;
+    std::fprintf(stderr,
+                 "replayed %llu frames (%llu failed) in %.3f s, %.0f frames/s\n",
+                 static_cast<unsigned long long>(sent),
+                 static_cast<unsigned long long>(failed),
+                 elapsed_s,
+                 elapsed_s > 0.0 ? static_cast<double>(sent) / elapsed_s : 0.0);
+    if (udp_fd >= 0) {
+        close(udp_fd);
+    }
+    return failed == 0 ? 0 : 2;
+}
@@ -0,0 +1,46 @@
+#include "routing.hpp"
+
+#include <algorithm>
+
+void sort_range_lookup(RangeLookup *table, std::size_t count) {
+    if (table == nullptr || count < 2) {
+        return;
+    }
+    std::sort(table, table + count, [](const RangeLookup &lhs, const RangeLookup &rhs) {
+        return lhs.range.min < rhs.range.min;
+    });
+}
+
+std::size_t find_channel_for_can_id(const RangeLookup *table, std::size_t count, std::uint32_t can_id) {
+    if (table == nullptr || count == 0) {
+        return kInvalidChannelIndex;
+    }
+
+    std::size_t low = 0;
+    std::size_t high = count;
+    while (low < high) {
+        const std::size_t mid = (low + high) / 2;
+        if (table[mid].range.min <= can_id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low == 0) {
+        return kInvalidChannelIndex;
+    }
+
+    const RangeLookup &candidate = table[low - 1];
+    if (candidate.range.min <= can_id && can_id <= candidate.range.max) {
+        return candidate.channel_index;
+    }
+    return kInvalidChannelIndex;
+}
+
+std::uint32_t extract_identifier(const struct can_frame &frame) {
+    if ((frame.can_id & CAN_EFF_FLAG) != 0U) {
+        return frame.can_id & CAN_EFF_MASK;
+    }
+    return frame.can_id & CAN_SFF_MASK;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/can.h>
+
+constexpr std::size_t kInvalidChannelIndex = static_cast<std::size_t>(-1);
+
+// 12 bytes per entry: a 32-channel table spans six cache lines.
+struct RangeLookup {
+    IdRange range{};
+    std::uint32_t channel_index{0};
+};
+
+// Sorts the table by range.min so find_channel_for_can_id can bisect it.
+void sort_range_lookup(RangeLookup *table, std::size_t count);
+std::size_t find_channel_for_can_id(const RangeLookup *table, std::size_t count, std::uint32_t can_id);
+std::uint32_t extract_identifier(const struct can_frame &frame);
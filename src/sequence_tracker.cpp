@@ -0,0 +1,35 @@
+#include "sequence_tracker.hpp"
+
+SequenceTracker::Verdict SequenceTracker::observe(std::uint32_t sequence, std::uint32_t &gap) {
+    gap = 0;
+    if (!started_) {
+        started_ = true;
+        next_ = sequence + 1U;
+        window_ = 1U;
+        return Verdict::First;
+    }
+
+    // Modular distance; the int32 cast splits "ahead" from "behind".
+    const std::int32_t ahead = static_cast<std::int32_t>(sequence - next_);
+    if (ahead >= 0) {
+        const std::uint32_t shift = static_cast<std::uint32_t>(ahead) + 1U;
+        window_ = (shift >= kWindow ? 0U : window_ << shift) | 1U;
+        next_ = sequence + 1U;
+        gap = static_cast<std::uint32_t>(ahead);
+        return ahead == 0 ? Verdict::InOrder : Verdict::Gap;
+    }
+
+    const std::uint32_t behind = next_ - 1U - sequence;
+    if (behind >= kWindow || sequence == 0U) {
+        next_ = sequence + 1U;
+        window_ = 1U;
+        return Verdict::Restart;
+    }
+    const std::uint64_t bit = std::uint64_t{1} << behind;
+    if ((window_ & bit) != 0U) {
+        return Verdict::Duplicate;
+    }
+    window_ |= bit;
+    // Counted as missing when the gap opened.
+    return Verdict::Late;
+}
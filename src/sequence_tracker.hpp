@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+// Receive-side accounting for sequence-numbered datagrams. Tracks the highest
+// sequence seen plus a 64-entry bitmap of the ones just below it, so a late
+// datagram can be told apart from a duplicate. Sequence numbers wrap at 2^32.
+class SequenceTracker {
+public:
+    enum class Verdict : std::uint8_t {
+        First,     // first datagram seen, nothing to compare against
+        InOrder,   // exactly the next sequence
+        Gap,       // ahead of the next sequence; `gap` datagrams missing
+        Late,      // behind, filling an earlier gap
+        Duplicate, // already seen inside the window
+        Restart,   // behind the window, or back at 0: the sender restarted
+    };
+
+    // Backwards jumps past the window cannot be checked for duplication and
+    // are taken as a sender restart rather than a very late datagram, as is
+    // any step back to 0 (where a sender's counter starts), so that a peer
+    // restarting after only a few datagrams is not read as duplicates.
+    static constexpr std::uint32_t kWindow = 64;
+
+    Verdict observe(std::uint32_t sequence, std::uint32_t &gap);
+    void reset() { started_ = false; }
+
+private:
+    bool started_{false};
+    std::uint32_t next_{0};
+    // Bit i set: sequence next_ - 1 - i has been seen.
+    std::uint64_t window_{0};
+};
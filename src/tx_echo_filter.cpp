@@ -0,0 +1,29 @@
+#include "tx_echo_filter.hpp"
+
+#include <cstring>
+
+void TxEchoFilter::record(const struct can_frame &frame, std::uint64_t now_ns) {
+    if (count_ == kDepth) {
+        head_ = (head_ + 1) % kDepth;
+        --count_;
+    }
+    entries_[(head_ + count_) % kDepth] = Entry{frame, now_ns};
+    ++count_;
+}
+
+bool TxEchoFilter::consume(const struct can_frame &frame, std::uint64_t now_ns) {
+    while (count_ != 0 && now_ns - entries_[head_].written_ns > kLifetimeNs) {
+        head_ = (head_ + 1) % kDepth;
+        --count_;
+    }
+    for (std::size_t i = 0; i < count_; ++i) {
+        const std::size_t slot = (head_ + i) % kDepth;
+        // The copy carries the bytes that were written, padding included.
+        if (std::memcmp(&entries_[slot].frame, &frame, sizeof(frame)) == 0) {
+            head_ = (slot + 1) % kDepth;
+            count_ -= i + 1;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/can.h>
+
+// Recognises the loopback copies of frames the bridge wrote to one CAN
+// interface, for receive paths that cannot tell them from bus traffic (the
+// AF_PACKET ring sees every socket's copy, including those of our own
+// writes). Copies come back in write order, so the oldest outstanding write
+// is checked first; writes whose copy never shows up (loopback off, TX
+// error) expire after kLifetimeNs or are pushed out by newer ones.
+class TxEchoFilter {
+public:
+    static constexpr std::size_t kDepth = 64;
+    static constexpr std::uint64_t kLifetimeNs = 1000000000ULL;
+
+    void record(const struct can_frame &frame, std::uint64_t now_ns);
+    // True, and forgets the write, when `frame` is the copy of an
+    // outstanding write. Older writes still waiting are given up as lost.
+    bool consume(const struct can_frame &frame, std::uint64_t now_ns);
+    std::size_t pending() const { return count_; }
+
+private:
+    struct Entry {
+        struct can_frame frame;
+        std::uint64_t written_ns;
+    };
+
+    std::array<Entry, kDepth> entries_{};
+    std::size_t head_{0};
+    std::size_t count_{0};
+};
@@ -0,0 +1,58 @@
+#include "tx_pacer.hpp"
+
+#include <algorithm>
+
+namespace {
+
+// Stuffable part before the data field: SOF + ID + RTR + IDE + r0 + DLC for
+// standard frames; SOF + base ID + SRR + IDE + ext ID + RTR + r1 + r0 + DLC
+// for extended frames. The 15-bit CRC is stuffed as well.
+constexpr std::uint32_t kSffHeaderBits = 1 + 11 + 1 + 1 + 1 + 4;
+constexpr std::uint32_t kEffHeaderBits = 1 + 11 + 1 + 1 + 18 + 1 + 2 + 4;
+constexpr std::uint32_t kCrcBits = 15;
+// CRC delimiter + ACK slot + ACK delimiter + EOF + intermission.
+constexpr std::uint32_t kTrailerBits = 1 + 1 + 1 + 7 + 3;
+
+constexpr std::uint64_t kPicosPerSecond = 1000000000000ULL;
+
+} // namespace
+
+std::uint32_t can_frame_wire_bits(const struct can_frame &frame) {
+    const bool extended = (frame.can_id & CAN_EFF_FLAG) != 0U;
+    const bool remote = (frame.can_id & CAN_RTR_FLAG) != 0U;
+    const std::uint32_t data_bytes = remote ? 0U : std::min<std::uint32_t>(frame.can_dlc, CAN_MAX_DLEN);
+    const std::uint32_t stuffable = (extended ? kEffHeaderBits : kSffHeaderBits) + data_bytes * 8U + kCrcBits;
+    return stuffable + (stuffable - 1U) / 4U + kTrailerBits;
+}
+
+bool TxPacer::initialize(std::uint32_t bitrate, std::uint32_t bus_load_percent, std::uint32_t burst_frames) {
+    ps_per_bit_ = 0;
+    lead_ns_ = 0;
+    busy_until_ns_ = 0;
+    if (bitrate == 0 || bus_load_percent == 0 || bus_load_percent > 100 || burst_frames == 0) {
+        return false;
+    }
+    ps_per_bit_ = kPicosPerSecond * 100U / (static_cast<std::uint64_t>(bitrate) * bus_load_percent);
+
+    struct can_frame longest{};
+    longest.can_id = CAN_EFF_FLAG;
+    longest.can_dlc = CAN_MAX_DLEN;
+    lead_ns_ = static_cast<std::uint64_t>(burst_frames - 1U) * frame_time_ns(longest);
+    return true;
+}
+
+std::uint64_t TxPacer::frame_time_ns(const struct can_frame &frame) const {
+    return static_cast<std::uint64_t>(can_frame_wire_bits(frame)) * ps_per_bit_ / 1000U;
+}
+
+void TxPacer::commit(const struct can_frame &frame, std::uint64_t now_ns) {
+    busy_until_ns_ = std::max(busy_until_ns_, now_ns) + frame_time_ns(frame);
+}
+
+void TxPacer::back_off(const struct can_frame &frame, std::uint64_t now_ns) {
+    busy_until_ns_ = std::max(busy_until_ns_, now_ns + lead_ns_ + frame_time_ns(frame));
+}
+
+std::uint64_t TxPacer::next_release_ns() const {
+    return busy_until_ns_ > lead_ns_ ? busy_until_ns_ - lead_ns_ : 0;
+}
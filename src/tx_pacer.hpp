@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include <linux/can.h>
+
+// Worst-case on-wire length of a classic CAN frame in bit times: SOF through
+// CRC with one stuff bit per four bits after the first, then the unstuffed
+// CRC delimiter, ACK slot/delimiter, EOF and the 3-bit intermission. RTR
+// frames carry no data field whatever their DLC. 8-byte frames come to 135
+// (standard) and 160 (extended) bits.
+std::uint32_t can_frame_wire_bits(const struct can_frame &frame);
+
+// Virtual bus clock for one channel. Every frame handed to the socket pushes
+// busy_until forward by its on-wire time; the caller may write while the bus
+// is booked less than `burst_frames` worst-case frames ahead of now.
+class TxPacer {
+public:
+    bool initialize(std::uint32_t bitrate, std::uint32_t bus_load_percent, std::uint32_t burst_frames);
+    bool enabled() const { return ps_per_bit_ != 0; }
+
+    std::uint64_t frame_time_ns(const struct can_frame &frame) const;
+    bool ready(std::uint64_t now_ns) const { return busy_until_ns_ <= now_ns + lead_ns_; }
+    // Books the bus for a frame the socket accepted.
+    void commit(const struct can_frame &frame, std::uint64_t now_ns);
+    // The socket pushed back although the model said the bus was free (other
+    // nodes, error frames, lost arbitration): wait at least one frame time.
+    void back_off(const struct can_frame &frame, std::uint64_t now_ns);
+    // Earliest time ready() turns true again.
+    std::uint64_t next_release_ns() const;
+
+private:
+    std::uint64_t ps_per_bit_{0};
+    std::uint64_t lead_ns_{0};
+    std::uint64_t busy_until_ns_{0};
+};
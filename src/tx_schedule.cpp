@@ -0,0 +1,36 @@
+#include "tx_schedule.hpp"
+
+#include <algorithm>
+
+bool TxSchedule::initialize(std::size_t capacity) {
+    heap_.clear();
+    capacity_ = 0;
+    next_sequence_ = 0;
+    if (capacity == 0) {
+        return false;
+    }
+    heap_.reserve(capacity);
+    capacity_ = capacity;
+    return true;
+}
+
+bool TxSchedule::push(std::uint64_t due_ns, const struct can_frame &frame) {
+    if (heap_.size() >= capacity_) {
+        return false;
+    }
+    heap_.push_back(Entry{due_ns, next_sequence_++, frame});
+    std::push_heap(heap_.begin(), heap_.end(), later);
+    return true;
+}
+
+void TxSchedule::pop() {
+    std::pop_heap(heap_.begin(), heap_.end(), later);
+    heap_.pop_back();
+}
+
+bool TxSchedule::later(const Entry &lhs, const Entry &rhs) {
+    if (lhs.due_ns != rhs.due_ns) {
+        return lhs.due_ns > rhs.due_ns;
+    }
+    return lhs.sequence > rhs.sequence;
+}
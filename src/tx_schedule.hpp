@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <linux/can.h>
+
+// Frames held back until a requested transmit time. A binary min-heap on
+// (due time, arrival order), so frames due at the same instant keep the
+// order they arrived in. Storage is reserved by initialize(); push/pop
+// never allocate.
+class TxSchedule {
+public:
+    bool initialize(std::size_t capacity);
+    bool enabled() const { return capacity_ != 0; }
+
+    bool empty() const { return heap_.empty(); }
+    std::size_t size() const { return heap_.size(); }
+
+    // Returns false when the schedule is full.
+    bool push(std::uint64_t due_ns, const struct can_frame &frame);
+    // Earliest due time and its frame; schedule must be non-empty.
+    std::uint64_t next_due_ns() const { return heap_.front().due_ns; }
+    const struct can_frame &front() const { return heap_.front().frame; }
+    void pop();
+
+private:
+    struct Entry {
+        std::uint64_t due_ns;
+        std::uint64_t sequence;
+        struct can_frame frame;
+    };
+
+    static bool later(const Entry &lhs, const Entry &rhs);
+
+    std::size_t capacity_{0};
+    std::uint64_t next_sequence_{0};
+    std::vector<Entry> heap_;
+};
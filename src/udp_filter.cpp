@@ -0,0 +1,86 @@
+#include "udp_filter.hpp"
+#include "protocol.hpp"
+
+#include <arpa/inet.h>
+
+namespace {
+
+constexpr std::uint32_t kUdpHeaderSize = 8;
+// Offset of the IPv4 source address, relative to the network header.
+constexpr std::uint32_t kIpv4SourceOffset = 12;
+constexpr std::uint8_t kMaxDlc = 8;
+
+// Jump targets are filled in afterwards.
+sock_filter instruction(std::uint16_t code, std::uint32_t k) {
+    return sock_filter{code, 0, 0, k};
+}
+
+} // namespace
+
+std::vector<sock_filter> build_udp_filter(const UdpFilterSpec &spec) {
+    const std::uint32_t payload_offset = kUdpHeaderSize + spec.header_size;
+    // Conditional jumps whose true or false branch leaves the program,
+    // patched once the two return statements are placed.
+    std::vector<std::size_t> true_to_drop;
+    std::vector<std::size_t> false_to_drop;
+    std::vector<std::size_t> false_to_accept;
+    std::vector<std::size_t> true_to_accept;
+    std::vector<sock_filter> program;
+    const auto emit = [&program](sock_filter insn) {
+        program.push_back(insn);
+        return program.size() - 1;
+    };
+
+    emit(instruction(BPF_LD | BPF_W | BPF_ABS, static_cast<std::uint32_t>(SKF_NET_OFF) + kIpv4SourceOffset));
+    false_to_drop.push_back(emit(instruction(BPF_JMP | BPF_JEQ | BPF_K, ntohl(spec.source.s_addr))));
+
+    emit(instruction(BPF_LD | BPF_W | BPF_LEN, 0));
+    false_to_drop.push_back(emit(instruction(BPF_JMP | BPF_JGE | BPF_K, payload_offset + spec.frame_size)));
+    if (spec.header_size == 0) {
+        emit(instruction(BPF_ALU | BPF_SUB | BPF_K, payload_offset));
+        emit(instruction(BPF_ALU | BPF_MOD | BPF_K, spec.frame_size));
+        false_to_drop.push_back(emit(instruction(BPF_JMP | BPF_JEQ | BPF_K, 0)));
+    }
+
+    if (spec.check_info) {
+        const std::size_t checks = spec.header_size == 0 ? kUdpFilterInfoChecks : 1;
+        for (std::size_t i = 0; i < checks; ++i) {
+            const std::uint32_t offset = payload_offset + static_cast<std::uint32_t>(i) * spec.frame_size;
+            if (i != 0) {
+                // No frame i: nothing left to check.
+                emit(instruction(BPF_LD | BPF_W | BPF_LEN, 0));
+                false_to_accept.push_back(emit(instruction(BPF_JMP | BPF_JGE | BPF_K, offset + spec.frame_size)));
+            }
+            emit(instruction(BPF_LD | BPF_B | BPF_ABS, offset));
+            // A control record's first slot skips the DLC check. In the
+            // first slot it may start an ISO-TP PDU, whose payload fills
+            // the rest of the datagram.
+            const std::size_t control = emit(instruction(BPF_JMP | BPF_JEQ | BPF_K, kControlInfo));
+            if (i == 0) {
+                true_to_accept.push_back(control);
+            } else {
+                program[control].jt = 2;
+            }
+            emit(instruction(BPF_ALU | BPF_AND | BPF_K, 0x0FU));
+            true_to_drop.push_back(emit(instruction(BPF_JMP | BPF_JGT | BPF_K, kMaxDlc)));
+        }
+    }
+
+    const std::size_t accept = emit(instruction(BPF_RET | BPF_K, 0xFFFFFFFFU));
+    const std::size_t drop = emit(instruction(BPF_RET | BPF_K, 0));
+    // Branch offsets are relative to the instruction after the jump; the
+    // program stays far below the 255-instruction reach of a jump.
+    for (const std::size_t at : true_to_drop) {
+        program[at].jt = static_cast<std::uint8_t>(drop - at - 1);
+    }
+    for (const std::size_t at : false_to_drop) {
+        program[at].jf = static_cast<std::uint8_t>(drop - at - 1);
+    }
+    for (const std::size_t at : false_to_accept) {
+        program[at].jf = static_cast<std::uint8_t>(accept - at - 1);
+    }
+    for (const std::size_t at : true_to_accept) {
+        program[at].jt = static_cast<std::uint8_t>(accept - at - 1);
+    }
+    return program;
+}
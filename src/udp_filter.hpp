@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <linux/filter.h>
+#include <netinet/in.h>
+
+// What a listen port accepts, checked in the kernel before the datagram is
+// queued: only `source` may send, the payload after the optional sequence
+// header must be whole frames of `frame_size` bytes, and with `check_info`
+// the leading frames' info bytes must carry a DLC of at most 8 or start a
+// control record; a datagram that opens with one is left to the bridge.
+struct UdpFilterSpec {
+    in_addr source;
+    std::uint32_t frame_size;
+    std::uint32_t header_size;
+    bool check_info;
+};
+
+// Info bytes checked per datagram at most; classic BPF cannot loop, so the
+// checks are unrolled and later frames are left to the bridge.
+constexpr std::size_t kUdpFilterInfoChecks = 8;
+
+// Classic BPF program for SO_ATTACH_FILTER on a UDP socket. Offsets are
+// relative to the UDP header, where the kernel runs socket filters for UDP.
+// A datagram that UDP GRO coalesced is checked as a whole: whole frames add
+// up to whole frames, but the frame positions of sequence-header ports
+// shift after the first datagram, so those only get their length and first
+// info byte checked against the smallest valid datagram.
+std::vector<sock_filter> build_udp_filter(const UdpFilterSpec &spec);
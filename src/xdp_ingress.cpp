@@ -0,0 +1,485 @@
+#include "xdp_ingress.hpp"
+#include "protocol.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+namespace {
+
+// One UMEM frame per ring slot: frames only ever cycle fill -> RX -> fill,
+// so the fill ring can always take back what the RX ring handed out.
+constexpr std::uint32_t kRingSize = 2048;
+constexpr std::uint32_t kFrameSize = 2048;
+constexpr std::size_t kUmemBytes = static_cast<std::size_t>(kRingSize) * kFrameSize;
+
+constexpr std::size_t kEthHeaderSize = 14;
+constexpr std::size_t kIpv4HeaderSize = 20;
+constexpr std::size_t kUdpHeaderSize = 8;
+constexpr std::int32_t kMaxDlc = 8;
+
+std::string errno_text(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+int bpf(int command, bpf_attr &attr) {
+    return static_cast<int>(syscall(__NR_bpf, command, &attr, sizeof(attr)));
+}
+
+bpf_insn instruction(std::uint8_t code, std::uint8_t dst, std::uint8_t src, std::int16_t offset, std::int32_t imm) {
+    bpf_insn insn{};
+    insn.code = code;
+    insn.dst_reg = dst & 0x0FU;
+    insn.src_reg = src & 0x0FU;
+    insn.off = offset;
+    insn.imm = imm;
+    return insn;
+}
+
+// Branch offsets are relative to the instruction after the jump.
+std::int16_t jump_to(std::size_t target, std::size_t from) {
+    return static_cast<std::int16_t>(static_cast<std::ptrdiff_t>(target) - static_cast<std::ptrdiff_t>(from) - 1);
+}
+
+bool map_ring(int fd,
+              std::size_t descriptor_size,
+              const xdp_ring_offset &offsets,
+              off_t page_offset,
+              void *&mapping,
+              std::size_t &length,
+              std::uint32_t *&producer,
+              std::uint32_t *&consumer,
+              std::uint32_t *&flags,
+              void *&descriptors) {
+    length = offsets.desc + kRingSize * descriptor_size;
+    mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, page_offset);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        return false;
+    }
+    auto *base = static_cast<std::uint8_t *>(mapping);
+    producer = reinterpret_cast<std::uint32_t *>(base + offsets.producer);
+    consumer = reinterpret_cast<std::uint32_t *>(base + offsets.consumer);
+    flags = reinterpret_cast<std::uint32_t *>(base + offsets.flags);
+    descriptors = base + offsets.desc;
+    return true;
+}
+
+// The program already matched the headers; this only bounds the payload by
+// the lengths the packet itself claims.
+void parse_packet(const std::uint8_t *frame, std::size_t length, XdpPacket &packet) {
+    packet = XdpPacket{0, nullptr, 0};
+    constexpr std::size_t kUdpOffset = kEthHeaderSize + kIpv4HeaderSize;
+    if (length < kUdpOffset + kUdpHeaderSize) {
+        return;
+    }
+    const std::size_t ip_length = (static_cast<std::size_t>(frame[kEthHeaderSize + 2]) << 8U) | frame[kEthHeaderSize + 3];
+    const std::size_t udp_length = (static_cast<std::size_t>(frame[kUdpOffset + 4]) << 8U) | frame[kUdpOffset + 5];
+    if (udp_length < kUdpHeaderSize || kIpv4HeaderSize + udp_length > ip_length ||
+        kEthHeaderSize + ip_length > length) {
+        return;
+    }
+    packet.dst_port = static_cast<std::uint16_t>((frame[kUdpOffset + 2] << 8U) | frame[kUdpOffset + 3]);
+    packet.payload = frame + kUdpOffset + kUdpHeaderSize;
+    packet.length = udp_length - kUdpHeaderSize;
+}
+
+} // namespace
+
+// XDP program, roughly:
+//   if (packet is IPv4 without options, UDP, not a fragment,
+//       and its destination port is one of `ports`) {
+//       if (the port is filtered and the datagram fails its checks)
+//           return XDP_DROP;
+//       return bpf_redirect_map(&xsks, ctx->rx_queue_index, XDP_PASS);
+//   }
+//   return XDP_PASS;
+// The XDP_PASS flag makes queues without a socket fall back to the stack.
+// Header fields are compared in network byte order as loaded; the UDP
+// length is converted to host order for the arithmetic. The checks are
+// build_udp_filter()'s, on a datagram GRO has not touched.
+std::vector<bpf_insn> build_xdp_program(int xsk_map_fd, const std::vector<XdpPort> &ports) {
+    constexpr std::uint8_t r0 = BPF_REG_0, r1 = BPF_REG_1, r2 = BPF_REG_2, r3 = BPF_REG_3, r4 = BPF_REG_4,
+                           r5 = BPF_REG_5;
+    constexpr std::int32_t kHeadersSize = kEthHeaderSize + kIpv4HeaderSize + kUdpHeaderSize;
+    // Conditional jumps to `pass`, `redirect` and `drop`, patched once their
+    // positions are known.
+    std::vector<std::size_t> to_pass;
+    std::vector<std::size_t> to_redirect;
+    std::vector<std::size_t> to_drop;
+    std::vector<bpf_insn> program;
+    const auto emit = [&program](bpf_insn insn) {
+        program.push_back(insn);
+        return program.size() - 1;
+    };
+
+    emit(instruction(BPF_LDX | BPF_MEM | BPF_W, r2, r1, offsetof(xdp_md, data), 0));
+    emit(instruction(BPF_LDX | BPF_MEM | BPF_W, r3, r1, offsetof(xdp_md, data_end), 0));
+    emit(instruction(BPF_ALU64 | BPF_MOV | BPF_X, r4, r2, 0, 0));
+    emit(instruction(BPF_ALU64 | BPF_ADD | BPF_K, r4, 0, 0, kHeadersSize));
+    to_pass.push_back(emit(instruction(BPF_JMP | BPF_JGT | BPF_X, r4, r3, 0, 0)));
+    emit(instruction(BPF_LDX | BPF_MEM | BPF_H, r4, r2, 12, 0));
+    to_pass.push_back(emit(instruction(BPF_JMP | BPF_JNE | BPF_K, r4, 0, 0, htons(ETH_P_IP))));
+    emit(instruction(BPF_LDX | BPF_MEM | BPF_B, r4, r2, kEthHeaderSize, 0));
+    to_pass.push_back(emit(instruction(BPF_JMP | BPF_JNE | BPF_K, r4, 0, 0, 0x45)));
+    emit(instruction(BPF_LDX | BPF_MEM | BPF_B, r4, r2, kEthHeaderSize + 9, 0));
+    to_pass.push_back(emit(instruction(BPF_JMP | BPF_JNE | BPF_K, r4, 0, 0, IPPROTO_UDP)));
+    emit(instruction(BPF_LDX | BPF_MEM | BPF_H, r4, r2, kEthHeaderSize + 6, 0));
+    emit(instruction(BPF_ALU64 | BPF_AND | BPF_K, r4, 0, 0, htons(0x3FFF))); // MF flag and fragment offset
+    to_pass.push_back(emit(instruction(BPF_JMP | BPF_JNE | BPF_K, r4, 0, 0, 0)));
+    emit(instruction(BPF_LDX | BPF_MEM | BPF_H, r4, r2, kEthHeaderSize + kIpv4HeaderSize + 2, 0));
+    for (const XdpPort &port : ports) {
+        if (!port.filtered) {
+            to_redirect.push_back(emit(instruction(BPF_JMP | BPF_JEQ | BPF_K, r4, 0, 0, htons(port.port))));
+            continue;
+        }
+        const std::size_t next_port = emit(instruction(BPF_JMP | BPF_JNE | BPF_K, r4, 0, 0, htons(port.port)));
+        const UdpFilterSpec &spec = port.filter;
+        emit(instruction(BPF_LDX | BPF_MEM | BPF_W, r5, r2, kEthHeaderSize + 12, 0));
+        to_drop.push_back(emit(instruction(
+            BPF_JMP32 | BPF_JNE | BPF_K, r5, 0, 0, static_cast<std::int32_t>(spec.source.s_addr))));
+        // r5: the payload length after the optional sequence header.
+        emit(instruction(BPF_LDX | BPF_MEM | BPF_H, r5, r2, kEthHeaderSize + kIpv4HeaderSize + 4, 0));
+        emit(instruction(BPF_ALU | BPF_END | BPF_TO_BE, r5, 0, 0, 16));
+        const auto overhead = static_cast<std::int32_t>(kUdpHeaderSize + spec.header_size);
+        const auto frame_size = static_cast<std::int32_t>(spec.frame_size);
+        to_drop.push_back(emit(instruction(BPF_JMP | BPF_JLT | BPF_K, r5, 0, 0, overhead + frame_size)));
+        emit(instruction(BPF_ALU64 | BPF_SUB | BPF_K, r5, 0, 0, overhead));
+        if (spec.header_size == 0) {
+            emit(instruction(BPF_ALU64 | BPF_MOV | BPF_X, r4, r5, 0, 0));
+            emit(instruction(BPF_ALU64 | BPF_MOD | BPF_K, r4, 0, 0, frame_size));
+            to_drop.push_back(emit(instruction(BPF_JMP | BPF_JNE | BPF_K, r4, 0, 0, 0)));
+        }
+        if (spec.check_info) {
+            const std::size_t checks = spec.header_size == 0 ? kUdpFilterInfoChecks : 1;
+            for (std::size_t i = 0; i < checks; ++i) {
+                const auto slot = static_cast<std::int32_t>(i) * frame_size;
+                const auto offset = static_cast<std::int16_t>(kHeadersSize + spec.header_size + slot);
+                if (i != 0) {
+                    // No frame i: nothing left to check.
+                    to_redirect.push_back(emit(instruction(BPF_JMP | BPF_JLT | BPF_K, r5, 0, 0, slot + frame_size)));
+                }
+                // Bounds the load for the verifier; a datagram longer than
+                // the packet is cut off.
+                emit(instruction(BPF_ALU64 | BPF_MOV | BPF_X, r4, r2, 0, 0));
+                emit(instruction(BPF_ALU64 | BPF_ADD | BPF_K, r4, 0, 0, offset + 1));
+                to_drop.push_back(emit(instruction(BPF_JMP | BPF_JGT | BPF_X, r4, r3, 0, 0)));
+                emit(instruction(BPF_LDX | BPF_MEM | BPF_B, r4, r2, offset, 0));
+                // As in the socket filter, a control record skips the DLC
+                // check and one in the first slot ends the checks.
+                const std::size_t control = emit(instruction(BPF_JMP | BPF_JEQ | BPF_K, r4, 0, 0, kControlInfo));
+                if (i == 0) {
+                    to_redirect.push_back(control);
+                } else {
+                    program[control].off = 2;
+                }
+                emit(instruction(BPF_ALU64 | BPF_AND | BPF_K, r4, 0, 0, 0x0F));
+                to_drop.push_back(emit(instruction(BPF_JMP | BPF_JGT | BPF_K, r4, 0, 0, kMaxDlc)));
+            }
+        }
+        to_redirect.push_back(emit(instruction(BPF_JMP | BPF_JA, 0, 0, 0, 0)));
+        // Other ports: reload the destination port the checks overwrote.
+        program[next_port].off = jump_to(program.size(), next_port);
+        emit(instruction(BPF_LDX | BPF_MEM | BPF_H, r4, r2, kEthHeaderSize + kIpv4HeaderSize + 2, 0));
+    }
+    to_pass.push_back(emit(instruction(BPF_JMP | BPF_JA, 0, 0, 0, 0)));
+
+    // The verifier rejects unreachable instructions, so the redirect and drop
+    // tails are only emitted when something jumps there: no ports at all, or
+    // none of them filtered.
+    const std::size_t pass = emit(instruction(BPF_ALU64 | BPF_MOV | BPF_K, r0, 0, 0, XDP_PASS));
+    emit(instruction(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+    std::size_t redirect = 0;
+    if (!to_redirect.empty()) {
+        redirect = emit(instruction(BPF_LDX | BPF_MEM | BPF_W, r2, r1, offsetof(xdp_md, rx_queue_index), 0));
+        emit(instruction(BPF_LD | BPF_DW | BPF_IMM, r1, BPF_PSEUDO_MAP_FD, 0, xsk_map_fd));
+        emit(instruction(0, 0, 0, 0, 0));
+        emit(instruction(BPF_ALU64 | BPF_MOV | BPF_K, r3, 0, 0, XDP_PASS));
+        emit(instruction(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map));
+        emit(instruction(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+    }
+    std::size_t drop = 0;
+    if (!to_drop.empty()) {
+        drop = emit(instruction(BPF_ALU64 | BPF_MOV | BPF_K, r0, 0, 0, XDP_DROP));
+        emit(instruction(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+    }
+
+    for (const std::size_t at : to_pass) {
+        program[at].off = jump_to(pass, at);
+    }
+    for (const std::size_t at : to_redirect) {
+        program[at].off = jump_to(redirect, at);
+    }
+    for (const std::size_t at : to_drop) {
+        program[at].off = jump_to(drop, at);
+    }
+    return program;
+}
+
+bool XdpIngress::open(const XdpConfig &config, const std::vector<XdpPort> &ports, std::string &error_message) {
+    close();
+    const unsigned int ifindex = if_nametoindex(config.interface.c_str());
+    if (ifindex == 0) {
+        error_message = errno_text("interface " + config.interface);
+        return false;
+    }
+
+    bpf_attr attr{};
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(std::uint32_t);
+    attr.value_size = sizeof(std::uint32_t);
+    attr.max_entries = config.queues;
+    xsk_map_fd_ = bpf(BPF_MAP_CREATE, attr);
+    if (xsk_map_fd_ < 0) {
+        error_message = errno_text("cannot create XSKMAP");
+        close();
+        return false;
+    }
+
+    queues_.resize(config.queues);
+    for (std::uint32_t queue_id = 0; queue_id < config.queues; ++queue_id) {
+        if (!open_queue(ifindex, queue_id, config.zero_copy, queues_[queue_id], error_message)) {
+            const int error = errno;
+            close();
+            errno = error;
+            return false;
+        }
+        std::uint32_t key = queue_id;
+        std::uint32_t value = static_cast<std::uint32_t>(queues_[queue_id].fd);
+        attr = bpf_attr{};
+        attr.map_fd = static_cast<std::uint32_t>(xsk_map_fd_);
+        attr.key = reinterpret_cast<std::uint64_t>(&key);
+        attr.value = reinterpret_cast<std::uint64_t>(&value);
+        if (bpf(BPF_MAP_UPDATE_ELEM, attr) < 0) {
+            error_message = errno_text("cannot add AF_XDP socket to XSKMAP");
+            close();
+            return false;
+        }
+    }
+
+    prog_fd_ = load_program(ports, error_message);
+    if (prog_fd_ < 0) {
+        close();
+        return false;
+    }
+
+    attr = bpf_attr{};
+    attr.link_create.prog_fd = static_cast<std::uint32_t>(prog_fd_);
+    attr.link_create.target_ifindex = ifindex;
+    attr.link_create.attach_type = BPF_XDP;
+    attr.link_create.flags = config.skb_mode ? XDP_FLAGS_SKB_MODE : 0U;
+    link_fd_ = bpf(BPF_LINK_CREATE, attr);
+    if (link_fd_ < 0) {
+        error_message = errno_text("cannot attach XDP program to " + config.interface);
+        close();
+        return false;
+    }
+
+    config_ = config;
+    ports_ = ports;
+    return true;
+}
+
+void XdpIngress::close() {
+    // Detach first so that no packet is redirected to a closing socket.
+    for (int *fd : {&link_fd_, &prog_fd_, &xsk_map_fd_}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+    for (Queue &queue : queues_) {
+        close_queue(queue);
+    }
+    queues_.clear();
+    ports_.clear();
+}
+
+bool XdpIngress::same_setup(const XdpConfig &config) const {
+    return active() && config.interface == config_.interface && config.queues == config_.queues &&
+           config.zero_copy == config_.zero_copy && config.skb_mode == config_.skb_mode;
+}
+
+bool XdpIngress::set_ports(const std::vector<XdpPort> &ports, std::string &error_message) {
+    const int prog_fd = load_program(ports, error_message);
+    if (prog_fd < 0) {
+        return false;
+    }
+    bpf_attr attr{};
+    attr.link_update.link_fd = static_cast<std::uint32_t>(link_fd_);
+    attr.link_update.new_prog_fd = static_cast<std::uint32_t>(prog_fd);
+    if (bpf(BPF_LINK_UPDATE, attr) < 0) {
+        error_message = errno_text("cannot replace XDP program");
+        ::close(prog_fd);
+        return false;
+    }
+    ::close(prog_fd_);
+    prog_fd_ = prog_fd;
+    ports_ = ports;
+    return true;
+}
+
+int XdpIngress::load_program(const std::vector<XdpPort> &ports, std::string &error_message) const {
+    const std::vector<bpf_insn> program = build_xdp_program(xsk_map_fd_, ports);
+    static const char kLicense[] = "GPL";
+    bpf_attr attr{};
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insns = reinterpret_cast<std::uint64_t>(program.data());
+    attr.insn_cnt = static_cast<std::uint32_t>(program.size());
+    attr.license = reinterpret_cast<std::uint64_t>(kLicense);
+    const int prog_fd = bpf(BPF_PROG_LOAD, attr);
+    if (prog_fd < 0) {
+        error_message = errno_text("cannot load XDP program");
+    }
+    return prog_fd;
+}
+
+// UMEM registration, the three rings and the bind, as in the kernel's
+// AF_XDP documentation. The fill ring starts out holding every frame.
+bool XdpIngress::open_queue(unsigned int ifindex,
+                            std::uint32_t queue_id,
+                            bool zero_copy,
+                            Queue &queue,
+                            std::string &error_message) {
+    const std::string name = "AF_XDP queue " + std::to_string(queue_id);
+    queue.fd = socket(AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0);
+    if (queue.fd < 0) {
+        error_message = errno_text("cannot create AF_XDP socket");
+        return false;
+    }
+    void *umem = mmap(nullptr, kUmemBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (umem == MAP_FAILED) {
+        error_message = errno_text(name + ": cannot allocate UMEM");
+        return false;
+    }
+    queue.umem = static_cast<std::uint8_t *>(umem);
+
+    xdp_umem_reg registration{};
+    registration.addr = reinterpret_cast<std::uint64_t>(queue.umem);
+    registration.len = kUmemBytes;
+    registration.chunk_size = kFrameSize;
+    const int ring_size = static_cast<int>(kRingSize);
+    if (setsockopt(queue.fd, SOL_XDP, XDP_UMEM_REG, &registration, sizeof(registration)) < 0 ||
+        setsockopt(queue.fd, SOL_XDP, XDP_UMEM_FILL_RING, &ring_size, sizeof(ring_size)) < 0 ||
+        setsockopt(queue.fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ring_size, sizeof(ring_size)) < 0 ||
+        setsockopt(queue.fd, SOL_XDP, XDP_RX_RING, &ring_size, sizeof(ring_size)) < 0) {
+        error_message = errno_text(name + ": cannot set up UMEM and rings");
+        return false;
+    }
+
+    xdp_mmap_offsets offsets{};
+    socklen_t offsets_length = sizeof(offsets);
+    if (getsockopt(queue.fd, SOL_XDP, XDP_MMAP_OFFSETS, &offsets, &offsets_length) < 0) {
+        error_message = errno_text(name + ": cannot query ring offsets");
+        return false;
+    }
+    Ring *const rings[] = {&queue.rx, &queue.fill, &queue.completion};
+    const xdp_ring_offset *const ring_offsets[] = {&offsets.rx, &offsets.fr, &offsets.cr};
+    const off_t page_offsets[] = {XDP_PGOFF_RX_RING, XDP_UMEM_PGOFF_FILL_RING, XDP_UMEM_PGOFF_COMPLETION_RING};
+    const std::size_t descriptor_sizes[] = {sizeof(xdp_desc), sizeof(std::uint64_t), sizeof(std::uint64_t)};
+    for (std::size_t i = 0; i < 3; ++i) {
+        Ring &ring = *rings[i];
+        if (!map_ring(queue.fd,
+                      descriptor_sizes[i],
+                      *ring_offsets[i],
+                      page_offsets[i],
+                      ring.mapping,
+                      ring.mapping_length,
+                      ring.producer,
+                      ring.consumer,
+                      ring.flags,
+                      ring.descriptors)) {
+            error_message = errno_text(name + ": cannot map ring");
+            return false;
+        }
+    }
+
+    auto *fill = static_cast<std::uint64_t *>(queue.fill.descriptors);
+    for (std::uint32_t i = 0; i < kRingSize; ++i) {
+        fill[i] = static_cast<std::uint64_t>(i) * kFrameSize;
+    }
+    __atomic_store_n(queue.fill.producer, kRingSize, __ATOMIC_RELEASE);
+
+    sockaddr_xdp address{};
+    address.sxdp_family = AF_XDP;
+    address.sxdp_ifindex = ifindex;
+    address.sxdp_queue_id = queue_id;
+    address.sxdp_flags = XDP_USE_NEED_WAKEUP | (zero_copy ? XDP_ZEROCOPY : 0U);
+    if (bind(queue.fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        error_message = errno_text(name + ": cannot bind");
+        return false;
+    }
+    return true;
+}
+
+void XdpIngress::close_queue(Queue &queue) {
+    for (Ring *ring : {&queue.rx, &queue.fill, &queue.completion}) {
+        if (ring->mapping != nullptr) {
+            munmap(ring->mapping, ring->mapping_length);
+        }
+        *ring = Ring{};
+    }
+    if (queue.fd >= 0) {
+        ::close(queue.fd);
+    }
+    if (queue.umem != nullptr) {
+        munmap(queue.umem, kUmemBytes);
+    }
+    queue = Queue{};
+}
+
+std::size_t XdpIngress::receive(std::size_t queue_index, XdpPacket *packets, std::size_t capacity) {
+    Queue &queue = queues_[queue_index];
+    const std::uint32_t consumer = *queue.rx.consumer;
+    const std::uint32_t available = __atomic_load_n(queue.rx.producer, __ATOMIC_ACQUIRE) - consumer;
+    const std::uint32_t count = static_cast<std::uint32_t>(std::min<std::size_t>(available, capacity));
+    const auto *descriptors = static_cast<const xdp_desc *>(queue.rx.descriptors);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        const xdp_desc &descriptor = descriptors[(consumer + i) & (kRingSize - 1)];
+        parse_packet(queue.umem + descriptor.addr, descriptor.len, packets[i]);
+    }
+    queue.taken = count;
+    return count;
+}
+
+// Returns the frames of the last receive() to the fill ring, then frees
+// their RX slots. With one frame per slot the fill ring always has room.
+void XdpIngress::release(std::size_t queue_index) {
+    Queue &queue = queues_[queue_index];
+    const std::uint32_t count = queue.taken;
+    if (count == 0) {
+        return;
+    }
+    queue.taken = 0;
+    const std::uint32_t consumer = *queue.rx.consumer;
+    const std::uint32_t producer = *queue.fill.producer;
+    const auto *descriptors = static_cast<const xdp_desc *>(queue.rx.descriptors);
+    auto *fill = static_cast<std::uint64_t *>(queue.fill.descriptors);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        // Aligned chunk mode: any address inside the frame names the frame.
+        const std::uint64_t address = descriptors[(consumer + i) & (kRingSize - 1)].addr;
+        fill[(producer + i) & (kRingSize - 1)] = address - address % kFrameSize;
+    }
+    __atomic_store_n(queue.fill.producer, producer + count, __ATOMIC_RELEASE);
+    __atomic_store_n(queue.rx.consumer, consumer + count, __ATOMIC_RELEASE);
+    if ((__atomic_load_n(queue.fill.flags, __ATOMIC_RELAXED) & XDP_RING_NEED_WAKEUP) != 0U) {
+        recvfrom(queue.fd, nullptr, 0, MSG_DONTWAIT, nullptr, nullptr);
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "config.hpp"
+#include "udp_filter.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <linux/bpf.h>
+
+// One UDP datagram taken from an AF_XDP RX ring. payload points into the
+// UMEM and stays valid until the batch is released.
+struct XdpPacket {
+    std::uint16_t dst_port;
+    const std::uint8_t *payload; // nullptr when the frame is not IPv4/UDP
+    std::size_t length;
+};
+
+// A destination port the XDP program redirects. With `filtered`, datagrams
+// that fail udp_filter's checks for the port (source address, whole frames,
+// info bytes) are dropped in the program, so they neither reach the socket
+// nor wake the bridge.
+struct XdpPort {
+    std::uint16_t port;
+    bool filtered;
+    UdpFilterSpec filter;
+};
+
+// The XDP program for `ports`, redirecting into the XSKMAP `xsk_map_fd`.
+std::vector<bpf_insn> build_xdp_program(int xsk_map_fd, const std::vector<XdpPort> &ports);
+
+// Receive-only AF_XDP path for UDP. An XDP program on one interface
+// redirects unfragmented IPv4/UDP packets for the given destination ports
+// into one AF_XDP socket per RX queue. Everything else, including packets on
+// queues without a socket, continues up the stack to the regular sockets.
+// Built on raw bpf(2)/AF_XDP calls; the program is attached through a BPF
+// link, so it is detached when the link fd is closed or the process dies.
+class XdpIngress {
+public:
+    XdpIngress() = default;
+    ~XdpIngress() { close(); }
+
+    XdpIngress(const XdpIngress &) = delete;
+    XdpIngress &operator=(const XdpIngress &) = delete;
+
+    // Fails with errno EBUSY while a queue is still held by a socket closed
+    // just before (a reload): its teardown is asynchronous and takes a few
+    // tens of ms, after which the caller may try again.
+    bool open(const XdpConfig &config, const std::vector<XdpPort> &ports, std::string &error_message);
+    void close();
+    bool active() const { return link_fd_ >= 0; }
+    // True when `config` needs the same sockets and attachment, so that a
+    // port change can go through set_ports() instead of a reopen.
+    bool same_setup(const XdpConfig &config) const;
+    const std::vector<XdpPort> &ports() const { return ports_; }
+    // Atomically replaces the attached program with one for `ports`.
+    bool set_ports(const std::vector<XdpPort> &ports, std::string &error_message);
+
+    std::size_t queue_count() const { return queues_.size(); }
+    int queue_fd(std::size_t queue) const { return queues_[queue].fd; }
+
+    // Takes up to `capacity` received frames off the queue's RX ring without
+    // copying them. Returns the number taken; each must be handed back with
+    // release() before the next receive() on the same queue.
+    std::size_t receive(std::size_t queue, XdpPacket *packets, std::size_t capacity);
+    void release(std::size_t queue);
+
+private:
+    struct Ring {
+        std::uint32_t *producer{nullptr};
+        std::uint32_t *consumer{nullptr};
+        std::uint32_t *flags{nullptr};
+        void *descriptors{nullptr};
+        void *mapping{nullptr};
+        std::size_t mapping_length{0};
+    };
+
+    struct Queue {
+        int fd{-1};
+        std::uint8_t *umem{nullptr};
+        Ring rx;
+        Ring fill;
+        Ring completion;
+        std::uint32_t taken{0};
+    };
+
+    static bool open_queue(unsigned int ifindex,
+                           std::uint32_t queue_id,
+                           bool zero_copy,
+                           Queue &queue,
+                           std::string &error_message);
+    static void close_queue(Queue &queue);
+    int load_program(const std::vector<XdpPort> &ports, std::string &error_message) const;
+
+    XdpConfig config_{};
+    std::vector<XdpPort> ports_;
+    std::vector<Queue> queues_;
+    int xsk_map_fd_{-1};
+    int prog_fd_{-1};
+    int link_fd_{-1};
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+// Minimal Google-Benchmark-style runner shared by the bridge benchmarks. It
+// scales the iteration count until the run lasts at least --min-time seconds
+// and reports per-frame wall time plus whatever perf counters are available.
+
+#include "perf_counters.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+template <typename T>
+inline void do_not_optimize(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobber_memory() {
+    asm volatile("" : : : "memory");
+}
+
+class BenchRunner {
+public:
+    BenchRunner(int argc, char **argv) {
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--filter") == 0 && (i + 1) < argc) {
+                filter_ = argv[++i];
+            } else if (std::strcmp(argv[i], "--min-time") == 0 && (i + 1) < argc) {
+                min_time_s_ = std::strtod(argv[++i], nullptr);
+            } else {
+                std::fprintf(stderr, "Usage: %s [--filter <substring>] [--min-time <seconds>]\n", argv[0]);
+                std::exit(1);
+            }
+        }
+        if (min_time_s_ <= 0.0) {
+            min_time_s_ = 0.2;
+        }
+    }
+
+    void print_header() const {
+        std::printf("%-60s %12s %12s %12s %12s %14s\n",
+                    "Benchmark",
+                    "ns/frame",
+                    "instr/frame",
+                    "L1d-miss/fr",
+                    "LLC-miss/fr",
+                    "frames");
+        std::printf("%s\n", std::string(127, '-').c_str());
+        if (!counters_.available(PerfEvent::Instructions)) {
+            std::printf("# perf counters unavailable (perf_event_paranoid?), reporting wall time only\n");
+        }
+    }
+
+    // fn(n) must process exactly n frames.
+    template <typename Fn>
+    void run(const std::string &name, Fn &&fn) {
+        if (!filter_.empty() && name.find(filter_) == std::string::npos) {
+            return;
+        }
+
+        std::size_t iterations = 1024;
+        double elapsed_s = 0.0;
+        while (true) {
+            elapsed_s = time_once(fn, iterations);
+            if (elapsed_s >= min_time_s_ || iterations >= (std::size_t{1} << 34U)) {
+                break;
+            }
+            const double scale = elapsed_s > 0.0 ? (min_time_s_ * 1.4) / elapsed_s : 100.0;
+            const double clamped = scale < 2.0 ? 2.0 : (scale > 100.0 ? 100.0 : scale);
+            iterations = static_cast<std::size_t>(static_cast<double>(iterations) * clamped);
+        }
+
+        counters_.start();
+        elapsed_s = time_once(fn, iterations);
+        counters_.stop();
+
+        const double frames = static_cast<double>(iterations);
+        char instr[32];
+        char l1d[32];
+        char llc[32];
+        format_counter(PerfEvent::Instructions, frames, instr, sizeof(instr));
+        format_counter(PerfEvent::L1dReadMisses, frames, l1d, sizeof(l1d));
+        format_counter(PerfEvent::LlcReadMisses, frames, llc, sizeof(llc));
+        std::printf("%-60s %12.2f %12s %12s %12s %14zu\n",
+                    name.c_str(),
+                    (elapsed_s * 1e9) / frames,
+                    instr,
+                    l1d,
+                    llc,
+                    iterations);
+        std::fflush(stdout);
+    }
+
+private:
+    template <typename Fn>
+    static double time_once(Fn &fn, std::size_t iterations) {
+        const auto begin = std::chrono::steady_clock::now();
+        fn(iterations);
+        clobber_memory();
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - begin).count();
+    }
+
+    void format_counter(PerfEvent event, double frames, char *out, std::size_t size) const {
+        const std::int64_t value = counters_.read_value(event);
+        if (value < 0) {
+            std::snprintf(out, size, "n/a");
+        } else {
+            std::snprintf(out, size, "%.3f", static_cast<double>(value) / frames);
+        }
+    }
+
+    std::string filter_;
+    double min_time_s_{0.2};
+    PerfCounters counters_;
+};
@@ -0,0 +1,624 @@
+#include "bench_harness.hpp"
+#include "bridge.hpp"
+#include "loopback_io_backend.hpp"
+#include "protocol.hpp"
+#include "rate_limiter.hpp"
+#include "routing.hpp"
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <linux/can.h>
+#include <netinet/in.h>
+
+namespace {
+
+constexpr std::size_t kSampleCount = 256; // power of two, fits comfortably in L1
+constexpr std::size_t kMaxRangeTableSize = 64;
+
+enum class FrameKind {
+    Standard,
+    Extended,
+    Remote,
+};
+
+const char *frame_kind_name(FrameKind kind) {
+    switch (kind) {
+    case FrameKind::Standard:
+        return "std";
+    case FrameKind::Extended:
+        return "ext";
+    case FrameKind::Remote:
+        return "rtr";
+    }
+    return "?";
+}
+
+std::uint32_t next_random(std::uint32_t &state) {
+    state ^= state << 13U;
+    state ^= state >> 17U;
+    state ^= state << 5U;
+    return state;
+}
+
+std::vector<struct can_frame> make_frames(FrameKind kind, std::uint8_t dlc) {
+    std::vector<struct can_frame> frames(kSampleCount);
+    std::uint32_t seed = 0x9E3779B9U ^ dlc;
+    for (auto &frame : frames) {
+        frame = {};
+        switch (kind) {
+        case FrameKind::Standard:
+            frame.can_id = next_random(seed) & CAN_SFF_MASK;
+            break;
+        case FrameKind::Extended:
+            frame.can_id = (next_random(seed) & CAN_EFF_MASK) | CAN_EFF_FLAG;
+            break;
+        case FrameKind::Remote:
+            frame.can_id = (next_random(seed) & CAN_SFF_MASK) | CAN_RTR_FLAG;
+            break;
+        }
+        frame.can_dlc = dlc;
+        for (std::uint8_t i = 0; i < dlc; ++i) {
+            frame.data[i] = static_cast<std::uint8_t>(next_random(seed));
+        }
+    }
+    return frames;
+}
+
+std::vector<std::uint8_t> make_wire_frames(const std::vector<struct can_frame> &frames) {
+    std::vector<std::uint8_t> wire(frames.size() * kUdpFrameSize);
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+        encode_udp_frame(frames[i], wire.data() + i * kUdpFrameSize);
+    }
+    return wire;
+}
+
+void register_codec_benchmarks(BenchRunner &runner) {
+    const FrameKind kinds[] = {FrameKind::Standard, FrameKind::Extended, FrameKind::Remote};
+    for (const FrameKind kind : kinds) {
+        for (std::uint8_t dlc = 0; dlc <= 8U; ++dlc) {
+            const std::vector<struct can_frame> frames = make_frames(kind, dlc);
+            const std::vector<std::uint8_t> wire = make_wire_frames(frames);
+            const std::string suffix = std::string("/") + frame_kind_name(kind) + "/dlc:" + std::to_string(dlc);
+
+            runner.run("BM_decode_udp_frame" + suffix, [&](std::size_t n) {
+                struct can_frame out{};
+                for (std::size_t i = 0; i < n; ++i) {
+                    const std::uint8_t *src = wire.data() + (i & (kSampleCount - 1)) * kUdpFrameSize;
+                    do_not_optimize(decode_udp_frame(src, out));
+                    do_not_optimize(out);
+                }
+            });
+
+            runner.run("BM_encode_udp_frame" + suffix, [&](std::size_t n) {
+                std::array<std::uint8_t, kUdpFrameSize> out{};
+                for (std::size_t i = 0; i < n; ++i) {
+                    do_not_optimize(encode_udp_frame(frames[i & (kSampleCount - 1)], out.data()));
+                    do_not_optimize(out);
+                }
+            });
+        }
+    }
+}
+
+// Builds `count` disjoint ranges with gaps between them so the query stream
+// exercises both hits and misses, mirroring a gateway config with one range
+// per channel.
+std::vector<RangeLookup> make_range_table(std::size_t count) {
+    std::vector<RangeLookup> table(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::uint32_t base = static_cast<std::uint32_t>(i) * 0x100U;
+        table[i].range.min = base;
+        table[i].range.max = base + 0xBFU;
+        table[i].channel_index = static_cast<std::uint32_t>(i);
+    }
+    // Shuffle-free but reversed so the sort in the setup path is not a no-op.
+    for (std::size_t i = 0; i < count / 2; ++i) {
+        std::swap(table[i], table[count - 1 - i]);
+    }
+    sort_range_lookup(table.data(), table.size());
+    return table;
+}
+
+void register_routing_benchmarks(BenchRunner &runner) {
+    for (std::size_t count = 1; count <= kMaxRangeTableSize; count *= 2) {
+        const std::vector<RangeLookup> table = make_range_table(count);
+        std::vector<std::uint32_t> queries(kSampleCount);
+        std::uint32_t seed = 0x2545F491U;
+        const std::uint32_t span = static_cast<std::uint32_t>(count + 1) * 0x100U;
+        for (auto &query : queries) {
+            query = next_random(seed) % span;
+        }
+
+        runner.run("BM_find_channel_for_can_id/ranges:" + std::to_string(count), [&](std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                do_not_optimize(find_channel_for_can_id(table.data(), table.size(), queries[i & (kSampleCount - 1)]));
+            }
+        });
+    }
+}
+
+void register_rate_limiter_benchmarks(BenchRunner &runner) {
+    // 256 single-ID rules below 2048, 256 single EFF IDs and 16 EFF ranges.
+    std::vector<RateLimitRule> rules;
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        RateLimitRule rule{};
+        rule.id_range = {i * 8U, i * 8U};
+        rule.max_rate_hz = 1000000;
+        rule.burst = 1000;
+        rules.push_back(rule);
+        rule.id_range = {0x18000000U + i * 16U, 0x18000000U + i * 16U};
+        rules.push_back(rule);
+    }
+    for (std::uint32_t i = 0; i < 16; ++i) {
+        RateLimitRule rule{};
+        rule.id_range = {0x10000000U + i * 0x1000U, 0x10000000U + i * 0x1000U + 0x7FFU};
+        rule.decimate = 2;
+        rules.push_back(rule);
+    }
+    RateLimiter limiter;
+    limiter.initialize(rules);
+
+    const struct {
+        const char *name;
+        std::uint32_t base;
+        std::uint32_t stride;
+    } cases[] = {
+        {"sff_direct", 0, 4},
+        {"eff_exact", 0x18000000U, 8},
+        {"eff_range", 0x10000000U, 0x101},
+    };
+    for (const auto &c : cases) {
+        std::vector<std::uint32_t> ids(kSampleCount);
+        for (std::size_t i = 0; i < kSampleCount; ++i) {
+            ids[i] = c.base + static_cast<std::uint32_t>(i) * c.stride;
+        }
+        runner.run(std::string("BM_rate_limiter_allow/") + c.name, [&](std::size_t n) {
+            std::uint64_t now = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                do_not_optimize(limiter.allow(FlowDirection::CanToUdp, ids[i & (kSampleCount - 1)], now));
+                now += 1000;
+            }
+        });
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Runtime table layout: the pre-arena BridgeApp layout (array-of-structs with
+// configs, strings and 4 KB rx buffers inline) against the current hot arrays.
+// Both run the same per-frame work as handle_udp_events/handle_can_events
+// minus the syscalls. Between datagrams a scratch buffer is streamed through
+// to model the cache footprint of the recv/write syscalls, so what remains is
+// the cost of re-fetching each layout's working set.
+// ---------------------------------------------------------------------------
+
+constexpr std::size_t kLayoutPorts = 8;
+constexpr std::size_t kLayoutFramesPerDatagram = 16;
+constexpr std::size_t kSyscallFootprintBytes = 24 * 1024;
+
+struct LegacyLayout {
+    struct UdpPortContext {
+        PortConfig config;
+        int udp_fd{-1};
+        sockaddr_in remote_addr{};
+        BridgeApp::PortStats stats{};
+        std::array<std::uint8_t, 4096> rx_buffer{};
+    };
+
+    struct ChannelContext {
+        ChannelConfig config;
+        int can_fd{-1};
+        std::size_t port_index{0};
+        BridgeApp::ChannelStats stats{};
+    };
+
+    struct LegacyRangeLookup {
+        IdRange range{};
+        std::size_t channel_index{0};
+    };
+
+    std::array<UdpPortContext, 8> udp_ports;
+    std::array<ChannelContext, 64> channels;
+    std::array<LegacyRangeLookup, 64> id_lookup;
+    std::size_t channel_count{0};
+
+    std::uint8_t *rx_buffer(std::size_t port) { return udp_ports[port].rx_buffer.data(); }
+
+    // Out of line, like find_channel_for_can_id in routing.cpp, so that only
+    // the table layout differs between the two variants.
+    __attribute__((noinline)) std::size_t find(std::uint32_t can_id) const {
+        std::size_t low = 0;
+        std::size_t high = channel_count;
+        while (low < high) {
+            const std::size_t mid = (low + high) / 2;
+            if (id_lookup[mid].range.min <= can_id) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        if (low == 0) {
+            return kInvalidChannelIndex;
+        }
+        const LegacyRangeLookup &candidate = id_lookup[low - 1];
+        return candidate.range.max >= can_id ? candidate.channel_index : kInvalidChannelIndex;
+    }
+
+    void build(const BridgeConfig &config) {
+        std::size_t port_index = 0;
+        for (const auto &port_cfg : config.ports) {
+            udp_ports[port_index].config = port_cfg;
+            udp_ports[port_index].udp_fd = static_cast<int>(100 + port_index);
+            for (const auto &channel_cfg : port_cfg.channels) {
+                channels[channel_count].config = channel_cfg;
+                channels[channel_count].can_fd = static_cast<int>(200 + channel_count);
+                channels[channel_count].port_index = port_index;
+                id_lookup[channel_count].range = channel_cfg.id_range;
+                id_lookup[channel_count].channel_index = channel_count;
+                ++channel_count;
+            }
+            ++port_index;
+        }
+    }
+
+    std::uint64_t udp_datagram(std::size_t port_index) {
+        UdpPortContext &port = udp_ports[port_index];
+        std::uint64_t sink = 0;
+        ++port.stats.udp_rx_datagrams;
+        for (std::size_t i = 0; i < kLayoutFramesPerDatagram; ++i) {
+            struct can_frame frame{};
+            decode_udp_frame(port.rx_buffer.data() + i * kUdpFrameSize, frame);
+            ++port.stats.udp_rx_frames;
+            const std::size_t channel_index = find(extract_identifier(frame));
+            if (channel_index == kInvalidChannelIndex || channels[channel_index].port_index != port_index) {
+                ++port.stats.udp_rx_unroutable;
+                continue;
+            }
+            sink += static_cast<std::uint64_t>(channels[channel_index].can_fd) + frame.data[0];
+            ++channels[channel_index].stats.can_tx_frames;
+        }
+        return sink;
+    }
+
+    std::uint64_t can_frame_out(std::size_t channel_index) {
+        ChannelContext &channel = channels[channel_index];
+        UdpPortContext &port = udp_ports[channel.port_index];
+        ++channel.stats.can_rx_frames;
+        ++port.stats.udp_tx_frames;
+        return static_cast<std::uint64_t>(port.udp_fd) + port.remote_addr.sin_port;
+    }
+};
+
+struct HotColdLayout {
+    Arena arena;
+    RangeLookup *id_lookup{nullptr};
+    std::uint32_t *channel_ports{nullptr};
+    int *can_fds{nullptr};
+    int *udp_fds{nullptr};
+    sockaddr_in *remote_addrs{nullptr};
+    BridgeApp::ChannelStats *channel_stats{nullptr};
+    BridgeApp::PortStats *port_stats{nullptr};
+    std::uint8_t *shared_rx_buffer{nullptr};
+    const ChannelConfig **channel_configs{nullptr};
+    std::size_t channel_count{0};
+
+    std::uint8_t *rx_buffer(std::size_t) { return shared_rx_buffer; }
+
+    void build(const BridgeConfig &config) {
+        std::size_t ports = config.ports.size();
+        for (const auto &port_cfg : config.ports) {
+            channel_count += port_cfg.channels.size();
+        }
+        arena.reserve(Arena::bytes_for<RangeLookup>(channel_count) + Arena::bytes_for<std::uint32_t>(channel_count) +
+                      Arena::bytes_for<int>(channel_count) + Arena::bytes_for<int>(ports) +
+                      Arena::bytes_for<sockaddr_in>(ports) +
+                      Arena::bytes_for<BridgeApp::ChannelStats>(channel_count) +
+                      Arena::bytes_for<BridgeApp::PortStats>(ports) + Arena::bytes_for<std::uint8_t>(4096) +
+                      Arena::bytes_for<const ChannelConfig *>(channel_count));
+        id_lookup = arena.allocate<RangeLookup>(channel_count);
+        channel_ports = arena.allocate<std::uint32_t>(channel_count);
+        can_fds = arena.allocate<int>(channel_count);
+        udp_fds = arena.allocate<int>(ports);
+        remote_addrs = arena.allocate<sockaddr_in>(ports);
+        channel_stats = arena.allocate<BridgeApp::ChannelStats>(channel_count);
+        port_stats = arena.allocate<BridgeApp::PortStats>(ports);
+        shared_rx_buffer = arena.allocate<std::uint8_t>(4096);
+        channel_configs = arena.allocate<const ChannelConfig *>(channel_count);
+
+        std::size_t channel_index = 0;
+        for (std::size_t p = 0; p < ports; ++p) {
+            udp_fds[p] = static_cast<int>(100 + p);
+            for (const auto &channel_cfg : config.ports[p].channels) {
+                channel_configs[channel_index] = &channel_cfg;
+                channel_ports[channel_index] = static_cast<std::uint32_t>(p);
+                can_fds[channel_index] = static_cast<int>(200 + channel_index);
+                id_lookup[channel_index].range = channel_cfg.id_range;
+                id_lookup[channel_index].channel_index = static_cast<std::uint32_t>(channel_index);
+                ++channel_index;
+            }
+        }
+    }
+
+    std::uint64_t udp_datagram(std::size_t port_index) {
+        BridgeApp::PortStats &stats = port_stats[port_index];
+        std::uint64_t sink = 0;
+        ++stats.udp_rx_datagrams;
+        for (std::size_t i = 0; i < kLayoutFramesPerDatagram; ++i) {
+            struct can_frame frame{};
+            decode_udp_frame(shared_rx_buffer + i * kUdpFrameSize, frame);
+            ++stats.udp_rx_frames;
+            const std::size_t channel_index = find_channel_for_can_id(id_lookup, channel_count, extract_identifier(frame));
+            if (channel_index == kInvalidChannelIndex || channel_ports[channel_index] != port_index) {
+                ++stats.udp_rx_unroutable;
+                continue;
+            }
+            sink += static_cast<std::uint64_t>(can_fds[channel_index]) + frame.data[0];
+            ++channel_stats[channel_index].can_tx_frames;
+        }
+        return sink;
+    }
+
+    std::uint64_t can_frame_out(std::size_t channel_index) {
+        const std::uint32_t port_index = channel_ports[channel_index];
+        ++channel_stats[channel_index].can_rx_frames;
+        ++port_stats[port_index].udp_tx_frames;
+        return static_cast<std::uint64_t>(udp_fds[port_index]) + remote_addrs[port_index].sin_port;
+    }
+};
+
+BridgeConfig make_layout_config(std::size_t channels) {
+    BridgeConfig config{};
+    config.server.ip = "127.0.0.1";
+    for (std::size_t p = 0; p < kLayoutPorts; ++p) {
+        PortConfig port{};
+        port.listen_port = static_cast<std::uint16_t>(5555 + p * 10);
+        port.send_port = static_cast<std::uint16_t>(5556 + p * 10);
+        config.ports.push_back(port);
+    }
+    for (std::size_t i = 0; i < channels; ++i) {
+        ChannelConfig channel{};
+        channel.vcan_name = "gateway_can_interface_" + std::to_string(i); // beyond SSO, like real configs
+        channel.tx_channel_id = static_cast<std::uint32_t>(i);
+        channel.id_range.min = static_cast<std::uint32_t>(i) * 0x40U;
+        channel.id_range.max = channel.id_range.min + 0x3FU;
+        channel.bitrate = 500000;
+        config.ports[i % kLayoutPorts].channels.push_back(channel);
+    }
+    return config;
+}
+
+template <typename Layout>
+void run_layout_benchmark(BenchRunner &runner, const char *label, std::size_t channels) {
+    const BridgeConfig config = make_layout_config(channels);
+    std::unique_ptr<Layout> layout(new Layout());
+    layout->build(config);
+    // Each port's datagram carries frames for that port's own channels.
+    for (std::size_t p = 0; p < kLayoutPorts; ++p) {
+        for (std::size_t i = 0; i < kLayoutFramesPerDatagram; ++i) {
+            const std::size_t channel = (p + kLayoutPorts * i) % channels;
+            struct can_frame frame{};
+            frame.can_id = static_cast<std::uint32_t>(channel) * 0x40U + static_cast<std::uint32_t>(i);
+            frame.can_dlc = 8;
+            frame.data[0] = static_cast<std::uint8_t>(i);
+            encode_udp_frame(frame, layout->rx_buffer(p) + i * kUdpFrameSize);
+        }
+    }
+    std::vector<std::uint8_t> scratch(kSyscallFootprintBytes);
+
+    runner.run(std::string("BM_runtime_table_layout/") + label + "/channels:" + std::to_string(channels),
+               [&](std::size_t n) {
+                   std::uint64_t sink = 0;
+                   std::size_t port = 0;
+                   std::size_t done = 0;
+                   while (done < n) {
+                       for (std::size_t offset = 0; offset < scratch.size(); offset += kCacheLineSize) {
+                           scratch[offset] = static_cast<std::uint8_t>(scratch[offset] + 1U);
+                       }
+                       sink += layout->udp_datagram(port);
+                       for (std::size_t c = port; c < channels; c += kLayoutPorts) {
+                           sink += layout->can_frame_out(c);
+                       }
+                       done += kLayoutFramesPerDatagram + channels / kLayoutPorts;
+                       port = (port + 1) % kLayoutPorts;
+                   }
+                   do_not_optimize(sink);
+               });
+}
+
+void register_layout_benchmarks(BenchRunner &runner) {
+    {
+        std::vector<std::uint8_t> scratch(kSyscallFootprintBytes);
+        const std::size_t frames_per_round = kLayoutFramesPerDatagram + 32 / kLayoutPorts;
+        // Cost of the simulated syscall footprint alone; subtract it from the rows below.
+        runner.run("BM_runtime_table_layout/syscall_footprint_only", [&](std::size_t n) {
+            for (std::size_t done = 0; done < n; done += frames_per_round) {
+                for (std::size_t offset = 0; offset < scratch.size(); offset += kCacheLineSize) {
+                    scratch[offset] = static_cast<std::uint8_t>(scratch[offset] + 1U);
+                }
+                clobber_memory();
+            }
+        });
+    }
+    for (const std::size_t channels : {std::size_t{8}, std::size_t{32}, std::size_t{64}}) {
+        run_layout_benchmark<LegacyLayout>(runner, "aos_legacy", channels);
+        run_layout_benchmark<HotColdLayout>(runner, "hot_cold", channels);
+    }
+}
+
+BridgeConfig make_bridge_config(std::size_t channels) {
+    BridgeConfig config{};
+    config.server.ip = "127.0.0.1";
+    PortConfig port{};
+    port.listen_port = 5555;
+    port.send_port = 5556;
+    for (std::size_t i = 0; i < channels; ++i) {
+        ChannelConfig channel{};
+        channel.vcan_name = "vcan" + std::to_string(i);
+        channel.tx_channel_id = static_cast<std::uint32_t>(i);
+        channel.id_range.min = static_cast<std::uint32_t>(i) * 0x40U;
+        channel.id_range.max = channel.id_range.min + 0x3FU;
+        channel.bitrate = 500000;
+        port.channels.push_back(channel);
+    }
+    config.ports.push_back(port);
+    return config;
+}
+
+// Full handle_udp_events/handle_can_events paths over the in-memory backend,
+// including epoll dispatch. Numbers include LoopbackIoBackend queue overhead,
+// so compare them only against earlier runs of the same benchmark.
+void register_loopback_benchmarks(BenchRunner &runner) {
+    constexpr std::size_t kChannels = 8;
+    constexpr std::size_t kFramesPerDatagram = 16;
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < kChannels; ++i) {
+        names.push_back("vcan" + std::to_string(i));
+    }
+
+    for (const std::size_t batch : {std::size_t{1}, kFramesPerDatagram}) {
+        runner.run("BM_bridge_udp_to_can/loopback/frames_per_datagram:" + std::to_string(batch), [&](std::size_t n) {
+            LoopbackIoBackend io;
+            for (const std::string &name : names) {
+                io.add_interface(name);
+            }
+            BridgeApp app(make_bridge_config(kChannels), io);
+            if (!app.initialize()) {
+                std::fprintf(stderr, "loopback bridge initialization failed\n");
+                std::exit(1);
+            }
+
+            std::vector<std::uint8_t> wire(batch * kUdpFrameSize);
+            for (std::size_t i = 0; i < batch; ++i) {
+                struct can_frame frame{};
+                frame.can_id = static_cast<std::uint32_t>((i % kChannels) * 0x40U + 1U);
+                frame.can_dlc = 8;
+                encode_udp_frame(frame, wire.data() + i * kUdpFrameSize);
+            }
+
+            struct can_frame out{};
+            for (std::size_t done = 0; done < n; done += batch) {
+                io.inject_udp(5555, wire.data(), wire.size());
+                app.poll_once(0);
+                for (const std::string &name : names) {
+                    while (io.pop_can_tx(name, out)) {
+                    }
+                }
+            }
+        });
+    }
+
+    runner.run("BM_bridge_can_to_udp/loopback", [&](std::size_t n) {
+        LoopbackIoBackend io;
+        for (const std::string &name : names) {
+            io.add_interface(name);
+        }
+        BridgeApp app(make_bridge_config(kChannels), io);
+        if (!app.initialize()) {
+            std::fprintf(stderr, "loopback bridge initialization failed\n");
+            std::exit(1);
+        }
+
+        struct can_frame frame{};
+        frame.can_id = 0x001;
+        frame.can_dlc = 8;
+        std::vector<std::uint8_t> datagram;
+        for (std::size_t done = 0; done < n; done += kFramesPerDatagram) {
+            for (std::size_t i = 0; i < kFramesPerDatagram; ++i) {
+                io.inject_can("vcan0", frame);
+            }
+            app.poll_once(0);
+            while (io.pop_udp_tx(5555, datagram)) {
+            }
+        }
+    });
+
+    // A flashing-sized ISO-TP transfer (4095 bytes), timed per payload byte:
+    // relayed as its 586 segmented frames, one per datagram, or as one PDU
+    // datagram that a CAN_ISOTP socket segments. The loopback socket does
+    // not segment, so the PDU cases measure the bridge's share only.
+    constexpr std::size_t kTransferSize = kMaxIsoTpPdu;
+    // A first frame carries 6 bytes, each consecutive frame 7.
+    constexpr std::size_t kTransferFrames = 1 + (kTransferSize - 6 + 6) / 7;
+    BridgeConfig isotp_config = make_bridge_config(kChannels);
+    IsoTpConfig link{};
+    link.vcan_name = "vcan0";
+    link.tx_id = 0x7E0;
+    link.rx_id = 0x7E8;
+    isotp_config.ports[0].isotp.push_back(link);
+    const auto run_transfers = [&](const std::string &name, auto &&transfer) {
+        runner.run("BM_isotp_transfer/loopback/" + name, [&](std::size_t n) {
+            LoopbackIoBackend io;
+            for (const std::string &interface_name : names) {
+                io.add_interface(interface_name);
+            }
+            BridgeApp app(isotp_config, io);
+            if (!app.initialize()) {
+                std::fprintf(stderr, "loopback bridge initialization failed\n");
+                std::exit(1);
+            }
+            for (std::size_t done = 0; done < n; done += kTransferSize) {
+                transfer(io, app);
+            }
+        });
+    };
+
+    struct can_frame segment{};
+    segment.can_id = 0x001;
+    segment.can_dlc = 8;
+    std::vector<std::uint8_t> segment_wire(kUdpFrameSize);
+    encode_udp_frame(segment, segment_wire.data());
+    std::vector<std::uint8_t> pdu_wire(kUdpFrameSize * (1 + (kTransferSize + kUdpFrameSize - 1) / kUdpFrameSize));
+    ControlRecord record{ControlOpcode::IsoTpPdu};
+    record.can_id = link.tx_id;
+    record.length = static_cast<std::uint16_t>(kTransferSize);
+    encode_control_record(record, pdu_wire.data());
+    const std::vector<std::uint8_t> payload(kTransferSize, 0x5A);
+
+    run_transfers("udp_to_can/frames", [&](LoopbackIoBackend &io, BridgeApp &app) {
+        struct can_frame out{};
+        for (std::size_t i = 0; i < kTransferFrames; ++i) {
+            io.inject_udp(5555, segment_wire.data(), segment_wire.size());
+            app.poll_once(0);
+            io.pop_can_tx("vcan0", out);
+        }
+    });
+    run_transfers("udp_to_can/pdu", [&](LoopbackIoBackend &io, BridgeApp &app) {
+        std::vector<std::uint8_t> pdu;
+        io.inject_udp(5555, pdu_wire.data(), pdu_wire.size());
+        app.poll_once(0);
+        io.pop_isotp_tx("vcan0", link.tx_id, pdu);
+    });
+    run_transfers("can_to_udp/frames", [&](LoopbackIoBackend &io, BridgeApp &app) {
+        std::vector<std::uint8_t> datagram;
+        for (std::size_t i = 0; i < kTransferFrames; ++i) {
+            io.inject_can("vcan0", segment);
+        }
+        app.poll_once(0);
+        while (io.pop_udp_tx(5555, datagram)) {
+        }
+    });
+    run_transfers("can_to_udp/pdu", [&](LoopbackIoBackend &io, BridgeApp &app) {
+        std::vector<std::uint8_t> datagram;
+        io.inject_isotp("vcan0", link.rx_id, payload.data(), payload.size());
+        app.poll_once(0);
+        io.pop_udp_tx(5555, datagram);
+    });
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    BenchRunner runner(argc, argv);
+    runner.print_header();
+    register_codec_benchmarks(runner);
+    register_routing_benchmarks(runner);
+    register_rate_limiter_benchmarks(runner);
+    register_layout_benchmarks(runner);
+    register_loopback_benchmarks(runner);
+    return 0;
+}
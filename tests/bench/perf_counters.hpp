@@ -0,0 +1,104 @@
+#pragma once
+
+// Thin perf_event_open wrapper for the benchmarks. Every counter is optional:
+// containers and locked-down hosts (perf_event_paranoid > 2) simply report the
+// counter as unavailable and the benchmark falls back to wall-clock numbers.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+enum class PerfEvent : std::size_t {
+    Instructions = 0,
+    Cycles,
+    L1dReadMisses,
+    LlcReadMisses,
+    Count,
+};
+
+class PerfCounters {
+public:
+    PerfCounters() {
+        fds_.fill(-1);
+        open_hw(PerfEvent::Instructions, PERF_COUNT_HW_INSTRUCTIONS);
+        open_hw(PerfEvent::Cycles, PERF_COUNT_HW_CPU_CYCLES);
+        open_cache(PerfEvent::L1dReadMisses, PERF_COUNT_HW_CACHE_L1D);
+        open_cache(PerfEvent::LlcReadMisses, PERF_COUNT_HW_CACHE_LL);
+    }
+
+    ~PerfCounters() {
+        for (int &fd : fds_) {
+            if (fd >= 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    bool available(PerfEvent event) const { return fds_[index(event)] >= 0; }
+
+    void start() {
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+
+    void stop() {
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+    }
+
+    // Returns the raw count, or -1 when the counter could not be opened.
+    std::int64_t read_value(PerfEvent event) const {
+        const int fd = fds_[index(event)];
+        if (fd < 0) {
+            return -1;
+        }
+        std::uint64_t value = 0;
+        if (::read(fd, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) {
+            return -1;
+        }
+        return static_cast<std::int64_t>(value);
+    }
+
+private:
+    static constexpr std::size_t index(PerfEvent event) { return static_cast<std::size_t>(event); }
+
+    void open_event(PerfEvent event, std::uint32_t type, std::uint64_t config) {
+        perf_event_attr attr{};
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        const long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        fds_[index(event)] = fd >= 0 ? static_cast<int>(fd) : -1;
+    }
+
+    void open_hw(PerfEvent event, std::uint64_t config) { open_event(event, PERF_TYPE_HARDWARE, config); }
+
+    void open_cache(PerfEvent event, std::uint64_t cache) {
+        const std::uint64_t config = cache | (PERF_COUNT_HW_CACHE_OP_READ << 8U) |
+                                     (PERF_COUNT_HW_CACHE_RESULT_MISS << 16U);
+        open_event(event, PERF_TYPE_HW_CACHE, config);
+    }
+
+    std::array<int, static_cast<std::size_t>(PerfEvent::Count)> fds_{};
+};
@@ -1,15 +1,39 @@
+#include "bridge.hpp"
+#include "candump_log.hpp"
+#include "capture.hpp"
+#include "can_link_setup.hpp"
+#include "change_filter.hpp"
 #include "config.hpp"
+#include "egress_queue.hpp"
+#include "loopback_io_backend.hpp"
+#include "rate_limiter.hpp"
+#include "replay.hpp"
 #include "protocol.hpp"
+#include "routing.hpp"
+#include "sequence_tracker.hpp"
+#include "tx_echo_filter.hpp"
+#include "tx_pacer.hpp"
+#include "udp_filter.hpp"
+#include "xdp_ingress.hpp"
 
+#include <algorithm>
+#include <array>
+#include <arpa/inet.h>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
+#include <csignal>
 #include <cstring>
 #include <fstream>
 #include <limits>
 #include <linux/can.h>
+#include <poll.h>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <thread>
 #include <unistd.h>
 #include <vector>
 
@@ -195,6 +219,2351 @@ bool test_decode_rejects_large_dlc() {
     return true;
 }
 
+bool test_routing_lookup_boundaries() {
+    constexpr const char *kTestName = "routing_lookup_boundaries";
+    RangeLookup table[3]{};
+    table[0].range = {0x300, 0x37F};
+    table[0].channel_index = 2;
+    table[1].range = {0x100, 0x1FF};
+    table[1].channel_index = 0;
+    table[2].range = {0x200, 0x2FF};
+    table[2].channel_index = 1;
+    sort_range_lookup(table, 3);
+
+    expect_true(find_channel_for_can_id(table, 3, 0x0FF) == kInvalidChannelIndex, kTestName, "id below first range");
+    expect_true(find_channel_for_can_id(table, 3, 0x100) == 0, kTestName, "range min not inclusive");
+    expect_true(find_channel_for_can_id(table, 3, 0x2FF) == 1, kTestName, "range max not inclusive");
+    expect_true(find_channel_for_can_id(table, 3, 0x37F) == 2, kTestName, "last range lookup failed");
+    expect_true(find_channel_for_can_id(table, 3, 0x380) == kInvalidChannelIndex, kTestName, "id above last range");
+    expect_true(find_channel_for_can_id(table, 0, 0x100) == kInvalidChannelIndex, kTestName, "empty table lookup");
+
+    struct can_frame frame{};
+    frame.can_id = 0x1ABCDE00 | CAN_EFF_FLAG | CAN_RTR_FLAG;
+    expect_true(extract_identifier(frame) == 0x1ABCDE00, kTestName, "extended identifier mismatch");
+    frame.can_id = 0x7FF | CAN_RTR_FLAG;
+    expect_true(extract_identifier(frame) == 0x7FF, kTestName, "standard identifier mismatch");
+    return true;
+}
+
+BridgeConfig make_loopback_config() {
+    BridgeConfig cfg{};
+    cfg.server.ip = "127.0.0.1";
+
+    PortConfig port0{};
+    port0.listen_port = 5555;
+    port0.send_port = 5556;
+    ChannelConfig vcan0{};
+    vcan0.vcan_name = "vcan0";
+    vcan0.tx_channel_id = 0;
+    vcan0.id_range = {0x100, 0x1FF};
+    vcan0.bitrate = 500000;
+    ChannelConfig vcan1{};
+    vcan1.vcan_name = "vcan1";
+    vcan1.tx_channel_id = 1;
+    vcan1.id_range = {0x200, 0x2FF};
+    vcan1.bitrate = 500000;
+    port0.channels = {vcan0, vcan1};
+
+    PortConfig port1{};
+    port1.listen_port = 5565;
+    port1.send_port = 5566;
+    ChannelConfig vcan2{};
+    vcan2.vcan_name = "vcan2";
+    vcan2.tx_channel_id = 2;
+    vcan2.id_range = {0x300, 0x37F};
+    vcan2.bitrate = 250000;
+    port1.channels = {vcan2};
+
+    cfg.ports = {port0, port1};
+    return cfg;
+}
+
+void add_loopback_interfaces(LoopbackIoBackend &io) {
+    io.add_interface("vcan0");
+    io.add_interface("vcan1");
+    io.add_interface("vcan2");
+}
+
+std::vector<std::uint8_t> encode_frames(const std::vector<struct can_frame> &frames) {
+    std::vector<std::uint8_t> wire(frames.size() * kUdpFrameSize);
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+        encode_udp_frame(frames[i], wire.data() + i * kUdpFrameSize);
+    }
+    return wire;
+}
+
+struct can_frame make_frame(std::uint32_t can_id, std::uint8_t dlc, std::uint8_t fill) {
+    struct can_frame frame{};
+    frame.can_id = can_id;
+    frame.can_dlc = dlc;
+    std::memset(frame.data, fill, dlc);
+    return frame;
+}
+
+bool test_bridge_requires_existing_interfaces() {
+    constexpr const char *kTestName = "bridge_requires_existing_interfaces";
+    LoopbackIoBackend io;
+    io.add_interface("vcan0");
+    BridgeApp app(make_loopback_config(), io);
+    expect_true(!app.initialize(), kTestName, "initialize should fail when vcan1/vcan2 are missing");
+    return true;
+}
+
+bool test_bridge_udp_to_can_routing() {
+    constexpr const char *kTestName = "bridge_udp_to_can_routing";
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(make_loopback_config(), io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    // One datagram carrying a batch: two routable frames, one for another port, one unmapped.
+    const std::vector<std::uint8_t> wire = encode_frames({make_frame(0x123, 8, 0x11),
+                                                          make_frame(0x234, 2, 0x22),
+                                                          make_frame(0x300, 1, 0x33),
+                                                          make_frame(0x7FF, 0, 0x00)});
+    expect_true(io.inject_udp(5555, wire.data(), wire.size()), kTestName, "inject failed");
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+
+    struct can_frame out{};
+    expect_true(io.pop_can_tx("vcan0", out) && out.can_id == 0x123 && out.can_dlc == 8 && out.data[7] == 0x11,
+                kTestName,
+                "vcan0 did not receive 0x123");
+    expect_true(io.pop_can_tx("vcan1", out) && out.can_id == 0x234 && out.can_dlc == 2, kTestName, "vcan1 did not receive 0x234");
+    expect_true(io.can_tx_pending("vcan2") == 0, kTestName, "frame for another port must not be forwarded");
+    expect_true(app.port_stats(0).udp_rx_datagrams == 1, kTestName, "datagram count mismatch");
+    expect_true(app.port_stats(0).udp_rx_frames == 4, kTestName, "decoded frame count mismatch");
+    expect_true(app.port_stats(0).udp_rx_unroutable == 2, kTestName, "unroutable count mismatch");
+    return true;
+}
+
+bool test_bridge_can_to_udp_forwarding() {
+    constexpr const char *kTestName = "bridge_can_to_udp_forwarding";
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(make_loopback_config(), io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    for (std::uint8_t i = 0; i < 5; ++i) {
+        io.inject_can("vcan2", make_frame(0x1ABCDE00U | CAN_EFF_FLAG, 3, i));
+    }
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+
+    expect_true(io.udp_tx_pending(5565) == 5, kTestName, "expected five datagrams on port 5565");
+    std::vector<std::uint8_t> datagram;
+    sockaddr_in destination{};
+    expect_true(io.pop_udp_tx(5565, datagram, &destination), kTestName, "no datagram emitted");
+    expect_true(datagram.size() == kUdpFrameSize, kTestName, "datagram size mismatch");
+    expect_true(ntohs(destination.sin_port) == 5566, kTestName, "datagram sent to wrong port");
+    struct can_frame decoded{};
+    expect_true(decode_udp_frame(datagram.data(), decoded) && decoded.can_id == (0x1ABCDE00U | CAN_EFF_FLAG),
+                kTestName,
+                "forwarded frame mismatch");
+    expect_true(app.channel_stats(2).can_rx_frames == 5, kTestName, "channel rx count mismatch");
+    expect_true(app.port_stats(1).udp_tx_frames == 5, kTestName, "port tx count mismatch");
+    return true;
+}
+
+bool test_bridge_can_backpressure_drops_rest_of_datagram() {
+    constexpr const char *kTestName = "bridge_can_backpressure_drops_rest_of_datagram";
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    io.set_can_tx_capacity("vcan0", 2);
+    BridgeApp app(make_loopback_config(), io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    std::vector<struct can_frame> frames;
+    for (std::uint8_t i = 0; i < 5; ++i) {
+        frames.push_back(make_frame(0x100U + i, 1, i));
+    }
+    const std::vector<std::uint8_t> wire = encode_frames(frames);
+    io.inject_udp(5555, wire.data(), wire.size());
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+
+    expect_true(io.can_tx_pending("vcan0") == 2, kTestName, "queue should hold exactly its capacity");
+    expect_true(app.channel_stats(0).can_tx_frames == 2, kTestName, "tx count mismatch");
+    expect_true(app.channel_stats(0).can_tx_dropped == 3, kTestName, "dropped count mismatch");
+
+    // Once the bus drains the bridge must keep forwarding new datagrams.
+    struct can_frame out{};
+    while (io.pop_can_tx("vcan0", out)) {
+    }
+    io.inject_udp(5555, wire.data(), kUdpFrameSize);
+    expect_true(app.poll_once(0), kTestName, "second poll failed");
+    expect_true(io.can_tx_pending("vcan0") == 1, kTestName, "bridge did not recover after backpressure");
+    return true;
+}
+
+bool test_bridge_supports_many_channels() {
+    constexpr const char *kTestName = "bridge_supports_many_channels";
+    constexpr std::size_t kChannels = 72;
+
+    BridgeConfig cfg{};
+    cfg.server.ip = "127.0.0.1";
+    LoopbackIoBackend io;
+    for (std::size_t p = 0; p < 12; ++p) {
+        PortConfig port{};
+        port.listen_port = static_cast<std::uint16_t>(6000 + p * 2);
+        port.send_port = static_cast<std::uint16_t>(6001 + p * 2);
+        for (std::size_t c = 0; c < kChannels / 12; ++c) {
+            const std::size_t index = p * (kChannels / 12) + c;
+            ChannelConfig channel{};
+            channel.vcan_name = "vcan" + std::to_string(index);
+            channel.tx_channel_id = static_cast<std::uint32_t>(index);
+            channel.id_range.min = static_cast<std::uint32_t>(index) * 0x10U;
+            channel.id_range.max = channel.id_range.min + 0x0FU;
+            channel.bitrate = 500000;
+            io.add_interface(channel.vcan_name);
+            port.channels.push_back(channel);
+        }
+        cfg.ports.push_back(port);
+    }
+
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed for 72 channels / 12 ports");
+    expect_true(app.channel_count() == kChannels, kTestName, "channel count mismatch");
+    expect_true(app.port_count() == 12, kTestName, "port count mismatch");
+
+    // Last channel lives on the last port.
+    const std::vector<std::uint8_t> wire = encode_frames({make_frame(0x475, 1, 0xAB)});
+    io.inject_udp(6022, wire.data(), wire.size());
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+    struct can_frame out{};
+    expect_true(io.pop_can_tx("vcan71", out) && out.can_id == 0x475, kTestName, "frame not routed to vcan71");
+    return true;
+}
+
+bool test_change_filter_config_parses() {
+    constexpr const char *kTestName = "change_filter_config_parses";
+    const char json[] = R"JSON(
+{
+  "server": { "ip": "10.0.0.5" },
+  "ports": [
+    {
+      "udp_listen_port": 5555,
+      "channels": [
+        {
+          "vcan_name": "vcan0",
+          "tx_channel_id": 0,
+          "id_range": { "min": "0x100", "max": "0x1FF" },
+          "bitrate": 500000,
+          "change_filter": { "refresh_interval_ms": 250, "eff_capacity": 100 }
+        },
+        {
+          "vcan_name": "vcan1",
+          "tx_channel_id": 1,
+          "id_range": { "min": "0x200", "max": "0x2FF" },
+          "bitrate": 500000
+        }
+      ]
+    }
+  ]
+}
+)JSON";
+    const std::string file_path = write_temp_file(json);
+
+    BridgeConfig cfg{};
+    std::string error;
+    const bool ok = load_bridge_config(file_path, cfg, error);
+    remove_file(file_path);
+
+    expect_true(ok, kTestName, error.c_str());
+    expect_true(ok && cfg.ports[0].channels[0].change_filter.enabled, kTestName, "change filter should be enabled");
+    expect_true(ok && cfg.ports[0].channels[0].change_filter.refresh_interval_ms == 250, kTestName, "refresh mismatch");
+    expect_true(ok && cfg.ports[0].channels[0].change_filter.eff_capacity == 100, kTestName, "capacity mismatch");
+    expect_true(ok && !cfg.ports[0].channels[1].change_filter.enabled, kTestName, "filter must default to off");
+    return true;
+}
+
+bool test_last_value_cache_suppresses_unchanged() {
+    constexpr const char *kTestName = "last_value_cache_suppresses_unchanged";
+    ChangeFilterConfig cfg{};
+    cfg.enabled = true;
+    cfg.refresh_interval_ms = 100;
+    cfg.eff_capacity = 16;
+    LastValueCache cache;
+    expect_true(cache.initialize(cfg), kTestName, "initialize failed");
+
+    constexpr std::uint64_t kMs = 1000000ULL;
+    struct can_frame frame = make_frame(0x123, 4, 0xAA);
+    expect_true(cache.should_forward(frame, 0), kTestName, "first frame must pass");
+    expect_true(!cache.should_forward(frame, 10 * kMs), kTestName, "unchanged frame must be suppressed");
+    frame.data[3] = 0xAB;
+    expect_true(cache.should_forward(frame, 20 * kMs), kTestName, "payload change must pass");
+    frame.can_dlc = 3;
+    expect_true(cache.should_forward(frame, 30 * kMs), kTestName, "DLC change must pass");
+    expect_true(!cache.should_forward(frame, 40 * kMs), kTestName, "repeat after DLC change must be suppressed");
+    expect_true(cache.should_forward(frame, 130 * kMs), kTestName, "forced refresh must pass");
+    expect_true(!cache.should_forward(frame, 140 * kMs), kTestName, "refresh restarts the interval");
+
+    struct can_frame other = make_frame(0x124, 4, 0xAA);
+    expect_true(cache.should_forward(other, 140 * kMs), kTestName, "IDs are cached independently");
+
+    struct can_frame rtr = make_frame(0x123 | CAN_RTR_FLAG, 0, 0);
+    expect_true(cache.should_forward(rtr, 150 * kMs) && cache.should_forward(rtr, 151 * kMs), kTestName, "RTR always passes");
+
+    // Same 11-bit value as an extended ID must not alias the SFF entry.
+    struct can_frame eff = make_frame(0x123 | CAN_EFF_FLAG, 3, 0xAA);
+    eff.data[3] = 0;
+    expect_true(cache.should_forward(eff, 160 * kMs), kTestName, "EFF frame aliased SFF entry");
+    expect_true(!cache.should_forward(eff, 161 * kMs), kTestName, "unchanged EFF frame must be suppressed");
+    return true;
+}
+
+bool test_last_value_cache_eff_overflow_forwards() {
+    constexpr const char *kTestName = "last_value_cache_eff_overflow_forwards";
+    ChangeFilterConfig cfg{};
+    cfg.enabled = true;
+    cfg.refresh_interval_ms = 0;
+    cfg.eff_capacity = 4;
+    LastValueCache cache;
+    cache.initialize(cfg);
+
+    for (std::uint32_t id = 0; id < 64; ++id) {
+        cache.should_forward(make_frame((0x18FF0000U + id) | CAN_EFF_FLAG, 8, 1), 0);
+    }
+    std::size_t forwarded = 0;
+    for (std::uint32_t id = 0; id < 64; ++id) {
+        forwarded += cache.should_forward(make_frame((0x18FF0000U + id) | CAN_EFF_FLAG, 8, 1), 1) ? 1 : 0;
+    }
+    expect_true(forwarded == 60, kTestName, "uncached EFF IDs must keep flowing, cached ones be suppressed");
+    expect_true(cache.eff_overflows() > 0, kTestName, "overflow counter not incremented");
+    return true;
+}
+
+bool test_bridge_change_only_forwarding() {
+    constexpr const char *kTestName = "bridge_change_only_forwarding";
+    BridgeConfig cfg = make_loopback_config();
+    cfg.ports[1].channels[0].change_filter.enabled = true;
+    cfg.ports[1].channels[0].change_filter.refresh_interval_ms = 60000;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    for (int i = 0; i < 10; ++i) {
+        io.inject_can("vcan2", make_frame(0x310, 8, 0x55));
+    }
+    io.inject_can("vcan2", make_frame(0x310, 8, 0x56));
+    // Unfiltered channel on the other port still forwards everything.
+    io.inject_can("vcan0", make_frame(0x110, 8, 0x55));
+    io.inject_can("vcan0", make_frame(0x110, 8, 0x55));
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+
+    expect_true(io.udp_tx_pending(5565) == 2, kTestName, "expected first frame and the change only");
+    expect_true(app.channel_stats(2).can_rx_suppressed == 9, kTestName, "suppressed count mismatch");
+    expect_true(io.udp_tx_pending(5555) == 2, kTestName, "unfiltered channel must not suppress");
+    return true;
+}
+
+bool test_rate_limit_config_parses() {
+    constexpr const char *kTestName = "rate_limit_config_parses";
+    const std::string base = R"JSON(
+{
+  "server": { "ip": "10.0.0.5" },
+  "ports": [
+    {
+      "udp_listen_port": 5555,
+      "channels": [
+        { "vcan_name": "vcan0", "tx_channel_id": 0, "id_range": { "min": "0x100", "max": "0x1FF" }, "bitrate": 500000 }
+      ]
+    }
+  ],
+  "rate_limits": RULES
+}
+)JSON";
+    const auto load_with = [&](const std::string &rules, BridgeConfig &cfg, std::string &error) {
+        std::string json = base;
+        json.replace(json.find("RULES"), 5, rules);
+        const std::string file_path = write_temp_file(json);
+        const bool ok = load_bridge_config(file_path, cfg, error);
+        remove_file(file_path);
+        return ok;
+    };
+
+    BridgeConfig cfg{};
+    std::string error;
+    const bool ok = load_with(R"([
+        { "id": "0x123", "max_rate_hz": 100, "burst": 5 },
+        { "id_range": { "min": "0x400", "max": "0x4FF" }, "decimate": 10, "direction": "can_to_udp" },
+        { "id_range": { "min": "0x400", "max": "0x4FF" }, "max_rate_hz": 50, "direction": "udp_to_can" }
+    ])",
+                              cfg,
+                              error);
+    expect_true(ok, kTestName, error.c_str());
+    expect_true(ok && cfg.rate_limits.size() == 3, kTestName, "rule count mismatch");
+    expect_true(ok && cfg.rate_limits[0].id_range.min == 0x123 && cfg.rate_limits[0].id_range.max == 0x123,
+                kTestName,
+                "single id rule mismatch");
+    expect_true(ok && cfg.rate_limits[1].decimate == 10 && cfg.rate_limits[1].direction == RateLimitDirection::CanToUdp,
+                kTestName,
+                "range rule mismatch");
+
+    BridgeConfig bad{};
+    expect_true(!load_with(R"([{ "id": "0x123", "max_rate_hz": 10 }, { "id_range": { "min": "0x100", "max": "0x1FF" }, "decimate": 2 }])",
+                           bad,
+                           error),
+                kTestName,
+                "overlapping rules in the same direction must fail");
+    expect_true(!load_with(R"([{ "id": "0x123" }])", bad, error), kTestName, "rule without a limit must fail");
+    return true;
+}
+
+bool test_rate_limiter_token_bucket_and_decimation() {
+    constexpr const char *kTestName = "rate_limiter_token_bucket_and_decimation";
+    std::vector<RateLimitRule> rules(4);
+    rules[0].id_range = {0x123, 0x123};
+    rules[0].max_rate_hz = 100; // one frame per 10 ms
+    rules[0].burst = 3;
+    rules[1].id_range = {0x400, 0x4FF};
+    rules[1].decimate = 4;
+    rules[1].direction = RateLimitDirection::CanToUdp;
+    rules[2].id_range = {0x18FF0010, 0x18FF0010};
+    rules[2].decimate = 2;
+    rules[3].id_range = {0x700, 0x1000};
+    rules[3].max_rate_hz = 1;
+    RateLimiter limiter;
+    expect_true(limiter.initialize(rules), kTestName, "initialize failed");
+
+    constexpr std::uint64_t kMs = 1000000ULL;
+    std::size_t passed = 0;
+    for (int i = 0; i < 10; ++i) {
+        passed += limiter.allow(FlowDirection::UdpToCan, 0x123, 1000 * kMs) ? 1 : 0;
+    }
+    expect_true(passed == 3, kTestName, "burst of 3 expected");
+    expect_true(!limiter.allow(FlowDirection::UdpToCan, 0x123, 1005 * kMs), kTestName, "bucket refilled too early");
+    expect_true(limiter.allow(FlowDirection::UdpToCan, 0x123, 1030 * kMs), kTestName, "bucket did not refill");
+    expect_true(limiter.allow(FlowDirection::CanToUdp, 0x123, 1000 * kMs), kTestName, "directions must not share a bucket");
+    expect_true(limiter.rule_stats(0).dropped_rate == 8, kTestName, "rate drop count mismatch");
+
+    passed = 0;
+    for (std::uint32_t i = 0; i < 16; ++i) {
+        passed += limiter.allow(FlowDirection::CanToUdp, 0x400 + i, 0) ? 1 : 0;
+    }
+    expect_true(passed == 4, kTestName, "decimate 4 should keep 4 of 16");
+    expect_true(limiter.rule_stats(1).dropped_decimation == 12, kTestName, "decimation drop count mismatch");
+    expect_true(limiter.allow(FlowDirection::UdpToCan, 0x400, 0) && limiter.allow(FlowDirection::UdpToCan, 0x400, 0),
+                kTestName,
+                "can_to_udp rule must not apply to udp_to_can");
+
+    expect_true(limiter.allow(FlowDirection::CanToUdp, 0x18FF0010, 0), kTestName, "EFF exact rule first frame");
+    expect_true(!limiter.allow(FlowDirection::CanToUdp, 0x18FF0010, 0), kTestName, "EFF exact rule decimation");
+    expect_true(limiter.allow(FlowDirection::CanToUdp, 0x18FF0011, 0), kTestName, "unlisted EFF id must pass");
+
+    // Rule spanning the direct table and the range list shares one bucket.
+    expect_true(limiter.allow(FlowDirection::CanToUdp, 0x7FF, 0), kTestName, "range rule first frame");
+    expect_true(!limiter.allow(FlowDirection::CanToUdp, 0x800, 0), kTestName, "range rule bucket not shared");
+    expect_true(limiter.allow(FlowDirection::CanToUdp, 0x1001, 0), kTestName, "id after range must pass");
+    return true;
+}
+
+bool test_bridge_rate_limits_both_directions() {
+    constexpr const char *kTestName = "bridge_rate_limits_both_directions";
+    BridgeConfig cfg = make_loopback_config();
+    RateLimitRule rule{};
+    rule.id_range = {0x120, 0x120};
+    rule.decimate = 5;
+    cfg.rate_limits.push_back(rule);
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    std::vector<struct can_frame> frames;
+    for (int i = 0; i < 10; ++i) {
+        frames.push_back(make_frame(0x120, 1, static_cast<std::uint8_t>(i)));
+        frames.push_back(make_frame(0x121, 1, static_cast<std::uint8_t>(i)));
+    }
+    const std::vector<std::uint8_t> wire = encode_frames(frames);
+    io.inject_udp(5555, wire.data(), wire.size());
+    for (const auto &frame : frames) {
+        io.inject_can("vcan0", frame);
+    }
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+
+    expect_true(io.can_tx_pending("vcan0") == 12, kTestName, "UDP->CAN should keep 2 of 10 limited + 10 others");
+    expect_true(io.udp_tx_pending(5555) == 12, kTestName, "CAN->UDP should keep 2 of 10 limited + 10 others");
+    expect_true(app.port_stats(0).udp_rx_rate_limited == 8, kTestName, "port rate-limited count mismatch");
+    expect_true(app.channel_stats(0).can_rx_rate_limited == 8, kTestName, "channel rate-limited count mismatch");
+    expect_true(app.rate_limiter().rule_stats(0).dropped_decimation == 16, kTestName, "rule stats mismatch");
+    return true;
+}
+
+bool test_egress_queue_priority_order() {
+    constexpr const char *kTestName = "egress_queue_priority_order";
+    EgressQueue queue;
+    expect_true(queue.initialize(6, true), kTestName, "initialize failed");
+
+    queue.push(make_frame(0x7FF, 0, 0));
+    queue.push(make_frame((0x123U << 18U) | 0x5U | CAN_EFF_FLAG, 0, 0)); // same base ID as 0x123, extended
+    queue.push(make_frame(0x123, 1, 1));
+    queue.push(make_frame(0x010, 0, 0));
+    queue.push(make_frame(0x123, 1, 2));
+    queue.push(make_frame(0x000U | CAN_EFF_FLAG, 0, 0));
+    expect_true(!queue.push(make_frame(0x001, 0, 0)), kTestName, "push beyond depth must fail");
+    expect_true(queue.size() == 6, kTestName, "size mismatch");
+
+    const std::uint32_t expected[] = {
+        0x000U | CAN_EFF_FLAG, 0x010, 0x123, 0x123, (0x123U << 18U) | 0x5U | CAN_EFF_FLAG, 0x7FF};
+    for (std::size_t i = 0; i < 6; ++i) {
+        expect_true(queue.front().can_id == expected[i], kTestName, "frames left out of arbitration order");
+        if (i == 2) {
+            expect_true(queue.front().data[0] == 1, kTestName, "equal IDs must keep arrival order");
+        }
+        queue.pop();
+    }
+    expect_true(queue.empty(), kTestName, "queue should be empty");
+    expect_true(queue.push(make_frame(0x001, 0, 0)), kTestName, "nodes must be recycled");
+
+    EgressQueue fifo;
+    fifo.initialize(4, false);
+    fifo.push(make_frame(0x700, 0, 0));
+    fifo.push(make_frame(0x001, 0, 0));
+    expect_true(fifo.front().can_id == 0x700, kTestName, "FIFO mode must keep arrival order");
+    return true;
+}
+
+bool test_bridge_priority_egress_under_backpressure() {
+    constexpr const char *kTestName = "bridge_priority_egress_under_backpressure";
+    BridgeConfig cfg = make_loopback_config();
+    cfg.ports[0].channels[0].tx_queue.enabled = true;
+    cfg.ports[0].channels[0].tx_queue.depth = 3;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    io.set_can_tx_capacity("vcan0", 2);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    const std::vector<std::uint8_t> wire = encode_frames({make_frame(0x1F0, 0, 0),
+                                                          make_frame(0x1E0, 0, 0),
+                                                          make_frame(0x150, 0, 0),
+                                                          make_frame(0x1A0, 0, 0),
+                                                          make_frame(0x110, 0, 0),
+                                                          make_frame(0x100, 0, 0)});
+    io.inject_udp(5555, wire.data(), wire.size());
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+
+    const BridgeApp::ChannelStats &stats = app.channel_stats(0);
+    expect_true(stats.can_tx_frames == 2, kTestName, "two frames should go straight through");
+    expect_true(stats.can_tx_queued == 3 && stats.can_tx_dropped == 1, kTestName, "queue depth 3 should drop one frame");
+
+    struct can_frame out{};
+    while (io.pop_can_tx("vcan0", out)) {
+    }
+    expect_true(app.poll_once(0), kTestName, "drain poll failed");
+    expect_true(io.pop_can_tx("vcan0", out) && out.can_id == 0x110, kTestName, "lowest ID must drain first");
+    expect_true(io.pop_can_tx("vcan0", out) && out.can_id == 0x150, kTestName, "second lowest ID must drain next");
+    expect_true(app.poll_once(0), kTestName, "final drain poll failed");
+    expect_true(io.pop_can_tx("vcan0", out) && out.can_id == 0x1A0, kTestName, "last queued frame missing");
+    expect_true(app.channel_stats(0).can_tx_frames == 5, kTestName, "tx count after drain mismatch");
+
+    // Queue empty again: new frames go straight to the socket.
+    io.inject_udp(5555, wire.data(), kUdpFrameSize);
+    expect_true(app.poll_once(0), kTestName, "poll after drain failed");
+    expect_true(io.can_tx_pending("vcan0") == 1, kTestName, "direct write after drain failed");
+    return true;
+}
+
+bool test_bridge_egress_backs_off_on_enobufs() {
+    constexpr const char *kTestName = "bridge_egress_backs_off_on_enobufs";
+    BridgeConfig cfg = make_loopback_config();
+    cfg.ports[0].channels[0].tx_queue.enabled = true;
+    cfg.ports[0].channels[0].tx_queue.depth = 8;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    io.set_can_tx_capacity("vcan0", 1);
+    io.set_can_tx_error("vcan0", ENOBUFS);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    const std::vector<std::uint8_t> wire =
+        encode_frames({make_frame(0x110, 1, 1), make_frame(0x120, 1, 2), make_frame(0x130, 1, 3)});
+    io.inject_udp(5555, wire.data(), wire.size());
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+    expect_true(app.channel_stats(0).can_tx_frames == 1 && app.channel_stats(0).can_tx_queued == 2,
+                kTestName,
+                "frames past the full device queue must be queued");
+
+    // The socket stays writable; the queue is retried only after the
+    // back-off, not on every EPOLLOUT.
+    struct can_frame out{};
+    expect_true(io.pop_can_tx("vcan0", out), kTestName, "first frame missing");
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+    expect_true(io.can_tx_pending("vcan0") == 0, kTestName, "queue must not be retried before the back-off");
+
+    expect_true(app.poll_once(100), kTestName, "poll after back-off failed");
+    expect_true(io.pop_can_tx("vcan0", out) && out.can_id == 0x120, kTestName, "queue must drain after the back-off");
+    return true;
+}
+
+bool test_tx_pacing_config_parses() {
+    constexpr const char *kTestName = "tx_pacing_config_parses";
+    const char json[] = R"JSON(
+{
+  "server": { "ip": "10.0.0.5" },
+  "ports": [
+    {
+      "udp_listen_port": 5555,
+      "channels": [
+        {
+          "vcan_name": "vcan0",
+          "tx_channel_id": 0,
+          "id_range": { "min": "0x100", "max": "0x1FF" },
+          "bitrate": 250000,
+          "tx_pacing": { "bus_load_percent": 80, "burst_frames": 3 }
+        },
+        {
+          "vcan_name": "vcan1",
+          "tx_channel_id": 1,
+          "id_range": { "min": "0x200", "max": "0x2FF" },
+          "bitrate": 500000,
+          "tx_pacing": {},
+          "tx_queue": { "depth": 32 }
+        }
+      ]
+    }
+  ]
+}
+)JSON";
+    const std::string file_path = write_temp_file(json);
+
+    BridgeConfig cfg{};
+    std::string error;
+    const bool ok = load_bridge_config(file_path, cfg, error);
+    remove_file(file_path);
+
+    expect_true(ok, kTestName, error.c_str());
+    if (!ok) {
+        return false;
+    }
+    const ChannelConfig &first = cfg.ports[0].channels[0];
+    expect_true(first.tx_pacing.enabled && first.tx_pacing.bus_load_percent == 80 && first.tx_pacing.burst_frames == 3,
+                kTestName,
+                "pacing fields mismatch");
+    expect_true(first.tx_queue.enabled && !first.tx_queue.priority, kTestName, "pacing must imply a FIFO queue");
+    const ChannelConfig &second = cfg.ports[0].channels[1];
+    expect_true(second.tx_queue.priority && second.tx_queue.depth == 32, kTestName, "explicit tx_queue must be kept");
+    return true;
+}
+
+bool test_tx_pacer_frame_time() {
+    constexpr const char *kTestName = "tx_pacer_frame_time";
+    expect_true(can_frame_wire_bits(make_frame(0x123, 8, 0)) == 135, kTestName, "SFF 8-byte worst case must be 135 bits");
+    expect_true(can_frame_wire_bits(make_frame(0x123U | CAN_EFF_FLAG, 8, 0)) == 160,
+                kTestName,
+                "EFF 8-byte worst case must be 160 bits");
+    expect_true(can_frame_wire_bits(make_frame(0x123, 0, 0)) == 55, kTestName, "SFF empty frame must be 55 bits");
+    expect_true(can_frame_wire_bits(make_frame(0x123U | CAN_RTR_FLAG, 8, 0)) == 55,
+                kTestName,
+                "RTR frames carry no data field");
+
+    TxPacer pacer;
+    expect_true(pacer.initialize(500000, 50, 1), kTestName, "initialize failed");
+    const struct can_frame frame = make_frame(0x123, 8, 0);
+    // 135 bits at 500 kbit/s is 270 us; a 50 % load budget doubles it.
+    expect_true(pacer.frame_time_ns(frame) == 540000, kTestName, "frame time mismatch");
+    expect_true(pacer.ready(1000), kTestName, "idle bus must be ready");
+    pacer.commit(frame, 1000);
+    pacer.commit(frame, 1000);
+    expect_true(!pacer.ready(1000 + 540000), kTestName, "second frame still occupies the bus");
+    expect_true(pacer.next_release_ns() == 1000 + 2 * 540000, kTestName, "release time mismatch");
+    expect_true(pacer.ready(1000 + 2 * 540000), kTestName, "bus must be free after both frames");
+
+    TxPacer bursty;
+    bursty.initialize(500000, 100, 3);
+    bursty.commit(frame, 0);
+    bursty.commit(frame, 0);
+    expect_true(bursty.ready(0), kTestName, "burst of three must allow a third frame");
+    bursty.commit(frame, 0);
+    expect_true(!bursty.ready(0), kTestName, "fourth frame must wait");
+    return true;
+}
+
+bool test_bridge_tx_pacing_releases_at_bus_speed() {
+    constexpr const char *kTestName = "bridge_tx_pacing_releases_at_bus_speed";
+    BridgeConfig cfg = make_loopback_config();
+    ChannelConfig &channel = cfg.ports[0].channels[0];
+    channel.bitrate = 10000; // 55-bit empty frames take 5.5 ms each
+    channel.tx_pacing.enabled = true;
+    channel.tx_queue.enabled = true;
+    channel.tx_queue.priority = false;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<std::uint8_t> wire =
+        encode_frames({make_frame(0x101, 0, 0), make_frame(0x102, 0, 0), make_frame(0x103, 0, 0)});
+    io.inject_udp(5555, wire.data(), wire.size());
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+    expect_true(io.can_tx_pending("vcan0") == 1, kTestName, "only the first frame may go out immediately");
+    expect_true(app.channel_stats(0).can_tx_queued == 2, kTestName, "remaining frames must be queued");
+
+    for (int i = 0; i < 20 && io.can_tx_pending("vcan0") < 3; ++i) {
+        expect_true(app.poll_once(100), kTestName, "poll failed");
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    expect_true(io.can_tx_pending("vcan0") == 3, kTestName, "queued frames were not released");
+    expect_true(elapsed >= std::chrono::microseconds(11000), kTestName, "frames released faster than the bus");
+    struct can_frame out{};
+    expect_true(io.pop_can_tx("vcan0", out) && out.can_id == 0x101, kTestName, "FIFO order violated");
+    expect_true(io.pop_can_tx("vcan0", out) && out.can_id == 0x102, kTestName, "FIFO order violated");
+    expect_true(io.pop_can_tx("vcan0", out) && out.can_id == 0x103, kTestName, "FIFO order violated");
+    expect_true(app.channel_stats(0).can_tx_frames == 3, kTestName, "tx count mismatch");
+    return true;
+}
+
+bool test_can_link_setup_plan() {
+    constexpr const char *kTestName = "can_link_setup_plan";
+    std::vector<CanLinkSpec> specs(4);
+    specs[0].name = "vcan9"; // missing
+    specs[0].txqueuelen = 500;
+    specs[1].name = "can0"; // wrong bitrate, up
+    specs[1].bitrate = 500000;
+    specs[1].txqueuelen = 1000;
+    specs[2].name = "can1"; // matches
+    specs[2].bitrate = 250000;
+    specs[3].name = "vcan0"; // down, bitrate irrelevant for vcan
+    specs[3].bitrate = 500000;
+
+    std::vector<CanLinkState> links(3);
+    links[0].name = "can0";
+    links[0].ifindex = 4;
+    links[0].kind = "can";
+    links[0].up = true;
+    links[0].bitrate = 125000;
+    links[0].txqueuelen = 10;
+    links[1].name = "can1";
+    links[1].ifindex = 5;
+    links[1].kind = "can";
+    links[1].up = true;
+    links[1].bitrate = 250000;
+    links[2].name = "vcan0";
+    links[2].ifindex = 6;
+    links[2].kind = "vcan";
+
+    std::vector<CanLinkOp> ops;
+    plan_can_link_setup(specs, links, ops);
+    expect_true(ops.size() == 4, kTestName, "unexpected number of link messages");
+    if (ops.size() != 4) {
+        return false;
+    }
+    expect_true(ops[0].type == CanLinkOp::Type::CreateVcan && ops[0].spec_index == 0 && ops[0].txqueuelen == 500,
+                kTestName,
+                "missing interface must be created as vcan");
+    expect_true(ops[1].type == CanLinkOp::Type::SetDown && ops[1].ifindex == 4,
+                kTestName,
+                "bitrate change must take the link down first");
+    expect_true(ops[2].type == CanLinkOp::Type::Configure && ops[2].bitrate == 500000 && ops[2].txqueuelen == 1000,
+                kTestName,
+                "bitrate and txqueuelen must be applied together");
+    expect_true(ops[3].type == CanLinkOp::Type::Configure && ops[3].ifindex == 6 && ops[3].bitrate == 0,
+                kTestName,
+                "down vcan must only be brought up");
+    return true;
+}
+
+bool test_bridge_auto_setup_creates_interfaces() {
+    constexpr const char *kTestName = "bridge_auto_setup_creates_interfaces";
+    BridgeConfig cfg = make_loopback_config();
+    cfg.auto_setup_interfaces = true;
+    cfg.ports[0].channels[1].txqueuelen = 1000;
+    LoopbackIoBackend io; // no interfaces registered up front
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize must create the missing interfaces");
+    expect_true(io.link_setup().size() == 3, kTestName, "every channel must be part of one setup batch");
+    expect_true(io.link_setup().size() == 3 && io.link_setup()[1].txqueuelen == 1000,
+                kTestName,
+                "txqueuelen must be passed through");
+    expect_true(io.interface_exists("vcan2"), kTestName, "vcan2 missing after setup");
+    return true;
+}
+
+bool test_bridge_auto_setup_waits_for_udp_ports() {
+    constexpr const char *kTestName = "bridge_auto_setup_waits_for_udp_ports";
+    BridgeConfig cfg = make_loopback_config();
+    cfg.auto_setup_interfaces = true;
+    LoopbackIoBackend io;
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    const int taken = io.open_udp(6001);
+    expect_true(taken >= 0, kTestName, "could not occupy the port");
+    BridgeConfig next = cfg;
+    next.ports[0].listen_port = 6001;
+    next.ports[0].channels[0].txqueuelen = 500;
+    expect_true(!app.reload(next), kTestName, "reload onto a busy port must fail");
+    expect_true(io.link_setup().size() == 3 && io.link_setup()[0].txqueuelen == 0U,
+                kTestName,
+                "interfaces must not be touched when a UDP port is busy");
+    io.close_endpoint(taken);
+    return true;
+}
+
+bool test_bridge_reload_keeps_unchanged_sockets() {
+    constexpr const char *kTestName = "bridge_reload_keeps_unchanged_sockets";
+    const BridgeConfig cfg = make_loopback_config();
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    io.add_interface("vcan3");
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    const std::vector<std::uint8_t> first = encode_frames({make_frame(0x120, 1, 1)});
+    io.inject_udp(5555, first.data(), first.size());
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+    const std::size_t endpoints_before = io.open_endpoint_count();
+
+    // Traffic that is in flight while the reload happens.
+    io.inject_can("vcan0", make_frame(0x130, 2, 2));
+    const std::vector<std::uint8_t> pending = encode_frames({make_frame(0x140, 1, 3), make_frame(0x200, 1, 4)});
+    io.inject_udp(5555, pending.data(), pending.size());
+
+    BridgeConfig next = cfg;
+    next.ports[0].send_port = 5557;
+    next.ports[0].channels.erase(next.ports[0].channels.begin() + 1); // drop vcan1
+    ChannelConfig vcan3 = next.ports[1].channels[0];
+    vcan3.vcan_name = "vcan3";
+    vcan3.tx_channel_id = 3;
+    vcan3.id_range = {0x380, 0x3FF};
+    next.ports[1].channels.push_back(vcan3);
+    expect_true(app.reload(next), kTestName, "reload failed");
+    expect_true(app.channel_count() == 3, kTestName, "channel count after reload mismatch");
+    expect_true(io.open_endpoint_count() == endpoints_before, kTestName, "only vcan1 should close and vcan3 open");
+    expect_true(app.channel_stats(0).can_tx_frames == 1, kTestName, "vcan0 stats must survive the reload");
+
+    expect_true(app.poll_once(0), kTestName, "poll after reload failed");
+    struct can_frame out{};
+    expect_true(io.pop_can_tx("vcan0", out) && io.pop_can_tx("vcan0", out) && out.can_id == 0x140,
+                kTestName,
+                "datagram queued before the reload was lost");
+    expect_true(app.port_stats(0).udp_rx_unroutable == 1, kTestName, "removed channel must no longer route");
+    std::vector<std::uint8_t> datagram;
+    sockaddr_in destination{};
+    expect_true(io.pop_udp_tx(5555, datagram, &destination), kTestName, "CAN frame pending at reload was lost");
+    expect_true(ntohs(destination.sin_port) == 5557, kTestName, "send port change not applied");
+
+    const std::vector<std::uint8_t> routed = encode_frames({make_frame(0x390, 1, 5)});
+    io.inject_udp(5565, routed.data(), routed.size());
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+    expect_true(io.pop_can_tx("vcan3", out) && out.can_id == 0x390, kTestName, "added channel does not route");
+
+    BridgeConfig broken = app.config();
+    broken.ports[1].channels[1].vcan_name = "vcan9";
+    expect_true(!app.reload(broken), kTestName, "reload onto a missing interface must be rejected");
+    expect_true(app.channel_count() == 3 && io.open_endpoint_count() == endpoints_before,
+                kTestName,
+                "rejected reload must leave the bridge untouched");
+    io.inject_udp(5565, routed.data(), routed.size());
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+    expect_true(io.pop_can_tx("vcan3", out), kTestName, "bridge stopped routing after a rejected reload");
+    return true;
+}
+
+bool test_bridge_reload_on_sighup() {
+    constexpr const char *kTestName = "bridge_reload_on_sighup";
+    const char before[] = R"JSON(
+{
+  "server": { "ip": "127.0.0.1" },
+  "ports": [
+    {
+      "udp_listen_port": 5555,
+      "channels": [
+        { "vcan_name": "vcan0", "tx_channel_id": 0, "id_range": { "min": "0x100", "max": "0x1FF" }, "bitrate": 500000 }
+      ]
+    }
+  ]
+}
+)JSON";
+    const char after[] = R"JSON(
+{
+  "server": { "ip": "127.0.0.1" },
+  "ports": [
+    {
+      "udp_listen_port": 5555,
+      "channels": [
+        { "vcan_name": "vcan0", "tx_channel_id": 0, "id_range": { "min": "0x100", "max": "0x1FF" }, "bitrate": 500000 },
+        { "vcan_name": "vcan1", "tx_channel_id": 1, "id_range": { "min": "0x200", "max": "0x2FF" }, "bitrate": 500000 }
+      ]
+    }
+  ]
+}
+)JSON";
+    const std::string file_path = write_temp_file(before);
+    BridgeConfig cfg{};
+    std::string error;
+    expect_true(load_bridge_config(file_path, cfg, error), kTestName, error.c_str());
+
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    app.enable_reload(file_path);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+    expect_true(app.channel_count() == 1, kTestName, "initial channel count mismatch");
+
+    {
+        std::ofstream out(file_path, std::ios::trunc);
+        out << after;
+    }
+    kill(getpid(), SIGHUP);
+    for (int i = 0; i < 10 && app.channel_count() != 2; ++i) {
+        expect_true(app.poll_once(100), kTestName, "poll failed");
+    }
+    remove_file(file_path);
+    expect_true(app.channel_count() == 2, kTestName, "SIGHUP did not reload the config");
+    return true;
+}
+
+bool test_bridge_run_stops_without_polling_timeout() {
+    constexpr const char *kTestName = "bridge_run_stops_without_polling_timeout";
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(make_loopback_config(), io);
+    app.enable_signals();
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    // Stop from another thread: run() must wake immediately, not after a timeout.
+    auto start = std::chrono::steady_clock::now();
+    std::thread stopper([&app]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        app.request_stop();
+    });
+    app.run();
+    stopper.join();
+    expect_true(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500),
+                kTestName,
+                "request_stop did not wake the loop");
+
+    // SIGTERM arrives through the signalfd.
+    expect_true(app.initialize(), kTestName, "re-initialize failed");
+    start = std::chrono::steady_clock::now();
+    std::thread signaller([]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        kill(getpid(), SIGTERM);
+    });
+    app.run();
+    signaller.join();
+    expect_true(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500),
+                kTestName,
+                "SIGTERM did not stop the loop");
+    return true;
+}
+
+bool test_timestamped_frame_roundtrip() {
+    constexpr const char *kTestName = "timestamped_frame_roundtrip";
+    const struct can_frame frame = make_frame(0x1234567U | CAN_EFF_FLAG, 5, 0xA5);
+    const std::uint64_t timestamp_ns = 0x0123456789ABCDEFULL;
+    std::uint8_t buffer[kTimestampedFrameSize] = {};
+    expect_true(encode_timestamped_frame(frame, timestamp_ns, buffer), kTestName, "encode failed");
+    expect_true(buffer[kUdpFrameSize] == 0x01 && buffer[kTimestampedFrameSize - 1] == 0xEF,
+                kTestName,
+                "timestamp must be big-endian after the frame");
+
+    struct can_frame decoded{};
+    std::uint64_t decoded_ns = 0;
+    expect_true(decode_timestamped_frame(buffer, decoded, decoded_ns), kTestName, "decode failed");
+    expect_true(decoded.can_id == frame.can_id && decoded.can_dlc == 5 && decoded.data[4] == 0xA5,
+                kTestName,
+                "frame mismatch");
+    expect_true(decoded_ns == timestamp_ns, kTestName, "timestamp mismatch");
+    return true;
+}
+
+bool test_frame_format_config_parses() {
+    constexpr const char *kTestName = "frame_format_config_parses";
+    const char json[] = R"JSON(
+{
+  "server": { "ip": "10.0.0.5" },
+  "ports": [
+    {
+      "udp_listen_port": 5555,
+      "frame_format": "timestamped",
+      "scheduled_tx": true,
+      "channels": [
+        { "vcan_name": "vcan0", "tx_channel_id": 0, "id_range": { "min": "0x100", "max": "0x1FF" }, "bitrate": 500000 }
+      ]
+    },
+    {
+      "udp_listen_port": 5565,
+      "sequence_header": true,
+      "channels": [
+        { "vcan_name": "vcan1", "tx_channel_id": 1, "id_range": { "min": "0x200", "max": "0x2FF" }, "bitrate": 500000 }
+      ]
+    }
+  ]
+}
+)JSON";
+    const std::string file_path = write_temp_file(json);
+    BridgeConfig cfg{};
+    std::string error;
+    const bool ok = load_bridge_config(file_path, cfg, error);
+    remove_file(file_path);
+    expect_true(ok, kTestName, error.c_str());
+    if (!ok) {
+        return false;
+    }
+    expect_true(cfg.ports[0].frame_format == FrameFormat::Timestamped && cfg.ports[0].scheduled_tx,
+                kTestName,
+                "timestamped port fields mismatch");
+    expect_true(cfg.ports[1].frame_format == FrameFormat::Standard && !cfg.ports[1].scheduled_tx,
+                kTestName,
+                "standard format must be the default");
+    expect_true(!cfg.ports[0].sequence_header && cfg.ports[1].sequence_header,
+                kTestName,
+                "sequence_header mismatch");
+
+    const char bad_json[] = R"JSON(
+{
+  "server": { "ip": "10.0.0.5" },
+  "ports": [
+    {
+      "udp_listen_port": 5555,
+      "scheduled_tx": true,
+      "channels": [
+        { "vcan_name": "vcan0", "tx_channel_id": 0, "id_range": { "min": "0x100", "max": "0x1FF" }, "bitrate": 500000 }
+      ]
+    }
+  ]
+}
+)JSON";
+    const std::string bad_path = write_temp_file(bad_json);
+    const bool bad_ok = load_bridge_config(bad_path, cfg, error);
+    remove_file(bad_path);
+    expect_true(!bad_ok, kTestName, "scheduled_tx without timestamped format must fail");
+    return true;
+}
+
+bool test_bridge_timestamped_can_to_udp() {
+    constexpr const char *kTestName = "bridge_timestamped_can_to_udp";
+    BridgeConfig cfg = make_loopback_config();
+    cfg.ports[1].frame_format = FrameFormat::Timestamped;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    const std::uint64_t rx_time_ns = 1700000000123456789ULL;
+    io.inject_can("vcan2", make_frame(0x310, 2, 0x5A), rx_time_ns);
+    io.inject_can("vcan0", make_frame(0x110, 2, 0x5A), rx_time_ns);
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+
+    std::vector<std::uint8_t> datagram;
+    expect_true(io.pop_udp_tx(5565, datagram, nullptr), kTestName, "no datagram on the timestamped port");
+    expect_true(datagram.size() == kTimestampedFrameSize, kTestName, "timestamped datagram size mismatch");
+    struct can_frame decoded{};
+    std::uint64_t decoded_ns = 0;
+    expect_true(decode_timestamped_frame(datagram.data(), decoded, decoded_ns) && decoded.can_id == 0x310,
+                kTestName,
+                "forwarded frame mismatch");
+    expect_true(decoded_ns == rx_time_ns, kTestName, "RX timestamp not propagated");
+
+    expect_true(io.pop_udp_tx(5555, datagram, nullptr), kTestName, "no datagram on the standard port");
+    expect_true(datagram.size() == kUdpFrameSize, kTestName, "standard port must keep 13-byte frames");
+    return true;
+}
+
+bool test_bridge_scheduled_tx_holds_until_due() {
+    constexpr const char *kTestName = "bridge_scheduled_tx_holds_until_due";
+    BridgeConfig cfg = make_loopback_config();
+    cfg.ports[0].frame_format = FrameFormat::Timestamped;
+    cfg.ports[0].scheduled_tx = true;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::uint64_t wall_ns = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+            .count());
+    std::vector<std::uint8_t> wire(3 * kTimestampedFrameSize);
+    encode_timestamped_frame(make_frame(0x101, 1, 1), wall_ns + 20000000ULL, wire.data());
+    encode_timestamped_frame(make_frame(0x102, 1, 2), 0, wire.data() + kTimestampedFrameSize);
+    encode_timestamped_frame(make_frame(0x103, 1, 3), wall_ns - 1000000ULL, wire.data() + 2 * kTimestampedFrameSize);
+    io.inject_udp(5555, wire.data(), wire.size());
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+
+    struct can_frame out{};
+    expect_true(io.can_tx_pending("vcan0") == 2, kTestName, "immediate and past frames must go out at once");
+    expect_true(io.pop_can_tx("vcan0", out) && out.can_id == 0x102, kTestName, "zero timestamp must mean now");
+    expect_true(io.pop_can_tx("vcan0", out) && out.can_id == 0x103, kTestName, "past timestamp must mean now");
+    expect_true(app.channel_stats(0).can_tx_scheduled == 1, kTestName, "future frame must be scheduled");
+
+    for (int i = 0; i < 20 && io.can_tx_pending("vcan0") == 0; ++i) {
+        expect_true(app.poll_once(100), kTestName, "poll failed");
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    expect_true(io.pop_can_tx("vcan0", out) && out.can_id == 0x101, kTestName, "scheduled frame was not released");
+    expect_true(elapsed >= std::chrono::milliseconds(15), kTestName, "scheduled frame released too early");
+    expect_true(app.channel_stats(0).can_tx_frames == 3, kTestName, "tx count mismatch");
+    return true;
+}
+
+bool test_sequence_tracker_verdicts() {
+    constexpr const char *kTestName = "sequence_tracker_verdicts";
+    using Verdict = SequenceTracker::Verdict;
+    SequenceTracker tracker;
+    std::uint32_t gap = 0;
+    expect_true(tracker.observe(0xFFFFFFFEU, gap) == Verdict::First, kTestName, "first datagram");
+    expect_true(tracker.observe(0xFFFFFFFFU, gap) == Verdict::InOrder, kTestName, "next sequence must be in order");
+    expect_true(tracker.observe(0U, gap) == Verdict::InOrder, kTestName, "sequence must wrap");
+    expect_true(tracker.observe(3U, gap) == Verdict::Gap && gap == 2, kTestName, "gap of two expected");
+    expect_true(tracker.observe(1U, gap) == Verdict::Late, kTestName, "1 fills the gap");
+    expect_true(tracker.observe(1U, gap) == Verdict::Duplicate, kTestName, "second 1 is a duplicate");
+    expect_true(tracker.observe(3U, gap) == Verdict::Duplicate, kTestName, "3 was already seen");
+    expect_true(tracker.observe(2U, gap) == Verdict::Late, kTestName, "2 fills the gap");
+    expect_true(tracker.observe(4U, gap) == Verdict::InOrder, kTestName, "4 follows 3");
+    expect_true(tracker.observe(200000U, gap) == Verdict::Gap && gap == 200000U - 5U, kTestName, "long outage");
+    expect_true(tracker.observe(7U, gap) == Verdict::Restart, kTestName, "far behind must be a restart");
+    expect_true(tracker.observe(8U, gap) == Verdict::InOrder, kTestName, "tracking resumes after a restart");
+
+    // A peer that restarts after a few datagrams: 0-99 then 0 again.
+    SequenceTracker short_run;
+    for (std::uint32_t sequence = 0; sequence < 100; ++sequence) {
+        short_run.observe(sequence, gap);
+    }
+    expect_true(short_run.observe(0U, gap) == Verdict::Restart, kTestName, "back to 0 must be a restart");
+    bool resumed = true;
+    for (std::uint32_t sequence = 1; sequence < 100; ++sequence) {
+        resumed = resumed && short_run.observe(sequence, gap) == Verdict::InOrder;
+    }
+    expect_true(resumed, kTestName, "restarted run must not be read as late or duplicate");
+    expect_true(short_run.observe(50U, gap) == Verdict::Duplicate, kTestName, "duplicates still detected");
+    expect_true(short_run.observe(0U, gap) == Verdict::Restart && short_run.observe(70U, gap) == Verdict::Gap &&
+                    short_run.observe(3U, gap) == Verdict::Restart,
+                kTestName,
+                "jumps back past the window must restart");
+    return true;
+}
+
+bool test_bridge_sequence_header_counts_loss() {
+    constexpr const char *kTestName = "bridge_sequence_header_counts_loss";
+    BridgeConfig cfg = make_loopback_config();
+    cfg.ports[0].sequence_header = true;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    const auto send = [&](std::uint32_t sequence, std::uint16_t announced, std::size_t frames) {
+        std::vector<std::uint8_t> wire(kSequenceHeaderSize + frames * kUdpFrameSize);
+        encode_datagram_header(DatagramHeader{sequence, announced}, wire.data());
+        for (std::size_t i = 0; i < frames; ++i) {
+            encode_udp_frame(make_frame(0x100U + sequence, 1, 0), wire.data() + kSequenceHeaderSize + i * kUdpFrameSize);
+        }
+        io.inject_udp(5555, wire.data(), wire.size());
+        app.poll_once(0);
+    };
+    send(10, 2, 2);
+    send(11, 1, 1);
+    send(14, 1, 1);
+    send(12, 1, 1);
+    send(12, 1, 1);
+    send(15, 3, 1);
+
+    const BridgeApp::PortStats &stats = app.port_stats(0);
+    expect_true(stats.udp_rx_datagrams == 6, kTestName, "datagram count mismatch");
+    expect_true(stats.udp_rx_seq_lost == 1, kTestName, "only 13 must remain lost");
+    expect_true(stats.udp_rx_seq_reordered == 1, kTestName, "12 arrived out of order");
+    expect_true(stats.udp_rx_seq_duplicates == 1, kTestName, "second 12 is a duplicate");
+    expect_true(stats.udp_rx_malformed == 1, kTestName, "frame count mismatch must be reported");
+    expect_true(io.can_tx_pending("vcan0") == 6, kTestName, "duplicate must not reach the bus");
+
+    io.inject_can("vcan0", make_frame(0x120, 1, 0));
+    io.inject_can("vcan1", make_frame(0x220, 1, 0));
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+    for (std::uint32_t expected = 0; expected < 2; ++expected) {
+        std::vector<std::uint8_t> datagram;
+        DatagramHeader header{};
+        expect_true(io.pop_udp_tx(5555, datagram, nullptr) && datagram.size() == kSequenceHeaderSize + kUdpFrameSize,
+                    kTestName,
+                    "CAN -> UDP datagram must carry the header");
+        expect_true(decode_datagram_header(datagram.data(), header) && header.sequence == expected &&
+                        header.frame_count == 1,
+                    kTestName,
+                    "outgoing sequence mismatch");
+    }
+
+    std::vector<std::uint8_t> datagram;
+    io.inject_can("vcan2", make_frame(0x320, 1, 0));
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+    expect_true(io.pop_udp_tx(5565, datagram, nullptr) && datagram.size() == kUdpFrameSize,
+                kTestName,
+                "ports without the header keep plain frames");
+    return true;
+}
+
+std::string make_temp_dir() {
+    char path[] = "/tmp/bridge_captureXXXXXX";
+    if (mkdtemp(path) == nullptr) {
+        throw std::runtime_error("mkdtemp failed");
+    }
+    return std::string(path);
+}
+
+void remove_capture_files(const std::string &dir, const std::string &base, std::uint32_t files) {
+    for (std::uint32_t i = 0; i < files; ++i) {
+        remove_file(dir + "/" + base + (i == 0 ? std::string() : "." + std::to_string(i)));
+    }
+    rmdir(dir.c_str());
+}
+
+bool test_capture_rotates_and_reads_back() {
+    constexpr const char *kTestName = "capture_rotates_and_reads_back";
+    const std::string dir = make_temp_dir();
+    const std::string path = dir + "/cap";
+    CaptureWriter writer;
+    std::string error;
+    // Four records per file, two files kept.
+    expect_true(writer.open(path, kCaptureDataOffset + 4 * sizeof(CaptureRecord), 2, {"vcan0", "vcan1"}, error),
+                kTestName,
+                error.c_str());
+    for (std::uint32_t i = 0; i < 10; ++i) {
+        CaptureRecord record{};
+        record.timestamp_ns = 1000U + i;
+        record.can_id = 0x100U + i;
+        record.channel = static_cast<std::uint16_t>(i % 2);
+        expect_true(writer.append(record, error), kTestName, "append failed");
+    }
+    expect_true(writer.file_records() == 2, kTestName, "third file must hold the last two records");
+    writer.close();
+
+    CaptureReader current;
+    CaptureReader previous;
+    expect_true(current.open(path, error), kTestName, error.c_str());
+    expect_true(previous.open(path + ".1", error), kTestName, error.c_str());
+    expect_true(current.size() == 2 && current.record(1).can_id == 0x109, kTestName, "current file mismatch");
+    expect_true(previous.size() == 4 && previous.record(0).can_id == 0x104, kTestName, "rotated file mismatch");
+    expect_true(previous.channel_name(1) == "vcan1" && previous.channel_name(7) == "can7",
+                kTestName,
+                "channel names mismatch");
+    CaptureReader dropped;
+    expect_true(!dropped.open(path + ".2", error), kTestName, "only two files may be kept");
+    current.close();
+    previous.close();
+    remove_capture_files(dir, "cap", 2);
+    return true;
+}
+
+bool test_candump_line_format() {
+    constexpr const char *kTestName = "candump_line_format";
+    expect_true(format_candump_line(1436509052249713123ULL, "vcan0", make_frame(0x123, 4, 0xDE)) ==
+                    "(1436509052.249713) vcan0 123#DEDEDEDE",
+                kTestName,
+                "standard frame line mismatch");
+    expect_true(format_candump_line(5000000ULL, "can1", make_frame(0x1ABCDE0U | CAN_EFF_FLAG, 0, 0)) ==
+                    "(0.005000) can1 01ABCDE0#",
+                kTestName,
+                "extended frame line mismatch");
+    expect_true(format_candump_line(0, "can1", make_frame(0x7FFU | CAN_RTR_FLAG, 2, 0)) == "(0.000000) can1 7FF#R2",
+                kTestName,
+                "remote frame line mismatch");
+    return true;
+}
+
+bool test_bridge_captures_forwarded_frames() {
+    constexpr const char *kTestName = "bridge_captures_forwarded_frames";
+    const std::string dir = make_temp_dir();
+    BridgeConfig cfg = make_loopback_config();
+    cfg.capture.enabled = true;
+    cfg.capture.path = dir + "/bridge.cap";
+    cfg.capture.file_size_mb = 1;
+    cfg.capture.files = 2;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    const std::vector<std::uint8_t> wire = encode_frames({make_frame(0x234, 2, 0x22), make_frame(0x7FF, 0, 0)});
+    io.inject_udp(5555, wire.data(), wire.size());
+    io.inject_can("vcan2", make_frame(0x301, 1, 0x33));
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+
+    CaptureReader reader;
+    std::string error;
+    expect_true(reader.open(cfg.capture.path, error), kTestName, error.c_str());
+    expect_true(reader.size() == 2, kTestName, "only forwarded frames may be captured");
+    bool saw_udp_to_can = false;
+    bool saw_can_to_udp = false;
+    for (std::size_t i = 0; i < reader.size(); ++i) {
+        const CaptureRecord &record = reader.record(i);
+        if (record.direction == static_cast<std::uint8_t>(CaptureDirection::UdpToCan)) {
+            saw_udp_to_can = record.can_id == 0x234 && reader.channel_name(record.channel) == "vcan1" &&
+                             record.udp_port == 5555 && record.data[1] == 0x22;
+        } else {
+            saw_can_to_udp = record.can_id == 0x301 && reader.channel_name(record.channel) == "vcan2" &&
+                             record.udp_port == 5565;
+        }
+        expect_true(record.timestamp_ns != 0, kTestName, "record without timestamp");
+    }
+    expect_true(saw_udp_to_can && saw_can_to_udp, kTestName, "direction, channel or port mismatch");
+    reader.close();
+    remove_capture_files(dir, "bridge.cap", 2);
+    return true;
+}
+
+bool test_candump_line_parse() {
+    constexpr const char *kTestName = "candump_line_parse";
+    CandumpEntry entry{};
+    expect_true(parse_candump_line("(1436509052.249713) vcan0 123#DEADBEEF", entry), kTestName, "SFF line rejected");
+    expect_true(entry.timestamp_ns == 1436509052249713000ULL && entry.interface_name == "vcan0" &&
+                    entry.frame.can_id == 0x123 && entry.frame.can_dlc == 4 && entry.frame.data[3] == 0xEF,
+                kTestName,
+                "SFF line mismatch");
+    expect_true(parse_candump_line("(0.5) can1 0000A123#R3", entry), kTestName, "EFF RTR line rejected");
+    expect_true(entry.timestamp_ns == 500000000ULL &&
+                    entry.frame.can_id == (0xA123U | CAN_EFF_FLAG | CAN_RTR_FLAG) && entry.frame.can_dlc == 3,
+                kTestName,
+                "EFF RTR line mismatch");
+    expect_true(parse_candump_line("(1.000000) can0 7FF#", entry) && entry.frame.can_dlc == 0,
+                kTestName,
+                "empty frame rejected");
+    expect_true(!parse_candump_line("(1.000000) can0 123##1AABB", entry), kTestName, "CAN FD must be skipped");
+    expect_true(!parse_candump_line("# comment", entry), kTestName, "comment must be skipped");
+    expect_true(!parse_candump_line("(1.000000) can0 800#", entry), kTestName, "3-digit id above 0x7FF must fail");
+    expect_true(!parse_candump_line("(1.000000) can0 123#112233445566778899", entry),
+                kTestName,
+                "more than 8 data bytes must fail");
+    return true;
+}
+
+bool test_bridge_replays_log_into_udp_side() {
+    constexpr const char *kTestName = "bridge_replays_log_into_udp_side";
+    const std::string log_path = write_temp_file("(100.000000) can9 123#01\n"
+                                                 "(100.020000) can9 234#02\n"
+                                                 "(100.020000) can9 7FF#03\n");
+    BridgeConfig cfg = make_loopback_config();
+    cfg.replay.enabled = true;
+    cfg.replay.path = log_path;
+    cfg.replay.speed = 1.0;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 20 && app.replay_active(); ++i) {
+        expect_true(app.poll_once(100), kTestName, "poll failed");
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    remove_file(log_path);
+
+    struct can_frame out{};
+    expect_true(!app.replay_active(), kTestName, "replay did not finish");
+    expect_true(io.pop_can_tx("vcan0", out) && out.can_id == 0x123 && out.data[0] == 0x01,
+                kTestName,
+                "0x123 must be routed to vcan0");
+    expect_true(io.pop_can_tx("vcan1", out) && out.can_id == 0x234, kTestName, "0x234 must be routed to vcan1");
+    expect_true(elapsed >= std::chrono::milliseconds(15), kTestName, "recorded timing not honoured");
+    expect_true(app.replay_stats().frames == 3 && app.replay_stats().unroutable == 1,
+                kTestName,
+                "replay stats mismatch");
+    return true;
+}
+
+bool test_bridge_replays_capture_into_can_side() {
+    constexpr const char *kTestName = "bridge_replays_capture_into_can_side";
+    const std::string dir = make_temp_dir();
+    const std::string path = dir + "/replay.cap";
+    {
+        CaptureWriter writer;
+        std::string error;
+        expect_true(writer.open(path, 1 << 20, 1, {"vcan2", "vcan0"}, error), kTestName, error.c_str());
+        for (std::uint32_t i = 0; i < 300; ++i) {
+            CaptureRecord record{};
+            record.timestamp_ns = 1000000000ULL * i; // 5 minutes at recorded speed
+            record.can_id = 0x300U + (i % 16U);
+            record.dlc = 1;
+            record.data[0] = static_cast<std::uint8_t>(i);
+            record.direction = static_cast<std::uint8_t>(i % 2 == 0 ? CaptureDirection::CanToUdp : CaptureDirection::UdpToCan);
+            record.channel = static_cast<std::uint16_t>(i % 2);
+            writer.append(record, error);
+        }
+    }
+
+    BridgeConfig cfg = make_loopback_config();
+    cfg.replay.enabled = true;
+    cfg.replay.path = path;
+    cfg.replay.speed = 0.0;
+    cfg.replay.inject = ReplayInject::Can;
+    cfg.replay.filter_direction = true;
+    cfg.replay.direction = CaptureDirection::CanToUdp;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+    for (int i = 0; i < 10 && app.replay_active(); ++i) {
+        expect_true(app.poll_once(100), kTestName, "poll failed");
+    }
+    remove_capture_files(dir, "replay.cap", 1);
+
+    expect_true(!app.replay_active(), kTestName, "max-speed replay must not wait for recorded time");
+    expect_true(app.replay_stats().frames == 150, kTestName, "direction filter must keep half the records");
+    expect_true(io.udp_tx_pending(5565) == 150, kTestName, "vcan2 frames must go out on port 5565");
+    expect_true(app.channel_stats(2).can_rx_frames == 150, kTestName, "replayed frames count as received");
+    std::vector<std::uint8_t> datagram;
+    struct can_frame decoded{};
+    expect_true(io.pop_udp_tx(5565, datagram, nullptr) && decode_udp_frame(datagram.data(), decoded) &&
+                    decoded.can_id == 0x300 && decoded.data[0] == 0,
+                kTestName,
+                "first replayed frame mismatch");
+    return true;
+}
+
+bool test_bridge_splits_gro_segments() {
+    constexpr const char *kTestName = "bridge_splits_gro_segments";
+    BridgeConfig cfg = make_loopback_config();
+    cfg.ports[0].sequence_header = true;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    // Three sequenced single-frame datagrams in one read, the last one cut
+    // short: each must be checked on its own boundary.
+    constexpr std::size_t kSegment = kSequenceHeaderSize + kUdpFrameSize;
+    std::vector<std::uint8_t> wire(3 * kSegment - 4);
+    for (std::uint32_t i = 0; i < 3; ++i) {
+        std::uint8_t *segment = wire.data() + i * kSegment;
+        encode_datagram_header(DatagramHeader{i, 1}, segment);
+        if (i < 2) {
+            encode_udp_frame(make_frame(0x100U + i, 1, 0), segment + kSequenceHeaderSize);
+        }
+    }
+    expect_true(io.inject_udp_coalesced(5555, wire.data(), wire.size(), kSegment), kTestName, "inject failed");
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+
+    const BridgeApp::PortStats &stats = app.port_stats(0);
+    expect_true(stats.udp_rx_coalesced == 1, kTestName, "one coalesced read expected");
+    expect_true(stats.udp_rx_datagrams == 3, kTestName, "every segment counts as a datagram");
+    expect_true(stats.udp_rx_frames == 2, kTestName, "two whole frames expected");
+    expect_true(stats.udp_rx_seq_lost == 0, kTestName, "segments are in sequence");
+    // The short segment fails both the frame-count and the length check.
+    expect_true(stats.udp_rx_malformed == 2, kTestName, "only the short segment is malformed");
+    expect_true(io.can_tx_pending("vcan0") == 2, kTestName, "both frames must reach the bus");
+    return true;
+}
+
+bool test_bridge_batches_can_to_udp_sends() {
+    constexpr const char *kTestName = "bridge_batches_can_to_udp_sends";
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(make_loopback_config(), io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    // 70 frames drained at once: one batch of 64 and one of 6, still one
+    // 13-byte datagram per frame on the wire.
+    for (std::uint8_t i = 0; i < 70; ++i) {
+        io.inject_can("vcan0", make_frame(0x100, 1, i));
+    }
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+
+    const BridgeApp::PortStats &stats = app.port_stats(0);
+    expect_true(stats.udp_tx_frames == 70, kTestName, "every frame must be sent");
+    expect_true(stats.udp_tx_segmented == 2, kTestName, "two segmented sends expected");
+    expect_true(io.udp_tx_pending(5555) == 70, kTestName, "peer must see one datagram per frame");
+    std::vector<std::uint8_t> datagram;
+    struct can_frame decoded{};
+    bool in_order = true;
+    for (std::uint8_t i = 0; i < 70; ++i) {
+        in_order = in_order && io.pop_udp_tx(5555, datagram, nullptr) && datagram.size() == kUdpFrameSize &&
+                   decode_udp_frame(datagram.data(), decoded) && decoded.data[0] == i;
+    }
+    expect_true(in_order, kTestName, "datagrams must keep the frame order");
+    return true;
+}
+
+bool test_bridge_xdp_falls_back_to_sockets() {
+    constexpr const char *kTestName = "bridge_xdp_falls_back_to_sockets";
+    const char json[] = R"JSON(
+{
+  "server": { "ip": "10.0.0.5" },
+  "xdp": { "interface": "xdp-missing0", "queues": 2 },
+  "ports": [
+    {
+      "udp_listen_port": 5555,
+      "xdp_ingress": true,
+      "channels": [
+        { "vcan_name": "vcan0", "tx_channel_id": 0, "id_range": { "min": "0x100", "max": "0x1FF" }, "bitrate": 500000 }
+      ]
+    }
+  ]
+}
+)JSON";
+    const std::string file_path = write_temp_file(json);
+    BridgeConfig parsed{};
+    std::string error;
+    const bool ok = load_bridge_config(file_path, parsed, error);
+    remove_file(file_path);
+    expect_true(ok, kTestName, error.c_str());
+    expect_true(parsed.xdp.enabled && parsed.xdp.interface == "xdp-missing0" && parsed.xdp.queues == 2 &&
+                    parsed.ports[0].xdp_ingress,
+                kTestName,
+                "xdp fields mismatch");
+
+    // The interface does not exist, so the setup fails and the UDP socket
+    // keeps serving the port.
+    BridgeConfig cfg = make_loopback_config();
+    cfg.xdp = parsed.xdp;
+    cfg.ports[0].xdp_ingress = true;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "XDP setup failure must not fail initialize");
+    expect_true(!app.xdp_active(), kTestName, "XDP must report inactive");
+    const std::vector<std::uint8_t> wire = encode_frames({make_frame(0x123, 1, 0x5A)});
+    io.inject_udp(5555, wire.data(), wire.size());
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+    struct can_frame out{};
+    expect_true(io.pop_can_tx("vcan0", out) && out.can_id == 0x123, kTestName, "socket path must forward");
+    expect_true(app.port_stats(0).udp_rx_xdp == 0, kTestName, "nothing arrives through AF_XDP");
+    return true;
+}
+
+// Runs the XDP program in the kernel through BPF_PROG_TEST_RUN. The XSKMAP
+// holds no socket, so a redirect falls back to XDP_PASS; rejected datagrams
+// come back as XDP_DROP.
+bool test_xdp_program_applies_udp_filter() {
+    constexpr const char *kTestName = "xdp_program_applies_udp_filter";
+    const auto bpf = [](int command, bpf_attr &attr) {
+        return static_cast<int>(syscall(__NR_bpf, command, &attr, sizeof(attr)));
+    };
+    bpf_attr attr{};
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(std::uint32_t);
+    attr.value_size = sizeof(std::uint32_t);
+    attr.max_entries = 1;
+    const int map_fd = bpf(BPF_MAP_CREATE, attr);
+    if (map_fd < 0) {
+        std::printf("%s: skipped, bpf() unavailable: %s\n", kTestName, std::strerror(errno));
+        return true;
+    }
+
+    in_addr server{};
+    inet_pton(AF_INET, "10.0.0.5", &server);
+    const auto load = [&](const std::vector<XdpPort> &ports) {
+        const std::vector<bpf_insn> program = build_xdp_program(map_fd, ports);
+        static const char kLicense[] = "GPL";
+        bpf_attr load_attr{};
+        load_attr.prog_type = BPF_PROG_TYPE_XDP;
+        load_attr.insns = reinterpret_cast<std::uint64_t>(program.data());
+        load_attr.insn_cnt = static_cast<std::uint32_t>(program.size());
+        load_attr.license = reinterpret_cast<std::uint64_t>(kLicense);
+        return bpf(BPF_PROG_LOAD, load_attr);
+    };
+    // Without filtered ports, or without ports, nothing jumps to the drop or
+    // redirect tail; the verifier rejects unreachable code.
+    for (const std::vector<XdpPort> &ports :
+         {std::vector<XdpPort>{XdpPort{5565, false, UdpFilterSpec{}}}, std::vector<XdpPort>{}}) {
+        const int fd = load(ports);
+        expect_true(fd >= 0, kTestName, "kernel rejected the XDP program without filtered ports");
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    const int prog_fd = load({XdpPort{5555, true, UdpFilterSpec{server, kUdpFrameSize, 0, true}},
+                              XdpPort{5565, false, UdpFilterSpec{}}});
+    expect_true(prog_fd >= 0, kTestName, "kernel rejected the XDP program");
+
+    // Ethernet, IPv4 and UDP headers around `payload`, padded to the
+    // Ethernet minimum.
+    const auto run = [&](const char *source, std::uint16_t port, const std::vector<std::uint8_t> &payload) {
+        std::vector<std::uint8_t> packet(42, 0);
+        packet[12] = 0x08;
+        packet[14] = 0x45;
+        const std::size_t ip_length = 28 + payload.size();
+        packet[16] = static_cast<std::uint8_t>(ip_length >> 8U);
+        packet[17] = static_cast<std::uint8_t>(ip_length);
+        packet[23] = IPPROTO_UDP;
+        in_addr address{};
+        inet_pton(AF_INET, source, &address);
+        std::memcpy(packet.data() + 26, &address, sizeof(address));
+        packet[36] = static_cast<std::uint8_t>(port >> 8U);
+        packet[37] = static_cast<std::uint8_t>(port);
+        packet[38] = static_cast<std::uint8_t>((8 + payload.size()) >> 8U);
+        packet[39] = static_cast<std::uint8_t>(8 + payload.size());
+        packet.insert(packet.end(), payload.begin(), payload.end());
+        packet.resize(std::max<std::size_t>(packet.size(), 60), 0);
+        bpf_attr test_run{};
+        test_run.test.prog_fd = static_cast<std::uint32_t>(prog_fd);
+        test_run.test.data_in = reinterpret_cast<std::uint64_t>(packet.data());
+        test_run.test.data_size_in = static_cast<std::uint32_t>(packet.size());
+        test_run.test.repeat = 1;
+        return bpf(BPF_PROG_TEST_RUN, test_run) == 0 ? test_run.test.retval : 0xFFFFFFFFU;
+    };
+    std::vector<std::uint8_t> frames = encode_frames({make_frame(0x100, 1, 1), make_frame(0x101, 1, 2)});
+    if (prog_fd >= 0) {
+        expect_true(run("10.0.0.5", 5555, frames) == XDP_PASS, kTestName, "server datagram must be redirected");
+        expect_true(run("10.0.0.6", 5555, frames) == XDP_DROP, kTestName, "foreign sender must be dropped");
+        expect_true(run("10.0.0.6", 5565, frames) == XDP_PASS, kTestName, "unfiltered port must not be checked");
+        std::vector<std::uint8_t> partial(frames.begin(), frames.end() - 1);
+        expect_true(run("10.0.0.5", 5555, partial) == XDP_DROP, kTestName, "partial frame must be dropped");
+        frames[kUdpFrameSize] = 0x0F;
+        expect_true(run("10.0.0.5", 5555, frames) == XDP_DROP, kTestName, "DLC 15 in the second frame must drop");
+        frames[0] = kControlInfo;
+        expect_true(run("10.0.0.5", 5555, frames) == XDP_PASS, kTestName, "control record must be redirected");
+        close(prog_fd);
+    }
+    close(map_fd);
+    return true;
+}
+
+bool test_bridge_refused_udp_batch_spares_other_port() {
+    constexpr const char *kTestName = "bridge_refused_udp_batch_spares_other_port";
+    BridgeConfig cfg = make_loopback_config();
+    cfg.shared_can_socket = true;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+    io.set_udp_tx_capacity(5565, 0); // port 1 refuses every send
+
+    // One drain of the shared socket: port 1's frame is staged first and
+    // refused when port 0's frame needs the staging area.
+    io.inject_can("vcan2", make_frame(0x310, 1, 1));
+    io.inject_can("vcan0", make_frame(0x110, 1, 2));
+    io.inject_can("vcan1", make_frame(0x210, 1, 3));
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+    expect_true(app.port_stats(1).udp_tx_dropped == 1 && app.port_stats(1).udp_tx_frames == 0,
+                kTestName,
+                "the refused frame must be counted against its own port");
+    expect_true(app.port_stats(0).udp_tx_dropped == 0 && app.port_stats(0).udp_tx_frames == 2,
+                kTestName,
+                "frames of the other port must still go out");
+    expect_true(io.udp_tx_pending(5555) == 2, kTestName, "port 0 datagrams missing");
+    return true;
+}
+
+bool test_bridge_shared_can_socket_demultiplexes() {
+    constexpr const char *kTestName = "bridge_shared_can_socket_demultiplexes";
+    BridgeConfig cfg = make_loopback_config();
+    cfg.shared_can_socket = true;
+    cfg.ports[0].channels[0].tx_queue.enabled = true;
+    cfg.ports[0].channels[0].tx_queue.depth = 8;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    io.add_interface("can9"); // not bridged
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+    expect_true(io.open_endpoint_count() == 3, kTestName, "two UDP sockets and one CAN socket expected");
+
+    io.inject_can("vcan1", make_frame(0x210, 1, 1));
+    io.inject_can("can9", make_frame(0x220, 1, 2));
+    io.inject_can("vcan2", make_frame(0x310, 1, 3));
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+    expect_true(app.channel_stats(0).can_rx_frames == 0 && app.channel_stats(1).can_rx_frames == 1 &&
+                    app.channel_stats(2).can_rx_frames == 1,
+                kTestName,
+                "frames must be counted against the channel of their interface");
+    expect_true(io.udp_tx_pending(5555) == 1 && io.udp_tx_pending(5565) == 1,
+                kTestName,
+                "each frame must go out on its channel's port, the unbridged one nowhere");
+
+    // UDP -> CAN goes out through the shared socket, addressed by ifindex,
+    // and a blocked channel drains on its EPOLLOUT.
+    io.set_can_tx_capacity("vcan0", 1);
+    const std::vector<std::uint8_t> wire = encode_frames({make_frame(0x120, 1, 4),
+                                                          make_frame(0x121, 1, 5),
+                                                          make_frame(0x220, 1, 6)});
+    io.inject_udp(5555, wire.data(), wire.size());
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+    struct can_frame out{};
+    expect_true(io.pop_can_tx("vcan1", out) && out.can_id == 0x220, kTestName, "vcan1 frame missing");
+    expect_true(io.pop_can_tx("vcan0", out) && out.can_id == 0x120, kTestName, "vcan0 frame missing");
+    expect_true(app.channel_stats(0).can_tx_queued == 1, kTestName, "second vcan0 frame should queue");
+    expect_true(app.poll_once(0), kTestName, "drain poll failed");
+    expect_true(io.pop_can_tx("vcan0", out) && out.can_id == 0x121, kTestName, "queued frame did not drain");
+
+    // Back to one socket per channel.
+    BridgeConfig next = cfg;
+    next.shared_can_socket = false;
+    expect_true(app.reload(next), kTestName, "reload failed");
+    expect_true(io.open_endpoint_count() == 5, kTestName, "shared socket must give way to per-channel sockets");
+    expect_true(app.channel_stats(1).can_rx_frames == 1, kTestName, "stats must survive the switch");
+    io.inject_can("vcan1", make_frame(0x230, 1, 7));
+    expect_true(app.poll_once(0), kTestName, "poll after reload failed");
+    expect_true(app.channel_stats(1).can_rx_frames == 2, kTestName, "per-channel socket does not receive");
+
+    expect_true(app.reload(cfg), kTestName, "reload back to the shared socket failed");
+    expect_true(io.open_endpoint_count() == 3, kTestName, "per-channel sockets must close again");
+    io.inject_can("vcan1", make_frame(0x240, 1, 8));
+    expect_true(app.poll_once(0), kTestName, "poll after second reload failed");
+    expect_true(app.channel_stats(1).can_rx_frames == 3, kTestName, "shared socket does not receive after reload");
+    return true;
+}
+
+bool test_tx_echo_filter_matches_own_writes() {
+    constexpr const char *kTestName = "tx_echo_filter_matches_own_writes";
+    TxEchoFilter filter;
+    filter.record(make_frame(0x100, 1, 1), 1000);
+    filter.record(make_frame(0x101, 1, 2), 1000);
+    filter.record(make_frame(0x102, 1, 3), 1000);
+    expect_true(!filter.consume(make_frame(0x100, 1, 9), 2000), kTestName, "different payload must not match");
+    expect_true(filter.consume(make_frame(0x100, 1, 1), 2000), kTestName, "oldest write must match");
+    // The copy of 0x101 was lost: 0x102 matches and gives it up.
+    expect_true(filter.consume(make_frame(0x102, 1, 3), 2000), kTestName, "later write must match");
+    expect_true(filter.pending() == 0, kTestName, "skipped write must be given up");
+    expect_true(!filter.consume(make_frame(0x101, 1, 2), 2000), kTestName, "bus frame equal to a lost write must pass");
+
+    filter.record(make_frame(0x200, 0, 0), 1000);
+    expect_true(!filter.consume(make_frame(0x200, 0, 0), 1000 + TxEchoFilter::kLifetimeNs + 1),
+                kTestName,
+                "expired write must not match");
+    for (std::size_t i = 0; i < TxEchoFilter::kDepth + 1; ++i) {
+        filter.record(make_frame(0x300, 1, static_cast<std::uint8_t>(i)), 5000);
+    }
+    expect_true(filter.pending() == TxEchoFilter::kDepth, kTestName, "full filter must drop the oldest write");
+    expect_true(!filter.consume(make_frame(0x300, 1, 0), 5000) && filter.consume(make_frame(0x300, 1, 1), 5000),
+                kTestName,
+                "oldest write should have been pushed out");
+
+    const char json[] = R"JSON(
+{
+  "server": { "ip": "10.0.0.5" },
+  "can_rx_ring": { "block_size": 131072, "block_count": 4 },
+  "ports": [
+    {
+      "udp_listen_port": 5555,
+      "channels": [
+        { "vcan_name": "vcan0", "tx_channel_id": 0, "id_range": { "min": "0x100", "max": "0x1FF" }, "bitrate": 500000 }
+      ]
+    }
+  ]
+}
+)JSON";
+    std::string file_path = write_temp_file(json);
+    BridgeConfig parsed{};
+    std::string error;
+    bool ok = load_bridge_config(file_path, parsed, error);
+    remove_file(file_path);
+    expect_true(ok, kTestName, error.c_str());
+    expect_true(parsed.can_rx_ring.enabled && parsed.can_rx_ring.block_size == 131072 &&
+                    parsed.can_rx_ring.block_count == 4 && parsed.can_rx_ring.block_timeout_ms == 1,
+                kTestName,
+                "can_rx_ring fields mismatch");
+
+    std::string bad(json);
+    bad.replace(bad.find("131072"), 6, "100000");
+    file_path = write_temp_file(bad);
+    ok = load_bridge_config(file_path, parsed, error);
+    remove_file(file_path);
+    expect_true(!ok && error.find("block_size") != std::string::npos, kTestName, "unaligned block size must be rejected");
+    return true;
+}
+
+// Length of the next datagram on `fd`, or -1 when none arrives in time.
+int receive_length(int fd) {
+    pollfd entry{fd, POLLIN, 0};
+    if (poll(&entry, 1, 50) <= 0) {
+        return -1;
+    }
+    std::uint8_t buffer[2048];
+    return static_cast<int>(recv(fd, buffer, sizeof(buffer), 0));
+}
+
+bool test_udp_filter_drops_bad_datagrams() {
+    constexpr const char *kTestName = "udp_filter_drops_bad_datagrams";
+    // Runs the program in the kernel over loopback: 127.0.0.1 is the
+    // server, 127.0.0.2 a stranger.
+    const int receiver = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    const int sender = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    const int stranger = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    sockaddr_in target{};
+    target.sin_family = AF_INET;
+    target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sockaddr_in stranger_addr = target;
+    stranger_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK + 1);
+    socklen_t target_len = sizeof(target);
+    const bool sockets_ok =
+        receiver >= 0 && sender >= 0 && stranger >= 0 &&
+        bind(receiver, reinterpret_cast<sockaddr *>(&target), sizeof(target)) == 0 &&
+        getsockname(receiver, reinterpret_cast<sockaddr *>(&target), &target_len) == 0 &&
+        bind(stranger, reinterpret_cast<sockaddr *>(&stranger_addr), sizeof(stranger_addr)) == 0;
+    expect_true(sockets_ok, kTestName, "cannot set up loopback sockets");
+
+    for (const std::uint32_t header_size : {0U, static_cast<std::uint32_t>(kSequenceHeaderSize)}) {
+        std::vector<sock_filter> program =
+            build_udp_filter(UdpFilterSpec{target.sin_addr, kUdpFrameSize, header_size, true});
+        sock_fprog attached{static_cast<unsigned short>(program.size()), program.data()};
+        expect_true(sockets_ok && setsockopt(receiver, SOL_SOCKET, SO_ATTACH_FILTER, &attached, sizeof(attached)) == 0,
+                    kTestName,
+                    "kernel rejected the program");
+
+        std::vector<std::uint8_t> datagram(header_size, 0);
+        const std::vector<std::uint8_t> frames = encode_frames({make_frame(0x100, 1, 1),
+                                                                make_frame(0x101, 1, 2),
+                                                                make_frame(0x102, 1, 3)});
+        datagram.insert(datagram.end(), frames.begin(), frames.end());
+        const auto send_prefix = [&](int fd, std::size_t length) {
+            sendto(fd, datagram.data(), length, 0, reinterpret_cast<const sockaddr *>(&target), sizeof(target));
+            return receive_length(receiver);
+        };
+        const int whole = static_cast<int>(header_size + 2 * kUdpFrameSize);
+        expect_true(send_prefix(sender, whole) == whole, kTestName, "whole frames must pass");
+        expect_true(send_prefix(sender, header_size + kUdpFrameSize - 1) < 0, kTestName, "short datagram must drop");
+        expect_true(send_prefix(stranger, whole) < 0, kTestName, "foreign source must drop");
+        datagram[header_size] = 0x09;
+        expect_true(send_prefix(sender, whole) < 0, kTestName, "DLC 9 in the first frame must drop");
+        datagram[header_size] = 0x01;
+        if (header_size == 0) {
+            // Without a header every frame position is known up front.
+            expect_true(send_prefix(sender, whole + 1) < 0, kTestName, "partial trailing frame must drop");
+            datagram[2 * kUdpFrameSize] = 0x0F;
+            expect_true(send_prefix(sender, datagram.size()) < 0, kTestName, "DLC 15 in the third frame must drop");
+            datagram[2 * kUdpFrameSize] = 0x01;
+        }
+        datagram[header_size] = kControlInfo;
+        expect_true(send_prefix(sender, whole) == whole, kTestName, "control record must pass");
+        // An ISO-TP payload behind the record is not checked as frames.
+        datagram[header_size + kUdpFrameSize] = 0xFF;
+        expect_true(send_prefix(sender, whole) == whole, kTestName, "ISO-TP payload must pass");
+        datagram[header_size + kUdpFrameSize] = 0x01;
+        datagram[header_size] = 0x01;
+    }
+    for (const int fd : {receiver, sender, stranger}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    // The bridge attaches the program to every listen port and takes it off
+    // again when a reload turns the filter off.
+    BridgeConfig cfg = make_loopback_config();
+    cfg.udp_filter.enabled = true;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+    expect_true(io.udp_filter_length(5555) > 0 && io.udp_filter_length(5565) > 0,
+                kTestName,
+                "every listen port must get a filter");
+    BridgeConfig next = cfg;
+    next.udp_filter.enabled = false;
+    expect_true(app.reload(next), kTestName, "reload failed");
+    expect_true(io.udp_filter_length(5555) == 0, kTestName, "disabled filter must be removed");
+
+    const char json[] = R"JSON(
+{
+  "server": { "ip": "10.0.0.5" },
+  "udp_filter": { "info_bytes": true },
+  "ports": [
+    {
+      "udp_listen_port": 5555,
+      "channels": [
+        { "vcan_name": "vcan0", "tx_channel_id": 0, "id_range": { "min": "0x100", "max": "0x1FF" }, "bitrate": 500000 }
+      ]
+    }
+  ]
+}
+)JSON";
+    const std::string file_path = write_temp_file(json);
+    BridgeConfig parsed{};
+    std::string error;
+    const bool ok = load_bridge_config(file_path, parsed, error);
+    remove_file(file_path);
+    expect_true(ok, kTestName, error.c_str());
+    expect_true(parsed.udp_filter.enabled && parsed.udp_filter.info_bytes, kTestName, "udp_filter fields mismatch");
+    return true;
+}
+
+bool test_bridge_counts_socket_drops_and_grows_buffers() {
+    constexpr const char *kTestName = "bridge_counts_socket_drops_and_grows_buffers";
+    // 4096 requested is 8192 accounted, room for 8 queued messages.
+    BridgeConfig cfg = make_loopback_config();
+    cfg.ports[0].socket_buffers.rcvbuf = 4096;
+    cfg.ports[0].socket_buffers.adaptive = true;
+    cfg.ports[0].socket_buffers.max_rcvbuf = 8192;
+    cfg.ports[0].channels[0].socket_buffers.rcvbuf = 4096;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+    expect_true(io.udp_receive_buffer(5555) == 8192 && io.can_receive_buffer("vcan0") == 8192,
+                kTestName,
+                "configured buffer sizes not applied");
+    expect_true(io.udp_receive_buffer(5565) == LoopbackIoBackend::kBufferLimit, kTestName, "unset port must keep its size");
+
+    // Overflow both sockets. The kernel reports drops with the next message
+    // that gets through, so one more of each follows the drain.
+    const std::vector<std::uint8_t> wire = encode_frames({make_frame(0x123, 1, 1)});
+    const auto overflow = [&](int datagrams, int frames) {
+        for (int i = 0; i < datagrams; ++i) {
+            io.inject_udp(5555, wire.data(), wire.size());
+        }
+        for (int i = 0; i < frames; ++i) {
+            io.inject_can("vcan0", make_frame(0x110, 1, static_cast<std::uint8_t>(i)));
+        }
+        expect_true(app.poll_once(0), kTestName, "poll failed");
+        io.inject_udp(5555, wire.data(), wire.size());
+        io.inject_can("vcan0", make_frame(0x111, 1, 0));
+        expect_true(app.poll_once(0), kTestName, "poll failed");
+    };
+    overflow(12, 10);
+    expect_true(app.port_stats(0).udp_rx_datagrams == 9 && app.port_stats(0).udp_rx_socket_drops == 4,
+                kTestName,
+                "UDP drops not counted");
+    expect_true(app.channel_stats(0).can_rx_frames == 9 && app.channel_stats(0).can_rx_socket_drops == 2,
+                kTestName,
+                "CAN drops not counted");
+    expect_true(io.udp_receive_buffer(5555) == 16384, kTestName, "adaptive buffer must double after drops");
+    expect_true(io.can_receive_buffer("vcan0") == 8192, kTestName, "fixed buffer must not grow");
+
+    // Doubling again would pass max_rcvbuf: the buffer stays, drops count on.
+    overflow(20, 0);
+    expect_true(app.port_stats(0).udp_rx_socket_drops == 8, kTestName, "second overflow not counted");
+    expect_true(io.udp_receive_buffer(5555) == 16384, kTestName, "buffer must stop at max_rcvbuf");
+
+    // A kept socket is resized when its setting changes.
+    BridgeConfig next = cfg;
+    next.ports[0].socket_buffers.rcvbuf = 65536;
+    next.ports[0].socket_buffers.max_rcvbuf = 65536;
+    expect_true(app.reload(next), kTestName, "reload failed");
+    expect_true(io.udp_receive_buffer(5555) == 131072 && app.port_stats(0).udp_rx_socket_drops == 8,
+                kTestName,
+                "reload must resize the kept socket and keep its stats");
+
+    const char json[] = R"JSON(
+{
+  "server": { "ip": "10.0.0.5" },
+  "socket_buffers": { "rcvbuf": 1048576, "adaptive": true },
+  "ports": [
+    {
+      "udp_listen_port": 5555,
+      "socket_buffers": { "sndbuf": 262144, "force": true },
+      "channels": [
+        { "vcan_name": "vcan0", "tx_channel_id": 0, "id_range": { "min": "0x100", "max": "0x1FF" }, "bitrate": 500000,
+          "socket_buffers": { "rcvbuf": 65536, "adaptive": false } }
+      ]
+    }
+  ]
+}
+)JSON";
+    std::string file_path = write_temp_file(json);
+    BridgeConfig parsed{};
+    std::string error;
+    bool ok = load_bridge_config(file_path, parsed, error);
+    remove_file(file_path);
+    expect_true(ok, kTestName, error.c_str());
+    const SocketBufferConfig &port_buffers = parsed.ports[0].socket_buffers;
+    const SocketBufferConfig &channel_buffers = parsed.ports[0].channels[0].socket_buffers;
+    expect_true(port_buffers.rcvbuf == 1048576 && port_buffers.adaptive && port_buffers.sndbuf == 262144 &&
+                    port_buffers.force,
+                kTestName,
+                "port must inherit the top-level buffers and add its own");
+    expect_true(channel_buffers.rcvbuf == 65536 && !channel_buffers.adaptive && !channel_buffers.force,
+                kTestName,
+                "channel must inherit from the top level, not from its port");
+
+    std::string bad(json);
+    bad.replace(bad.find("262144"), 6, "1024");
+    file_path = write_temp_file(bad);
+    ok = load_bridge_config(file_path, parsed, error);
+    remove_file(file_path);
+    expect_true(!ok && error.find("sndbuf") != std::string::npos, kTestName, "tiny sndbuf must be rejected");
+
+    // A zero-length datagram still reports the kernel's drop counter, so it
+    // cannot read as the counter going back to 0.
+    SocketIoBackend socket_io;
+    const int receiver = socket_io.open_udp(0);
+    const int sender = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    sockaddr_in target{};
+    socklen_t target_len = sizeof(target);
+    const bool sockets_ok = receiver >= 0 && sender >= 0 && socket_io.set_socket_buffers(receiver, 1, 0, false) &&
+                            getsockname(receiver, reinterpret_cast<sockaddr *>(&target), &target_len) == 0;
+    expect_true(sockets_ok, kTestName, "cannot set up loopback sockets");
+    target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    const std::vector<std::uint8_t> filler(1000, 0);
+    const auto send_datagram = [&](std::size_t length) {
+        sendto(sender, filler.data(), length, 0, reinterpret_cast<const sockaddr *>(&target), sizeof(target));
+    };
+    std::vector<std::uint8_t> buffer(2048);
+    // Every read returns the counter as of when its datagram was queued.
+    const auto drain = [&](std::vector<std::uint32_t> &counters) {
+        while (sockets_ok) {
+            std::size_t segment_size = 0;
+            std::uint32_t drop_counter = 0xFFFFFFFFU;
+            if (socket_io.udp_recv(receiver, buffer.data(), buffer.size(), segment_size, drop_counter) < 0) {
+                break;
+            }
+            counters.push_back(drop_counter);
+        }
+    };
+    std::vector<std::uint32_t> counters;
+    for (int i = 0; i < 64 && sockets_ok; ++i) {
+        send_datagram(filler.size());
+    }
+    drain(counters);
+    counters.clear();
+    send_datagram(0);
+    send_datagram(1);
+    drain(counters);
+    expect_true(counters.size() == 2 && counters[1] > 0 && counters[0] == counters[1],
+                kTestName,
+                "zero-length datagram must carry the drop counter");
+    for (const int fd : {receiver, sender}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    return true;
+}
+
+bool test_bridge_cyclic_tx_offloads_to_bcm() {
+    constexpr const char *kTestName = "bridge_cyclic_tx_offloads_to_bcm";
+    ControlRecord record{};
+    std::array<std::uint8_t, kUdpFrameSize> slot{};
+    expect_true(encode_control_record(ControlRecord{ControlOpcode::CyclicStart, 100000}, slot.data()) &&
+                    decode_control_record(slot.data(), record) && record.opcode == ControlOpcode::CyclicStart &&
+                    record.period_us == 100000,
+                kTestName,
+                "control record roundtrip failed");
+    struct can_frame decoded{};
+    expect_true(!decode_udp_frame(slot.data(), decoded), kTestName, "a control slot must not decode as a frame");
+
+    BridgeConfig cfg = make_loopback_config();
+    cfg.cyclic_tx.enabled = true;
+    cfg.cyclic_tx.max_jobs = 2;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+
+    const auto control = [&](ControlOpcode opcode, std::uint32_t period_us, const struct can_frame &frame) {
+        std::vector<std::uint8_t> wire(kUdpFrameSize);
+        encode_control_record(ControlRecord{opcode, period_us}, wire.data());
+        const std::vector<std::uint8_t> framed = encode_frames({frame});
+        wire.insert(wire.end(), framed.begin(), framed.end());
+        return wire;
+    };
+    const auto send = [&](const std::vector<std::uint8_t> &wire) {
+        io.inject_udp(5555, wire.data(), wire.size());
+        expect_true(app.poll_once(0), kTestName, "poll failed");
+    };
+
+    // A start record and a plain frame in one datagram: the kernel announces
+    // the cyclic frame, the plain one is written as usual.
+    std::vector<std::uint8_t> wire = control(ControlOpcode::CyclicStart, 100000, make_frame(0x123, 2, 7));
+    const std::vector<std::uint8_t> plain = encode_frames({make_frame(0x124, 1, 1)});
+    wire.insert(wire.end(), plain.begin(), plain.end());
+    send(wire);
+    struct can_frame job{};
+    std::uint32_t period_us = 0;
+    expect_true(io.bcm_tx_job("vcan0", 0x123, job, period_us) && period_us == 100000 && job.can_dlc == 2 &&
+                    job.data[0] == 7,
+                kTestName,
+                "start record must install a CAN_BCM job");
+    struct can_frame out{};
+    expect_true(io.pop_can_tx("vcan0", out) && out.can_id == 0x123 && io.pop_can_tx("vcan0", out) && out.can_id == 0x124,
+                kTestName,
+                "announce and plain frame expected on vcan0");
+    const BridgeApp::PortStats &stats = app.port_stats(0);
+    expect_true(stats.udp_rx_control == 1 && stats.udp_rx_frames == 1 && stats.udp_rx_malformed == 0,
+                kTestName,
+                "control record miscounted");
+
+    send(control(ControlOpcode::CyclicStart, 500, make_frame(0x125, 1, 0)));
+    send(control(ControlOpcode::CyclicStart, 20000, make_frame(0x200, 1, 0)));
+    send(control(ControlOpcode::CyclicStart, 20000, make_frame(0x201, 1, 0)));
+    expect_true(stats.udp_rx_control_rejected == 2 && app.cyclic_job_count() == 2,
+                kTestName,
+                "short period and job limit must be refused");
+    send(control(ControlOpcode::CyclicStart, 50000, make_frame(0x123, 1, 9)));
+    expect_true(io.bcm_tx_job("vcan0", 0x123, job, period_us) && period_us == 50000 && job.data[0] == 9 &&
+                    app.cyclic_job_count() == 2,
+                kTestName,
+                "restart must update the running job");
+    send(control(ControlOpcode::CyclicStop, 0, make_frame(0x200, 0, 0)));
+    send(control(ControlOpcode::CyclicStop, 0, make_frame(0x200, 0, 0)));
+    expect_true(io.bcm_tx_job_count() == 1 && stats.udp_rx_control_rejected == 3,
+                kTestName,
+                "stop must delete the job once");
+
+    // A reload keeps the jobs whose ID still routes to their interface.
+    send(control(ControlOpcode::CyclicStart, 20000, make_frame(0x200, 1, 0)));
+    BridgeConfig next = cfg;
+    next.ports[0].channels[0].id_range.max = 0x11F;
+    expect_true(app.reload(next), kTestName, "reload failed");
+    expect_true(io.bcm_tx_job_count() == 1 && io.bcm_tx_job("vcan1", 0x200, job, period_us),
+                kTestName,
+                "reload must prune only the jobs that no longer route");
+    next.cyclic_tx.enabled = false;
+    expect_true(app.reload(next), kTestName, "reload failed");
+    expect_true(io.bcm_tx_job_count() == 0 && app.cyclic_job_count() == 0, kTestName, "disabling must end every job");
+    send(control(ControlOpcode::CyclicStart, 20000, make_frame(0x200, 1, 0)));
+    expect_true(app.port_stats(0).udp_rx_control_rejected == 4, kTestName, "records must be refused when disabled");
+
+    const char json[] = R"JSON(
+{
+  "server": { "ip": "10.0.0.5" },
+  "cyclic_tx": { "max_jobs": 16, "min_period_us": 5000 },
+  "ports": [
+    {
+      "udp_listen_port": 5555,
+      "channels": [
+        { "vcan_name": "vcan0", "tx_channel_id": 0, "id_range": { "min": "0x100", "max": "0x1FF" }, "bitrate": 500000 }
+      ]
+    }
+  ]
+}
+)JSON";
+    const std::string file_path = write_temp_file(json);
+    BridgeConfig parsed{};
+    std::string error;
+    const bool ok = load_bridge_config(file_path, parsed, error);
+    remove_file(file_path);
+    expect_true(ok, kTestName, error.c_str());
+    expect_true(parsed.cyclic_tx.enabled && parsed.cyclic_tx.max_jobs == 16 && parsed.cyclic_tx.min_period_us == 5000,
+                kTestName,
+                "cyclic_tx fields mismatch");
+    return true;
+}
+
+bool test_bridge_bcm_rx_filters_in_kernel() {
+    constexpr const char *kTestName = "bridge_bcm_rx_filters_in_kernel";
+    BridgeConfig cfg = make_loopback_config();
+    cfg.ports[0].channels[0].bcm_rx.enabled = true;
+    cfg.ports[0].channels[0].bcm_rx.ids = {0x110, 0x111};
+    cfg.ports[0].channels[1].bcm_rx.enabled = true;
+    cfg.ports[0].channels[1].bcm_rx.throttle_ms = 100;
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+    std::uint32_t throttle_ms = 0;
+    expect_true(io.bcm_rx_op_count() == 2 + 256 && io.bcm_rx_subscribed("vcan1", 0x2FF, throttle_ms) &&
+                    throttle_ms == 100,
+                kTestName,
+                "ids and id_range must be subscribed");
+
+    const auto forwarded = [&]() {
+        expect_true(app.poll_once(0), kTestName, "poll failed");
+        std::size_t count = 0;
+        std::vector<std::uint8_t> datagram;
+        while (io.pop_udp_tx(5555, datagram)) {
+            ++count;
+        }
+        return count;
+    };
+    // Only changes of subscribed IDs reach the bridge; the CAN_RAW socket
+    // no longer receives.
+    io.inject_can("vcan0", make_frame(0x110, 1, 1));
+    io.inject_can("vcan0", make_frame(0x110, 1, 1));
+    io.inject_can("vcan0", make_frame(0x110, 1, 2));
+    io.inject_can("vcan0", make_frame(0x120, 1, 1));
+    expect_true(forwarded() == 2 && app.channel_stats(0).can_rx_frames == 2,
+                kTestName,
+                "only changed frames of subscribed IDs may be forwarded");
+
+    // The subscription also sees our own writes; their copies stay local.
+    const std::vector<std::uint8_t> wire = encode_frames({make_frame(0x111, 1, 5)});
+    io.inject_udp(5555, wire.data(), wire.size());
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+    struct can_frame written{};
+    expect_true(io.pop_can_tx("vcan0", written), kTestName, "UDP frame not written");
+    io.inject_can("vcan0", written);
+    expect_true(forwarded() == 0, kTestName, "echo of an own write must be dropped");
+
+    // Rewriting the current content produces no copy, so nothing may wait
+    // for one: the value coming back after a change is real bus traffic.
+    io.inject_can("vcan0", make_frame(0x110, 1, 2));
+    expect_true(forwarded() == 0, kTestName, "unchanged frame must be filtered");
+    const std::vector<std::uint8_t> same = encode_frames({make_frame(0x110, 1, 2)});
+    io.inject_udp(5555, same.data(), same.size());
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+    expect_true(io.pop_can_tx("vcan0", written), kTestName, "UDP frame not written");
+    io.inject_can("vcan0", written);
+    expect_true(forwarded() == 0, kTestName, "unchanged own write must not be reported");
+    io.inject_can("vcan0", make_frame(0x110, 1, 3));
+    io.inject_can("vcan0", make_frame(0x110, 1, 2));
+    expect_true(forwarded() == 2, kTestName, "return to the written value must be forwarded");
+
+    // Unchanged subscriptions keep their last frame across a reload.
+    BridgeConfig next = cfg;
+    next.ports[0].channels[0].bcm_rx.ids = {0x110};
+    expect_true(app.reload(next), kTestName, "reload failed");
+    expect_true(io.bcm_rx_op_count() == 1 + 256 && !io.bcm_rx_subscribed("vcan0", 0x111, throttle_ms),
+                kTestName,
+                "reload must drop removed IDs");
+    io.inject_can("vcan0", make_frame(0x110, 1, 2));
+    expect_true(forwarded() == 0, kTestName, "kept subscription must remember its last frame");
+
+    next.ports[0].channels[0].bcm_rx.enabled = false;
+    next.ports[0].channels[1].bcm_rx.enabled = false;
+    expect_true(app.reload(next), kTestName, "reload failed");
+    io.inject_can("vcan0", make_frame(0x120, 1, 1));
+    expect_true(io.bcm_rx_op_count() == 0 && forwarded() == 1,
+                kTestName,
+                "disabling bcm_rx must restore CAN_RAW receive");
+
+    const char json[] = R"JSON(
+{
+  "server": { "ip": "10.0.0.5" },
+  "ports": [
+    {
+      "udp_listen_port": 5555,
+      "channels": [
+        { "vcan_name": "vcan0", "tx_channel_id": 0, "id_range": { "min": "0x100", "max": "0x1FFF" }, "bitrate": 500000,
+          "bcm_rx": { "ids": ["0x120", "0x18DAF110", "0x120"], "throttle_ms": 50 } }
+      ]
+    }
+  ]
+}
+)JSON";
+    std::string file_path = write_temp_file(json);
+    BridgeConfig parsed{};
+    std::string error;
+    bool ok = load_bridge_config(file_path, parsed, error);
+    remove_file(file_path);
+    expect_true(ok, kTestName, error.c_str());
+    const BcmRxConfig &bcm_rx = parsed.ports[0].channels[0].bcm_rx;
+    expect_true(bcm_rx.enabled && bcm_rx.changes_only && bcm_rx.throttle_ms == 50 && bcm_rx.ids.size() == 2,
+                kTestName,
+                "bcm_rx fields mismatch");
+
+    std::string bad(json);
+    bad.replace(bad.find("\"ids\""), std::string("\"ids\": [\"0x120\", \"0x18DAF110\", \"0x120\"], ").size(), "");
+    file_path = write_temp_file(bad);
+    ok = load_bridge_config(file_path, parsed, error);
+    remove_file(file_path);
+    expect_true(!ok && error.find("ids") != std::string::npos, kTestName, "wide id_range without ids must be rejected");
+    return true;
+}
+
+bool test_bridge_isotp_carries_whole_pdus() {
+    constexpr const char *kTestName = "bridge_isotp_carries_whole_pdus";
+    BridgeConfig cfg = make_loopback_config();
+    IsoTpConfig link{};
+    link.vcan_name = "vcan0";
+    link.tx_id = 0x7E0;
+    link.rx_id = 0x7E8;
+    link.st_min_us = 500;
+    cfg.ports[0].isotp.push_back(link);
+    LoopbackIoBackend io;
+    add_loopback_interfaces(io);
+    BridgeApp app(cfg, io);
+    expect_true(app.initialize(), kTestName, "initialize failed");
+    expect_true(app.isotp_link_count() == 1, kTestName, "link not set up");
+
+    const auto pdu_datagram = [](std::uint32_t can_id, std::size_t length, std::size_t claimed) {
+        std::vector<std::uint8_t> wire(kUdpFrameSize);
+        ControlRecord record{ControlOpcode::IsoTpPdu};
+        record.can_id = can_id;
+        record.length = static_cast<std::uint16_t>(claimed);
+        encode_control_record(record, wire.data());
+        for (std::size_t i = 0; i < length; ++i) {
+            wire.push_back(static_cast<std::uint8_t>(i));
+        }
+        wire.resize(kUdpFrameSize * (1 + (length + kUdpFrameSize - 1) / kUdpFrameSize), 0);
+        return wire;
+    };
+    const auto send = [&](const std::vector<std::uint8_t> &wire) {
+        io.inject_udp(5555, wire.data(), wire.size());
+        expect_true(app.poll_once(0), kTestName, "poll failed");
+    };
+
+    // UDP -> CAN: the payload goes to the socket in one piece, and a second
+    // one is refused while the first is still in flight.
+    send(pdu_datagram(0x7E0, 100, 100));
+    send(pdu_datagram(0x7E0, 100, 100));
+    std::vector<std::uint8_t> pdu;
+    expect_true(io.pop_isotp_tx("vcan0", 0x7E0, pdu) && pdu.size() == 100 && pdu[99] == 99,
+                kTestName,
+                "PDU must reach the ISO-TP socket whole");
+    expect_true(app.isotp_stats(0).can_tx_pdus == 1 && app.isotp_stats(0).can_tx_bytes == 100 &&
+                    app.isotp_stats(0).can_tx_dropped == 1,
+                kTestName,
+                "busy link must drop the second PDU");
+    send(pdu_datagram(0x7E1, 8, 8));
+    send(pdu_datagram(0x7E0, 8, 40));
+    const BridgeApp::PortStats &stats = app.port_stats(0);
+    expect_true(stats.udp_rx_unroutable == 1 && stats.udp_rx_malformed == 1 && stats.udp_rx_frames == 0,
+                kTestName,
+                "unknown link and oversized length must be counted");
+
+    // CAN -> UDP: an empty read carries nothing; a reassembled 4095-byte PDU
+    // leaves in one datagram.
+    std::vector<std::uint8_t> payload(kMaxIsoTpPdu);
+    expect_true(io.inject_isotp("vcan0", 0x7E8, payload.data(), 0), kTestName, "no socket on rx_id");
+    for (std::size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = static_cast<std::uint8_t>(i * 7);
+    }
+    expect_true(io.inject_isotp("vcan0", 0x7E8, payload.data(), payload.size()), kTestName, "no socket on rx_id");
+    expect_true(app.poll_once(0), kTestName, "poll failed");
+    std::vector<std::uint8_t> datagram;
+    ControlRecord record{};
+    expect_true(io.udp_tx_pending(5555) == 1, kTestName, "an empty read must not be forwarded");
+    expect_true(io.pop_udp_tx(5555, datagram) && datagram.size() == kUdpFrameSize * 316 &&
+                    decode_control_record(datagram.data(), record) && record.opcode == ControlOpcode::IsoTpPdu &&
+                    record.can_id == 0x7E8 && record.length == kMaxIsoTpPdu &&
+                    std::equal(payload.begin(), payload.end(), datagram.begin() + kUdpFrameSize),
+                kTestName,
+                "PDU datagram mismatch");
+    expect_true(app.isotp_stats(0).can_rx_pdus == 1 && app.isotp_stats(0).can_rx_bytes == kMaxIsoTpPdu,
+                kTestName,
+                "received PDU not counted");
+
+    // An unchanged link keeps its socket and stats; a removed one closes.
+    const std::size_t endpoints = io.open_endpoint_count();
+    BridgeConfig next = cfg;
+    next.ports[1].channels[0].id_range.max = 0x33F;
+    expect_true(app.reload(next), kTestName, "reload failed");
+    expect_true(io.open_endpoint_count() == endpoints && app.isotp_stats(0).can_rx_pdus == 1,
+                kTestName,
+                "reload must keep the link");
+    next.ports[0].isotp.clear();
+    expect_true(app.reload(next), kTestName, "reload failed");
+    expect_true(io.open_endpoint_count() == endpoints - 1 && app.isotp_link_count() == 0,
+                kTestName,
+                "removed link must close");
+
+    const char json[] = R"JSON(
+{
+  "server": { "ip": "10.0.0.5" },
+  "ports": [
+    {
+      "udp_listen_port": 5555,
+      "channels": [
+        { "vcan_name": "vcan0", "tx_channel_id": 0, "id_range": { "min": "0x100", "max": "0x1FF" }, "bitrate": 500000 }
+      ],
+      "isotp": [
+        { "vcan_name": "vcan0", "tx_id": "0x18DA10F1", "rx_id": "0x18DAF110", "block_size": 8, "st_min_us": 2000,
+          "padding": "0xCC" },
+        { "vcan_name": "vcan0", "tx_id": "0x7E0", "rx_id": "0x7E8" }
+      ]
+    }
+  ]
+}
+)JSON";
+    std::string file_path = write_temp_file(json);
+    BridgeConfig parsed{};
+    std::string error;
+    bool ok = load_bridge_config(file_path, parsed, error);
+    remove_file(file_path);
+    expect_true(ok, kTestName, error.c_str());
+    expect_true(parsed.ports[0].isotp.size() == 2 && parsed.ports[0].isotp[0].tx_id == 0x18DA10F1 &&
+                    parsed.ports[0].isotp[0].block_size == 8 && parsed.ports[0].isotp[0].st_min_us == 2000 &&
+                    parsed.ports[0].isotp[0].padding == 0xCC && parsed.ports[0].isotp[1].padding == -1,
+                kTestName,
+                "isotp fields mismatch");
+
+    std::string bad(json);
+    bad.replace(bad.find("\"0x7E8\""), std::string("\"0x7E8\"").size(), "\"0x18DAF110\"");
+    file_path = write_temp_file(bad);
+    ok = load_bridge_config(file_path, parsed, error);
+    remove_file(file_path);
+    expect_true(!ok && error.find("rx_id") != std::string::npos, kTestName, "duplicate rx_id must be rejected");
+
+    bad = json;
+    bad.replace(bad.find("\"0x7E8\""), std::string("\"0x7E8\"").size(), "\"0x1E8\"");
+    file_path = write_temp_file(bad);
+    ok = load_bridge_config(file_path, parsed, error);
+    remove_file(file_path);
+    expect_true(!ok && error.find("isotp[1].rx_id") != std::string::npos && error.find("id_range") != std::string::npos,
+                kTestName,
+                "a link ID inside the channel's id_range must be rejected");
+    return true;
+}
+
 } // namespace
 
 int main() {
@@ -204,6 +2573,55 @@ int main() {
     test_protocol_roundtrip_standard();
     test_protocol_roundtrip_extended();
     test_decode_rejects_large_dlc();
+    test_routing_lookup_boundaries();
+    test_bridge_requires_existing_interfaces();
+    test_bridge_udp_to_can_routing();
+    test_bridge_can_to_udp_forwarding();
+    test_bridge_can_backpressure_drops_rest_of_datagram();
+    test_bridge_supports_many_channels();
+    test_change_filter_config_parses();
+    test_last_value_cache_suppresses_unchanged();
+    test_last_value_cache_eff_overflow_forwards();
+    test_bridge_change_only_forwarding();
+    test_rate_limit_config_parses();
+    test_rate_limiter_token_bucket_and_decimation();
+    test_bridge_rate_limits_both_directions();
+    test_egress_queue_priority_order();
+    test_bridge_priority_egress_under_backpressure();
+    test_bridge_egress_backs_off_on_enobufs();
+    test_tx_pacing_config_parses();
+    test_tx_pacer_frame_time();
+    test_bridge_tx_pacing_releases_at_bus_speed();
+    test_can_link_setup_plan();
+    test_bridge_auto_setup_creates_interfaces();
+    test_bridge_auto_setup_waits_for_udp_ports();
+    test_bridge_reload_keeps_unchanged_sockets();
+    test_bridge_reload_on_sighup();
+    test_bridge_run_stops_without_polling_timeout();
+    test_timestamped_frame_roundtrip();
+    test_frame_format_config_parses();
+    test_bridge_timestamped_can_to_udp();
+    test_bridge_scheduled_tx_holds_until_due();
+    test_sequence_tracker_verdicts();
+    test_bridge_sequence_header_counts_loss();
+    test_capture_rotates_and_reads_back();
+    test_candump_line_format();
+    test_bridge_captures_forwarded_frames();
+    test_candump_line_parse();
+    test_bridge_replays_log_into_udp_side();
+    test_bridge_replays_capture_into_can_side();
+    test_bridge_splits_gro_segments();
+    test_bridge_batches_can_to_udp_sends();
+    test_bridge_xdp_falls_back_to_sockets();
+    test_xdp_program_applies_udp_filter();
+    test_bridge_shared_can_socket_demultiplexes();
+    test_bridge_refused_udp_batch_spares_other_port();
+    test_tx_echo_filter_matches_own_writes();
+    test_udp_filter_drops_bad_datagrams();
+    test_bridge_counts_socket_drops_and_grows_buffers();
+    test_bridge_cyclic_tx_offloads_to_bcm();
+    test_bridge_bcm_rx_filters_in_kernel();
+    test_bridge_isotp_carries_whole_pdus();
 
     if (g_failures == 0) {
         std::puts("All tests passed.");
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""
+AF_XDP 接入的 veth 测试环境
+
+在本机建立一对 veth（vxbr0 在主机侧，vxbr1 在网络命名空间 canbr-xdp 中），
+从命名空间一侧向桥接程序的监听端口发送 13 字节帧，用于在没有物理网卡时验证
+`xdp` 配置段：桥接程序的 `xdp.interface` 设为 vxbr0，对应端口设 `xdp_ingress`。
+
+使用方式：
+    sudo python3 tests/xdp_veth_ingress.py setup
+    sudo python3 tests/xdp_veth_ingress.py send --port 5555 --count 100000 --can-id 0x123
+    sudo python3 tests/xdp_veth_ingress.py teardown
+"""
+
+from __future__ import annotations
+
+import argparse
+import socket
+import struct
+import subprocess
+import sys
+import time
+
+NAMESPACE = "canbr-xdp"
+HOST_IF = "vxbr0"
+PEER_IF = "vxbr1"
+HOST_ADDR = "10.77.0.1"
+PEER_ADDR = "10.77.0.2"
+
+
+def run(*args: str, check: bool = True) -> None:
+    subprocess.run(args, check=check)
+
+
+def setup() -> None:
+    run("ip", "netns", "add", NAMESPACE)
+    run("ip", "link", "add", HOST_IF, "type", "veth", "peer", "name", PEER_IF)
+    run("ip", "link", "set", PEER_IF, "netns", NAMESPACE)
+    run("ip", "addr", "add", f"{HOST_ADDR}/24", "dev", HOST_IF)
+    run("ip", "link", "set", HOST_IF, "up")
+    run("ip", "netns", "exec", NAMESPACE, "ip", "addr", "add", f"{PEER_ADDR}/24", "dev", PEER_IF)
+    run("ip", "netns", "exec", NAMESPACE, "ip", "link", "set", PEER_IF, "up")
+    run("ip", "netns", "exec", NAMESPACE, "ip", "link", "set", "lo", "up")
+    print(f"{HOST_IF} ({HOST_ADDR}) <-> {NAMESPACE}/{PEER_IF} ({PEER_ADDR})")
+
+
+def teardown() -> None:
+    run("ip", "link", "del", HOST_IF, check=False)
+    run("ip", "netns", "del", NAMESPACE, check=False)
+
+
+def encode_frame(can_id: int, payload: bytes) -> bytes:
+    info = len(payload) & 0x0F
+    if can_id > 0x7FF:
+        info |= 0x80
+    return struct.pack(">BI8s", info, can_id, payload.ljust(8, b"\x00"))
+
+
+def send(port: int, count: int, can_id: int, rate: float) -> None:
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    interval = 1.0 / rate if rate > 0 else 0.0
+    started = time.monotonic()
+    for i in range(count):
+        sock.sendto(encode_frame(can_id, struct.pack(">I", i)), (HOST_ADDR, port))
+        if interval:
+            delay = started + (i + 1) * interval - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+    elapsed = time.monotonic() - started
+    print(f"sent {count} frames to {HOST_ADDR}:{port} in {elapsed:.3f} s ({count / max(elapsed, 1e-9):.0f} pps)")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+    sub.add_parser("setup")
+    sub.add_parser("teardown")
+    send_parser = sub.add_parser("send")
+    send_parser.add_argument("--port", type=int, default=5555)
+    send_parser.add_argument("--count", type=int, default=1000)
+    send_parser.add_argument("--can-id", type=lambda text: int(text, 0), default=0x123)
+    send_parser.add_argument("--rate", type=float, default=0.0, help="frames/s, 0 = as fast as possible")
+    send_parser.add_argument("--in-namespace", action="store_true", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.command == "setup":
+        setup()
+    elif args.command == "teardown":
+        teardown()
+    elif not args.in_namespace:
+        # Re-run inside the namespace so that the packets cross the veth.
+        return subprocess.run(["ip", "netns", "exec", NAMESPACE, sys.executable, *sys.argv, "--in-namespace"]).returncode
+    else:
+        send(args.port, args.count, args.can_id, args.rate)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())